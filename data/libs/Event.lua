@@ -24,24 +24,7 @@
 -- your module needs to know the difference.
 --
 
-local Engine = require 'Engine'
-
-local pending = {}
-local callbacks = {}
-local do_callback = {}
-
-local do_callback_normal = function (cb, p)
-	cb(table.unpack(p.event))
-end
-local do_callback_timed = function (cb, p)
-	local d = debug.getinfo(cb)
-
-	local tstart = Engine.ticks
-	cb(table.unpack(p.event))
-	local tend = Engine.ticks
-
-	print(string.format("DEBUG: %s %dms %s:%d", p.name, tend-tstart, d.source, d.linedefined))
-end
+local EventQueue = require 'EventQueue'
 
 local Event
 Event = {
@@ -76,11 +59,7 @@ Event = {
 	--
 	--   stable
 	--
-	Register = function (name, cb)
-		if not callbacks[name] then callbacks[name] = {} end
-		callbacks[name][cb] = cb;
-        if not do_callback[name] then do_callback[name] = do_callback_normal end
-	end,
+	Register = EventQueue.Register,
 
 	--
 	-- Function: Deregister
@@ -107,10 +86,7 @@ Event = {
 	--
 	--   stable
 	--
-	Deregister = function (name, cb)
-		if not callbacks[name] then return end
-		callbacks[name][cb] = nil
-	end,
+	Deregister = EventQueue.Deregister,
 
 	--
 	-- Function: Queue
@@ -138,9 +114,7 @@ Event = {
 	--
 	--   stable
 	--
-	Queue = function (name, ...)
-		table.insert(pending, { name = name, event = {...} })
-	end,
+	Queue = EventQueue.Queue,
 
 	--
 	-- Function: DebugTimer
@@ -167,26 +141,7 @@ Event = {
 	--   debug
     --
 
-    DebugTimer = function (name, enabled)
-		do_callback[name] = enabled and do_callback_timed or do_callback_normal
-	end,
-
-	-- internal method, called from C++
-	_Clear = function ()
-		pending = {}
-	end,
-
-	-- internal method, called from C++
-	_Emit = function ()
-		while #pending > 0 do
-			local p = table.remove(pending, 1)
-			if callbacks[p.name] then
-				for cb,_ in pairs(callbacks[p.name]) do
-					do_callback[p.name](cb, p)
-				end
-			end
-		end
-	end
+	DebugTimer = EventQueue.DebugTimer,
 }
 
 --
@@ -237,6 +192,45 @@ Event = {
 --   stable
 --
 
+--
+-- Event: onGameSaved
+--
+-- Triggered when a background save started with <Game.SaveGameAsync> has
+-- been written.
+--
+-- > local onGameSaved = function (filename) ... end
+-- > Event.Register("onGameSaved", onGameSaved)
+--
+-- Availability:
+--
+--   2020
+--
+-- Status:
+--
+--   experimental
+--
+
+--
+-- Event: onGameSaveFailed
+--
+-- Triggered when a background save started with <Game.SaveGameAsync> could
+-- not be written.
+--
+-- > local onGameSaveFailed = function (filename, message) ... end
+-- > Event.Register("onGameSaveFailed", onGameSaveFailed)
+--
+-- message is a translated description of the error, suitable for showing to
+-- the player.
+--
+-- Availability:
+--
+--   2020
+--
+-- Status:
+--
+--   experimental
+--
+
 --
 -- Event: onEnterSystem
 --
@@ -156,7 +156,7 @@ end
 local nearbysystems
 local makeAdvert = function (station)
 	if nearbysystems == nil then
-		nearbysystems = Game.system:GetNearbySystems(max_ass_dist, function (s) return #s:GetStationPaths() > 0 end)
+		nearbysystems = Game.system:FindNearbySystems(max_ass_dist, { hasStations = true })
 	end
 	if #nearbysystems == 0 then return end
 	local client = Character.New()
@@ -393,7 +393,7 @@ local onAICompleted = function (ship, ai_error)
 		if mission.status == 'ACTIVE' and
 		   mission.ship == ship then
 			if mission.shipstate == 'outbound' then
-				local systems = Game.system:GetNearbySystems(ship.hyperspaceRange, function (s) return #s:GetStationPaths() > 0 end)
+				local systems = Game.system:FindNearbySystems(ship.hyperspaceRange, { hasStations = true })
 				if #systems == 0 then return end
 				local system = systems[Engine.rand:Integer(1,#systems)]
 
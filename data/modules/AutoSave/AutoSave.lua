@@ -33,21 +33,31 @@ local function PickNextAutosave()
 	return '_autosave' .. next_save_number
 end
 
-local function CheckedSave(filename)
+local function CheckedSave(filename, save)
 	if not Engine.GetAutosaveEnabled() then
 		return
 	end
 
-	local ok, err = pcall(Game.SaveGame, filename)
+	local ok, err = pcall(save or Game.SaveGame, filename)
 	if not ok then
 		print('Error making autosave:')
 		print(err)
 	end
 end
 
-local f = function (ship) if ship:IsPlayer() then CheckedSave(PickNextAutosave()); end; end
+-- autosaves made while playing are written in the background so they don't
+-- interrupt the game; the one made on exit has to be finished before the game goes
+local f = function (ship)
+	if ship:IsPlayer() and not Game.IsSaving() then
+		CheckedSave(PickNextAutosave(), Game.SaveGameAsync)
+	end
+end
 Event.Register('onShipDocked', f)
 Event.Register('onShipLanded', f)
 Event.Register('onShipUndocked', f)
 Event.Register('onShipTakeOff', f)
 Event.Register('onGameEnd', function() CheckedSave('_exit'); end)
+Event.Register('onGameSaveFailed', function (filename, message)
+	print('Error saving game ' .. filename .. ':')
+	print(message)
+end)
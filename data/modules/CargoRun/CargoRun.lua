@@ -507,7 +507,7 @@ local makeAdvert = function (station)
 		end
 	else
 		if nearbysystems == nil then
-			nearbysystems = Game.system:GetNearbySystems(max_delivery_dist, function (s) return #s:GetStationPaths() > 0 end)
+			nearbysystems = Game.system:FindNearbySystems(max_delivery_dist, { hasStations = true })
 		end
 		if #nearbysystems == 0 then return nil end
 		nearbysystem = nearbysystems[Engine.rand:Integer(1,#nearbysystems)]
@@ -254,7 +254,7 @@ local makeAdvert = function (station, manualFlavour, nearbystations)
 		due = Game.time + ((4*24*60*60) * (Engine.rand:Number(1.5,3.5) - urgency))
 	else
 		if nearbysystems == nil then
-			nearbysystems = Game.system:GetNearbySystems(max_delivery_dist, function (s) return #s:GetStationPaths() > 0 end)
+			nearbysystems = Game.system:FindNearbySystems(max_delivery_dist, { hasStations = true })
 		end
 		if #nearbysystems == 0 then return nil end
 		nearbysystem = nearbysystems[Engine.rand:Integer(1,#nearbysystems)]
@@ -302,7 +302,7 @@ end
 
 local onCreateBB = function (station)
 	if nearbysystems == nil then
-		nearbysystems = Game.system:GetNearbySystems(max_delivery_dist, function (s) return #s:GetStationPaths() > 0 end)
+		nearbysystems = Game.system:FindNearbySystems(max_delivery_dist, { hasStations = true })
 	end
 	local nearbystations = findNearbyStations(station, 1000, 1.4960e11 * 20)
 	local num = Engine.rand:Integer(0, math.ceil(Game.system.population))
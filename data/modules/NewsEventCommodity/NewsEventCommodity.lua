@@ -189,7 +189,7 @@ local createNewsEvent = function (timeInHyper)
 	-- find system for event, excluding the current one
 	if nearbySystems == nil then
 		local dist = maxDist  * Engine.rand:Number(0.4,1.0)
-		nearbySystems = Game.system:GetNearbySystems(dist, function (s) return #s:GetStationPaths() > 0 end)
+		nearbySystems = Game.system:FindNearbySystems(dist, { hasStations = true })
 	end
 
 	-- scrap news if no systems with stations
@@ -1075,9 +1075,9 @@ local findNearbySystems = function (with_stations)
 	-- get systems (either inhabited or not - depending on variable with_stations)
 	local nearbysystems_raw
 	if with_stations == true then
-		nearbysystems_raw = Game.system:GetNearbySystems(max_mission_dist, function (s) return #s:GetStationPaths() > 0 end)
+		nearbysystems_raw = Game.system:FindNearbySystems(max_mission_dist, { hasStations = true })
 	else
-		nearbysystems_raw = Game.system:GetNearbySystems(max_mission_dist, function (s) return #s:GetStationPaths() == 0 end)
+		nearbysystems_raw = Game.system:FindNearbySystems(max_mission_dist, { hasStations = false })
 	end
 
 	-- determine distance to player system
@@ -249,7 +249,7 @@ local makeAdvert = function (station)
 	end
 
 	if nearbysystems == nil then
-		nearbysystems = Game.system:GetNearbySystems(max_taxi_dist, function (s) return #s:GetStationPaths() > 0 end)
+		nearbysystems = Game.system:FindNearbySystems(max_taxi_dist, { hasStations = true })
 	end
 	if #nearbysystems == 0 then return end
 	location = nearbysystems[Engine.rand:Integer(1,#nearbysystems)]
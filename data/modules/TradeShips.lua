@@ -405,14 +405,11 @@ local spawnInitialShips = function (game_start)
 	-- the base number of seconds between ships spawned in hyperspace
 	trade_ships['interval'] = (864000 / (num_trade_ships / 4))
 	-- get nearby system paths for hyperspace spawns to come from
-	local from_systems, dist = {}, 10
-	while #from_systems < 10 do
-		from_systems = Game.system:GetNearbySystems(dist)
-		dist = dist + 5
-	end
+	local dist = 10
 	from_paths = {}
-	for _, system in ipairs(from_systems) do
-		table.insert(from_paths, system.path)
+	while #from_paths < 10 do
+		from_paths = Game.system:GetNearbySystemPaths(dist)
+		dist = dist + 5
 	end
 
 	-- spawn the initial trade ships
@@ -923,14 +920,11 @@ local onGameStart = function ()
 		end
 
 		-- rebuild nearby system paths for hyperspace spawns to come from
-		local from_systems, dist = {}, 10
-		while #from_systems < 10 do
-			from_systems = Game.system:GetNearbySystems(dist)
-			dist = dist + 5
-		end
+		local dist = 10
 		from_paths = {}
-		for _, system in ipairs(from_systems) do
-			table.insert(from_paths, system.path)
+		while #from_paths < 10 do
+			from_paths = Game.system:GetNearbySystemPaths(dist)
+			dist = dist + 5
 		end
 
 		-- check if any trade ships were waiting on a timer
@@ -3,7 +3,6 @@
 
 #extension GL_ARB_explicit_attrib_location : enable
 
-uniform mat4 uProjectionMatrix;
 uniform mat4 uViewMatrix;
 uniform mat4 uViewMatrixInverse;
 uniform mat4 uViewProjectionMatrix;
@@ -15,7 +14,11 @@ struct Light {
 	vec4 specular;
 	vec4 position;
 };
-uniform Light uLight[4];
+
+//scene uniform parameters
+struct Scene {
+	vec4 ambient;
+};
 
 struct Material {
 	vec4 emission;
@@ -25,6 +28,20 @@ struct Material {
 	float shininess;
 };
 
+// Shared by every draw until the projection, lights or ambient colour change.
+// Laid out to match FrameUniformData in RendererGL.cpp.
+layout(std140) uniform FrameUniforms {
+	mat4 uProjectionMatrix;
+	Light uLight[4];
+	Scene scene;
+};
+
+// One buffer per material, uploaded when its parameters change.
+// Laid out to match MaterialUniformData in MaterialGL.h.
+layout(std140) uniform MaterialUniforms {
+	Material material;
+};
+
 #ifdef VERTEX_SHADER
 
 layout (location = 0) in vec4 a_vertex;
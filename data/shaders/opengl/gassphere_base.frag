@@ -15,9 +15,6 @@ uniform vec3 geosphereCenter;
 uniform float geosphereAtmosFogDensity;
 uniform float geosphereAtmosInvScaleHeight;
 
-uniform Material material;
-uniform Scene scene;
-
 in vec3 varyingEyepos;
 in vec3 varyingNormal;
 in vec3 varyingTexCoord0;
@@ -32,9 +32,6 @@ in vec3 normal;
 #endif // HEAT_COLOURING
 #endif // (NUM_LIGHTS > 0)
 
-uniform Scene scene;
-uniform Material material;
-
 out vec4 frag_color;
 
 #if (NUM_LIGHTS > 0)
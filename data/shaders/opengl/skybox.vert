@@ -5,7 +5,6 @@
 #include "lib.glsl"
 
 uniform vec4 u_viewPosition;
-uniform Material material;
 
 out vec3 v_texCoord;
 out float v_skyboxFactor;
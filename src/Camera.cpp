@@ -6,6 +6,7 @@
 #include "Body.h"
 #include "Frame.h"
 #include "Game.h"
+#include "ModelBody.h"
 #include "Pi.h"
 #include "Planet.h"
 #include "Player.h"
@@ -138,6 +139,7 @@ void Camera::Update()
 
 	// evaluate each body and determine if/where/how to draw it
 	m_sortedBodies.clear();
+	m_bodiesInView.clear();
 	for (Body *b : Pi::game->GetSpace()->GetBodies()) {
 		BodyAttrs attrs;
 		attrs.body = b;
@@ -159,6 +161,8 @@ void Camera::Update()
 		if (!m_context->GetFrustum().TestPointInfinite(attrs.viewCoords, rad))
 			continue;
 
+		m_bodiesInView.push_back({ b, attrs.viewCoords });
+
 		attrs.camDist = attrs.viewCoords.Length();
 		attrs.bodyFlags = b->GetFlags();
 
@@ -274,6 +278,8 @@ void Camera::Draw(const Body *excludeBody)
 		m_renderer->SetLights(rendererLights.size(), &rendererLights[0]);
 	}
 
+	FindModelGroups(excludeBody);
+
 	for (std::list<BodyAttrs>::iterator i = m_sortedBodies.begin(); i != m_sortedBodies.end(); ++i) {
 		BodyAttrs *attrs = &(*i);
 
@@ -290,9 +296,80 @@ void Camera::Draw(const Body *excludeBody)
 			attrs->body->Render(m_renderer, this, attrs->viewCoords, attrs->viewTransform);
 	}
 
+	// the groups point at bodies that may be gone by the next time this camera
+	// draws anything
+	m_modelGroups.clear();
+	m_modelGroupIndex.clear();
+
 	SfxManager::RenderAll(m_renderer, rootFrameId, camFrameId);
 }
 
+static bool SameLighting(const Camera::ModelGroup &group, const std::vector<Graphics::Light> &lights, const Color &ambient)
+{
+	if (group.ambient != ambient || group.lights.size() != lights.size())
+		return false;
+	for (size_t i = 0; i < lights.size(); i++) {
+		const Graphics::Light &a = group.lights[i];
+		const Graphics::Light &b = lights[i];
+		if (a.GetType() != b.GetType() || !(a.GetPosition() == b.GetPosition()) ||
+			a.GetDiffuse() != b.GetDiffuse() || a.GetSpecular() != b.GetSpecular())
+			return false;
+	}
+	return true;
+}
+
+void Camera::FindModelGroups(const Body *excludeBody)
+{
+	PROFILE_SCOPED()
+	m_modelGroups.clear();
+	m_modelGroupIndex.clear();
+
+	std::vector<Graphics::Light> lights;
+	Color ambient;
+	for (const BodyAttrs &attrs : m_sortedBodies) {
+		if (attrs.billboard || attrs.body == excludeBody || !attrs.body->IsType(ObjectType::MODELBODY))
+			continue;
+
+		ModelBody *b = static_cast<ModelBody *>(attrs.body);
+		if (!b->IsModelInstanceable())
+			continue;
+
+		b->GetLighting(this, lights, ambient);
+
+		// there are only ever a few groups, so they're just searched
+		ModelGroup *group = nullptr;
+		for (ModelGroup &g : m_modelGroups) {
+			if (g.bodies.front()->GetModel()->CanInstanceWith(*b->GetModel()) && SameLighting(g, lights, ambient)) {
+				group = &g;
+				break;
+			}
+		}
+		if (!group) {
+			m_modelGroups.emplace_back();
+			group = &m_modelGroups.back();
+			group->lights = lights;
+			group->ambient = ambient;
+		}
+
+		group->bodies.push_back(b);
+		group->transforms.push_back(b->GetModelTransform(attrs.viewCoords, attrs.viewTransform));
+	}
+
+	// a group of one is drawn as before
+	for (size_t i = 0; i < m_modelGroups.size(); i++) {
+		if (m_modelGroups[i].bodies.size() < 2)
+			continue;
+		for (const ModelBody *b : m_modelGroups[i].bodies)
+			m_modelGroupIndex[b] = i;
+	}
+}
+
+const Camera::ModelGroup *Camera::GetModelGroup(const ModelBody *b) const
+{
+	auto it = m_modelGroupIndex.find(b);
+	return it != m_modelGroupIndex.end() ? &m_modelGroups[it->second] : nullptr;
+}
+
 void Camera::CalcShadows(const int lightNum, const Body *b, std::vector<Shadow> &shadowsOut) const
 {
 	// Set up data for eclipses. All bodies are assumed to be spheres.
@@ -10,9 +10,11 @@
 #include "graphics/Light.h"
 #include "matrix4x4.h"
 #include "vector3.h"
+#include <unordered_map>
 
 class Body;
 class Frame;
+class ModelBody;
 
 namespace Graphics {
 	class Material;
@@ -113,6 +115,31 @@ public:
 	const std::vector<LightSource> &GetLightSources() const { return m_lightSources; }
 	int GetNumLightSources() const { return static_cast<Uint32>(m_lightSources.size()); }
 
+	// a body that passed the frustum test in the last Update(), before any were
+	// dropped for being too small to see
+	struct BodyInView {
+		Body *body;
+		vector3d viewCoords; // camera space
+	};
+
+	// in the order of Space's body list; only valid until the bodies are next updated
+	const std::vector<BodyInView> &GetBodiesInView() const { return m_bodiesInView; }
+
+	// Bodies whose models are drawn together, instanced: models that
+	// CanInstanceWith() each other and are lit the same. Found by Draw() before
+	// any body is drawn and dropped once they all have been; the first body of
+	// the group draws the solid geometry of all of them, in the order the
+	// bodies are drawn.
+	struct ModelGroup {
+		std::vector<ModelBody *> bodies;
+		std::vector<matrix4x4f> transforms;
+		std::vector<Graphics::Light> lights;
+		Color ambient;
+	};
+
+	// the body's group, or null if its model is drawn on its own this frame
+	const ModelGroup *GetModelGroup(const ModelBody *b) const;
+
 private:
 	RefCountedPtr<CameraContext> m_context;
 	Graphics::Renderer *m_renderer;
@@ -149,8 +176,14 @@ private:
 		};
 	};
 
+	void FindModelGroups(const Body *excludeBody);
+
 	std::list<BodyAttrs> m_sortedBodies;
+	std::vector<BodyInView> m_bodiesInView;
 	std::vector<LightSource> m_lightSources;
+
+	std::vector<ModelGroup> m_modelGroups;
+	std::unordered_map<const ModelBody *, size_t> m_modelGroupIndex; // only bodies in groups of more than one
 };
 
 #endif
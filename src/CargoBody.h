@@ -21,6 +21,7 @@ public:
 	LuaRef GetCargoType() const { return m_cargo; }
 	virtual void SetLabel(const std::string &label) override;
 	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform) override;
+	virtual bool IsModelInstanceable() const override { return true; }
 	virtual void TimeStepUpdate(const float timeStep) override;
 	virtual bool OnCollision(Body *o, Uint32 flags, double relVel) override;
 	virtual bool OnDamage(Body *attacker, float kgDamage, const CollisionContact &contactData) override;
@@ -0,0 +1,177 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "CborWriter.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace {
+	enum CborMajorType {
+		MAJOR_TEXT = 0x60,
+		MAJOR_ARRAY = 0x80,
+		MAJOR_MAP = 0xA0,
+	};
+
+	enum CborSimpleValues {
+		INDEFINITE_ARRAY = 0x9F,
+		INDEFINITE_MAP = 0xBF,
+		BREAK = 0xFF,
+	};
+} // namespace
+
+// Lets nlohmann's CBOR encoder write straight into our buffer.
+class CborWriter::Adapter : public nlohmann::detail::output_adapter_protocol<uint8_t> {
+public:
+	explicit Adapter(CborWriter *writer) :
+		m_writer(writer) {}
+
+	void write_character(uint8_t c) override { m_writer->WriteByte(c); }
+	void write_characters(const uint8_t *s, std::size_t length) override { m_writer->WriteBytes(s, length); }
+
+private:
+	CborWriter *m_writer;
+};
+
+CborWriter::CborWriter(OutputFunc output, size_t bufferSize) :
+	m_output(output),
+	m_bufferSize(bufferSize),
+	m_written(0),
+	m_adapter(std::make_shared<Adapter>(this)),
+	m_openEnded(0)
+{
+	m_buffer.reserve(m_bufferSize);
+}
+
+CborWriter::~CborWriter()
+{
+	// not flushed here: the output function may throw, and a half written
+	// document is no use to anyone anyway
+}
+
+void CborWriter::BeginObject(size_t size)
+{
+	WriteHeader(MAJOR_MAP, size);
+}
+
+void CborWriter::BeginObject()
+{
+	WriteByte(INDEFINITE_MAP);
+	++m_openEnded;
+}
+
+void CborWriter::BeginArray(size_t size)
+{
+	WriteHeader(MAJOR_ARRAY, size);
+}
+
+void CborWriter::BeginArray()
+{
+	WriteByte(INDEFINITE_ARRAY);
+	++m_openEnded;
+}
+
+void CborWriter::End()
+{
+	assert(m_openEnded > 0);
+	WriteByte(BREAK);
+	--m_openEnded;
+}
+
+void CborWriter::Key(const char *key)
+{
+	String(key, strlen(key));
+}
+
+void CborWriter::Null()
+{
+	Value(Json());
+}
+
+void CborWriter::Bool(bool value)
+{
+	Value(Json(value));
+}
+
+void CborWriter::Int(int64_t value)
+{
+	Value(Json(value));
+}
+
+void CborWriter::Double(double value)
+{
+	Value(Json(value));
+}
+
+void CborWriter::String(const char *str, size_t length)
+{
+	WriteHeader(MAJOR_TEXT, length);
+	WriteBytes(reinterpret_cast<const uint8_t *>(str), length);
+}
+
+void CborWriter::Value(const Json &value)
+{
+	nlohmann::detail::binary_writer<Json, uint8_t> writer(m_adapter);
+	writer.write_cbor(value);
+}
+
+void CborWriter::Fields(const Json &object)
+{
+	assert(object.is_object());
+	for (auto it = object.begin(); it != object.end(); ++it) {
+		String(it.key());
+		Value(it.value());
+	}
+}
+
+void CborWriter::Flush()
+{
+	if (m_buffer.empty()) return;
+	m_output(m_buffer.data(), m_buffer.size());
+	m_written += m_buffer.size();
+	m_buffer.clear();
+}
+
+// The shortest form of the initial byte and argument, as Json::to_cbor writes them.
+void CborWriter::WriteHeader(uint8_t major, uint64_t value)
+{
+	if (value <= 0x17) {
+		WriteByte(major | uint8_t(value));
+	} else if (value <= 0xff) {
+		WriteByte(major | 0x18);
+		WriteByte(uint8_t(value));
+	} else if (value <= 0xffff) {
+		WriteByte(major | 0x19);
+		for (int shift = 8; shift >= 0; shift -= 8)
+			WriteByte(uint8_t(value >> shift));
+	} else if (value <= 0xffffffff) {
+		WriteByte(major | 0x1a);
+		for (int shift = 24; shift >= 0; shift -= 8)
+			WriteByte(uint8_t(value >> shift));
+	} else {
+		WriteByte(major | 0x1b);
+		for (int shift = 56; shift >= 0; shift -= 8)
+			WriteByte(uint8_t(value >> shift));
+	}
+}
+
+void CborWriter::WriteByte(uint8_t byte)
+{
+	if (m_buffer.size() >= m_bufferSize)
+		Flush();
+	m_buffer.push_back(byte);
+}
+
+void CborWriter::WriteBytes(const uint8_t *data, size_t length)
+{
+	if (m_buffer.size() + length > m_bufferSize) {
+		Flush();
+		// too big to be worth copying into the buffer
+		if (length >= m_bufferSize) {
+			m_output(data, length);
+			m_written += length;
+			return;
+		}
+	}
+	m_buffer.insert(m_buffer.end(), data, data + length);
+}
@@ -0,0 +1,73 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _CBORWRITER_H
+#define _CBORWRITER_H
+
+#include "Json.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/* Writes CBOR a value at a time instead of building a whole Json tree first.
+
+   The output is buffered and handed to the output function in chunks, so the
+   amount of memory needed doesn't depend on the size of the document. Anything
+   it writes reads back with Json::from_cbor; Value() and the scalar writers use
+   the same encoder as Json::to_cbor, so a document written piecewise decodes to
+   the same Json as one built up as a tree.
+
+   Objects and arrays are either sized up front (BeginObject(n)/BeginArray(n),
+   followed by exactly n key/value pairs or values) or open ended
+   (BeginObject()/BeginArray(), closed with End()).
+*/
+class CborWriter {
+public:
+	typedef std::function<void(const uint8_t *data, size_t length)> OutputFunc;
+
+	explicit CborWriter(OutputFunc output, size_t bufferSize = 64 * 1024);
+	~CborWriter();
+
+	void BeginObject(size_t size);
+	void BeginObject();
+	void BeginArray(size_t size);
+	void BeginArray();
+	void End();
+
+	void Key(const char *key);
+	void Key(const std::string &key) { String(key); }
+
+	void Null();
+	void Bool(bool value);
+	void Int(int64_t value);
+	void Double(double value);
+	void String(const char *str, size_t length);
+	void String(const std::string &str) { String(str.data(), str.size()); }
+
+	// a whole Json value, however deep
+	void Value(const Json &value);
+	// each key/value pair of a Json object, as members of the object being written
+	void Fields(const Json &object);
+
+	// hands everything buffered so far to the output function
+	void Flush();
+
+	size_t GetBytesWritten() const { return m_written + m_buffer.size(); }
+
+private:
+	class Adapter;
+
+	void WriteHeader(uint8_t major, uint64_t value);
+	void WriteByte(uint8_t byte);
+	void WriteBytes(const uint8_t *data, size_t length);
+
+	OutputFunc m_output;
+	std::vector<uint8_t> m_buffer;
+	size_t m_bufferSize;
+	size_t m_written;
+	std::shared_ptr<Adapter> m_adapter;
+	int m_openEnded;
+};
+
+#endif /* _CBORWRITER_H */
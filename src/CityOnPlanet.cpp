@@ -380,11 +380,14 @@ void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustu
 		++uCount;
 	}
 
-	// render the building models using instancing
+	// render the building models using instancing, queued so that the buildings
+	// sharing programs and textures are drawn together
+	r->BeginQueue();
 	for (Uint32 i = 0; i < s_buildingList.numBuildings; i++) {
 		if (!transform[i].empty())
 			s_buildingList.buildings[i].resolvedModel->Render(transform[i]);
 	}
+	r->EndQueue();
 
 	r->GetStats().AddToStatCount(Graphics::Stats::STAT_BUILDINGS, uCount);
 	r->GetStats().AddToStatCount(Graphics::Stats::STAT_CITIES, 1);
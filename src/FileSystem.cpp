@@ -283,6 +283,17 @@ namespace FileSystem {
 		return RefCountedPtr<FileData>();
 	}
 
+	RefCountedPtr<FileData> FileSourceUnion::MapFile(const std::string &path)
+	{
+		for (FileSource *fs : m_sources) {
+			RefCountedPtr<FileData> data = fs->MapFile(path);
+			if (data) {
+				return data;
+			}
+		}
+		return RefCountedPtr<FileData>();
+	}
+
 	// Merge two sets of FileInfo's, by path.
 	// Input vectors must be sorted. Output will be sorted.
 	// Where a path is present in both inputs, directories are selected
@@ -110,6 +110,8 @@ namespace FileSystem {
 		const FileSource &GetSource() const { return *m_source; }
 
 		RefCountedPtr<FileData> Read() const;
+		// like Read(), but maps the file into memory where the source can
+		RefCountedPtr<FileData> Map() const;
 
 		friend bool operator==(const FileInfo &a, const FileInfo &b)
 		{
@@ -206,6 +208,11 @@ namespace FileSystem {
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path) = 0;
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output) = 0;
 
+		// Maps the file into memory rather than reading it, which is quicker for
+		// large files where only some of the data is looked at. Sources that can't
+		// map files read them instead.
+		virtual RefCountedPtr<FileData> MapFile(const std::string &path) { return ReadFile(path); }
+
 		bool IsTrusted() const { return m_trusted; }
 
 	protected:
@@ -225,6 +232,7 @@ namespace FileSystem {
 		virtual FileInfo Lookup(const std::string &path);
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path);
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output);
+		virtual RefCountedPtr<FileData> MapFile(const std::string &path);
 
 		bool MakeDirectory(const std::string &path);
 
@@ -236,6 +244,11 @@ namespace FileSystem {
 		FILE *OpenReadStream(const std::string &path);
 		// similar to fopen(path, "wb")
 		FILE *OpenWriteStream(const std::string &path, int flags = 0);
+
+		// moves a file, replacing anything already at the destination
+		bool RenameFile(const std::string &from, const std::string &to);
+		// deletes a file, not a directory
+		bool RemoveFile(const std::string &path);
 	};
 
 	class FileSourceUnion : public FileSource {
@@ -254,6 +267,7 @@ namespace FileSystem {
 		std::vector<FileInfo> LookupAll(const std::string &path);
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path);
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output);
+		virtual RefCountedPtr<FileData> MapFile(const std::string &path);
 
 	private:
 		std::vector<FileSource *> m_sources;
@@ -305,4 +319,9 @@ inline RefCountedPtr<FileSystem::FileData> FileSystem::FileInfo::Read() const
 	return m_source->ReadFile(m_path);
 }
 
+inline RefCountedPtr<FileSystem::FileData> FileSystem::FileInfo::Map() const
+{
+	return m_source->MapFile(m_path);
+}
+
 #endif
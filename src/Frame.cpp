@@ -2,6 +2,7 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "Frame.h"
+#include "CborWriter.h"
 
 #include "GameSaveError.h"
 #include "JsonUtils.h"
@@ -129,12 +130,13 @@ Frame &Frame::operator=(Frame &&other)
 	return *this;
 }
 
-void Frame::ToJson(Json &frameObj, FrameId fId, Space *space)
+void Frame::ToCbor(CborWriter &writer, FrameId fId, Space *space)
 {
 	Frame *f = Frame::GetFrame(fId);
 
 	assert(f != nullptr);
 
+	Json frameObj = Json::object();
 	frameObj["frameId"] = f->m_thisId;
 	frameObj["flags"] = f->m_flags;
 	frameObj["radius"] = f->m_radius;
@@ -145,17 +147,19 @@ void Frame::ToJson(Json &frameObj, FrameId fId, Space *space)
 	frameObj["index_for_system_body"] = space->GetIndexForSystemBody(f->m_sbody);
 	frameObj["index_for_astro_body"] = space->GetIndexForBody(f->m_astroBody);
 
-	Json childFrameArray = Json::array(); // Create JSON array to contain child frame data.
-	for (FrameId kid : f->GetChildren()) {
-		Json childFrameArrayEl = Json::object(); // Create JSON object to contain child frame.
-		Frame::ToJson(childFrameArrayEl, kid, space);
-		childFrameArray.push_back(childFrameArrayEl); // Append child frame object to array.
-	}
-	if (!childFrameArray.empty())
-		frameObj["child_frames"] = childFrameArray; // Add child frame array to frame object.
-
-	// Add sfx array to supplied object.
+	// Add sfx array to frame object.
 	SfxManager::ToJson(frameObj, f->m_thisId);
+
+	writer.BeginObject(frameObj.size() + (f->m_children.empty() ? 0 : 1));
+	writer.Fields(frameObj);
+
+	// Child frames go straight to the writer rather than into the frame object.
+	if (!f->m_children.empty()) {
+		writer.Key("child_frames");
+		writer.BeginArray(f->m_children.size());
+		for (FrameId kid : f->m_children)
+			Frame::ToCbor(writer, kid, space);
+	}
 }
 
 Frame::~Frame()
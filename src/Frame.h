@@ -15,6 +15,7 @@
 #include <string>
 
 class Body;
+class CborWriter;
 class CollisionSpace;
 class Geom;
 class SystemBody;
@@ -54,7 +55,8 @@ public:
 	static FrameId CreateCameraFrame(FrameId parent);
 	static void DeleteCameraFrame(FrameId camera);
 
-	static void ToJson(Json &jsonObj, FrameId fId, Space *space);
+	// writes the frame and all its children straight to the save stream
+	static void ToCbor(CborWriter &writer, FrameId fId, Space *space);
 	static void PostUnserializeFixup(FrameId fId, Space *space);
 
 	static void DeleteFrames();
@@ -6,14 +6,19 @@
 #include "Game.h"
 
 #include "Body.h"
+#include "CborWriter.h"
 #include "DeathView.h"
 #include "FileSystem.h"
+#include "GameConfig.h"
 #include "GameLog.h"
 #include "GameSaveError.h"
+#include "GameSaveHeader.h"
 #include "HyperspaceCloud.h"
+#include "Lang.h"
 #include "MathUtil.h"
 #include "collider/CollisionSpace.h"
 #include "core/GZipFormat.h"
+#include "core/LZ4Format.h"
 #include "galaxy/Economy.h"
 #include "lua/LuaEvent.h"
 #include "lua/LuaSerializer.h"
@@ -27,14 +32,26 @@
 #include "ShipCpanel.h"
 #include "Space.h"
 #include "SpaceStation.h"
+#include "StringF.h"
 #include "SystemInfoView.h"
 #include "SystemView.h"
 #include "WorldView.h"
 #include "galaxy/GalaxyGenerator.h"
 #include "pigui/PiGuiView.h"
 #include "ship/PlayerShipController.h"
+#include <atomic>
 
-static const int s_saveVersion = 87;
+static const int s_saveVersion = 91;
+
+// Versions 88 to 91 changed how the same game state is encoded (streamed CBOR,
+// the binary Lua pickle, the uncompressed header and LZ4), not what's in it,
+// and the loader still understands each of the older encodings.
+static const int s_oldestSaveVersion = 87;
+
+static bool IsLoadableSaveVersion(const Json &version)
+{
+	return version.is_number_integer() && version.get<int>() >= s_oldestSaveVersion && version.get<int>() <= s_saveVersion;
+}
 
 Game::Game(const SystemPath &path, const double startDateTime) :
 	m_galaxy(GalaxyGenerator::Create()),
@@ -125,8 +142,8 @@ Game::Game(const Json &jsonObj) :
 	try {
 		int version = jsonObj["version"];
 		Output("savefile version: %d\n", version);
-		if (version != s_saveVersion) {
-			Output("can't load savefile, expected version: %d\n", s_saveVersion);
+		if (!IsLoadableSaveVersion(jsonObj["version"])) {
+			Output("can't load savefile, expected version: %d to %d\n", s_oldestSaveVersion, s_saveVersion);
 			throw SavedGameWrongVersionException();
 		}
 	} catch (Json::type_error &) {
@@ -176,17 +193,26 @@ Game::Game(const Json &jsonObj) :
 
 	Pi::luaSerializer->UninitTableRefs();
 
+	// unpickling made a lot of garbage with no frames to step the collector
+	Lua::manager->CollectGarbage();
+
 	EmitPauseState(IsPaused());
 
 	Pi::RequestProfileFrame("LoadGame");
 }
 
-void Game::ToJson(Json &jsonObj)
+void Game::ToCbor(CborWriter &writer)
 {
 	PROFILE_SCOPED()
 	// preparing the lua serializer
 	Pi::luaSerializer->InitTableRefs();
 
+	// The root object is written out a section at a time, so its size isn't known up front.
+	// Small sections are collected in jsonObj and flushed before each large one.
+	writer.BeginObject();
+
+	Json jsonObj = Json::object();
+
 	// version
 	jsonObj["version"] = s_saveVersion;
 
@@ -208,8 +234,12 @@ void Game::ToJson(Json &jsonObj)
 	bool have_cam_frame = m_gameViews->m_worldView->GetCameraContext()->GetTempFrame().valid();
 	if (have_cam_frame) m_gameViews->m_worldView->EndCameraFrame();
 
+	writer.Fields(jsonObj);
+	jsonObj = Json::object();
+
 	// space, all the bodies and things
-	m_space->ToJson(jsonObj);
+	writer.Key("space");
+	m_space->ToCbor(writer);
 	jsonObj["player"] = m_space->GetIndexForBody(m_player.get());
 
 	// hyperspace clouds being brought over from the previous system
@@ -226,11 +256,26 @@ void Game::ToJson(Json &jsonObj)
 	m_gameViews->m_sectorView->SaveToJson(jsonObj);
 	m_gameViews->m_worldView->SaveToJson(jsonObj);
 
+	writer.Fields(jsonObj);
+
 	// lua
-	Pi::luaSerializer->ToJson(jsonObj);
+	Pi::luaSerializer->ToCbor(writer);
+
+	writer.Key("game_info");
+	writer.Value(GameInfoToJson());
+
+	writer.End();
 
-	// Stuff to show in the preview in load game window
-	// some may be redundant, but this won't require loading up a game to get it all
+	Pi::luaSerializer->UninitTableRefs();
+
+	// Bring back camera frame:
+	if (have_cam_frame) m_gameViews->m_worldView->BeginCameraFrame();
+}
+
+// Stuff to show in the preview in load game window
+// some may be redundant, but this won't require loading up a game to get it all
+Json Game::GameInfoToJson()
+{
 	Json gameInfo = Json::object();
 	float credits = LuaObject<Player>::CallMethod<float>(Pi::player, "GetMoney");
 
@@ -268,12 +313,16 @@ void Game::ToJson(Json &jsonObj)
 		break;
 	}
 
-	jsonObj["game_info"] = gameInfo;
-
-	Pi::luaSerializer->UninitTableRefs();
+	return gameInfo;
+}
 
-	// Bring back camera frame:
-	if (have_cam_frame) m_gameViews->m_worldView->BeginCameraFrame();
+Json Game::SaveHeaderToJson()
+{
+	Json header = Json::object();
+	header["version"] = s_saveVersion;
+	header["time"] = m_time;
+	header["game_info"] = GameInfoToJson();
+	return header;
 }
 
 void Game::TimeStep(float step)
@@ -884,13 +933,24 @@ Json Game::LoadGameToJson(const std::string &filename)
 		Output("Loading saved game '%s' failed.\n", filename.c_str());
 		throw SavedGameCorruptException();
 	}
-	if (!rootNode["version"].is_number_integer() || rootNode["version"].get<int>() != s_saveVersion) {
+	if (!IsLoadableSaveVersion(rootNode["version"])) {
 		Output("Loading saved game '%s' failed: wrong save file version.\n", filename.c_str());
 		throw SavedGameCorruptException();
 	}
 	return rootNode;
 }
 
+bool Game::LoadGameHeader(const std::string &filename, Json &header)
+{
+	if (!GameSaveHeader::Get(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename), header))
+		return false;
+	if (!IsLoadableSaveVersion(header["version"])) {
+		Output("Reading saved game '%s' failed: wrong save file version.\n", filename.c_str());
+		throw SavedGameCorruptException();
+	}
+	return true;
+}
+
 Game *Game::LoadGame(const std::string &filename)
 {
 	Output("Game::LoadGame('%s')\n", filename.c_str());
@@ -916,45 +976,265 @@ bool Game::CanLoadGame(const std::string &filename)
 	// file data is freed here
 }
 
-void Game::SaveGame(const std::string &filename, Game *game)
-{
-	PROFILE_SCOPED()
-	assert(game);
-
-	if (game->IsHyperspace())
-		throw CannotSaveInHyperspace();
+namespace {
+	// How saves are compressed, from the SaveCompression config option. Loading
+	// doesn't care: the format is recognised from the data.
+	enum class SaveCompression {
+		GZIP,		   // "gzip": deflated while the save is written, without holding all of it
+		GZIP_PARALLEL, // "gzip-mt": deflated in chunks on all cores; still plain gzip
+		LZ4,		   // "lz4": much faster to write and to load, but bigger
+		LZ4_HC,		   // "lz4hc": smaller than lz4 and as fast to load, but slower to write
+	};
 
-	if (game->GetPlayer()->IsDead())
-		throw CannotSaveDeadPlayer();
+	const int LZ4_FAST_PRESET = 0;
+	const int LZ4_HC_PRESET = 9;
 
-	if (!FileSystem::userFiles.MakeDirectory(Pi::SAVE_DIR_NAME)) {
-		throw CouldNotOpenFileException();
+	SaveCompression GetSaveCompression()
+	{
+		const std::string name = Pi::config->String("SaveCompression");
+		if (name == "gzip-mt") return SaveCompression::GZIP_PARALLEL;
+		if (name == "lz4") return SaveCompression::LZ4;
+		if (name == "lz4hc") return SaveCompression::LZ4_HC;
+		return SaveCompression::GZIP;
 	}
 
-	Json rootNode;
-	game->ToJson(rootNode); // Encode the game data as JSON and give to the root value.
-	std::vector<uint8_t> jsonData;
+	// Compresses a saved game into the save directory, after its uncompressed header.
+	// It is written to a temporary file first and only renamed into place by Commit(),
+	// so a failed save can't clobber an existing one; the temporary file is deleted if
+	// the save is never committed. Safe to use from a worker thread.
+	// Except with GZIP, the data is held until Commit() and compressed all at once.
+	class SaveFile {
+	public:
+		SaveFile(const std::string &filename, const Json &header, SaveCompression compression) :
+			m_path(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename)),
+			m_tmpPath(m_path + "." + std::to_string(++s_serial) + ".tmp"),
+			m_innerName(filename + ".json"),
+			m_compression(compression),
+			m_file(FileSystem::userFiles.OpenWriteStream(m_tmpPath)),
+			m_committed(false)
+		{
+			if (!m_file) throw CouldNotOpenFileException();
+			if (!GameSaveHeader::Write(m_file, header)) {
+				Abandon();
+				throw CouldNotWriteToFileException();
+			}
+			if (m_compression == SaveCompression::GZIP) {
+				try {
+					m_compressor.reset(new gzip::GZipFileWriter(m_file, m_innerName));
+				} catch (gzip::GZipException) {
+					Abandon();
+					throw CouldNotWriteToFileException();
+				}
+			}
+		}
+
+		~SaveFile()
+		{
+			if (!m_committed)
+				Abandon();
+		}
+
+		const std::string &GetPath() const { return m_path; }
+
+		void Write(const uint8_t *data, size_t length)
+		{
+			if (!m_compressor) {
+				m_data.insert(m_data.end(), data, data + length);
+				return;
+			}
+			try {
+				m_compressor->Write(data, length);
+			} catch (gzip::GZipException) {
+				throw CouldNotWriteToFileException();
+			}
+		}
+
+		// the same, but takes the data over rather than copying it if it's going to be held anyway
+		void Write(std::vector<uint8_t> &&data)
+		{
+			if (!m_compressor && m_data.empty())
+				m_data.swap(data);
+			else
+				Write(data.data(), data.size());
+		}
+
+		void Commit()
+		{
+			if (m_compressor) {
+				try {
+					m_compressor->Finish();
+				} catch (gzip::GZipException) {
+					throw CouldNotWriteToFileException();
+				}
+			} else {
+				const std::string compressed = Compress();
+				std::vector<uint8_t>().swap(m_data);
+				if (fwrite(compressed.data(), compressed.size(), 1, m_file) != 1)
+					throw CouldNotWriteToFileException();
+			}
+			const bool closed = fclose(m_file) == 0;
+			m_file = nullptr;
+			if (!closed || !FileSystem::userFiles.RenameFile(m_tmpPath, m_path))
+				throw CouldNotWriteToFileException();
+			m_committed = true;
+		}
+
+	private:
+		void Abandon()
+		{
+			m_compressor.reset();
+			if (m_file) fclose(m_file);
+			m_file = nullptr;
+			FileSystem::userFiles.RemoveFile(m_tmpPath);
+		}
+
+		std::string Compress() const
+		{
+			PROFILE_SCOPED()
+			try {
+				// this usually runs as a job itself, so take no more threads than
+				// the job queue has runners
+				if (m_compression == SaveCompression::GZIP_PARALLEL)
+					return gzip::CompressGZipParallel(m_data.data(), m_data.size(), m_innerName, Pi::GetAsyncJobQueue()->GetNumRunners());
+
+				const lz4::string_view data(reinterpret_cast<const char *>(m_data.data()), m_data.size());
+				return lz4::CompressLZ4(data, m_compression == SaveCompression::LZ4_HC ? LZ4_HC_PRESET : LZ4_FAST_PRESET);
+			} catch (gzip::GZipException) {
+				throw CouldNotWriteToFileException();
+			} catch (lz4::CompressionFailedException &) {
+				throw CouldNotWriteToFileException();
+			}
+		}
+
+		static std::atomic<Uint32> s_serial;
+
+		const std::string m_path;
+		const std::string m_tmpPath;
+		const std::string m_innerName;
+		const SaveCompression m_compression;
+		FILE *m_file;
+		bool m_committed;
+		std::unique_ptr<gzip::GZipFileWriter> m_compressor;
+		std::vector<uint8_t> m_data;
+	};
+
+	std::atomic<Uint32> SaveFile::s_serial(0);
+
+	// Compresses and writes a captured save on a worker thread, then reports back through Lua events.
+	class SaveGameJob : public Job {
+	public:
+		SaveGameJob(const std::string &filename, Json &&header, std::vector<uint8_t> &&data, SaveCompression compression) :
+			m_filename(filename),
+			m_header(std::move(header)),
+			m_data(std::move(data)),
+			m_compression(compression) {}
+
+		virtual void OnRun() override
+		{
+			PROFILE_SCOPED()
+			try {
+				SaveFile file(m_filename, m_header, m_compression);
+				file.Write(std::move(m_data));
+				file.Commit();
+			} catch (CouldNotOpenFileException) {
+				const std::string path = FileSystem::JoinPathBelow(Pi::GetSaveDir(), m_filename);
+				m_error = stringf(Lang::COULD_NOT_OPEN_FILENAME, formatarg("path", path));
+			} catch (CouldNotWriteToFileException) {
+				m_error = Lang::GAME_SAVE_CANNOT_WRITE;
+			}
+			std::vector<uint8_t>().swap(m_data);
+		}
+
+		virtual void OnFinish() override
+		{
+			GameSaveHeader::Forget(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, m_filename));
+			if (m_error.empty())
+				LuaEvent::Queue("onGameSaved", m_filename);
+			else
+				LuaEvent::Queue("onGameSaveFailed", m_filename, m_error);
+		}
+
+	private:
+		const std::string m_filename;
+		const Json m_header;
+		std::vector<uint8_t> m_data;
+		const SaveCompression m_compression;
+		std::string m_error;
+	};
+
+	// Saves still being written; kept here rather than in the Game so that a save
+	// started just before the game ends still gets finished. Game::FinishSaves()
+	// empties it before the job queue it uses is destroyed.
+	std::unique_ptr<JobSet> s_saveJobs;
+
+	void CheckCanSave(Game *game)
 	{
-		PROFILE_SCOPED_DESC("json.to_cbor");
-		jsonData = Json::to_cbor(rootNode); // Convert the JSON data to CBOR.
-	}
+		assert(game);
 
-	FileSystem::userFiles.MakeDirectory(Pi::SAVE_DIR_NAME);
-	FILE *f = FileSystem::userFiles.OpenWriteStream(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename));
-	if (!f) throw CouldNotOpenFileException();
+		if (game->IsHyperspace())
+			throw CannotSaveInHyperspace();
 
-	try {
-		// Compress the CBOR data.
-		const std::string comressed_data = gzip::CompressGZip(
-			std::string(reinterpret_cast<const char *>(jsonData.data()), jsonData.size()),
-			filename + ".json");
-		size_t nwritten = fwrite(comressed_data.data(), comressed_data.size(), 1, f);
-		fclose(f);
-		if (nwritten != 1) throw CouldNotWriteToFileException();
-	} catch (gzip::CompressionFailedException) {
-		fclose(f);
-		throw CouldNotWriteToFileException();
+		if (game->GetPlayer()->IsDead())
+			throw CannotSaveDeadPlayer();
+
+		if (!FileSystem::userFiles.MakeDirectory(Pi::SAVE_DIR_NAME)) {
+			throw CouldNotOpenFileException();
+		}
 	}
+} // namespace
+
+void Game::SaveGame(const std::string &filename, Game *game)
+{
+	PROFILE_SCOPED()
+	CheckCanSave(game);
+
+	// With gzip, the CBOR data is compressed as it is produced, without building it all in memory first.
+	SaveFile file(filename, game->SaveHeaderToJson(), GetSaveCompression());
+	CborWriter writer([&file](const uint8_t *data, size_t length) {
+		file.Write(data, length);
+	});
+	game->ToCbor(writer);
+	writer.Flush();
+	file.Commit();
+	GameSaveHeader::Forget(file.GetPath());
 
 	Pi::RequestProfileFrame("SaveGame");
 }
+
+void Game::SaveGameAsync(const std::string &filename, Game *game)
+{
+	PROFILE_SCOPED()
+	CheckCanSave(game);
+
+	// Encoding has to happen here, while the game state can't change under it, but
+	// a CBOR snapshot is much cheaper to capture than compressing and writing it.
+	std::vector<uint8_t> data;
+	CborWriter writer([&data](const uint8_t *bytes, size_t length) {
+		data.insert(data.end(), bytes, bytes + length);
+	});
+	game->ToCbor(writer);
+	writer.Flush();
+
+	if (!s_saveJobs)
+		s_saveJobs.reset(new JobSet(Pi::GetAsyncJobQueue()));
+	s_saveJobs->Order(new SaveGameJob(filename, game->SaveHeaderToJson(), std::move(data), GetSaveCompression()));
+}
+
+bool Game::IsSaving()
+{
+	return s_saveJobs && !s_saveJobs->IsEmpty();
+}
+
+void Game::FinishSaves()
+{
+	PROFILE_SCOPED()
+	if (!s_saveJobs)
+		return;
+
+	while (!s_saveJobs->IsEmpty()) {
+		s_saveJobs->GetQueue()->FinishJobs();
+		if (!s_saveJobs->IsEmpty())
+			SDL_Delay(1);
+	}
+	s_saveJobs.reset();
+}
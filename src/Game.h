@@ -10,6 +10,7 @@
 #include "gameconsts.h"
 #include <string>
 
+class CborWriter;
 class GameLog;
 class HyperspaceCloud;
 class Player;
@@ -40,12 +41,24 @@ class ObjectViewerView;
 class Game {
 public:
 	static Json LoadGameToJson(const std::string &filename);
+	// reads just the header of a saved game (version, time and game_info) without
+	// loading the rest; returns false for older saves that don't have one
+	static bool LoadGameHeader(const std::string &filename, Json &header);
 	// LoadGame and SaveGame throw exceptions on failure
 	static Game *LoadGame(const std::string &filename);
 	static bool CanLoadGame(const std::string &filename);
 	// XXX game arg should be const, and this should probably be a member function
 	// (or LoadGame/SaveGame should be somewhere else entirely)
 	static void SaveGame(const std::string &filename, Game *game);
+	// Like SaveGame, but only captures the game state before returning; compressing and
+	// writing the file happen on a worker thread. Queues the onGameSaved(filename) or
+	// onGameSaveFailed(filename, message) Lua event when the file is done.
+	static void SaveGameAsync(const std::string &filename, Game *game);
+	// whether any SaveGameAsync is still being written
+	static bool IsSaving();
+	// Waits for the saves still being written to finish, and lets go of their job set.
+	// Call before the async job queue goes away.
+	static void FinishSaves();
 
 	// start docked in station referenced by path or nearby to body if it is no station
 	Game(const SystemPath &path, const double startDateTime = 0.0);
@@ -55,8 +68,10 @@ public:
 
 	~Game();
 
-	// save game
-	void ToJson(Json &jsonObj);
+	// save game; writes the root object of the save file, section by section
+	void ToCbor(CborWriter &writer);
+	// the header written ahead of the compressed save
+	Json SaveHeaderToJson();
 
 	// various game states
 	bool IsNormalSpace() const { return m_state == State::NORMAL; }
@@ -152,6 +167,9 @@ private:
 		ObjectViewerView *m_objectViewerView;
 	};
 
+	// what the load game window shows about the save
+	Json GameInfoToJson();
+
 	void CreateViews();
 	void LoadViewsFromJson(const Json &jsonObj);
 	void DestroyViews();
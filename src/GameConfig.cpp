@@ -49,6 +49,10 @@ GameConfig::GameConfig(const map_string &override_)
 	map["EnableGLDebug"] = "0";
 	map["EnableGPUJobs"] = "1";
 	map["GL3ForwardCompatible"] = "1";
+	map["LuaFramePacedGC"] = "1";
+	map["LuaGCStepBudget"] = "1.0"; // ms per frame
+	map["SaveCompression"] = "gzip"; // gzip, gzip-mt, lz4 or lz4hc
+	map["ModelCacheBudget"] = "256"; // MB of model geometry kept loaded
 
 	Read(FileSystem::userFiles, "config.ini");
 
@@ -0,0 +1,118 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "GameSaveHeader.h"
+#include "DateTime.h"
+#include "FileSystem.h"
+#include "GameSaveError.h"
+#include <cstring>
+#include <map>
+
+namespace {
+	const char MAGIC[8] = { 'P', 'I', 'O', 'N', 'S', 'A', 'V', 'E' };
+	const size_t PREFIX_SIZE = sizeof(MAGIC) + 4;
+
+	// much bigger than any real header; anything larger is garbage
+	const uint32_t MAX_HEADER_SIZE = 1024 * 1024;
+
+	uint32_t GetHeaderLength(const uint8_t *prefix)
+	{
+		if (memcmp(prefix, MAGIC, sizeof(MAGIC)) != 0)
+			return 0;
+		const uint8_t *p = prefix + sizeof(MAGIC);
+		return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+	}
+
+	struct IndexEntry {
+		Time::DateTime modTime;
+		bool hasHeader;
+		Json header;
+	};
+
+	std::map<std::string, IndexEntry> s_index;
+} // namespace
+
+namespace GameSaveHeader {
+
+	bool Write(FILE *f, const Json &header)
+	{
+		const std::vector<uint8_t> cbor = Json::to_cbor(header);
+		const uint32_t length = cbor.size();
+
+		uint8_t prefix[PREFIX_SIZE];
+		memcpy(prefix, MAGIC, sizeof(MAGIC));
+		for (int i = 0; i < 4; i++)
+			prefix[sizeof(MAGIC) + i] = uint8_t(length >> (8 * i));
+
+		return fwrite(prefix, sizeof(prefix), 1, f) == 1 &&
+			fwrite(cbor.data(), cbor.size(), 1, f) == 1;
+	}
+
+	size_t GetSize(const uint8_t *data, size_t size)
+	{
+		if (size < PREFIX_SIZE)
+			return 0;
+		const uint32_t length = GetHeaderLength(data);
+		if (!length || length > size - PREFIX_SIZE)
+			return 0;
+		return PREFIX_SIZE + length;
+	}
+
+	bool Get(const std::string &path, Json &header)
+	{
+		const FileSystem::FileInfo info = FileSystem::userFiles.Lookup(path);
+		if (!info.IsFile())
+			throw CouldNotOpenFileException();
+
+		auto it = s_index.find(path);
+		if (it != s_index.end() && it->second.modTime == info.GetModificationTime()) {
+			header = it->second.header;
+			return it->second.hasHeader;
+		}
+
+		FILE *f = FileSystem::userFiles.OpenReadStream(path);
+		if (!f)
+			throw CouldNotOpenFileException();
+
+		IndexEntry entry;
+		entry.modTime = info.GetModificationTime();
+		entry.hasHeader = false;
+
+		uint8_t prefix[PREFIX_SIZE];
+		if (fread(prefix, sizeof(prefix), 1, f) == 1) {
+			const uint32_t length = GetHeaderLength(prefix);
+			if (length) {
+				if (length > MAX_HEADER_SIZE) {
+					fclose(f);
+					throw SavedGameCorruptException();
+				}
+				std::vector<uint8_t> cbor(length);
+				const bool complete = fread(cbor.data(), length, 1, f) == 1;
+				fclose(f);
+				f = nullptr;
+				try {
+					if (!complete) throw SavedGameCorruptException();
+					entry.header = Json::from_cbor(cbor);
+				} catch (Json::parse_error &) {
+					throw SavedGameCorruptException();
+				}
+				if (!entry.header.is_object())
+					throw SavedGameCorruptException();
+				entry.hasHeader = true;
+			}
+		}
+		if (f)
+			fclose(f);
+
+		const bool hasHeader = entry.hasHeader;
+		header = entry.header;
+		s_index[path] = std::move(entry);
+		return hasHeader;
+	}
+
+	void Forget(const std::string &path)
+	{
+		s_index.erase(path);
+	}
+
+} // namespace GameSaveHeader
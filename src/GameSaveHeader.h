@@ -0,0 +1,39 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef GAME_SAVE_HEADER_H
+#define GAME_SAVE_HEADER_H
+
+#include "Json.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/* A saved game starts with a small uncompressed header holding what the load
+   menu shows: the save version, the game time and the game_info object. It
+   is followed by the compressed game state, so the header can be read
+   without decompressing or decoding anything else.
+
+   The header block is an 8 byte magic string, the length of the header as a
+   32 bit little-endian integer, and the header itself as CBOR. Saves from
+   before the header was added start straight away with the compressed data.
+*/
+namespace GameSaveHeader {
+	// writes the header block; false if it couldn't be written
+	bool Write(FILE *f, const Json &header);
+
+	// the size of the header block at the start of a save, or 0 if it doesn't have one
+	size_t GetSize(const uint8_t *data, size_t size);
+
+	// reads the header of a save, given its path in the user folder. returns
+	// false if the save doesn't have one. throws CouldNotOpenFileException if
+	// there's no such file and SavedGameCorruptException if the header is
+	// damaged. Headers are kept in an index by path, and read again once the
+	// file's modification time changes.
+	bool Get(const std::string &path, Json &header);
+
+	// drops a file from the index, for when it has just been written
+	void Forget(const std::string &path);
+} // namespace GameSaveHeader
+
+#endif
@@ -128,6 +128,9 @@ public:
 	// and then delete all finished and cancelled jobs. returns the number of
 	// finished jobs (not cancelled)
 	virtual Uint32 FinishJobs() = 0;
+
+	// number of jobs that may be running at the same time
+	virtual Uint32 GetNumRunners() const = 0;
 };
 
 // the queue management class. create one from the main thread, and feed your
@@ -160,6 +163,8 @@ public:
 	// finished jobs (not cancelled)
 	virtual Uint32 FinishJobs() override;
 
+	virtual Uint32 GetNumRunners() const override { return m_runners.size(); }
+
 private:
 	// a runner wraps a single thread, and calls into the queue when its ready for
 	// a new job. no user-servicable parts inside!
@@ -228,6 +233,8 @@ public:
 	// finished jobs (not cancelled)
 	virtual Uint32 FinishJobs() override;
 
+	virtual Uint32 GetNumRunners() const override { return 1; }
+
 	Uint32 RunJobs(Uint32 count = 1);
 
 private:
@@ -269,6 +276,7 @@ public:
 	virtual void RemoveJob(Job::Handle *handle) { m_jobs.erase(*handle); }
 
 	bool IsEmpty() const { return m_jobs.empty(); }
+	JobQueue *GetQueue() const { return m_queue; }
 
 private:
 	JobQueue *m_queue;
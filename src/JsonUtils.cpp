@@ -7,8 +7,10 @@
 
 #include "JsonUtils.h"
 #include "FileSystem.h"
+#include "GameSaveHeader.h"
 #include "base64/base64.hpp"
 #include "core/GZipFormat.h"
+#include "core/LZ4Format.h"
 #include "utils.h"
 #include <cmath>
 
@@ -79,15 +81,11 @@ namespace JsonUtils {
 	{
 		auto file = source.ReadFile(filename);
 		if (!file) return nullptr;
-		const auto file_data = std::string(file->GetData(), file->GetSize());
-		const unsigned char *dataPtr = reinterpret_cast<const unsigned char *>(&file_data[0]);
+		// newer saves start with an uncompressed header, which is left to GameSaveHeader
+		const unsigned char *dataPtr = reinterpret_cast<const unsigned char *>(file->GetData());
+		const size_t header_size = GameSaveHeader::GetSize(dataPtr, file->GetSize());
 		try {
-			std::string plain_data;
-			if (gzip::IsGZipFormat(dataPtr, file_data.size())) {
-				plain_data = gzip::DecompressDeflateOrGZip(dataPtr, file_data.size());
-			} else {
-				plain_data = file_data;
-			}
+			const std::string plain_data = DecompressSaveData(dataPtr + header_size, file->GetSize() - header_size);
 
 			Json rootNode;
 			try {
@@ -102,8 +100,21 @@ namespace JsonUtils {
 			}
 		} catch (gzip::DecompressionFailedException) {
 			return nullptr;
+		} catch (lz4::DecompressionFailedException &e) {
+			Output("error in lz4 file '%s': %s\n", file->GetInfo().GetPath().c_str(), e.what());
+			return nullptr;
 		}
 	}
+
+	std::string DecompressSaveData(const unsigned char *data, size_t length)
+	{
+		PROFILE_SCOPED()
+		if (gzip::IsGZipFormat(data, length))
+			return gzip::DecompressDeflateOrGZip(data, length);
+		if (lz4::IsLZ4Format(reinterpret_cast<const char *>(data), length))
+			return lz4::DecompressLZ4(lz4::string_view(reinterpret_cast<const char *>(data), length));
+		return std::string(reinterpret_cast<const char *>(data), length);
+	}
 } // namespace JsonUtils
 
 #define USE_STRING_VERSIONS
@@ -27,8 +27,12 @@ namespace JsonUtils {
 	// Load a JSON file from the game's data sources, optionally applying all
 	// files with the the name <filename>.patch as Json Merge Patch (RFC 7386) files
 	Json LoadJsonDataFile(const std::string &filename, bool with_merge = true);
-	// Loads an optionally-gzipped, optionally-CBOR encoded JSON file from the specified source.
+	// Loads an optionally-compressed (gzip or lz4), optionally-CBOR encoded JSON file from the specified source.
 	Json LoadJsonSaveFile(const std::string &filename, FileSystem::FileSource &source);
+	// Decompresses the data following a saved game's header, telling gzip and lz4 apart by
+	// their magic bytes; anything else is returned unchanged. Throws
+	// gzip::DecompressionFailedException or lz4::DecompressionFailedException.
+	std::string DecompressSaveData(const unsigned char *data, size_t length);
 } // namespace JsonUtils
 
 // To-JSON functions. These are called explicitly, and are passed a reference to the object to fill.
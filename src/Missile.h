@@ -23,6 +23,7 @@ public:
 	virtual void NotifyRemoved(const Body *const removedBody) override;
 	virtual void PostLoadFixup(Space *space) override;
 	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform) override;
+	virtual bool IsModelInstanceable() const override { return !IsDead(); }
 	void ECMAttack(int power_val);
 	Body *GetOwner() const { return m_owner; }
 	bool IsArmed() const { return m_armed; }
@@ -7,6 +7,7 @@
 #include "Frame.h"
 #include "GameSaveError.h"
 #include "Json.h"
+#include "ModelCache.h"
 #include "Pi.h"
 #include "Planet.h"
 #include "Shields.h"
@@ -67,14 +68,16 @@ ModelBody::ModelBody() :
 	m_isStatic(false),
 	m_colliding(true),
 	m_geom(nullptr),
-	m_model(nullptr)
+	m_model(nullptr),
+	m_modelAcquired(false)
 {
 }
 
 ModelBody::ModelBody(const Json &jsonObj, Space *space) :
 	Body(jsonObj, space),
 	m_geom(nullptr),
-	m_model(nullptr)
+	m_model(nullptr),
+	m_modelAcquired(false)
 {
 	Json modelBodyObj = jsonObj["model_body"];
 
@@ -96,7 +99,7 @@ ModelBody::~ModelBody()
 	DeleteGeoms();
 
 	//delete instanced model
-	delete m_model;
+	ReleaseModel();
 }
 
 void ModelBody::SaveToJson(Json &jsonObj, Space *space)
@@ -175,13 +178,18 @@ void ModelBody::RebuildCollisionMesh()
 void ModelBody::SetModel(const char *modelName)
 {
 	//remove old instance
-	delete m_model;
-	m_model = 0;
+	ReleaseModel();
 
 	m_modelName = modelName;
 
+	//the reference lets the cache evict the model once no body uses it
+	SceneGraph::Model *model = Pi::modelCache->AcquireModel(m_modelName);
+	m_modelAcquired = model != nullptr;
+	if (!model)
+		model = Pi::FindModel(m_modelName); // reports it, and gives the placeholder
+
 	//create model instance (some modelbodies, like missiles could avoid this)
-	m_model = Pi::FindModel(m_modelName)->MakeInstance();
+	m_model = model->MakeInstance();
 	m_idleAnimation = m_model->FindAnimation("idle");
 
 	SetClipRadius(m_model->GetDrawClipRadius());
@@ -191,6 +199,16 @@ void ModelBody::SetModel(const char *modelName)
 	RebuildCollisionMesh();
 }
 
+void ModelBody::ReleaseModel()
+{
+	delete m_model;
+	m_model = 0;
+
+	if (m_modelAcquired && Pi::modelCache)
+		Pi::modelCache->ReleaseModel(m_modelName);
+	m_modelAcquired = false;
+}
+
 void ModelBody::SetPosition(const vector3d &p)
 {
 	Body::SetPosition(p);
@@ -390,16 +408,29 @@ void ModelBody::CalcLighting(double &ambient, double &direct, const Camera *came
 void ModelBody::SetLighting(Graphics::Renderer *r, const Camera *camera, std::vector<Graphics::Light> &oldLights, Color &oldAmbient)
 {
 	std::vector<Graphics::Light> newLights;
+	Color ambient;
+	GetLighting(camera, newLights, ambient);
+
+	const std::vector<Camera::LightSource> &lightSources = camera->GetLightSources();
+	oldLights.reserve(lightSources.size());
+	for (size_t i = 0; i < lightSources.size(); i++)
+		oldLights.push_back(lightSources[i].GetLight());
+
+	oldAmbient = r->GetAmbientColor();
+	r->SetAmbientColor(ambient);
+	r->SetLights(newLights.size(), &newLights[0]);
+}
+
+void ModelBody::GetLighting(const Camera *camera, std::vector<Graphics::Light> &newLights, Color &ambientColor)
+{
 	double ambient, direct;
 	CalcLighting(ambient, direct, camera);
 	const std::vector<Camera::LightSource> &lightSources = camera->GetLightSources();
+	newLights.clear();
 	newLights.reserve(lightSources.size());
-	oldLights.reserve(lightSources.size());
 	for (size_t i = 0; i < lightSources.size(); i++) {
 		Graphics::Light light(lightSources[i].GetLight());
 
-		oldLights.push_back(light);
-
 		const float intensity = direct * camera->ShadowedIntensity(i, this);
 
 		Color c = light.GetDiffuse();
@@ -421,9 +452,7 @@ void ModelBody::SetLighting(Graphics::Renderer *r, const Camera *camera, std::ve
 		newLights.push_back(Graphics::Light(Graphics::Light::LIGHT_DIRECTIONAL, vector3f(0.f), Color::WHITE, Color::WHITE));
 	}
 
-	oldAmbient = r->GetAmbientColor();
-	r->SetAmbientColor(Color(ambient * 255, ambient * 255, ambient * 255));
-	r->SetLights(newLights.size(), &newLights[0]);
+	ambientColor = Color(ambient * 255, ambient * 255, ambient * 255);
 }
 
 void ModelBody::ResetLighting(Graphics::Renderer *r, const std::vector<Graphics::Light> &oldLights, const Color &oldAmbient)
@@ -441,6 +470,29 @@ void ModelBody::RenderModel(Graphics::Renderer *r, const Camera *camera, const v
 	if (setLighting)
 		SetLighting(r, camera, oldLights, oldAmbient);
 
+	const matrix4x4f trans = GetModelTransform(viewCoords, viewTransform);
+
+	m_model->UpdateAnimations();
+
+	const Camera::ModelGroup *group = camera->GetModelGroup(this);
+	if (!group) {
+		m_model->Render(trans);
+	} else {
+		// the first of the group to be drawn draws the solid geometry of them all
+		if (group->bodies.front() == this) {
+			m_model->RenderInstanced(group->transforms);
+			r->GetStats().AddToStatCount(Graphics::Stats::STAT_INSTANCED_MODELS, group->bodies.size());
+			r->GetStats().AddToStatCount(Graphics::Stats::STAT_MODEL_GROUPS, 1);
+		}
+		m_model->RenderUninstanced(trans);
+	}
+
+	if (setLighting)
+		ResetLighting(r, oldLights, oldAmbient);
+}
+
+matrix4x4f ModelBody::GetModelTransform(const vector3d &viewCoords, const matrix4x4d &viewTransform) const
+{
 	matrix4x4d m2 = GetInterpOrient();
 	m2.SetTranslate(GetInterpPosition());
 	matrix4x4d t = viewTransform * m2;
@@ -453,11 +505,7 @@ void ModelBody::RenderModel(Graphics::Renderer *r, const Camera *camera, const v
 	trans[13] = viewCoords.y;
 	trans[14] = viewCoords.z;
 	trans[15] = 1.0f;
-
-	m_model->Render(trans);
-
-	if (setLighting)
-		ResetLighting(r, oldLights, oldAmbient);
+	return trans;
 }
 
 void ModelBody::TimeStepUpdate(const float timestep)
@@ -466,5 +514,8 @@ void ModelBody::TimeStepUpdate(const float timestep)
 		// step animation by timestep/total length, loop to 0.0 if it goes >= 1.0
 		m_idleAnimation->SetProgress(fmod(m_idleAnimation->GetProgress() + timestep / m_idleAnimation->GetDuration(), 1.0));
 
-	m_model->UpdateAnimations();
+	// otherwise the animated transforms are only needed to draw the model, and
+	// RenderModel() catches up with them when it isn't culled
+	if (!m_dynGeoms.empty())
+		m_model->UpdateAnimations();
 }
@@ -6,7 +6,10 @@
 
 #include "Body.h"
 #include "CollMesh.h"
+#include "Color.h"
 #include "FrameId.h"
+#include "matrix4x4.h"
+#include <vector>
 
 class Shields;
 class Geom;
@@ -46,6 +49,17 @@ public:
 
 	void RenderModel(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform, const bool setLighting = true);
 
+	// Whether the model can be drawn instanced with others like it this frame
+	// (see Camera::GetModelGroup). Only bodies that draw their model with
+	// RenderModel() and its usual lighting, and nothing that depends on the
+	// body's own orientation, should say yes.
+	virtual bool IsModelInstanceable() const { return false; }
+
+	// the model's transform in camera space
+	matrix4x4f GetModelTransform(const vector3d &viewCoords, const matrix4x4d &viewTransform) const;
+	// the lights and ambient colour RenderModel() draws the model with
+	void GetLighting(const Camera *camera, std::vector<Graphics::Light> &lights, Color &ambient);
+
 	virtual void TimeStepUpdate(const float timeStep) override;
 
 protected:
@@ -64,6 +78,7 @@ private:
 	void MoveGeoms(const matrix4x4d &, const vector3d &);
 
 	void CalcLighting(double &ambient, double &direct, const Camera *camera);
+	void ReleaseModel();
 
 	bool m_isStatic;
 	bool m_colliding;
@@ -71,6 +86,7 @@ private:
 	Geom *m_geom; //static geom
 	std::string m_modelName;
 	SceneGraph::Model *m_model;
+	bool m_modelAcquired; // holds a reference to m_modelName in the model cache
 	std::vector<Geom *> m_dynGeoms;
 	SceneGraph::Animation *m_idleAnimation;
 	std::unique_ptr<Shields> m_shields;
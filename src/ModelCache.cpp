@@ -3,40 +3,378 @@
 
 #include "ModelCache.h"
 #include "Shields.h"
+#include "graphics/VertexBuffer.h"
+#include "scenegraph/BinaryConverter.h"
+#include "scenegraph/NodeVisitor.h"
 #include "scenegraph/SceneGraph.h"
+#include "utils.h"
+#include <SDL_mutex.h>
+#include <set>
 
-ModelCache::ModelCache(Graphics::Renderer *r) :
-	m_renderer(r)
+namespace {
+	// the vertex and index data in the model's meshes, which is most of what a
+	// model takes up; LODs and clones can share meshes, so each is counted once
+	class ModelSizeVisitor : public SceneGraph::NodeVisitor {
+	public:
+		ModelSizeVisitor() :
+			size(0) {}
+
+		virtual void ApplyStaticGeometry(SceneGraph::StaticGeometry &sg) override
+		{
+			for (unsigned int i = 0; i < sg.GetNumMeshes(); i++) {
+				const SceneGraph::StaticGeometry::Mesh &mesh = sg.GetMeshAt(i);
+				if (mesh.vertexBuffer.Valid() && m_buffers.insert(mesh.vertexBuffer.Get()).second) {
+					const Graphics::VertexBufferDesc &desc = mesh.vertexBuffer->GetDesc();
+					size += size_t(desc.numVertices) * desc.stride;
+				}
+				if (mesh.indexBuffer.Valid() && m_buffers.insert(mesh.indexBuffer.Get()).second)
+					size += size_t(mesh.indexBuffer->GetSize()) * sizeof(Uint32);
+			}
+		}
+
+		size_t size;
+
+	private:
+		std::set<const void *> m_buffers;
+	};
+} // namespace
+
+// A preload, shared with the job that reads it. Whichever thread claims it
+// first does the read; the main thread can claim it before the job runs.
+struct ModelCache::Request {
+	enum State {
+		WAITING, // not handed to the job queue yet
+		QUEUED,
+		READING,
+		DONE
+	};
+
+	Request(const std::string &name_, Priority priority_, Uint32 order_) :
+		name(name_),
+		priority(priority_),
+		order(order_),
+		found(false),
+		m_state(WAITING)
+	{
+		m_lock = SDL_CreateMutex();
+		m_doneCond = SDL_CreateCond();
+	}
+
+	~Request()
+	{
+		SDL_DestroyCond(m_doneCond);
+		SDL_DestroyMutex(m_lock);
+	}
+
+	State GetState()
+	{
+		SDL_LockMutex(m_lock);
+		const State state = m_state;
+		SDL_UnlockMutex(m_lock);
+		return state;
+	}
+
+	void SetQueued()
+	{
+		SDL_LockMutex(m_lock);
+		if (m_state == WAITING)
+			m_state = QUEUED;
+		SDL_UnlockMutex(m_lock);
+	}
+
+	// false if another thread has it already
+	bool Claim()
+	{
+		SDL_LockMutex(m_lock);
+		const bool claimed = m_state == WAITING || m_state == QUEUED;
+		if (claimed)
+			m_state = READING;
+		SDL_UnlockMutex(m_lock);
+		return claimed;
+	}
+
+	void Read() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+	{
+		found = SceneGraph::BinaryConverter::ReadModel(name, "models", dir, file, data);
+
+		SDL_LockMutex(m_lock);
+		m_state = DONE;
+		SDL_CondBroadcast(m_doneCond);
+		SDL_UnlockMutex(m_lock);
+	}
+
+	void Wait()
+	{
+		PROFILE_SCOPED()
+		SDL_LockMutex(m_lock);
+		while (m_state != DONE)
+			SDL_CondWait(m_doneCond, m_lock);
+		SDL_UnlockMutex(m_lock);
+	}
+
+	const std::string name;
+	Priority priority; // only touched by the main thread
+	const Uint32 order;
+
+	// the .sgm, uncompressed
+	ByteRange GetData() const { return data.empty() ? file->AsByteRange() : ByteRange(data.data(), data.size()); }
+
+	// filled in by Read(), and only to be looked at once it's DONE
+	bool found; // there's an .sgm, in dir
+	std::string dir;
+	RefCountedPtr<FileSystem::FileData> file;
+	std::string data; // what a compressed .sgm decompressed to
+
+private:
+	State m_state;
+	SDL_mutex *m_lock;
+	SDL_cond *m_doneCond;
+};
+
+class ModelCache::ReadJob : public Job {
+public:
+	ReadJob(const std::shared_ptr<Request> &request) :
+		m_request(request) {}
+
+	virtual void OnRun() override // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+	{
+		if (m_request->Claim())
+			m_request->Read();
+	}
+
+	virtual void OnFinish() override {}
+
+private:
+	std::shared_ptr<Request> m_request;
+};
+
+ModelCache::ModelCache(Graphics::Renderer *r, JobQueue *jobQueue, size_t memoryBudget) :
+	m_renderer(r),
+	m_jobs(jobQueue ? new JobSet(jobQueue) : nullptr),
+	m_maxReads(jobQueue ? jobQueue->GetNumRunners() : 0),
+	m_requestCount(0),
+	m_memoryBudget(memoryBudget),
+	m_memoryUsed(0),
+	m_updateCount(0),
+	m_evictedCount(0)
 {
 }
 
 ModelCache::~ModelCache()
 {
+	// reads already running finish with their own reference to the request
+	m_jobs.reset();
+	m_requests.clear();
 	Flush();
 }
 
 SceneGraph::Model *ModelCache::FindModel(const std::string &name)
+{
+	Entry *entry = GetEntry(name);
+	entry->pinned = true;
+	return entry->model;
+}
+
+SceneGraph::Model *ModelCache::AcquireModel(const std::string &name)
+{
+	try {
+		Entry *entry = GetEntry(name);
+		++entry->refs;
+		return entry->model;
+	} catch (const ModelNotFoundException &) {
+		return nullptr;
+	}
+}
+
+void ModelCache::ReleaseModel(const std::string &name)
+{
+	ModelMap::iterator it = m_models.find(name);
+	if (it == m_models.end())
+		return;
+
+	Entry &entry = it->second;
+	assert(entry.refs > 0);
+	if (entry.refs && !--entry.refs)
+		entry.lastUsed = m_updateCount;
+}
+
+void ModelCache::Preload(const std::string &name, Priority priority)
+{
+	if (!m_jobs || name.empty() || m_models.count(name))
+		return;
+
+	RequestMap::iterator it = m_requests.find(name);
+	if (it != m_requests.end()) {
+		it->second->priority = std::max(it->second->priority, priority);
+		return;
+	}
+
+	m_requests.insert(std::make_pair(name, std::make_shared<Request>(name, priority, m_requestCount++)));
+	Dispatch();
+}
+
+void ModelCache::Update()
+{
+	PROFILE_SCOPED()
+	++m_updateCount;
+
+	// building takes a while and has to be done here, so only one a frame
+	std::shared_ptr<Request> next;
+	for (const auto &it : m_requests) {
+		const std::shared_ptr<Request> &request = it.second;
+		if (request->GetState() != Request::DONE)
+			continue;
+		if (!next || request->priority > next->priority || (request->priority == next->priority && request->order < next->order))
+			next = request;
+	}
+
+	if (next) {
+		m_requests.erase(next->name);
+		try {
+			AddEntry(next->name, Build(next->name, next.get()));
+		} catch (const ModelNotFoundException &) {
+			Output("Could not preload model: %s\n", next->name.c_str());
+		}
+	}
+
+	Dispatch();
+	Evict();
+}
+
+ModelCache::Stats ModelCache::GetStats() const
+{
+	Stats stats;
+	stats.models = m_models.size();
+	stats.unused = 0;
+	for (const auto &it : m_models)
+		if (!it.second.pinned && !it.second.refs)
+			++stats.unused;
+	stats.loading = m_requests.size();
+	stats.evicted = m_evictedCount;
+	stats.memoryUsed = m_memoryUsed;
+	stats.memoryBudget = m_memoryBudget;
+	return stats;
+}
+
+void ModelCache::Flush()
+{
+	for (ModelMap::iterator it = m_models.begin(); it != m_models.end(); ++it) {
+		delete it->second.model;
+	}
+	m_models.clear();
+	m_memoryUsed = 0;
+}
+
+ModelCache::Entry *ModelCache::GetEntry(const std::string &name)
 {
 	ModelMap::iterator it = m_models.find(name);
+	if (it != m_models.end())
+		return &it->second;
 
-	if (it == m_models.end()) {
+	// take over the preload if there is one, rather than reading the file again
+	std::shared_ptr<Request> request;
+	RequestMap::iterator req = m_requests.find(name);
+	if (req != m_requests.end()) {
+		request = req->second;
+		m_requests.erase(req);
+		Dispatch(); // keep the job queue busy with the others meanwhile
+		if (request->Claim())
+			request->Read();
+		else
+			request->Wait();
+	}
+
+	return &AddEntry(name, Build(name, request.get()));
+}
+
+ModelCache::Entry &ModelCache::AddEntry(const std::string &name, SceneGraph::Model *m)
+{
+	ModelSizeVisitor sizeVisitor;
+	m->GetRoot()->Accept(sizeVisitor);
+
+	Entry entry;
+	entry.model = m;
+	entry.size = sizeVisitor.size;
+	entry.refs = 0;
+	entry.pinned = false;
+	entry.lastUsed = m_updateCount;
+	m_memoryUsed += entry.size;
+	return m_models.insert(std::make_pair(name, entry)).first->second;
+}
+
+SceneGraph::Model *ModelCache::Build(const std::string &name, const Request *request)
+{
+	PROFILE_SCOPED()
+	SceneGraph::Model *m = nullptr;
+	if (request && request->found) {
+		SceneGraph::BinaryConverter bc(m_renderer);
+		m = bc.Load(name, request->dir, request->GetData());
+	}
+
+	// no .sgm, or one that couldn't be used; the loader falls back to the .model
+	if (!m) {
 		try {
 			SceneGraph::Loader loader(m_renderer);
-			SceneGraph::Model *m = loader.LoadModel(name);
-			Shields::ReparentShieldNodes(m);
-			m_models[name] = m;
-			return m;
+			m = loader.LoadModel(name);
 		} catch (SceneGraph::LoadingError &) {
 			throw ModelNotFoundException();
 		}
 	}
-	return it->second;
+
+	Shields::ReparentShieldNodes(m);
+	return m;
 }
 
-void ModelCache::Flush()
+// Keeps no more reads on the job queue than it has runners, so a preload asked
+// for later with a higher priority doesn't end up behind less important ones.
+void ModelCache::Dispatch()
 {
-	for (ModelMap::iterator it = m_models.begin(); it != m_models.end(); ++it) {
-		delete it->second;
+	if (!m_jobs)
+		return;
+
+	Uint32 reading = 0;
+	for (const auto &it : m_requests) {
+		const Request::State state = it.second->GetState();
+		if (state == Request::QUEUED || state == Request::READING)
+			++reading;
+	}
+
+	while (reading < m_maxReads) {
+		std::shared_ptr<Request> next;
+		for (const auto &it : m_requests) {
+			const std::shared_ptr<Request> &request = it.second;
+			if (request->GetState() != Request::WAITING)
+				continue;
+			if (!next || request->priority > next->priority || (request->priority == next->priority && request->order < next->order))
+				next = request;
+		}
+		if (!next)
+			break;
+
+		next->SetQueued();
+		m_jobs->Order(new ReadJob(next));
+		++reading;
+	}
+}
+
+// least recently used first, and only the ones nothing holds
+void ModelCache::Evict()
+{
+	while (m_memoryUsed > m_memoryBudget) {
+		ModelMap::iterator oldest = m_models.end();
+		for (ModelMap::iterator it = m_models.begin(); it != m_models.end(); ++it) {
+			const Entry &entry = it->second;
+			if (entry.pinned || entry.refs)
+				continue;
+			if (oldest == m_models.end() || entry.lastUsed < oldest->second.lastUsed)
+				oldest = it;
+		}
+		if (oldest == m_models.end())
+			break;
+
+		m_memoryUsed -= oldest->second.size;
+		delete oldest->second.model;
+		m_models.erase(oldest);
+		++m_evictedCount;
 	}
-	m_models.clear();
 }
@@ -4,10 +4,23 @@
 #ifndef _MODELCACHE_H
 #define _MODELCACHE_H
 /*
- * This class is a quick thoughtless hack
- * Also it only deals in New Models
+ * Loads models by name and keeps them to make instances from.
+ * It only deals in New Models.
+ *
+ * Models can be asked for ahead of time with Preload(). The .sgm is found,
+ * read and decompressed on the job queue, the most important first, and
+ * Update() builds the nodes, materials and buffers from it on the main thread,
+ * a model at a time. Asking for a model that is still being read waits for the
+ * read to finish, or does the read there and then if it hasn't started yet.
+ *
+ * FindModel() keeps a model until Flush(). AcquireModel() counts a reference
+ * instead, and once every reference has been released the model may be
+ * evicted, the least recently used first, while the cache is over its memory
+ * budget.
  */
+#include "JobQueue.h"
 #include "libs.h"
+#include <memory>
 #include <stdexcept>
 
 namespace Graphics {
@@ -23,15 +36,78 @@ public:
 		ModelNotFoundException() :
 			std::runtime_error("Could not find model") {}
 	};
-	ModelCache(Graphics::Renderer *);
+
+	enum Priority {
+		PRIORITY_LOW,
+		PRIORITY_NORMAL,
+		PRIORITY_HIGH
+	};
+
+	struct Stats {
+		Uint32 models;		 // built and in the cache
+		Uint32 unused;		 // of those, the ones that could be evicted
+		Uint32 loading;		 // preloads not built yet
+		Uint32 evicted;		 // since the cache was created
+		size_t memoryUsed;	 // vertex and index buffers of the models in the cache
+		size_t memoryBudget;
+	};
+
+	// without a job queue preloading does nothing and every model is loaded
+	// when it's asked for
+	ModelCache(Graphics::Renderer *, JobQueue *jobQueue = nullptr, size_t memoryBudget = 256 * 1024 * 1024);
 	~ModelCache();
+
 	SceneGraph::Model *FindModel(const std::string &);
+
+	// Like FindModel(), but counts a reference that ReleaseModel() gives back.
+	// Returns nullptr, without counting a reference, if there's no such model.
+	SceneGraph::Model *AcquireModel(const std::string &);
+	void ReleaseModel(const std::string &);
+
+	// a hint that the model will be wanted soon
+	void Preload(const std::string &, Priority priority = PRIORITY_NORMAL);
+
+	// Builds a preloaded model, hands out more reads to the job queue and
+	// evicts unused models while over budget. Call once a frame.
+	void Update();
+
+	void SetMemoryBudget(size_t bytes) { m_memoryBudget = bytes; }
+	Stats GetStats() const;
+
 	void Flush();
 
 private:
-	typedef std::map<std::string, SceneGraph::Model *> ModelMap;
+	struct Entry {
+		SceneGraph::Model *model;
+		size_t size;
+		Uint32 refs;
+		bool pinned;	 // asked for with FindModel(), so never evicted
+		Uint32 lastUsed; // the Update() it was last built or released in
+	};
+
+	struct Request;
+	class ReadJob;
+
+	Entry *GetEntry(const std::string &);
+	Entry &AddEntry(const std::string &, SceneGraph::Model *);
+	SceneGraph::Model *Build(const std::string &, const Request *);
+	void Dispatch();
+	void Evict();
+
+	typedef std::map<std::string, Entry> ModelMap;
+	typedef std::map<std::string, std::shared_ptr<Request>> RequestMap;
 	ModelMap m_models;
+	RequestMap m_requests;
 	Graphics::Renderer *m_renderer;
+
+	std::unique_ptr<JobSet> m_jobs;
+	Uint32 m_maxReads;	   // reads handed to the job queue at once
+	Uint32 m_requestCount; // orders preloads of the same priority
+
+	size_t m_memoryBudget;
+	size_t m_memoryUsed;
+	Uint32 m_updateCount;
+	Uint32 m_evictedCount;
 };
 
 #endif
@@ -217,6 +217,7 @@ void ModelViewer::ToggleGuns()
 			tag->RemoveChildAt(0);
 		}
 	}
+	m_model->InvalidateRenderList();
 	return;
 }
 
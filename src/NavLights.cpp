@@ -125,6 +125,7 @@ NavLights::NavLights(SceneGraph::Model *model, float period) :
 		mt->SetNodeMask(SceneGraph::NODE_TRANSPARENT);
 		mt->AddChild(bblight);
 	}
+	model->InvalidateRenderList();
 }
 
 NavLights::~NavLights()
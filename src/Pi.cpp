@@ -32,6 +32,7 @@
 #include "lua/LuaConsole.h"
 #include "lua/LuaEvent.h"
 #include "lua/LuaTimer.h"
+#include "lua/PropertyMap.h"
 #include "profiler/Profiler.h"
 #include "sound/AmbientSounds.h"
 #if WITH_OBJECTVIEWER
@@ -70,6 +71,7 @@
 #include "graphics/Graphics.h"
 #include "graphics/Light.h"
 #include "graphics/Stats.h"
+#include "graphics/TextureBuilder.h"
 #endif // WITH_DEVKEYS
 
 #include "scenegraph/Lua.h"
@@ -394,6 +396,7 @@ void Pi::App::Startup()
 	numThreads = numThreads ? numThreads : std::max(OS::GetNumCores() - 1, 1U);
 	Pi::asyncJobQueue.reset(new AsyncJobQueue(numThreads));
 	Pi::syncJobQueue.reset(new SyncJobQueue);
+	Graphics::TextureBuilder::SetJobQueue(Pi::asyncJobQueue.get());
 
 	threadTimer.Stop();
 	Output("started %d worker threads in %.2fms\n", numThreads, threadTimer.milliseconds());
@@ -422,6 +425,11 @@ void Pi::App::Shutdown()
 
 	// This function should only be called at the very end of the shutdown procedure.
 	assert(Pi::game == nullptr);
+
+	// an autosave can still be being written; finish it while Lua is around to
+	// hear about it, and before the job queue it's running on goes
+	Game::FinishSaves();
+
 	if (Pi::ffmpegFile != nullptr) {
 		_pclose(Pi::ffmpegFile);
 	}
@@ -455,6 +463,8 @@ void Pi::App::Shutdown()
 
 	GalaxyGenerator::Uninit();
 
+	Graphics::TextureBuilder::SetJobQueue(nullptr);
+
 	ShutdownRenderer();
 	Pi::renderer = nullptr;
 
@@ -496,6 +506,7 @@ void LoadStep::Start()
 	// templates. so now we have crap everywhere :/
 	Output("Lua::Init()\n");
 	Lua::Init();
+	Lua::manager->SetFramePacedGC(Pi::config->Int("LuaFramePacedGC"), Pi::config->Float("LuaGCStepBudget"));
 
 	// TODO: Get the lua state responsible for drawing the init progress up as fast as possible
 	// Investigate using a pigui-only Lua state that we can initialize without depending on
@@ -546,7 +557,15 @@ void LoadStep::Start()
 	AddStep("FaceParts::Init()", &FaceParts::Init);
 
 	AddStep("new ModelCache", []() {
-		Pi::modelCache = new ModelCache(Pi::renderer);
+		const size_t budget = size_t(std::max(Pi::config->Int("ModelCacheBudget"), 0)) * 1024 * 1024;
+		Pi::modelCache = new ModelCache(Pi::renderer, Pi::GetAsyncJobQueue(), budget);
+
+		// the intro shows the player ships as soon as loading is done, and the
+		// rest turn up as traffic; read them while the other steps run
+		for (const ShipType::Id &id : ShipType::player_ships)
+			Pi::modelCache->Preload(ShipType::types[id].modelName, ModelCache::PRIORITY_NORMAL);
+		for (const auto &it : ShipType::types)
+			Pi::modelCache->Preload(it.second.modelName, ModelCache::PRIORITY_LOW);
 	});
 
 	AddStep("Shields::Init", []() {
@@ -620,6 +639,7 @@ void LoadStep::Update(float deltaTime)
 
 		m_loadTimer.Stop();
 		Output("\n\nPioneer loading took %.2fms\n", m_loadTimer.milliseconds());
+		Pi::renderer->LogShaderStats();
 
 		Pi::RequestProfileFrame();
 	}
@@ -843,6 +863,13 @@ void Pi::App::PreUpdate()
 	Pi::frameTime = DeltaTime();
 
 	GuiApplication::PreUpdate();
+
+	// before anything draws, so textures that finished loading show this frame
+	Graphics::TextureBuilder::UploadTextures(Pi::renderer, TEXTURE_UPLOAD_BYTES_PER_LOOP);
+
+	// builds a model that was preloaded, if there is one ready
+	if (Pi::modelCache)
+		Pi::modelCache->Update();
 }
 
 void Pi::App::PostUpdate()
@@ -852,6 +879,13 @@ void Pi::App::PostUpdate()
 
 	HandleRequests();
 
+	// property changes made outside of the time step, e.g. by the UI or while paused
+	PropertyMap::EmitPendingSignals();
+
+	// all of this frame's Lua has run by now
+	if (Lua::manager)
+		Lua::manager->StepGarbageCollector();
+
 #ifdef PIONEER_PROFILER
 	// TODO: profileSlow is profiling the previous frame, need to move that functionality to Application
 	if (Pi::doProfileOne || (Pi::doProfileSlow && (GetFrameTime() > 0.1))) { // slow: < ~10fps
@@ -228,6 +228,7 @@ private:
 
 	// private members
 	static const Uint32 SYNC_JOBS_PER_LOOP = 1;
+	static const Uint32 TEXTURE_UPLOAD_BYTES_PER_LOOP = 4 * 1024 * 1024;
 	static std::unique_ptr<AsyncJobQueue> asyncJobQueue;
 	static std::unique_ptr<SyncJobQueue> syncJobQueue;
 
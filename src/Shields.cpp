@@ -162,6 +162,7 @@ void Shields::ReparentShieldNodes(SceneGraph::Model *model)
 			}
 
 			model->GetRoot()->AddChild(shieldGroup);
+			model->InvalidateRenderList();
 		}
 	}
 }
@@ -38,6 +38,25 @@ HeatGradientParameters_t Ship::s_heatGradientParams;
 const float Ship::DEFAULT_SHIELD_COOLDOWN_TIME = 1.0f;
 const double Ship::DEFAULT_LIFT_TO_DRAG_RATIO = 0.001;
 
+// properties that are set or read every tick
+static const PropertyMap::Key PROP_HULL_MASS_LEFT("hullMassLeft");
+static const PropertyMap::Key PROP_HULL_PERCENT("hullPercent");
+static const PropertyMap::Key PROP_SHIELD_MASS_LEFT("shieldMassLeft");
+static const PropertyMap::Key PROP_FUEL_MASS_LEFT("fuelMassLeft");
+static const PropertyMap::Key PROP_FUEL("fuel");
+static const PropertyMap::Key PROP_ATMO_SHIELD_CAP("atmo_shield_cap");
+static const PropertyMap::Key PROP_CARGO_SCOOP_CAP("cargo_scoop_cap");
+static const PropertyMap::Key PROP_SHIELD_CAP("shield_cap");
+static const PropertyMap::Key PROP_THRUSTER_POWER_CAP("thruster_power_cap");
+static const PropertyMap::Key PROP_LASER_COOLER_CAP("laser_cooler_cap");
+static const PropertyMap::Key PROP_ECM_RECHARGE_CAP("ecm_recharge_cap");
+static const PropertyMap::Key PROP_ECM_POWER_CAP("ecm_power_cap");
+static const PropertyMap::Key PROP_RADAR_CAP("radar_cap");
+static const PropertyMap::Key PROP_FUEL_SCOOP_CAP("fuel_scoop_cap");
+static const PropertyMap::Key PROP_CARGO_LIFE_SUPPORT_CAP("cargo_life_support_cap");
+static const PropertyMap::Key PROP_SHIELD_ENERGY_BOOSTER_CAP("shield_energy_booster_cap");
+static const PropertyMap::Key PROP_HULL_AUTOREPAIR_CAP("hull_autorepair_cap");
+
 Ship::Ship(const ShipType::Id &shipId) :
 	DynamicBody(),
 	m_controller(0),
@@ -360,7 +379,7 @@ float Ship::GetPercentShields() const
 float Ship::GetAtmosphericPressureLimit() const
 {
 	int atmo_shield_cap = 0;
-	const_cast<Ship *>(this)->Properties().Get("atmo_shield_cap", atmo_shield_cap);
+	const_cast<Ship *>(this)->Properties().Get(PROP_ATMO_SHIELD_CAP, atmo_shield_cap);
 	atmo_shield_cap = std::max(atmo_shield_cap, 1); //default to base limit if no shield installed
 	return m_type->atmosphericPressureLimit * atmo_shield_cap;
 }
@@ -368,8 +387,8 @@ float Ship::GetAtmosphericPressureLimit() const
 void Ship::SetPercentHull(float p)
 {
 	m_stats.hull_mass_left = 0.01f * Clamp(p, 0.0f, 100.0f) * float(m_type->hullMass);
-	Properties().Set("hullMassLeft", m_stats.hull_mass_left);
-	Properties().Set("hullPercent", 100.0f * (m_stats.hull_mass_left / float(m_type->hullMass)));
+	Properties().Set(PROP_HULL_MASS_LEFT, m_stats.hull_mass_left);
+	Properties().Set(PROP_HULL_PERCENT, 100.0f * (m_stats.hull_mass_left / float(m_type->hullMass)));
 }
 
 void Ship::UpdateMass()
@@ -482,7 +501,7 @@ bool Ship::OnDamage(Body *attacker, float kgDamage, const CollisionContact &cont
 				dam -= m_stats.shield_mass_left;
 				m_stats.shield_mass_left = 0;
 			}
-			Properties().Set("shieldMassLeft", m_stats.shield_mass_left);
+			Properties().Set(PROP_SHIELD_MASS_LEFT, m_stats.shield_mass_left);
 		}
 
 		m_shieldCooldown = DEFAULT_SHIELD_COOLDOWN_TIME;
@@ -494,8 +513,8 @@ bool Ship::OnDamage(Body *attacker, float kgDamage, const CollisionContact &cont
 		GetShields()->AddHit(localPos);
 
 		m_stats.hull_mass_left -= dam;
-		Properties().Set("hullMassLeft", m_stats.hull_mass_left);
-		Properties().Set("hullPercent", 100.0f * (m_stats.hull_mass_left / float(m_type->hullMass)));
+		Properties().Set(PROP_HULL_MASS_LEFT, m_stats.hull_mass_left);
+		Properties().Set(PROP_HULL_PERCENT, 100.0f * (m_stats.hull_mass_left / float(m_type->hullMass)));
 		if (m_stats.hull_mass_left < 0) {
 			if (attacker) {
 				LuaEvent::Queue("onShipDestroyed", this, attacker);
@@ -532,7 +551,7 @@ bool Ship::OnCollision(Body *b, Uint32 flags, double relVel)
 
 	// hitting cargo scoop surface shouldn't do damage
 	int cargoscoop_cap = 0;
-	Properties().Get("cargo_scoop_cap", cargoscoop_cap);
+	Properties().Get(PROP_CARGO_SCOOP_CAP, cargoscoop_cap);
 	if (cargoscoop_cap > 0 && b->IsType(ObjectType::CARGOBODY) && !b->IsDead()) {
 		LuaRef item = static_cast<CargoBody *>(b)->GetCargoType();
 		if (LuaObject<Ship>::CallMethod<int>(this, "AddEquip", item) > 0) { // try to add it to the ship cargo.
@@ -600,7 +619,7 @@ bool Ship::DoDamage(float kgDamage)
 				dam -= m_stats.shield_mass_left;
 				m_stats.shield_mass_left = 0;
 			}
-			Properties().Set("shieldMassLeft", m_stats.shield_mass_left);
+			Properties().Set(PROP_SHIELD_MASS_LEFT, m_stats.shield_mass_left);
 		}
 
 		m_shieldCooldown = DEFAULT_SHIELD_COOLDOWN_TIME;
@@ -614,8 +633,8 @@ bool Ship::DoDamage(float kgDamage)
 		GetShields()->AddHit(randPos * (GetPhysRadius() * 0.75));
 
 		m_stats.hull_mass_left -= dam;
-		Properties().Set("hullMassLeft", m_stats.hull_mass_left);
-		Properties().Set("hullPercent", 100.0f * (m_stats.hull_mass_left / float(m_type->hullMass)));
+		Properties().Set(PROP_HULL_MASS_LEFT, m_stats.hull_mass_left);
+		Properties().Set(PROP_HULL_PERCENT, 100.0f * (m_stats.hull_mass_left / float(m_type->hullMass)));
 		if (m_stats.hull_mass_left < 0) {
 			Explode();
 		} else {
@@ -646,7 +665,7 @@ void Ship::UpdateEquipStats()
 	p.Set("staticMass", m_stats.static_mass);
 
 	int shield_cap = 0;
-	Properties().Get("shield_cap", shield_cap);
+	Properties().Get(PROP_SHIELD_CAP, shield_cap);
 	m_stats.shield_mass = TONS_HULL_PER_SHIELD * float(shield_cap);
 	p.Set("shieldMass", m_stats.shield_mass);
 
@@ -654,7 +673,7 @@ void Ship::UpdateEquipStats()
 	UpdateGunsStats();
 
 	unsigned int thruster_power_cap = 0;
-	Properties().Get("thruster_power_cap", thruster_power_cap);
+	Properties().Get(PROP_THRUSTER_POWER_CAP, thruster_power_cap);
 	const double power_mul = m_type->thrusterUpgrades[Clamp(thruster_power_cap, 0U, 3U)];
 	GetPropulsion()->SetThrustPowerMult(power_mul, m_type->linThrust, m_type->angThrust);
 
@@ -689,7 +708,7 @@ void Ship::UpdateGunsStats()
 {
 
 	float cooler = 1.0f;
-	Properties().Get("laser_cooler_cap", cooler);
+	Properties().Get(PROP_LASER_COOLER_CAP, cooler);
 	GetFixedGuns()->SetCoolingBoost(cooler);
 
 	for (int num = 0; num < 2; num++) {
@@ -731,7 +750,7 @@ void Ship::UpdateGunsStats()
 void Ship::UpdateFuelStats()
 {
 	m_stats.fuel_tank_mass_left = GetPropulsion()->FuelTankMassLeft();
-	Properties().Set("fuelMassLeft", m_stats.fuel_tank_mass_left);
+	Properties().Set(PROP_FUEL_MASS_LEFT, m_stats.fuel_tank_mass_left);
 
 	UpdateMass();
 }
@@ -776,14 +795,14 @@ void Ship::AbortHyperjump()
 float Ship::GetECMRechargeTime()
 {
 	float ecm_recharge_cap = 0.f;
-	Properties().Get("ecm_recharge_cap", ecm_recharge_cap);
+	Properties().Get(PROP_ECM_RECHARGE_CAP, ecm_recharge_cap);
 	return ecm_recharge_cap;
 }
 
 Ship::ECMResult Ship::UseECM()
 {
 	int ecm_power_cap = 0;
-	Properties().Get("ecm_power_cap", ecm_power_cap);
+	Properties().Get(PROP_ECM_POWER_CAP, ecm_power_cap);
 	if (m_ecmRecharge > 0.0f) return ECM_RECHARGING;
 
 	if (ecm_power_cap > 0) {
@@ -1061,7 +1080,7 @@ double Ship::GetHullTemperature() const
 	// TODO: fix this to properly account for heating due to air friction instead of G-force.
 	double dragGs = GetAtmosForce().Length() / (GetMass() * 9.81);
 	int atmo_shield_cap = 0;
-	const_cast<Ship *>(this)->Properties().Get(R"(atmo_shield_cap)", atmo_shield_cap);
+	const_cast<Ship *>(this)->Properties().Get(PROP_ATMO_SHIELD_CAP, atmo_shield_cap);
 	return dragGs / (15.0 * (1.0 + atmo_shield_cap + (2.0 * (1.0 - m_wheelState))));
 }
 
@@ -1075,7 +1094,7 @@ void Ship::UpdateAlertState()
 {
 	// no alerts if no radar
 	int radar_cap = 0;
-	Properties().Get("radar_cap", radar_cap);
+	Properties().Get(PROP_RADAR_CAP, radar_cap);
 	if (radar_cap <= 0) {
 		// clear existing alert state if there was one
 		if (GetAlertState() != ALERT_NONE) {
@@ -1202,7 +1221,7 @@ void Ship::UpdateFuel(const float timeStep)
 {
 	GetPropulsion()->UpdateFuel(timeStep);
 	UpdateFuelStats();
-	Properties().Set("fuel", GetFuel() * 100); // XXX to match SetFuelPercent
+	Properties().Set(PROP_FUEL, GetFuel() * 100); // XXX to match SetFuelPercent
 
 	if (GetPropulsion()->IsFuelStateChanged())
 		LuaEvent::Queue("onShipFuelChanged", this, EnumStrings::GetString("PropulsionFuelStatus", GetPropulsion()->GetFuelState()));
@@ -1232,7 +1251,7 @@ void Ship::StaticUpdate(const float timeStep)
 			p->GetAtmosphericState(dist, &pressure, &density);
 
 			int atmo_shield_cap = 0;
-			const_cast<Ship *>(this)->Properties().Get("atmo_shield_cap", atmo_shield_cap);
+			const_cast<Ship *>(this)->Properties().Get(PROP_ATMO_SHIELD_CAP, atmo_shield_cap);
 			atmo_shield_cap = std::max(atmo_shield_cap, 1); // needs to have some shielding by default
 			if (pressure > (m_type->atmosphericPressureLimit * atmo_shield_cap)) {
 				float damage = float(pressure - m_type->atmosphericPressureLimit);
@@ -1245,7 +1264,7 @@ void Ship::StaticUpdate(const float timeStep)
 
 	/* FUEL SCOOPING!!!!!!!!! */
 	int capacity = 0;
-	Properties().Get("fuel_scoop_cap", capacity);
+	Properties().Get(PROP_FUEL_SCOOP_CAP, capacity);
 	if (m_flightState == FLYING && capacity > 0) {
 		Frame *frame = Frame::GetFrame(GetFrame());
 		Body *astro = frame->GetBody();
@@ -1281,7 +1300,7 @@ void Ship::StaticUpdate(const float timeStep)
 
 	// Cargo bay life support
 	capacity = 0;
-	Properties().Get("cargo_life_support_cap", capacity);
+	Properties().Get(PROP_CARGO_LIFE_SUPPORT_CAP, capacity);
 	if (!capacity) {
 		// Hull is pressure-sealed, it just doesn't provide
 		// temperature regulation and breathable atmosphere
@@ -1353,10 +1372,10 @@ void Ship::StaticUpdate(const float timeStep)
 		// 250 second recharge
 		float recharge_rate = 0.004f;
 		float booster = 1.0f;
-		Properties().Get("shield_energy_booster_cap", booster);
+		Properties().Get(PROP_SHIELD_ENERGY_BOOSTER_CAP, booster);
 		recharge_rate *= booster;
 		m_stats.shield_mass_left = Clamp(m_stats.shield_mass_left + m_stats.shield_mass * recharge_rate * timeStep, 0.0f, m_stats.shield_mass);
-		Properties().Set("shieldMassLeft", m_stats.shield_mass_left);
+		Properties().Set(PROP_SHIELD_MASS_LEFT, m_stats.shield_mass_left);
 	}
 
 	if (m_wheelTransition) {
@@ -1369,11 +1388,11 @@ void Ship::StaticUpdate(const float timeStep)
 	if (m_testLanded) TestLanded();
 
 	capacity = 0;
-	Properties().Get("hull_autorepair_cap", capacity);
+	Properties().Get(PROP_HULL_AUTOREPAIR_CAP, capacity);
 	if (capacity) {
 		m_stats.hull_mass_left = std::min(m_stats.hull_mass_left + 0.1f * timeStep, float(m_type->hullMass));
-		Properties().Set("hullMassLeft", m_stats.hull_mass_left);
-		Properties().Set("hullPercent", 100.0f * (m_stats.hull_mass_left / float(m_type->hullMass)));
+		Properties().Set(PROP_HULL_MASS_LEFT, m_stats.hull_mass_left);
+		Properties().Set(PROP_HULL_PERCENT, 100.0f * (m_stats.hull_mass_left / float(m_type->hullMass)));
 	}
 
 	// After calling StartHyperspaceTo this Ship must not spawn objects
@@ -1472,8 +1491,7 @@ void Ship::Render(Graphics::Renderer *renderer, const Camera *camera, const vect
 	s_heatGradientParams.heatingAmount = Clamp(GetHullTemperature(), 0.0, 1.0);
 
 	// This has to be done per-model with a shield and just before it's rendered
-	const bool shieldsVisible = m_shieldCooldown > 0.01f && m_stats.shield_mass_left > (m_stats.shield_mass / 100.0f);
-	GetShields()->SetEnabled(shieldsVisible);
+	GetShields()->SetEnabled(AreShieldsVisible());
 	GetShields()->Update(m_shieldCooldown, 0.01f * GetPercentShields());
 
 	//strncpy(params.pText[0], GetLabel().c_str(), sizeof(params.pText));
@@ -1511,6 +1529,17 @@ void Ship::Render(Graphics::Renderer *renderer, const Camera *camera, const vect
 	}
 }
 
+bool Ship::AreShieldsVisible() const
+{
+	return m_shieldCooldown > 0.01f && m_stats.shield_mass_left > (m_stats.shield_mass / 100.0f);
+}
+
+bool Ship::IsModelInstanceable() const
+{
+	// the shields and re-entry heating depend on the ship's own hits and orientation
+	return !IsDead() && !AreShieldsVisible() && GetHullTemperature() <= 0.0;
+}
+
 bool Ship::SpawnCargo(CargoBody *c_body) const
 {
 	if (m_flightState != FLYING) return false;
@@ -80,6 +80,7 @@ public:
 	virtual void SetLandedOn(Planet *p, float latitude, float longitude);
 
 	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform) override;
+	virtual bool IsModelInstanceable() const override;
 
 	inline void ClearThrusterState()
 	{
@@ -266,6 +267,7 @@ protected:
 
 private:
 	float GetECMRechargeTime();
+	bool AreShieldsVisible() const;
 	void DoThrusterSounds() const;
 	void Init();
 	void TestLanded();
@@ -4,6 +4,7 @@
 #include "Space.h"
 
 #include "Body.h"
+#include "CborWriter.h"
 #include "CityOnPlanet.h"
 #include "Frame.h"
 #include "Game.h"
@@ -23,6 +24,7 @@
 #include "graphics/Graphics.h"
 #include "lua/LuaEvent.h"
 #include "lua/LuaTimer.h"
+#include "lua/PropertyMap.h"
 #include <algorithm>
 #include <functional>
 
@@ -63,6 +65,8 @@ Space::BodyNearList Space::BodyNearFinder::GetBodiesMaybeNear(const vector3d &po
 	return std::move(m_nearBodies);
 }
 
+Uint32 Space::s_bodyRemovals = 0;
+
 Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, Space *oldSpace) :
 	m_starSystemCache(oldSpace ? oldSpace->m_starSystemCache : galaxy->NewStarSystemSlaveCache()),
 	m_game(game),
@@ -171,29 +175,29 @@ void Space::RefreshBackground()
 	m_background.reset(new Background::Container(Pi::renderer, rand, this, m_game->GetGalaxy()));
 }
 
-void Space::ToJson(Json &jsonObj)
+void Space::ToCbor(CborWriter &writer)
 {
 	PROFILE_SCOPED()
 	RebuildBodyIndex();
 	RebuildSystemBodyIndex();
 
-	Json spaceObj({}); // Create JSON object to contain space data (all the bodies and things).
-
+	Json spaceObj({}); // Create JSON object to contain the star system data.
 	StarSystem::ToJson(spaceObj, m_starSystem.Get());
 
-	Json frameObj({});
-	Frame::ToJson(frameObj, m_rootFrameId, this);
-	spaceObj["frame"] = frameObj;
+	writer.BeginObject(spaceObj.size() + 2);
+	writer.Fields(spaceObj);
 
-	Json bodyArray = Json::array(); // Create JSON array to contain body data.
+	writer.Key("frame");
+	Frame::ToCbor(writer, m_rootFrameId, this);
+
+	// Each body is only held as JSON for as long as it takes to write it out.
+	writer.Key("bodies");
+	writer.BeginArray(m_bodies.size());
 	for (Body *b : m_bodies) {
-		Json bodyArrayEl({}); // Create JSON object to contain body.
-		b->ToJson(bodyArrayEl, this);
-		bodyArray.push_back(bodyArrayEl); // Append body object to array.
+		Json bodyObj({}); // Create JSON object to contain body.
+		b->ToJson(bodyObj, this);
+		writer.Value(bodyObj);
 	}
-	spaceObj["bodies"] = bodyArray; // Add body array to space object.
-
-	jsonObj["space"] = spaceObj; // Add space object to supplied object.
 }
 
 Body *Space::GetBodyByIndex(Uint32 idx) const
@@ -982,6 +986,7 @@ void Space::TimeStep(float step)
 	for (Body *b : m_bodies)
 		b->TimeStepUpdate(step);
 
+	PropertyMap::EmitPendingSignals();
 	LuaEvent::Emit();
 	Pi::luaTimer->Tick();
 
@@ -1008,6 +1013,7 @@ void Space::UpdateBodies()
 		if (remove_iterator != m_bodies.end()) {
 			*remove_iterator = m_bodies.back();
 			m_bodies.pop_back();
+			++s_bodyRemovals;
 			if (b.second == BodyAssignation::KILL)
 				delete b.first;
 			else
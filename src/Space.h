@@ -12,6 +12,7 @@
 #include "vector3.h"
 
 class Body;
+class CborWriter;
 class Frame;
 class Game;
 enum class ObjectType;
@@ -29,10 +30,11 @@ public:
 
 	~Space();
 
-	void ToJson(Json &jsonObj);
+	// writes the "space" object of a saved game
+	void ToCbor(CborWriter &writer);
 
 	// body/sbody indexing for save/load. valid after
-	// construction/ToJson(), invalidated by TimeStep(). they will assert
+	// construction/ToCbor(), invalidated by TimeStep(). they will assert
 	// if called while invalid
 	Body *GetBodyByIndex(Uint32 idx) const;
 	SystemBody *GetSystemBodyByIndex(Uint32 idx) const;
@@ -66,6 +68,10 @@ public:
 	Body *FindBodyForPath(const SystemPath *path) const;
 
 	Uint32 GetNumBodies() const { return static_cast<Uint32>(m_bodies.size()); }
+
+	// goes up whenever a body is removed from (or deleted by) any Space, so
+	// Body pointers kept from an earlier frame can be checked for staleness
+	static Uint32 GetBodyRemovalCount() { return s_bodyRemovals; }
 	IterationProxy<std::vector<Body *>> GetBodies() { return MakeIterationProxy(m_bodies); }
 	const IterationProxy<const std::vector<Body *>> GetBodies() const { return MakeIterationProxy(m_bodies); }
 
@@ -115,6 +121,7 @@ private:
 	};
 
 	std::vector<std::pair<Body *, BodyAssignation>> m_assignedBodies;
+	static Uint32 s_bodyRemovals;
 
 	void RebuildBodyIndex();
 	void RebuildSystemBodyIndex();
@@ -5,6 +5,7 @@
 #include "FileSystem.h"
 #include "Json.h"
 #include "MathUtil.h"
+#include "ModelCache.h"
 #include "Pi.h"
 #include "Ship.h"
 #include "StringF.h"
@@ -19,7 +20,7 @@ struct StationTypeLoadError {};
 std::vector<SpaceStationType> SpaceStationType::surfaceTypes;
 std::vector<SpaceStationType> SpaceStationType::orbitalTypes;
 
-SpaceStationType::SpaceStationType(const std::string &id_, const std::string &path_) :
+SpaceStationType::SpaceStationType(const std::string &id_, const std::string &path_, const Json &data) :
 	id(id_),
 	model(0),
 	modelName(""),
@@ -32,7 +33,6 @@ SpaceStationType::SpaceStationType(const std::string &id_, const std::string &pa
 	parkingDistance(0),
 	parkingGapSize(0)
 {
-	Json data = JsonUtils::LoadJsonDataFile(path_);
 	if (data.is_null()) {
 		Output("couldn't read station def '%s'\n", path_.c_str());
 		throw StationTypeLoadError();
@@ -397,22 +397,34 @@ void SpaceStationType::Init()
 		return;
 	isInitted = true;
 
-	// load all station definitions
 	namespace fs = FileSystem;
+
+	// every station model is needed straight away, so start reading them all
+	// on the job queue rather than one at a time as each type is set up
+	std::vector<std::pair<fs::FileInfo, Json>> defs;
 	for (fs::FileEnumerator files(fs::gameDataFiles, "stations", 0); !files.Finished(); files.Next()) {
 		const fs::FileInfo &info = files.Current();
 		if (ends_with_ci(info.GetPath(), ".json")) {
-			const std::string id(info.GetName().substr(0, info.GetName().size() - 5));
-			try {
-				SpaceStationType st = SpaceStationType(id, info.GetPath());
-				switch (st.dockMethod) {
-				case SURFACE: surfaceTypes.push_back(st); break;
-				case ORBITAL: orbitalTypes.push_back(st); break;
-				}
-			} catch (StationTypeLoadError) {
-				// TODO: Actual error handling would be nice.
-				Error("Error while loading Space Station data (check stdout/output.txt).\n");
+			defs.push_back(std::make_pair(info, JsonUtils::LoadJsonDataFile(info.GetPath())));
+			const Json &data = defs.back().second;
+			if (data.is_object())
+				Pi::modelCache->Preload(data.value("model", ""), ModelCache::PRIORITY_HIGH);
+		}
+	}
+
+	// load all station definitions
+	for (const auto &def : defs) {
+		const fs::FileInfo &info = def.first;
+		const std::string id(info.GetName().substr(0, info.GetName().size() - 5));
+		try {
+			SpaceStationType st = SpaceStationType(id, info.GetPath(), def.second);
+			switch (st.dockMethod) {
+			case SURFACE: surfaceTypes.push_back(st); break;
+			case ORBITAL: orbitalTypes.push_back(st); break;
 			}
+		} catch (StationTypeLoadError) {
+			// TODO: Actual error handling would be nice.
+			Error("Error while loading Space Station data (check stdout/output.txt).\n");
 		}
 	}
 }
@@ -4,6 +4,7 @@
 #ifndef _SPACESTATIONTYPE_H
 #define _SPACESTATIONTYPE_H
 
+#include "Json.h"
 #include "libs.h"
 
 //Space station definition, loaded from data/stations
@@ -66,7 +67,7 @@ private:
 	static std::vector<SpaceStationType> orbitalTypes;
 
 public:
-	SpaceStationType(const std::string &id, const std::string &path);
+	SpaceStationType(const std::string &id, const std::string &path, const Json &data);
 
 	void OnSetupComplete();
 	const SPort *FindPortByBay(const int zeroBaseBayID) const;
@@ -44,6 +44,7 @@ public:
 	void SaveToJson(Json &jsonObj) override;
 
 	RefCountedPtr<CameraContext> GetCameraContext() const { return m_cameraContext; }
+	const Camera *GetCamera() const { return m_camera.get(); }
 
 	ViewController *GetViewController() const { return m_viewController; }
 	void SetViewController(ViewController *newView);
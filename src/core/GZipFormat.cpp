@@ -1,7 +1,12 @@
 #include "GZipFormat.h"
+#include <SDL_atomic.h>
+#include <SDL_cpuinfo.h>
+#include <SDL_thread.h>
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <string>
+#include <vector>
 
 extern "C" {
 #include <miniz/miniz.h>
@@ -35,6 +40,13 @@ namespace {
 		return MZ_TRUE;
 	}
 
+	// Streaming output function for GZipFileWriter.
+	static mz_bool PutBytesToFile(const void *buf, int len, void *user)
+	{
+		FILE *out = static_cast<FILE *>(user);
+		return fwrite(buf, len, 1, out) == 1 ? MZ_TRUE : MZ_FALSE;
+	}
+
 	static uint32_t ReadLE32(const unsigned char *data)
 	{
 		return (uint32_t(data[0]) << 0) |
@@ -50,6 +62,69 @@ namespace {
 		out[2] = (value >> 16) & 0xffu;
 		out[3] = (value >> 24) & 0xffu;
 	}
+
+	// The GZip header written by CompressGZip and friends.
+	static void AppendHeader(std::string &out, const std::string &inner_file_name)
+	{
+		const size_t start = out.size();
+
+		// The base GZip header.
+		const unsigned char header_bytes[10] = { 31, 139, 8, FLAG_HCRC | FLAG_NAME, 0, 0, 0, 0, 0, 255 };
+		out.append(reinterpret_cast<const char *>(header_bytes), sizeof(header_bytes));
+
+		// Add inner file name, *including* null terminator (c_str() ensures that the data is null terminated).
+		out.append(inner_file_name.c_str(), inner_file_name.size() + 1);
+
+		// Add 16-bit header-CRC.
+		uint32_t header_crc = mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const mz_uint8 *>(out.data() + start), out.size() - start);
+		const unsigned char crc_buf[2] = {
+			static_cast<unsigned char>((header_crc >> 0) & 0xffu),
+			static_cast<unsigned char>((header_crc >> 8) & 0xffu),
+		};
+		out.append(reinterpret_cast<const char *>(crc_buf), sizeof(crc_buf));
+	}
+
+	// Chunks compressed by CompressGZipParallel don't share a dictionary, so they are
+	// kept big enough for that to cost well under a percent of the output size.
+	const size_t PARALLEL_CHUNK_SIZE = 1024 * 1024;
+
+	struct DeflateChunk {
+		const unsigned char *data;
+		size_t length;
+		bool last;
+		bool ok;
+		std::string out;
+	};
+
+	struct ParallelDeflate {
+		std::vector<DeflateChunk> chunks;
+		SDL_atomic_t next;
+	};
+
+	// Compresses chunks until there are none left. Each chunk gets a fresh compressor
+	// and, unless it's the last, ends with a full flush: the final bit of its blocks
+	// is clear and it finishes with an empty stored block, so it ends on a byte
+	// boundary and the chunks join up into one valid DEFLATE stream.
+	static int ParallelDeflateThread(void *data)
+	{
+		ParallelDeflate *job = static_cast<ParallelDeflate *>(data);
+		std::unique_ptr<tdefl_compressor> compressor;
+		for (;;) {
+			const int index = SDL_AtomicAdd(&job->next, 1);
+			if (index >= int(job->chunks.size()))
+				break;
+
+			DeflateChunk &chunk = job->chunks[index];
+			if (!compressor)
+				compressor.reset(new tdefl_compressor);
+			if (tdefl_init(compressor.get(), &PutBytesToString, static_cast<void *>(&chunk.out), TDEFL_DEFAULT_MAX_PROBES) != TDEFL_STATUS_OKAY)
+				continue;
+
+			const tdefl_status status = tdefl_compress_buffer(compressor.get(), chunk.data, chunk.length, chunk.last ? TDEFL_FINISH : TDEFL_FULL_FLUSH);
+			chunk.ok = status == (chunk.last ? TDEFL_STATUS_DONE : TDEFL_STATUS_OKAY);
+		}
+		return 0;
+	}
 } // namespace
 
 bool gzip::IsGZipFormat(const unsigned char *data, size_t length)
@@ -183,21 +258,7 @@ std::string gzip::DecompressRawDeflate(const unsigned char *data, size_t length)
 std::string gzip::CompressGZip(const std::string &data, const std::string &inner_file_name)
 {
 	std::string out;
-
-	// The base GZip header.
-	const unsigned char header_bytes[10] = { 31, 139, 8, FLAG_HCRC | FLAG_NAME, 0, 0, 0, 0, 0, 255 };
-	out.append(reinterpret_cast<const char *>(header_bytes), sizeof(header_bytes));
-
-	// Add inner file name, *including* null terminator (c_str() ensures that the data is null terminated).
-	out.append(inner_file_name.c_str(), inner_file_name.size() + 1);
-
-	// Add 16-bit header-CRC.
-	uint32_t header_crc = mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const mz_uint8 *>(out.data()), out.size());
-	const unsigned char crc_buf[2] = {
-		static_cast<unsigned char>((header_crc >> 0) & 0xffu),
-		static_cast<unsigned char>((header_crc >> 8) & 0xffu),
-	};
-	out.append(reinterpret_cast<const char *>(crc_buf), sizeof(crc_buf));
+	AppendHeader(out, inner_file_name);
 
 	bool success = tdefl_compress_mem_to_output(data.data(), data.size(), &PutBytesToString, static_cast<void *>(&out), TDEFL_DEFAULT_MAX_PROBES);
 	if (!success) {
@@ -214,3 +275,123 @@ std::string gzip::CompressGZip(const std::string &data, const std::string &inner
 
 	return out;
 }
+
+std::string gzip::CompressGZipParallel(const unsigned char *data, size_t length, const std::string &inner_file_name, int num_threads)
+{
+	ParallelDeflate job;
+	const size_t num_chunks = std::max<size_t>((length + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE, 1);
+	job.chunks.resize(num_chunks);
+	for (size_t i = 0; i < num_chunks; i++) {
+		DeflateChunk &chunk = job.chunks[i];
+		chunk.data = data + i * PARALLEL_CHUNK_SIZE;
+		chunk.length = std::min(PARALLEL_CHUNK_SIZE, length - i * PARALLEL_CHUNK_SIZE);
+		chunk.last = (i + 1 == num_chunks);
+		chunk.ok = false;
+	}
+	SDL_AtomicSet(&job.next, 0);
+
+	num_threads = std::max(std::min(num_threads, int(num_chunks)), 1);
+
+	// This thread takes chunks too, once it has worked out the CRC. If a thread
+	// can't be started, the others just get through more chunks each.
+	std::vector<SDL_Thread *> threads;
+	for (int i = 1; i < num_threads; i++) {
+		SDL_Thread *thread = SDL_CreateThread(&ParallelDeflateThread, "GZipCompress", &job);
+		if (thread) threads.push_back(thread);
+	}
+	const uint32_t data_crc = mz_crc32(MZ_CRC32_INIT, data, length);
+	ParallelDeflateThread(&job);
+	for (SDL_Thread *thread : threads)
+		SDL_WaitThread(thread, nullptr);
+
+	size_t compressed_size = 0;
+	for (const DeflateChunk &chunk : job.chunks) {
+		if (!chunk.ok) {
+			throw gzip::CompressionFailedException();
+		}
+		compressed_size += chunk.out.size();
+	}
+
+	std::string out;
+	out.reserve(compressed_size + inner_file_name.size() + BASE_HEADER_SIZE + BASE_FOOTER_SIZE + 3);
+	AppendHeader(out, inner_file_name);
+	for (DeflateChunk &chunk : job.chunks) {
+		out += chunk.out;
+		std::string().swap(chunk.out);
+	}
+
+	unsigned char footer_bytes[8];
+	WriteLE32(footer_bytes + 0, data_crc);
+	// As in CompressGZip, the size is written modulo 2^32.
+	WriteLE32(footer_bytes + 4, length);
+	out.append(reinterpret_cast<const char *>(footer_bytes), sizeof(footer_bytes));
+
+	return out;
+}
+
+struct gzip::GZipFileWriter::Compressor {
+	tdefl_compressor state;
+};
+
+gzip::GZipFileWriter::GZipFileWriter(FILE *file, const std::string &inner_file_name) :
+	m_compressor(new Compressor),
+	m_file(file),
+	m_crc(MZ_CRC32_INIT),
+	m_inputSize(0),
+	m_finished(false)
+{
+	assert(file != nullptr);
+
+	// The same header as CompressGZip writes.
+	std::string header;
+	AppendHeader(header, inner_file_name);
+
+	if (fwrite(header.data(), header.size(), 1, m_file) != 1) {
+		throw gzip::WriteFailedException();
+	}
+
+	if (tdefl_init(&m_compressor->state, &PutBytesToFile, static_cast<void *>(m_file), TDEFL_DEFAULT_MAX_PROBES) != TDEFL_STATUS_OKAY) {
+		throw gzip::CompressionFailedException();
+	}
+}
+
+gzip::GZipFileWriter::~GZipFileWriter()
+{
+}
+
+void gzip::GZipFileWriter::Write(const unsigned char *data, size_t length)
+{
+	assert(!m_finished);
+	if (!length) return;
+
+	m_crc = mz_crc32(m_crc, data, length);
+	m_inputSize += length;
+
+	const tdefl_status status = tdefl_compress_buffer(&m_compressor->state, data, length, TDEFL_NO_FLUSH);
+	if (status == TDEFL_STATUS_PUT_BUF_FAILED) {
+		throw gzip::WriteFailedException();
+	} else if (status != TDEFL_STATUS_OKAY) {
+		throw gzip::CompressionFailedException();
+	}
+}
+
+void gzip::GZipFileWriter::Finish()
+{
+	assert(!m_finished);
+	m_finished = true;
+
+	const tdefl_status status = tdefl_compress_buffer(&m_compressor->state, nullptr, 0, TDEFL_FINISH);
+	if (status == TDEFL_STATUS_PUT_BUF_FAILED) {
+		throw gzip::WriteFailedException();
+	} else if (status != TDEFL_STATUS_DONE) {
+		throw gzip::CompressionFailedException();
+	}
+
+	unsigned char footer_bytes[8];
+	WriteLE32(footer_bytes + 0, m_crc);
+	// As in CompressGZip, the size is written modulo 2^32.
+	WriteLE32(footer_bytes + 4, m_inputSize);
+	if (fwrite(footer_bytes, sizeof(footer_bytes), 1, m_file) != 1) {
+		throw gzip::WriteFailedException();
+	}
+}
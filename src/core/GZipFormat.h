@@ -4,12 +4,16 @@
 #ifndef GZIP_FORMAT_H
 #define GZIP_FORMAT_H
 
+#include <cstdint>
+#include <cstdio>
+#include <memory>
 #include <string>
 
 namespace gzip {
 	struct GZipException {};
 	struct DecompressionFailedException : public GZipException {};
 	struct CompressionFailedException : public GZipException {};
+	struct WriteFailedException : public GZipException {};
 
 	// Checks if the data block could plausibly be a GZip file.
 	// This really just checks for the magic GZip bytes and a basic length check.
@@ -34,6 +38,39 @@ namespace gzip {
 	// If compression fails it throws an exception.
 	// Parameter 'inner_file_name' is the name written in the GZip header as the file name of the compressed block.
 	std::string CompressGZip(const std::string &data, const std::string &inner_file_name);
+
+	// Compresses a block of data like CompressGZip, but in 1MB chunks spread over at most
+	// num_threads threads, the calling one included. The chunks are joined into a single
+	// DEFLATE stream, so the output is ordinary GZip and decompresses anywhere; it is
+	// slightly bigger than CompressGZip's because the chunks don't share a dictionary.
+	// If compression fails it throws an exception.
+	std::string CompressGZipParallel(const unsigned char *data, size_t length, const std::string &inner_file_name, int num_threads);
+
+	// Compresses data as it is handed over and writes it to a file, producing the same
+	// format as CompressGZip without ever holding the whole input or output in memory.
+	// Write() may be called any number of times; Finish() must be called once at the end
+	// to write the GZip footer. The file is not closed.
+	// If compression fails it throws CompressionFailedException, if writing to the file
+	// fails it throws WriteFailedException.
+	class GZipFileWriter {
+	public:
+		GZipFileWriter(FILE *file, const std::string &inner_file_name);
+		~GZipFileWriter();
+
+		void Write(const unsigned char *data, size_t length);
+		void Finish();
+
+		// uncompressed bytes handed to Write() so far
+		size_t GetInputSize() const { return m_inputSize; }
+
+	private:
+		struct Compressor;
+		std::unique_ptr<Compressor> m_compressor;
+		FILE *m_file;
+		uint32_t m_crc;
+		size_t m_inputSize;
+		bool m_finished;
+	};
 } // namespace gzip
 
 #endif
@@ -5,12 +5,17 @@
 #include "lz4/lz4frame.h"
 #include "profiler/Profiler.h"
 #include <SDL_endian.h>
+#include <cstring>
 #include <functional>
 #include <memory>
 
 bool lz4::IsLZ4Format(const char *data, size_t length)
 {
-	const uint32_t magic = *reinterpret_cast<const uint32_t *>(data);
+	if (length < sizeof(uint32_t))
+		return false;
+
+	uint32_t magic;
+	memcpy(&magic, data, sizeof(magic));
 
 	return magic == SDL_SwapLE32(0x184D2204);
 }
@@ -509,6 +509,7 @@ void FactionsDatabase::SetHomeSectors()
 	for (auto it = m_factions.begin(); it != m_factions.end(); ++it)
 		if ((*it)->hasHomeworld)
 			(*it)->m_homesector = m_galaxy->GetSector((*it)->homeworld);
+	m_claim_index.Build(m_factions, m_spatial_index);
 	m_may_assign_factions = true;
 }
 
@@ -536,6 +537,7 @@ void FactionsDatabase::AddFaction(Faction *faction)
 		m_missingFactionsMap.erase(it);
 	}
 	m_spatial_index.Add(faction);
+	m_claim_index.Clear(); // rebuilt by SetHomeSectors
 
 	if (faction->hasHomeworld) m_homesystems.insert(faction->homeworld.SystemOnly());
 	faction->idx = m_factions.size() - 1;
@@ -580,6 +582,26 @@ const Faction *FactionsDatabase::GetNearestClaimant(const Sector::System *sys) c
 	}
 
 	// if it didn't, or it wasn't a custom StarStystem, then we go ahead and assign it a faction allegiance like normal below...
+	const Faction *result = &m_no_faction;
+	double closestFactionDist = HUGE_VAL;
+	ConstFactionList &candidates = m_claim_index.IsBuilt() ? m_claim_index.CandidateFactions(sys) : m_spatial_index.CandidateFactions(sys);
+
+	for (ConstFactionIterator it = candidates.begin(); it != candidates.end(); ++it) {
+		if ((*it)->IsClaimed(sys->GetPath()))
+			return *it; // this is a very specific claim, no further checks for distance from another factions homeworld is needed.
+		if ((*it)->IsCloserAndContains(closestFactionDist, sys))
+			result = *it;
+	}
+	return result;
+}
+
+const Faction *FactionsDatabase::GetNearestClaimantUnindexed(const Sector::System *sys) const
+{
+	PROFILE_SCOPED()
+	if (sys->GetCustomSystem() && sys->GetCustomSystem()->faction) {
+		return sys->GetCustomSystem()->faction;
+	}
+
 	const Faction *result = &m_no_faction;
 	double closestFactionDist = HUGE_VAL;
 	ConstFactionList &candidates = m_spatial_index.CandidateFactions(sys);
@@ -879,3 +901,111 @@ const std::vector<const Faction *> &FactionsDatabase::Octsapling::CandidateFacti
 	*/
 	return octbox[BoxIndex(sys->sx)][BoxIndex(sys->sy)][BoxIndex(sys->sz)];
 }
+
+const std::vector<const Faction *> &FactionsDatabase::Octsapling::CandidateFactions(Sint32 sx, Sint32 sy, Sint32 sz) const
+{
+	return octbox[BoxIndex(sx)][BoxIndex(sy)][BoxIndex(sz)];
+}
+
+void FactionsDatabase::ClaimIndex::Clear()
+{
+	m_buckets.clear();
+	for (int bx = 0; bx < 2; bx++)
+		for (int by = 0; by < 2; by++)
+			for (int bz = 0; bz < 2; bz++)
+				m_unbounded[bx][by][bz].clear();
+	m_built = false;
+}
+
+void FactionsDatabase::ClaimIndex::Build(const std::vector<Faction *> &factions, const Octsapling &octsapling)
+{
+	PROFILE_SCOPED()
+	/*	The Octsapling only splits the galaxy at Sol, so every query still has to test
+		most of the factions on that side of it. Here we walk every faction once and work
+		out which buckets its border sphere can touch, so that the per-system work is
+		limited to factions that have a real chance of winning.
+
+		To be sure that the answers are exactly those of the Octsapling on its own we
+		only ever remove factions from its candidate lists, and we're generous about it:
+		the sphere test is padded and a faction is always kept in its home bucket (which
+		it claims at distance 0) and in the buckets holding any of its explicit claims.
+	*/
+	Clear();
+
+	const float BUCKET_SIZE = Sector::SIZE * BUCKET_SECTORS;
+	const float SLACK = 1.0f; // light years, covers float error in Sector::System::DistanceBetween
+
+	std::set<const Faction *> unbounded;
+	std::map<SystemPath, std::set<const Faction *>, SystemPath::LessSectorOnly> reach;
+
+	for (const Faction *faction : factions) {
+		RefCountedPtr<const Sector> sec = faction->hasHomeworld ? faction->GetHomeSector() : RefCountedPtr<const Sector>();
+		if (!sec || faction->homeworld.systemIndex >= sec->m_systems.size()) {
+			// no position to test against, so it's a candidate everywhere
+			unbounded.insert(faction);
+			continue;
+		}
+
+		const vector3f home = sec->m_systems[faction->homeworld.systemIndex].GetFullPosition();
+		const float radius = std::max(float(faction->Radius()), 0.0f) + SLACK;
+
+		reach[SystemPath(BucketIndex(faction->homeworld.sectorX), BucketIndex(faction->homeworld.sectorY), BucketIndex(faction->homeworld.sectorZ))].insert(faction);
+
+		const Sint32 bxmin = BucketIndex(Sint32(floor((home.x - radius) / Sector::SIZE)));
+		const Sint32 bxmax = BucketIndex(Sint32(floor((home.x + radius) / Sector::SIZE)));
+		const Sint32 bymin = BucketIndex(Sint32(floor((home.y - radius) / Sector::SIZE)));
+		const Sint32 bymax = BucketIndex(Sint32(floor((home.y + radius) / Sector::SIZE)));
+		const Sint32 bzmin = BucketIndex(Sint32(floor((home.z - radius) / Sector::SIZE)));
+		const Sint32 bzmax = BucketIndex(Sint32(floor((home.z + radius) / Sector::SIZE)));
+
+		for (Sint32 bx = bxmin; bx <= bxmax; bx++) {
+			for (Sint32 by = bymin; by <= bymax; by++) {
+				for (Sint32 bz = bzmin; bz <= bzmax; bz++) {
+					// distance from the homeworld to the nearest point of the bucket
+					const vector3f lo = BUCKET_SIZE * vector3f(float(bx), float(by), float(bz));
+					const vector3f nearest(
+						Clamp(home.x, lo.x, lo.x + BUCKET_SIZE),
+						Clamp(home.y, lo.y, lo.y + BUCKET_SIZE),
+						Clamp(home.z, lo.z, lo.z + BUCKET_SIZE));
+					if ((nearest - home).LengthSqr() <= radius * radius)
+						reach[SystemPath(bx, by, bz)].insert(faction);
+				}
+			}
+		}
+
+		for (const SystemPath &claim : faction->m_ownedsystemlist)
+			reach[SystemPath(BucketIndex(claim.sectorX), BucketIndex(claim.sectorY), BucketIndex(claim.sectorZ))].insert(faction);
+	}
+
+	for (int bx = 0; bx < 2; bx++) {
+		for (int by = 0; by < 2; by++) {
+			for (int bz = 0; bz < 2; bz++) {
+				// any sector index with the right signs picks the octbox cell
+				for (const Faction *faction : octsapling.CandidateFactions(bx - 1, by - 1, bz - 1))
+					if (unbounded.count(faction))
+						m_unbounded[bx][by][bz].push_back(faction);
+			}
+		}
+	}
+
+	for (auto &bucket : reach) {
+		const SystemPath &b = bucket.first;
+		std::vector<const Faction *> &candidates = m_buckets[b];
+		for (const Faction *faction : octsapling.CandidateFactions(b.sectorX, b.sectorY, b.sectorZ))
+			if (unbounded.count(faction) || bucket.second.count(faction))
+				candidates.push_back(faction);
+	}
+
+	m_built = true;
+	Output("Faction claim index: " SIZET_FMT " buckets, " SIZET_FMT " unbounded factions\n", m_buckets.size(), unbounded.size());
+}
+
+const std::vector<const Faction *> &FactionsDatabase::ClaimIndex::CandidateFactions(const Sector::System *sys) const
+{
+	PROFILE_SCOPED()
+	const SystemPath bucket(BucketIndex(sys->sx), BucketIndex(sys->sy), BucketIndex(sys->sz));
+	auto it = m_buckets.find(bucket);
+	if (it != m_buckets.end())
+		return it->second;
+	return m_unbounded[BoxIndex(bucket.sectorX)][BoxIndex(bucket.sectorY)][BoxIndex(bucket.sectorZ)];
+}
@@ -79,11 +79,6 @@ private:
 	bool IsCloserAndContains(double &closestFactionDist, const Sector::System *sys) const;
 };
 
-/* One day it might grow up to become a full tree, on the  other hand it might be
-   cut down before it's full growth to be replaced by
-   a proper spatial data structure.
-*/
-
 class FactionsDatabase {
 public:
 	FactionsDatabase(Galaxy *galaxy, const std::string &factionDir) :
@@ -105,6 +100,8 @@ public:
 	const Faction *GetFaction(const Uint32 index) const;
 	const Faction *GetFaction(const std::string &factionName) const;
 	const Faction *GetNearestClaimant(const Sector::System *sys) const;
+	// same answer as GetNearestClaimant, but without the claim index (for validation and benchmarking)
+	const Faction *GetNearestClaimantUnindexed(const Sector::System *sys) const;
 	bool IsHomeSystem(const SystemPath &sysPath) const;
 
 	Uint32 GetNumFactions() const;
@@ -112,10 +109,15 @@ public:
 	bool MayAssignFactions() const;
 
 private:
+	/* One day it might grow up to become a full tree, on the  other hand it might be
+	   cut down before it's full growth to be replaced by
+	   a proper spatial data structure.
+	*/
 	class Octsapling {
 	public:
 		void Add(const Faction *faction);
 		const std::vector<const Faction *> &CandidateFactions(const Sector::System *sys) const;
+		const std::vector<const Faction *> &CandidateFactions(Sint32 sx, Sint32 sy, Sint32 sz) const;
 
 	private:
 		std::vector<const Faction *> octbox[2][2][2];
@@ -123,6 +125,32 @@ private:
 		void PruneDuplicates(const int bx, const int by, const int bz);
 	};
 
+	/* Claim map over buckets of BUCKET_SECTORS^3 sectors, built once the home sectors are
+	   known. Each bucket keeps the Octsapling candidates of its cell (in the same order) that
+	   can actually claim a system inside the bucket, so GetNearestClaimant only has to look
+	   at a handful of factions instead of every faction on that side of Sol.
+	*/
+	class ClaimIndex {
+	public:
+		ClaimIndex() :
+			m_built(false) {}
+
+		void Build(const std::vector<Faction *> &factions, const Octsapling &octsapling);
+		void Clear();
+		bool IsBuilt() const { return m_built; }
+		const std::vector<const Faction *> &CandidateFactions(const Sector::System *sys) const;
+
+	private:
+		static const Sint32 BUCKET_SECTORS = 8;
+		static Sint32 BucketIndex(Sint32 sectorIndex) { return sectorIndex < 0 ? (sectorIndex + 1) / BUCKET_SECTORS - 1 : sectorIndex / BUCKET_SECTORS; }
+		static int BoxIndex(Sint32 bucketIndex) { return bucketIndex < 0 ? 0 : 1; }
+
+		typedef std::map<SystemPath, std::vector<const Faction *>, SystemPath::LessSectorOnly> BucketMap;
+		BucketMap m_buckets;
+		std::vector<const Faction *> m_unbounded[2][2][2]; // answer for buckets that no bounded faction reaches
+		bool m_built;
+	};
+
 	typedef std::vector<Faction *> FactionList;
 	typedef FactionList::iterator FactionIterator;
 	typedef const std::vector<const Faction *> ConstFactionList;
@@ -141,6 +169,7 @@ private:
 	FactionMap m_factions_byName;
 	HomeSystemSet m_homesystems;
 	Octsapling m_spatial_index;
+	ClaimIndex m_claim_index;
 	bool m_may_assign_factions;
 	bool m_initialized = false;
 	MissingFactionsMap m_missingFactionsMap;
@@ -76,6 +76,21 @@ void Galaxy::Init()
 #endif
 }
 
+void Galaxy::GetStarSystems(const std::vector<SystemPath> &paths, std::vector<RefCountedPtr<StarSystem>> &systems)
+{
+	PROFILE_SCOPED()
+	std::set<SystemPath, SystemPath::LessSectorOnly> sectorSet;
+	for (const SystemPath &path : paths)
+		if (!m_starSystemCache.GetIfCached(path))
+			sectorSet.insert(path.SectorOnly());
+
+	// keep the sectors alive until the systems that need them are done
+	std::vector<RefCountedPtr<Sector>> sectors;
+	GetSectors(std::vector<SystemPath>(sectorSet.begin(), sectorSet.end()), sectors);
+
+	m_starSystemCache.GetCachedBulk(paths, systems);
+}
+
 void Galaxy::FlushCaches()
 {
 	m_factions.ClearCache();
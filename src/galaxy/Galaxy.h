@@ -47,6 +47,12 @@ public:
 	RefCountedPtr<StarSystem> GetStarSystem(const SystemPath &path) { return m_starSystemCache.GetCached(path); }
 	RefCountedPtr<StarSystemCache::Slave> NewStarSystemSlaveCache() { return m_starSystemCache.NewSlaveCache(); }
 
+	// Bulk versions of GetSector and GetStarSystem, results match paths by index.
+	// Sectors are generated in parallel on the async job queue; star systems need Lua and
+	// are generated on the calling thread once all of their sectors have been generated.
+	void GetSectors(const std::vector<SystemPath> &paths, std::vector<RefCountedPtr<Sector>> &sectors) { m_sectorCache.GetCachedBulk(paths, sectors); }
+	void GetStarSystems(const std::vector<SystemPath> &paths, std::vector<RefCountedPtr<StarSystem>> &systems);
+
 	void FlushCaches();
 	void Dump(FILE *file, Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 radius);
 
@@ -67,6 +67,55 @@ RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::GetCached(const SystemPath &pat
 	return s;
 }
 
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T, CompareT>::GetCachedBulk(const PathVector &paths, std::vector<RefCountedPtr<T>> &objects)
+{
+	PROFILE_SCOPED()
+
+	objects.clear();
+	objects.resize(paths.size());
+
+	PathVector missing;
+	std::vector<size_t> missingIndex;
+	for (size_t i = 0; i < paths.size(); ++i) {
+		objects[i] = GetIfCached(paths[i]);
+		if (objects[i]) {
+			++m_cacheHits;
+		} else {
+			missing.push_back(paths[i]);
+			missingIndex.push_back(i);
+		}
+	}
+
+	if (missing.empty())
+		return;
+
+	JobQueue *queue = Pi::GetAsyncJobQueue();
+	if (!GENERATE_IN_WORKERS || !queue || missing.size() == 1) {
+		for (size_t i = 0; i < missing.size(); ++i)
+			objects[missingIndex[i]] = GetCached(missing[i]);
+		return;
+	}
+
+	// One job per runner, each of them pulls paths from the shared request until none are left.
+	// This thread pulls paths too, so the lookup finishes even when every runner is busy with
+	// something else; it only generates with a null cache, the same as the workers do.
+	m_cacheMisses += missing.size();
+	std::shared_ptr<BulkRequest> request(new BulkRequest(missing, RefCountedPtr<Galaxy>(m_galaxy)));
+	// A job is cancelled once its handle goes, even if it hasn't started, so keep them until it's all done.
+	const size_t numJobs = std::min<size_t>(queue->GetNumRunners(), missing.size());
+	std::vector<Job::Handle> jobs;
+	jobs.reserve(numJobs);
+	for (size_t i = 0; i < numJobs; ++i)
+		jobs.push_back(queue->Queue(new BulkJob(request)));
+	request->Generate();
+	request->Wait();
+
+	AddToCache(request->m_objects); // This modifies the vector to the objects already in the cache
+	for (size_t i = 0; i < missing.size(); ++i)
+		objects[missingIndex[i]] = request->m_objects[i];
+}
+
 template <typename T, typename CompareT>
 bool GalaxyObjectCache<T, CompareT>::HasCached(const SystemPath &path) const
 {
@@ -196,7 +245,8 @@ void GalaxyObjectCache<T, CompareT>::Slave::FillCache(const typename GalaxyObjec
 	unsigned toBeCreated = 0;
 #endif
 
-	// chop the paths into groups of CACHE_JOB_SIZE
+	PathVector uncached;
+	uncached.reserve(paths.size());
 	for (auto it = paths.begin(), itEnd = paths.end(); it != itEnd; ++it) {
 		RefCountedPtr<T> s = m_master->GetIfCached(*it);
 		if (s) {
@@ -205,20 +255,29 @@ void GalaxyObjectCache<T, CompareT>::Slave::FillCache(const typename GalaxyObjec
 			++masterCached;
 #endif
 		} else {
-			if (!current_paths) {
-				current_paths.reset(new PathVector);
-				current_paths->reserve(CACHE_JOB_SIZE);
-			}
-			current_paths->push_back(*it);
-			if (current_paths->size() >= CACHE_JOB_SIZE) {
-				vec_paths.push_back(std::move(current_paths));
-			}
+			uncached.push_back(*it);
 #ifdef DEBUG_CACHE
 			++toBeCreated;
 #endif
 		}
 	}
 
+	// spread the work over all runners, but in groups of at most CACHE_JOB_SIZE
+	const size_t numRunners = std::max<size_t>(m_jobs.GetQueue()->GetNumRunners(), 1);
+	const size_t jobSize = Clamp<size_t>((uncached.size() + numRunners - 1) / numRunners, 1, CACHE_JOB_SIZE);
+
+	// chop the paths into groups of jobSize
+	for (auto it = uncached.begin(), itEnd = uncached.end(); it != itEnd; ++it) {
+		if (!current_paths) {
+			current_paths.reset(new PathVector);
+			current_paths->reserve(jobSize);
+		}
+		current_paths->push_back(*it);
+		if (current_paths->size() >= jobSize) {
+			vec_paths.push_back(std::move(current_paths));
+		}
+	}
+
 	// catch the last loop in case it's got some entries (could be less than the spread width)
 	if (current_paths) {
 		vec_paths.push_back(std::move(current_paths));
@@ -270,11 +329,62 @@ void GalaxyObjectCache<T, CompareT>::CacheJob::OnFinish() // runs in primary thr
 		m_callback();
 }
 
+template <typename T, typename CompareT>
+GalaxyObjectCache<T, CompareT>::BulkRequest::BulkRequest(const PathVector &paths, RefCountedPtr<Galaxy> galaxy) :
+	m_paths(paths),
+	m_objects(paths.size()),
+	m_galaxy(galaxy),
+	m_galaxyGenerator(galaxy->GetGenerator()),
+	m_next(0),
+	m_remaining(paths.size())
+{
+	m_lock = SDL_CreateMutex();
+	m_doneCond = SDL_CreateCond();
+}
+
+template <typename T, typename CompareT>
+GalaxyObjectCache<T, CompareT>::BulkRequest::~BulkRequest()
+{
+	SDL_DestroyCond(m_doneCond);
+	SDL_DestroyMutex(m_lock);
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T, CompareT>::BulkRequest::Generate() // RUNS IN SEVERAL THREADS AT ONCE!! MUST BE THREAD SAFE!
+{
+	size_t done = 0;
+	for (size_t i = m_next++; i < m_paths.size(); i = m_next++) {
+		m_objects[i] = m_galaxyGenerator->Generate<T, GalaxyObjectCache<T, CompareT>>(m_galaxy, m_paths[i], nullptr);
+		++done;
+	}
+
+	if (done) {
+		SDL_LockMutex(m_lock);
+		m_remaining -= done;
+		if (!m_remaining)
+			SDL_CondBroadcast(m_doneCond);
+		SDL_UnlockMutex(m_lock);
+	}
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T, CompareT>::BulkRequest::Wait()
+{
+	PROFILE_SCOPED()
+	SDL_LockMutex(m_lock);
+	while (m_remaining)
+		SDL_CondWait(m_doneCond, m_lock);
+	SDL_UnlockMutex(m_lock);
+}
+
 /****** SectorCache ******/
 
 template <>
 const std::string GalaxyObjectCache<Sector, SystemPath::LessSectorOnly>::CACHE_NAME("SectorCache");
 
+template <>
+const bool GalaxyObjectCache<Sector, SystemPath::LessSectorOnly>::GENERATE_IN_WORKERS = true;
+
 template class GalaxyObjectCache<Sector, SystemPath::LessSectorOnly>;
 
 /****** StarSystemCache ******/
@@ -291,4 +401,8 @@ GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::Slave::Slave(GalaxyOb
 template <>
 const std::string GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::CACHE_NAME("StarSystemCache");
 
+// names for bodies and stations come from Lua, so this has to stay on the main thread
+template <>
+const bool GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::GENERATE_IN_WORKERS = false;
+
 template class GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>;
@@ -7,6 +7,7 @@
 #include "JobQueue.h"
 #include "RefCounted.h"
 #include "galaxy/SystemPath.h"
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
@@ -43,6 +44,11 @@ public:
 	typedef std::map<SystemPath, T *, CompareT> AtticMap;
 	typedef std::function<void()> CacheFilledCallback;
 
+	// Fetch many objects at once; `objects` matches `paths` by index. Missing objects are
+	// generated in parallel on the async job queue if that is safe for T (GENERATE_IN_WORKERS),
+	// otherwise one after the other on the calling thread. Blocks until all of them are ready.
+	void GetCachedBulk(const PathVector &paths, std::vector<RefCountedPtr<T>> &objects);
+
 	class Slave : public RefCounted {
 		friend class GalaxyObjectCache<T, CompareT>;
 
@@ -74,6 +80,7 @@ public:
 
 private:
 	static const unsigned CACHE_JOB_SIZE = 100;
+	static const bool GENERATE_IN_WORKERS;
 
 	void AddToCache(std::vector<RefCountedPtr<T>> &objects);
 	bool HasCached(const SystemPath &path) const;
@@ -99,6 +106,42 @@ private:
 		CacheFilledCallback m_callback;
 	};
 
+	// ********************************************************************************
+	// Work shared by the BulkJobs of one GetCachedBulk call
+	// ********************************************************************************
+	class BulkRequest {
+	public:
+		BulkRequest(const PathVector &paths, RefCountedPtr<Galaxy> galaxy);
+		~BulkRequest();
+
+		void Generate(); // RUNS IN SEVERAL THREADS AT ONCE!! MUST BE THREAD SAFE!
+		void Wait();
+
+		PathVector m_paths;
+		std::vector<RefCountedPtr<T>> m_objects;
+
+	private:
+		RefCountedPtr<Galaxy> m_galaxy;
+		RefCountedPtr<GalaxyGenerator> m_galaxyGenerator;
+		std::atomic<size_t> m_next;
+		size_t m_remaining;
+		SDL_mutex *m_lock;
+		SDL_cond *m_doneCond;
+	};
+
+	class BulkJob : public Job {
+	public:
+		BulkJob(std::shared_ptr<BulkRequest> request) :
+			m_request(request) {}
+
+		virtual void OnRun() { m_request->Generate(); } // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+		virtual void OnFinish() {}
+		virtual void OnCancel() {}
+
+	private:
+		std::shared_ptr<BulkRequest> m_request;
+	};
+
 	Galaxy *m_galaxy;
 	std::set<Slave *> m_slaves;
 	AtticMap m_attic; // Those contains non-refcounted pointers which are kept alive by RefCountedPtrs in slave caches
@@ -0,0 +1,131 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "SystemQuery.h"
+
+#include "galaxy/Galaxy.h"
+#include "galaxy/Sector.h"
+#include "galaxy/StarSystem.h"
+#include <algorithm>
+
+SystemQuery::SystemQuery(const SystemPath &center, double radius) :
+	m_center(center.SystemOnly()),
+	m_radius(radius),
+	m_includeCenter(false),
+	m_explored(EXPLORED_ANY),
+	m_hasPopulation(false),
+	m_economy(GalacticEconomy::InvalidEconomyId),
+	m_stations(STATIONS_ANY)
+{
+}
+
+void SystemQuery::SetPopulation(fixed min, fixed max)
+{
+	m_hasPopulation = true;
+	m_minPopulation = min;
+	m_maxPopulation = max;
+}
+
+bool SystemQuery::MatchStarSystem(const StarSystem *system) const
+{
+	if (!MatchPopulation(system->GetTotalPop()))
+		return false;
+	if (m_economy != GalacticEconomy::InvalidEconomyId && system->GetEconType() != m_economy)
+		return false;
+	if (m_stations == STATIONS_ONLY && !system->HasSpaceStations())
+		return false;
+	if (m_stations == NO_STATIONS && system->HasSpaceStations())
+		return false;
+	return true;
+}
+
+void SystemQuery::FindCandidates(Galaxy *galaxy, std::vector<SystemPath> &paths, std::vector<bool> &needSystem)
+{
+	PROFILE_SCOPED()
+	m_stats = Stats();
+
+	const int diff_sec = int(ceil(m_radius / Sector::SIZE));
+
+	std::vector<SystemPath> sectorPaths;
+	sectorPaths.reserve((2 * diff_sec + 1) * (2 * diff_sec + 1) * (2 * diff_sec + 1));
+	for (int x = m_center.sectorX - diff_sec; x <= m_center.sectorX + diff_sec; x++) {
+		for (int y = m_center.sectorY - diff_sec; y <= m_center.sectorY + diff_sec; y++) {
+			for (int z = m_center.sectorZ - diff_sec; z <= m_center.sectorZ + diff_sec; z++) {
+				sectorPaths.push_back(SystemPath(x, y, z));
+			}
+		}
+	}
+
+	std::vector<RefCountedPtr<Sector>> sectors;
+	galaxy->GetSectors(sectorPaths, sectors);
+	m_stats.sectors = sectors.size();
+
+	RefCountedPtr<const Sector> here_sec = galaxy->GetSector(m_center);
+
+	for (const RefCountedPtr<Sector> &sec : sectors) {
+		for (const Sector::System &sys : sec->m_systems) {
+			if (!m_includeCenter && sys.IsSameSystem(m_center))
+				continue;
+
+			if (Sector::DistanceBetween(here_sec, m_center.systemIndex, sec, sys.idx) > m_radius)
+				continue;
+			++m_stats.inRange;
+
+			if ((m_explored == EXPLORED_ONLY && !sys.IsExplored()) || (m_explored == UNEXPLORED_ONLY && sys.IsExplored()))
+				continue;
+
+			if (!m_factions.empty() && std::find(m_factions.begin(), m_factions.end(), sys.GetFaction()) == m_factions.end())
+				continue;
+
+			// a negative population means it hasn't been stored in the sector yet
+			const bool knownPopulation = sys.GetPopulation() >= 0;
+			if (knownPopulation && !MatchPopulation(sys.GetPopulation()))
+				continue;
+
+			paths.push_back(sys.GetPath());
+			needSystem.push_back(NeedsStarSystem() || (m_hasPopulation && !knownPopulation));
+			++m_stats.sectorMatches;
+		}
+	}
+}
+
+void SystemQuery::FindPaths(Galaxy *galaxy, std::vector<SystemPath> &paths)
+{
+	PROFILE_SCOPED()
+	std::vector<SystemPath> candidates;
+	std::vector<bool> needSystem;
+	FindCandidates(galaxy, candidates, needSystem);
+
+	std::vector<SystemPath> toGenerate;
+	for (size_t i = 0; i < candidates.size(); i++)
+		if (needSystem[i])
+			toGenerate.push_back(candidates[i]);
+
+	std::vector<RefCountedPtr<StarSystem>> systems;
+	galaxy->GetStarSystems(toGenerate, systems);
+	m_stats.generated = systems.size();
+
+	auto system = systems.begin();
+	for (size_t i = 0; i < candidates.size(); i++) {
+		if (needSystem[i]) {
+			// remember the population, so the next query can answer it from the sector
+			RefCountedPtr<Sector> sec = galaxy->GetMutableSector(candidates[i]);
+			sec->m_systems[candidates[i].systemIndex].SetPopulation((*system)->GetTotalPop());
+
+			const bool match = MatchStarSystem(system->Get());
+			++system;
+			if (!match)
+				continue;
+		}
+		paths.push_back(candidates[i]);
+	}
+	m_stats.matches = paths.size();
+}
+
+void SystemQuery::FindSystems(Galaxy *galaxy, std::vector<RefCountedPtr<StarSystem>> &systems)
+{
+	PROFILE_SCOPED()
+	std::vector<SystemPath> paths;
+	FindPaths(galaxy, paths);
+	galaxy->GetStarSystems(paths, systems);
+}
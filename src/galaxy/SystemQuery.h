@@ -0,0 +1,89 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SYSTEMQUERY_H
+#define _SYSTEMQUERY_H
+
+#include "RefCounted.h"
+#include "fixed.h"
+#include "galaxy/Economy.h"
+#include "galaxy/SystemPath.h"
+#include <vector>
+
+class Faction;
+class Galaxy;
+class StarSystem;
+
+/* Find the systems within some distance of a system that match a set of criteria.
+
+   The criteria are checked from cheapest to most expensive. Distance, exploration
+   state and faction only need the sector data, and so does population if a previous
+   query (or the sector view) has already stored it there. Only the systems that get
+   through those are turned into StarSystems, and only if some criterion remains that
+   needs one (unknown population, economy type or stations).
+
+   Results come out in the same order as StarSystem:GetNearbySystems has always
+   returned them: by sector x, y, z and then system index.
+*/
+class SystemQuery {
+public:
+	enum ExploredFilter {
+		EXPLORED_ANY,
+		EXPLORED_ONLY,
+		UNEXPLORED_ONLY
+	};
+
+	enum StationFilter {
+		STATIONS_ANY,
+		STATIONS_ONLY,
+		NO_STATIONS
+	};
+
+	struct Stats {
+		size_t sectors = 0;		 // sectors searched
+		size_t inRange = 0;		 // systems within the radius
+		size_t sectorMatches = 0; // systems that passed the sector-level checks
+		size_t generated = 0;	 // StarSystems that had to be fetched
+		size_t matches = 0;
+	};
+
+	SystemQuery(const SystemPath &center, double radius);
+
+	void SetIncludeCenter(bool include) { m_includeCenter = include; }
+	void SetExplored(ExploredFilter explored) { m_explored = explored; }
+	void AddFaction(const Faction *faction) { m_factions.push_back(faction); }
+	void SetPopulation(fixed min, fixed max);
+	void SetEconomy(GalacticEconomy::EconomyId economy) { m_economy = economy; }
+	void SetStations(StationFilter stations) { m_stations = stations; }
+
+	// the matching systems, generating StarSystems only where a criterion needs one
+	void FindPaths(Galaxy *galaxy, std::vector<SystemPath> &paths);
+	// the matching systems as StarSystems
+	void FindSystems(Galaxy *galaxy, std::vector<RefCountedPtr<StarSystem>> &systems);
+
+	const Stats &GetStats() const { return m_stats; }
+
+private:
+	bool NeedsStarSystem() const { return m_economy != GalacticEconomy::InvalidEconomyId || m_stations != STATIONS_ANY; }
+	bool MatchPopulation(fixed population) const { return !m_hasPopulation || (population >= m_minPopulation && population <= m_maxPopulation); }
+	bool MatchStarSystem(const StarSystem *system) const;
+
+	// systems that pass everything that can be checked in the sectors, plus whether
+	// each of them still has to be checked against its StarSystem
+	void FindCandidates(Galaxy *galaxy, std::vector<SystemPath> &paths, std::vector<bool> &needSystem);
+
+	const SystemPath m_center;
+	const double m_radius;
+	bool m_includeCenter;
+	ExploredFilter m_explored;
+	std::vector<const Faction *> m_factions;
+	bool m_hasPopulation;
+	fixed m_minPopulation;
+	fixed m_maxPopulation;
+	GalacticEconomy::EconomyId m_economy;
+	StationFilter m_stations;
+
+	Stats m_stats;
+};
+
+#endif /* _SYSTEMQUERY_H */
@@ -103,6 +103,10 @@ namespace Graphics {
 
 		virtual void SetCommonUniforms(const matrix4x4f &mv, const matrix4x4f &proj) = 0;
 
+		// identifies the shader program the material draws with, so that draws can
+		// be grouped by it; materials sharing a program return the same handle
+		virtual const void *GetProgramHandle() const { return nullptr; }
+
 		void *specialParameter0; //this can be whatever. Bit of a hack.
 
 		//XXX may not be necessary. Used by newmodel to check if a material uses patterns
@@ -0,0 +1,155 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "RenderQueue.h"
+#include "Material.h"
+#include "RenderState.h"
+#include "Stats.h"
+#include "profiler/Profiler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	// bits of each part of the key
+	const Uint32 PROGRAM_BITS = 12;
+	const Uint32 MATERIAL_BITS = 16;
+	const Uint32 TEXTURE_BITS = 16;
+	const Uint32 DEPTH_BITS = 18;
+
+	const Uint32 DEPTH_SHIFT = 0;
+	const Uint32 TEXTURE_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+	const Uint32 MATERIAL_SHIFT = TEXTURE_SHIFT + TEXTURE_BITS;
+	const Uint32 PROGRAM_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+	const Uint32 PASS_SHIFT = 62;
+
+	// blended draws are sorted on depth alone, just below the pass
+	const Uint32 TRANSPARENT_DEPTH_SHIFT = PASS_SHIFT - DEPTH_BITS;
+
+	static_assert(PROGRAM_SHIFT + PROGRAM_BITS <= PASS_SHIFT, "render queue key parts overlap");
+
+	inline Uint64 Field(Uint32 value, Uint32 bits)
+	{
+		return std::min(value, (Uint32(1) << bits) - 1);
+	}
+
+	// A positive float's bit pattern sorts the same way as its value, so the top
+	// bits below the sign make a depth that is coarse for far away things and
+	// fine for near ones.
+	inline Uint32 QuantiseDepth(float depth)
+	{
+		depth = std::max(depth, 0.0f);
+		Uint32 bits;
+		memcpy(&bits, &depth, sizeof(bits));
+		return bits >> (31 - DEPTH_BITS);
+	}
+
+	struct Changes {
+		Uint32 programs;
+		Uint32 materials;
+		Uint32 textures;
+	};
+
+	Changes CountChanges(const std::vector<const Graphics::RenderQueue::Item *> &items)
+	{
+		Changes changes = { 0, 0, 0 };
+		const Graphics::RenderQueue::Item *prev = nullptr;
+		for (const Graphics::RenderQueue::Item *item : items) {
+			const Graphics::Material *mat = item->material;
+			if (!prev || mat->GetProgramHandle() != prev->material->GetProgramHandle())
+				++changes.programs;
+			if (!prev || mat != prev->material)
+				++changes.materials;
+			if (!prev || mat->texture0 != prev->material->texture0)
+				++changes.textures;
+			prev = item;
+		}
+		return changes;
+	}
+} // namespace
+
+namespace Graphics {
+
+	RenderQueue::RenderQueue()
+	{
+	}
+
+	Uint64 RenderQueue::MakeKey(Pass pass, Uint32 program, Uint32 material, Uint32 texture, float depth)
+	{
+		const Uint64 d = QuantiseDepth(depth);
+		if (pass == PASS_TRANSPARENT)
+			return (Uint64(pass) << PASS_SHIFT) | ((((Uint64(1) << DEPTH_BITS) - 1) - d) << TRANSPARENT_DEPTH_SHIFT);
+
+		return (Uint64(pass) << PASS_SHIFT) |
+			(Field(program, PROGRAM_BITS) << PROGRAM_SHIFT) |
+			(Field(material, MATERIAL_BITS) << MATERIAL_SHIFT) |
+			(Field(texture, TEXTURE_BITS) << TEXTURE_SHIFT) |
+			(d << DEPTH_SHIFT);
+	}
+
+	Uint32 RenderQueue::GetId(IdMap &ids, const void *p)
+	{
+		return ids.emplace(p, Uint32(ids.size())).first->second;
+	}
+
+	void RenderQueue::Add(const matrix4x4f &transform, VertexBuffer *vb, IndexBuffer *ib, InstanceBuffer *instb, RenderState *state, Material *mat, PrimitiveType type)
+	{
+		const Pass pass = state->GetDesc().blendMode == BLEND_SOLID ? PASS_OPAQUE : PASS_TRANSPARENT;
+
+		// the transform is the model view matrix, so its translation is where the
+		// model is relative to the camera; squared, as only the order matters
+		const float depth = transform.GetTranslate().LengthSqr();
+
+		Item item;
+		item.key = MakeKey(pass,
+			GetId(m_programs, mat->GetProgramHandle()),
+			GetId(m_materials, mat),
+			GetId(m_textures, mat->texture0),
+			depth);
+		item.transform = transform;
+		item.vertices = vb;
+		item.indices = ib;
+		item.instances = instb;
+		item.state = state;
+		item.material = mat;
+		item.type = type;
+		m_items.push_back(item);
+	}
+
+	const std::vector<const RenderQueue::Item *> &RenderQueue::Sort(Stats &stats)
+	{
+		PROFILE_SCOPED()
+		m_sorted.clear();
+		m_sorted.reserve(m_items.size());
+		for (const Item &item : m_items)
+			m_sorted.push_back(&item);
+
+		const Changes before = CountChanges(m_sorted);
+
+		// the items are in one vector, so comparing pointers keeps equal keys in the order they were added
+		std::sort(m_sorted.begin(), m_sorted.end(), [](const Item *a, const Item *b) {
+			return a->key < b->key || (a->key == b->key && a < b);
+		});
+
+		const Changes after = CountChanges(m_sorted);
+
+		stats.AddToStatCount(Stats::STAT_QUEUED_DRAWS, m_items.size());
+		stats.AddToStatCount(Stats::STAT_PROGRAM_CHANGES_UNSORTED, before.programs);
+		stats.AddToStatCount(Stats::STAT_PROGRAM_CHANGES, after.programs);
+		stats.AddToStatCount(Stats::STAT_MATERIAL_CHANGES_UNSORTED, before.materials);
+		stats.AddToStatCount(Stats::STAT_MATERIAL_CHANGES, after.materials);
+		stats.AddToStatCount(Stats::STAT_TEXTURE_CHANGES_UNSORTED, before.textures);
+		stats.AddToStatCount(Stats::STAT_TEXTURE_CHANGES, after.textures);
+
+		return m_sorted;
+	}
+
+	void RenderQueue::Clear()
+	{
+		m_items.clear();
+		m_sorted.clear();
+		m_programs.clear();
+		m_materials.clear();
+		m_textures.clear();
+	}
+
+} // namespace Graphics
@@ -0,0 +1,82 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_RENDERQUEUE_H
+#define _GRAPHICS_RENDERQUEUE_H
+
+#include "Types.h"
+#include "matrix4x4.h"
+#include <unordered_map>
+#include <vector>
+
+namespace Graphics {
+
+	class IndexBuffer;
+	class InstanceBuffer;
+	class Material;
+	class RenderState;
+	class Stats;
+	class VertexBuffer;
+
+	/* The draws recorded between Renderer::BeginQueue() and EndQueue().
+
+	   Each draw gets a sort key made of its pass, program, material, texture
+	   and depth, in that order of importance. Opaque draws come first, grouped
+	   by program, then material, then texture, and front to back within that.
+	   Blended draws come after them, back to front, and draws at the same depth
+	   (everything in one model has the same transform) keep the order they were
+	   made in.
+
+	   Programs, materials and textures are numbered in the order they're first
+	   seen since the last Clear(), so the keys only mean something within one
+	   queue.
+	*/
+	class RenderQueue {
+	public:
+		enum Pass {
+			PASS_OPAQUE = 0,
+			PASS_TRANSPARENT = 1
+		};
+
+		struct Item {
+			Uint64 key;
+			matrix4x4f transform;
+			VertexBuffer *vertices;
+			IndexBuffer *indices;	   // may be null
+			InstanceBuffer *instances; // may be null
+			RenderState *state;
+			Material *material;
+			PrimitiveType type;
+		};
+
+		RenderQueue();
+
+		void Add(const matrix4x4f &transform, VertexBuffer *vb, IndexBuffer *ib, InstanceBuffer *instb, RenderState *state, Material *mat, PrimitiveType type);
+
+		// Returns the items in the order to draw them. Adds the number of program,
+		// material and texture changes in both the order the items were added in
+		// and the sorted order to the stats.
+		const std::vector<const Item *> &Sort(Stats &stats);
+
+		void Clear();
+
+		bool Empty() const { return m_items.empty(); }
+		size_t Size() const { return m_items.size(); }
+
+		static Uint64 MakeKey(Pass pass, Uint32 program, Uint32 material, Uint32 texture, float depth);
+
+	private:
+		typedef std::unordered_map<const void *, Uint32> IdMap;
+
+		static Uint32 GetId(IdMap &ids, const void *p);
+
+		std::vector<Item> m_items;
+		std::vector<const Item *> m_sorted;
+		IdMap m_programs;
+		IdMap m_materials;
+		IdMap m_textures;
+	};
+
+} // namespace Graphics
+
+#endif
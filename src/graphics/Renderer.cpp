@@ -3,6 +3,7 @@
 
 #include "Renderer.h"
 #include "Texture.h"
+#include "profiler/Profiler.h"
 
 namespace Graphics {
 
@@ -10,7 +11,8 @@ namespace Graphics {
 		m_width(w),
 		m_height(h),
 		m_ambient(Color::BLACK),
-		m_window(window)
+		m_window(window),
+		m_queueDepth(0)
 	{
 	}
 
@@ -48,4 +50,43 @@ namespace Graphics {
 		m_textureCache.clear();
 	}
 
+	void Renderer::BeginQueue()
+	{
+		++m_queueDepth;
+	}
+
+	void Renderer::EndQueue()
+	{
+		assert(m_queueDepth > 0);
+		if (--m_queueDepth == 0)
+			FlushQueue();
+	}
+
+	void Renderer::FlushQueue()
+	{
+		if (m_queue.Empty())
+			return;
+
+		PROFILE_SCOPED()
+		const matrix4x4f transform = GetTransform();
+
+		const Material *prevMaterial = nullptr;
+		for (const RenderQueue::Item *item : m_queue.Sort(m_stats)) {
+			DrawQueued(*item, item->material != prevMaterial);
+			prevMaterial = item->material;
+		}
+		m_queue.Clear();
+
+		SetTransform(transform);
+	}
+
+	bool Renderer::QueueDraw(VertexBuffer *vb, IndexBuffer *ib, InstanceBuffer *instb, RenderState *state, Material *mat, PrimitiveType type)
+	{
+		if (!m_queueDepth)
+			return false;
+
+		m_queue.Add(GetTransform(), vb, ib, instb, state, mat, type);
+		return true;
+	}
+
 } // namespace Graphics
@@ -6,6 +6,7 @@
 
 #include "Graphics.h"
 #include "Light.h"
+#include "RenderQueue.h"
 #include "Stats.h"
 #include "Types.h"
 #include "libs.h"
@@ -52,6 +53,9 @@ namespace Graphics {
 
 		virtual void WriteRendererInfo(std::ostream &out) const {}
 
+		// writes how long the shaders took to build, and what caching saved, to the log
+		virtual void LogShaderStats() const {}
+
 		virtual void CheckRenderErrors(const char *func = nullptr, const int line = -1) const {}
 
 		virtual bool SupportsInstancing() = 0;
@@ -126,6 +130,19 @@ namespace Graphics {
 		virtual bool DrawBufferInstanced(VertexBuffer *, RenderState *, Material *, InstanceBuffer *, PrimitiveType type = TRIANGLES) = 0;
 		virtual bool DrawBufferIndexedInstanced(VertexBuffer *, IndexBuffer *, RenderState *, Material *, InstanceBuffer *, PrimitiveType = TRIANGLES) = 0;
 
+		// Deferred drawing. Between BeginQueue() and EndQueue() the DrawBuffer*()
+		// calls are recorded along with the current transform instead of being
+		// drawn, and EndQueue() draws them sorted by RenderQueue's key, applying
+		// each material only once per run of draws that use it. Queues nest; only
+		// the outermost EndQueue() draws. Anything else that draws or changes
+		// renderer state (the projection, lights, depth range, ...) draws what has
+		// been queued first. The materials, states and buffers have to stay as they
+		// are until the queue is drawn.
+		void BeginQueue();
+		void EndQueue();
+		void FlushQueue();
+		bool IsQueueing() const { return m_queueDepth > 0; }
+
 		//creates a unique material based on the descriptor. It will not be deleted automatically.
 		virtual Material *CreateMaterial(const MaterialDescriptor &descriptor) = 0;
 		virtual Texture *CreateTexture(const TextureDescriptor &descriptor) = 0;
@@ -221,8 +238,15 @@ namespace Graphics {
 		virtual void PushState() = 0;
 		virtual void PopState() = 0;
 
+		// records the draw if a queue is open; false if it should be drawn now
+		bool QueueDraw(VertexBuffer *vb, IndexBuffer *ib, InstanceBuffer *instb, RenderState *state, Material *mat, PrimitiveType type);
+		// draws a queued item; applyMaterial is false if the previous item used the same material
+		virtual void DrawQueued(const RenderQueue::Item &item, bool applyMaterial) = 0;
+
 	private:
 		TextureCacheMap m_textureCache;
+		RenderQueue m_queue;
+		int m_queueDepth;
 	};
 
 } // namespace Graphics
@@ -22,6 +22,20 @@ namespace Graphics {
 			GetOrCreateCounter("Buffers Destroyed"),
 			GetOrCreateCounter("Buffers In Use", false),
 
+			GetOrCreateCounter("Stream Buffer Allocations"),
+			GetOrCreateCounter("Stream Buffer Bytes Written"),
+			GetOrCreateCounter("Stream Buffer Waits"),
+			GetOrCreateCounter("Stream Buffer Orphans"),
+			GetOrCreateCounter("Stream Buffer Memory", false),
+
+			GetOrCreateCounter("Queued Draws"),
+			GetOrCreateCounter("Program Changes (Unsorted)"),
+			GetOrCreateCounter("Program Changes"),
+			GetOrCreateCounter("Material Changes (Unsorted)"),
+			GetOrCreateCounter("Material Changes"),
+			GetOrCreateCounter("Texture Changes (Unsorted)"),
+			GetOrCreateCounter("Texture Changes"),
+
 			GetOrCreateCounter("Num Buildings"),
 			GetOrCreateCounter("Num Cities"),
 			GetOrCreateCounter("Num Ground Stations"),
@@ -32,6 +46,8 @@ namespace Graphics {
 			GetOrCreateCounter("Num Gas Giants"),
 			GetOrCreateCounter("Num Stars"),
 			GetOrCreateCounter("Num Ships"),
+			GetOrCreateCounter("Num Instanced Models"),
+			GetOrCreateCounter("Num Model Groups"),
 
 			GetOrCreateCounter("Num Billboards"),
 
@@ -40,7 +56,11 @@ namespace Graphics {
 			GetOrCreateCounter("TextureCube Count", false),
 			GetOrCreateCounter("TextureCube Memory Used", false),
 			GetOrCreateCounter("TextureArray2D Count", false),
-			GetOrCreateCounter("TextureArray2D Memory Used", false)
+			GetOrCreateCounter("TextureArray2D Memory Used", false),
+
+			GetOrCreateCounter("Textures Pending", false),
+			GetOrCreateCounter("Texture Uploads"),
+			GetOrCreateCounter("Texture Bytes Uploaded")
 		};
 	}
 
@@ -30,6 +30,22 @@ namespace Graphics {
 			STAT_DESTROY_BUFFER,
 			STAT_BUFFER_INUSE,
 
+			// stream buffer, for DrawTriangles and DrawPointSprites
+			STAT_STREAM_ALLOCS,
+			STAT_STREAM_BYTES,
+			STAT_STREAM_WAITS,
+			STAT_STREAM_ORPHANS,
+			STAT_MEM_STREAM_BUFFER,
+
+			// render queue, state changes as submitted and as drawn
+			STAT_QUEUED_DRAWS,
+			STAT_PROGRAM_CHANGES_UNSORTED,
+			STAT_PROGRAM_CHANGES,
+			STAT_MATERIAL_CHANGES_UNSORTED,
+			STAT_MATERIAL_CHANGES,
+			STAT_TEXTURE_CHANGES_UNSORTED,
+			STAT_TEXTURE_CHANGES,
+
 			// objects
 			STAT_BUILDINGS,
 			STAT_CITIES,
@@ -41,6 +57,8 @@ namespace Graphics {
 			STAT_GASGIANTS,
 			STAT_STARS,
 			STAT_SHIPS,
+			STAT_INSTANCED_MODELS,
+			STAT_MODEL_GROUPS,
 
 			// scenegraph entries
 			STAT_BILLBOARD,
@@ -53,6 +71,11 @@ namespace Graphics {
 			STAT_NUM_TEXTUREARRAY2D,
 			STAT_MEM_TEXTUREARRAY2D,
 
+			// textures loaded on the job queue
+			STAT_TEXTURES_PENDING,
+			STAT_TEXTURE_UPLOADS,
+			STAT_TEXTURE_UPLOAD_BYTES,
+
 			MAX_STAT
 		};
 
@@ -122,6 +122,11 @@ namespace Graphics {
 		virtual uint32_t GetTextureID() const = 0;
 		virtual uint32_t GetTextureMemSize() const = 0;
 
+		// Throws away the texture's contents and gives it new, empty storage for
+		// the descriptor, keeping the same object so that materials holding it
+		// see the new storage. Follow it with an Update().
+		virtual void Reallocate(const TextureDescriptor &descriptor) = 0;
+
 		virtual void Bind() = 0;
 		virtual void Unbind() = 0;
 
@@ -131,6 +136,8 @@ namespace Graphics {
 		Texture(const TextureDescriptor &descriptor) :
 			m_descriptor(descriptor) {}
 
+		void SetDescriptor(const TextureDescriptor &descriptor) { m_descriptor = descriptor; }
+
 	private:
 		TextureDescriptor m_descriptor;
 	};
@@ -3,11 +3,15 @@
 
 #include "TextureBuilder.h"
 #include "FileSystem.h"
+#include "JobQueue.h"
+#include "Stats.h"
 #include "profiler/Profiler.h"
 #include "utils.h"
 #include <SDL_image.h>
 #include <SDL_rwops.h>
 #include <algorithm>
+#include <deque>
+#include <memory>
 #include <sstream>
 
 namespace Graphics {
@@ -15,6 +19,51 @@ namespace Graphics {
 	//static
 	SDL_mutex *TextureBuilder::m_textureLock = nullptr;
 
+	// a file decoded on the job queue, waiting for the main thread to upload it
+	struct DecodedTexture {
+		std::string type;
+		Texture *texture; // the placeholder; only compared, never dereferenced
+		std::unique_ptr<TextureBuilder> builder;
+	};
+
+	static std::unique_ptr<JobSet> s_decodeJobs;
+	static SDL_mutex *s_decodedLock = nullptr;
+	static std::deque<DecodedTexture> s_decoded;
+	static Uint32 s_texturesPending = 0; // decoding or decoded, but not uploaded yet
+
+	// Loads and converts the file on a worker, and hands the result over. The
+	// texture's refcount isn't thread safe, so it's left alone until the upload.
+	class DecodeTextureJob : public Job {
+	public:
+		DecodeTextureJob(const std::string &type, Texture *texture, const TextureBuilder &builder) :
+			m_type(type),
+			m_texture(texture),
+			m_builder(new TextureBuilder(builder))
+		{}
+
+		virtual void OnRun() override
+		{
+			PROFILE_SCOPED()
+			m_builder->GetDescriptor();
+
+			DecodedTexture decoded;
+			decoded.type = m_type;
+			decoded.texture = m_texture;
+			decoded.builder = std::move(m_builder);
+
+			SDL_LockMutex(s_decodedLock);
+			s_decoded.push_back(std::move(decoded));
+			SDL_UnlockMutex(s_decodedLock);
+		}
+
+		virtual void OnFinish() override {}
+
+	private:
+		std::string m_type;
+		Texture *m_texture;
+		std::unique_ptr<TextureBuilder> m_builder;
+	};
+
 	TextureBuilder::TextureBuilder(const SDLSurfacePtr &surface, TextureSampleMode sampleMode, bool generateMipmaps, bool potExtend, bool forceRGBA, bool compressTextures, bool anisoFiltering) :
 		m_surface(surface),
 		m_sampleMode(sampleMode),
@@ -65,6 +114,79 @@ namespace Graphics {
 	void TextureBuilder::Init()
 	{
 		m_textureLock = SDL_CreateMutex();
+		s_decodedLock = SDL_CreateMutex();
+	}
+
+	Texture *TextureBuilder::GetOrCreateTextureAsync(Renderer *r, const std::string &type, const Color &placeholder)
+	{
+		if (!s_decodeJobs || m_filenames.empty() || m_textureType != TEXTURE_2D)
+			return GetOrCreateTexture(r, type);
+
+		SDL_LockMutex(m_textureLock);
+		Texture *t = r->GetCachedTexture(type, m_filenames.front());
+		if (t) {
+			SDL_UnlockMutex(m_textureLock);
+			return t;
+		}
+		const TextureDescriptor desc(TEXTURE_RGBA_8888, vector3f(1.0f), m_sampleMode, false, false, m_anisotropicFiltering, 0, TEXTURE_2D);
+		t = r->CreateTexture(desc);
+		t->Update(&placeholder, vector3f(1.0f, 1.0f, 0.0f), TEXTURE_RGBA_8888);
+		r->AddCachedTexture(type, m_filenames.front(), t);
+		SDL_UnlockMutex(m_textureLock);
+
+		s_decodeJobs->Order(new DecodeTextureJob(type, t, *this));
+		++s_texturesPending;
+		r->GetStats().SetStatCount(Stats::STAT_TEXTURES_PENDING, s_texturesPending);
+		return t;
+	}
+
+	void TextureBuilder::SetJobQueue(JobQueue *queue)
+	{
+		// cancels the jobs that haven't run yet
+		s_decodeJobs.reset(queue ? new JobSet(queue) : nullptr);
+
+		SDL_LockMutex(s_decodedLock);
+		s_decoded.clear();
+		SDL_UnlockMutex(s_decodedLock);
+		s_texturesPending = 0;
+	}
+
+	void TextureBuilder::UploadTextures(Renderer *r, Uint32 byteBudget)
+	{
+		PROFILE_SCOPED()
+		Uint32 uploads = 0;
+		Uint32 bytes = 0;
+		while (!uploads || bytes < byteBudget) {
+			SDL_LockMutex(s_decodedLock);
+			if (s_decoded.empty()) {
+				SDL_UnlockMutex(s_decodedLock);
+				break;
+			}
+			DecodedTexture decoded = std::move(s_decoded.front());
+			s_decoded.pop_front();
+			SDL_UnlockMutex(s_decodedLock);
+
+			if (s_texturesPending)
+				--s_texturesPending;
+
+			// the placeholder may have been dropped from the cache while it was loading
+			TextureBuilder &builder = *decoded.builder;
+			SDL_LockMutex(m_textureLock);
+			Texture *t = r->GetCachedTexture(decoded.type, builder.m_filenames.front());
+			SDL_UnlockMutex(m_textureLock);
+			if (t != decoded.texture)
+				continue;
+
+			t->Reallocate(builder.GetDescriptor());
+			builder.UpdateTexture(t);
+			bytes += builder.GetDataSize();
+			++uploads;
+		}
+
+		Stats &stats = r->GetStats();
+		stats.SetStatCount(Stats::STAT_TEXTURES_PENDING, s_texturesPending);
+		stats.AddToStatCount(Stats::STAT_TEXTURE_UPLOADS, uploads);
+		stats.AddToStatCount(Stats::STAT_TEXTURE_UPLOAD_BYTES, bytes);
 	}
 
 // RGBA and RGBpixel format for converting textures
@@ -366,6 +488,18 @@ namespace Graphics {
 		}
 	}
 
+	size_t TextureBuilder::GetDataSize() const
+	{
+		size_t size = 0;
+		if (m_surface)
+			size += size_t(m_surface->pitch) * m_surface->h;
+		if (m_dds.headerdone_)
+			size += m_dds.imgdata_.size;
+		for (const PicoDDS::DDSImage &dds : m_ddsarray)
+			size += dds.imgdata_.size;
+		return size;
+	}
+
 	Texture *TextureBuilder::GetWhiteTexture(Renderer *r)
 	{
 		return Model("textures/white.png").GetOrCreateTexture(r, "model");
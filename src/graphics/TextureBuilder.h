@@ -4,6 +4,7 @@
 #ifndef _TEXTUREBUILDER_H
 #define _TEXTUREBUILDER_H
 
+#include "Color.h"
 #include "Renderer.h"
 #include "SDLWrappers.h"
 #include "Texture.h"
@@ -12,6 +13,8 @@
 
 #include "PicoDDS/PicoDDS.h"
 
+class JobQueue;
+
 namespace Graphics {
 
 	class TextureBuilder {
@@ -89,6 +92,22 @@ namespace Graphics {
 			return t;
 		}
 
+		// Like GetOrCreateTexture, but a 2D texture that isn't in the cache yet
+		// is returned straight away as a single texel of the placeholder colour,
+		// and the file is decoded on the job queue given to SetJobQueue(). The
+		// texture gets its real contents in a later UploadTextures(). Without a
+		// job queue this is just GetOrCreateTexture.
+		Texture *GetOrCreateTextureAsync(Renderer *r, const std::string &type, const Color &placeholder = Color::WHITE);
+
+		// The queue to decode textures on, or nullptr to load them synchronously.
+		// Anything still waiting to be decoded or uploaded is dropped, leaving
+		// its placeholder in the cache.
+		static void SetJobQueue(JobQueue *queue);
+
+		// Uploads decoded textures, stopping once byteBudget bytes have gone up
+		// but always doing at least one. Call once a frame on the main thread.
+		static void UploadTextures(Renderer *r, Uint32 byteBudget);
+
 		//commonly used dummy textures
 		static Texture *GetWhiteTexture(Renderer *);
 		static Texture *GetTransparentTexture(Renderer *);
@@ -119,6 +138,7 @@ namespace Graphics {
 			return t;
 		}
 		void UpdateTexture(Texture *texture); // XXX pass src/dest rectangles
+		size_t GetDataSize() const;			  // bytes of decoded image data
 		void PrepareSurface();
 		bool m_prepared;
 
@@ -99,8 +99,9 @@ namespace Graphics {
 		// copies the contents of the VertexArray into the buffer
 		virtual bool Populate(const VertexArray &) = 0;
 
-		// change the buffer data without mapping
-		virtual void BufferData(const size_t, void *) = 0;
+		// change the buffer data without mapping; a static buffer is given all of
+		// its data at once this way, without a copy in between
+		virtual void BufferData(const size_t, const void *) = 0;
 
 		virtual void Bind() = 0;
 		virtual void Release() = 0;
@@ -117,8 +118,9 @@ namespace Graphics {
 		virtual ~IndexBuffer();
 		virtual Uint32 *Map(BufferMapMode) = 0;
 
-		// change the buffer data without mapping
-		virtual void BufferData(const size_t, void *) = 0;
+		// change the buffer data without mapping; a static buffer is given all of
+		// its data at once this way, without a copy in between
+		virtual void BufferData(const size_t, const void *) = 0;
 
 		Uint32 GetIndexCount() const { return m_indexCount; }
 		void SetIndexCount(Uint32);
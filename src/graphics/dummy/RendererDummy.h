@@ -21,7 +21,7 @@ namespace Graphics {
 
 		RendererDummy() :
 			Renderer(0, 0, 0),
-			m_identity(matrix4x4f::Identity())
+			m_modelView(matrix4x4f::Identity())
 		{}
 
 		virtual const char *GetName() const override final { return "Dummy"; }
@@ -31,7 +31,7 @@ namespace Graphics {
 		virtual bool GetNearFarRange(float &near_, float &far_) const override final { return true; }
 
 		virtual bool BeginFrame() override final { return true; }
-		virtual bool EndFrame() override final { return true; }
+		virtual bool EndFrame() override final { FlushQueue(); return true; }
 		virtual bool SwapBuffers() override final { return true; }
 
 		virtual bool SetRenderState(RenderState *) override final { return true; }
@@ -47,8 +47,8 @@ namespace Graphics {
 		virtual bool SetViewport(Viewport v) override final { return true; }
 		virtual Viewport GetViewport() const override final { return {}; }
 
-		virtual bool SetTransform(const matrix4x4f &m) override final { return true; }
-		virtual matrix4x4f GetTransform() const override final { return matrix4x4f::Identity(); }
+		virtual bool SetTransform(const matrix4x4f &m) override final { m_modelView = m; return true; }
+		virtual matrix4x4f GetTransform() const override final { return m_modelView; }
 		virtual bool SetPerspectiveProjection(float fov, float aspect, float near_, float far_) override final { return true; }
 		virtual bool SetOrthographicProjection(float xmin, float xmax, float ymin, float ymax, float zmin, float zmax) override final { return true; }
 		virtual bool SetProjection(const matrix4x4f &m) override final { return true; }
@@ -65,10 +65,10 @@ namespace Graphics {
 		virtual bool DrawTriangles(const VertexArray *vertices, RenderState *state, Material *material, PrimitiveType type = TRIANGLES) override final { return true; }
 		virtual bool DrawPointSprites(const Uint32 count, const vector3f *positions, RenderState *rs, Material *material, float size) override final { return true; }
 		virtual bool DrawPointSprites(const Uint32 count, const vector3f *positions, const vector2f *offsets, const float *sizes, RenderState *rs, Material *material) override final { return true; }
-		virtual bool DrawBuffer(VertexBuffer *, RenderState *, Material *, PrimitiveType) override final { return true; }
-		virtual bool DrawBufferIndexed(VertexBuffer *, IndexBuffer *, RenderState *, Material *, PrimitiveType) override final { return true; }
-		virtual bool DrawBufferInstanced(VertexBuffer *, RenderState *, Material *, InstanceBuffer *, PrimitiveType type = TRIANGLES) override final { return true; }
-		virtual bool DrawBufferIndexedInstanced(VertexBuffer *, IndexBuffer *, RenderState *, Material *, InstanceBuffer *, PrimitiveType = TRIANGLES) override final { return true; }
+		virtual bool DrawBuffer(VertexBuffer *vb, RenderState *rs, Material *m, PrimitiveType pt) override final { QueueDraw(vb, nullptr, nullptr, rs, m, pt); return true; }
+		virtual bool DrawBufferIndexed(VertexBuffer *vb, IndexBuffer *ib, RenderState *rs, Material *m, PrimitiveType pt) override final { QueueDraw(vb, ib, nullptr, rs, m, pt); return true; }
+		virtual bool DrawBufferInstanced(VertexBuffer *vb, RenderState *rs, Material *m, InstanceBuffer *instb, PrimitiveType pt = TRIANGLES) override final { QueueDraw(vb, nullptr, instb, rs, m, pt); return true; }
+		virtual bool DrawBufferIndexedInstanced(VertexBuffer *vb, IndexBuffer *ib, RenderState *rs, Material *m, InstanceBuffer *instb, PrimitiveType pt = TRIANGLES) override final { QueueDraw(vb, ib, instb, rs, m, pt); return true; }
 
 		virtual Material *CreateMaterial(const MaterialDescriptor &d) override final { return new Graphics::Dummy::Material(); }
 		virtual Texture *CreateTexture(const TextureDescriptor &d) override final { return new Graphics::TextureDummy(d); }
@@ -83,9 +83,11 @@ namespace Graphics {
 	protected:
 		virtual void PushState() override final {}
 		virtual void PopState() override final {}
+		// nothing to draw, but the queue is still sorted and counted
+		virtual void DrawQueued(const RenderQueue::Item &item, bool applyMaterial) override {}
 
 	private:
-		const matrix4x4f m_identity;
+		matrix4x4f m_modelView; // kept so that queued draws get sorted on depth
 	};
 
 } // namespace Graphics
@@ -21,6 +21,7 @@ namespace Graphics {
 		virtual void BuildMipmaps(const uint32_t) override {}
 		virtual uint32_t GetTextureID() const override final { return 0U; }
 		uint32_t GetTextureMemSize() const final { return 0U; }
+		virtual void Reallocate(const TextureDescriptor &descriptor) override final { SetDescriptor(descriptor); }
 
 	private:
 		friend class RendererDummy;
@@ -5,6 +5,8 @@
 #define DUMMY_VERTEXBUFFER_H
 
 #include "graphics/VertexBuffer.h"
+#include <algorithm>
+#include <cstring>
 
 namespace Graphics {
 
@@ -21,7 +23,10 @@ namespace Graphics {
 			virtual bool Populate(const VertexArray &) override final { return true; }
 
 			// change the buffer data without mapping
-			virtual void BufferData(const size_t, void *) override final {}
+			virtual void BufferData(const size_t size, const void *data) override final
+			{
+				memcpy(m_buffer.get(), data, std::min(size, size_t(m_desc.numVertices * m_desc.stride)));
+			}
 
 			virtual void Bind() override final {}
 			virtual void Release() override final {}
@@ -44,7 +49,10 @@ namespace Graphics {
 			virtual Uint32 *Map(BufferMapMode) override final { return m_buffer.get(); }
 			virtual void Unmap() override final {}
 
-			virtual void BufferData(const size_t, void *) override final {}
+			virtual void BufferData(const size_t size, const void *data) override final
+			{
+				memcpy(m_buffer.get(), data, std::min(size, sizeof(Uint32) * m_size));
+			}
 
 			virtual void Bind() override final {}
 			virtual void Release() override final {}
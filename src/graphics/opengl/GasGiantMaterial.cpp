@@ -91,8 +91,6 @@ namespace Graphics {
 			const GeoSphere::MaterialParameters params = *static_cast<GeoSphere::MaterialParameters *>(this->specialParameter0);
 			const AtmosphereParameters ap = params.atmosphere;
 
-			p->emission.Set(this->emissive);
-			p->sceneAmbient.Set(m_renderer->GetAmbientColor());
 			p->atmosColor.Set(ap.atmosCol);
 			p->geosphereAtmosFogDensity.Set(ap.atmosDensity);
 			p->geosphereAtmosInvScaleHeight.Set(ap.atmosInvScaleHeight);
@@ -101,16 +99,6 @@ namespace Graphics {
 			p->geosphereRadius.Set(ap.planetRadius);
 			p->geosphereInvRadius.Set(1.0f / ap.planetRadius);
 
-			//Light uniform parameters
-			for (Uint32 i = 0; i < m_renderer->GetNumLights(); i++) {
-				const Light &Light = m_renderer->GetLight(i);
-				p->lights[i].diffuse.Set(Light.GetDiffuse());
-				p->lights[i].specular.Set(Light.GetSpecular());
-				const vector3f &pos = Light.GetPosition();
-				p->lights[i].position.Set(pos.x, pos.y, pos.z, (Light.GetType() == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f));
-			}
-
-			p->diffuse.Set(this->diffuse);
 			p->texture0.Set(this->texture0, 0);
 
 			// we handle up to three shadows at a time
@@ -107,8 +107,6 @@ namespace Graphics {
 			const GeoSphere::MaterialParameters params = *static_cast<GeoSphere::MaterialParameters *>(this->specialParameter0);
 			const AtmosphereParameters ap = params.atmosphere;
 
-			p->emission.Set(this->emissive);
-			p->sceneAmbient.Set(m_renderer->GetAmbientColor());
 			p->atmosColor.Set(ap.atmosCol);
 			p->geosphereAtmosFogDensity.Set(ap.atmosDensity);
 			p->geosphereAtmosInvScaleHeight.Set(ap.atmosInvScaleHeight);
@@ -127,15 +125,6 @@ namespace Graphics {
 				p->detailScaleLo.Set(loScale * fDetailFrequency);
 			}
 
-			//Light uniform parameters
-			for (Uint32 i = 0; i < m_renderer->GetNumLights(); i++) {
-				const Light &Light = m_renderer->GetLight(i);
-				p->lights[i].diffuse.Set(Light.GetDiffuse());
-				p->lights[i].specular.Set(Light.GetSpecular());
-				const vector3f &pos = Light.GetPosition();
-				p->lights[i].position.Set(pos.x, pos.y, pos.z, (Light.GetType() == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f));
-			}
-
 			// we handle up to three shadows at a time
 			vector3f shadowCentreX;
 			vector3f shadowCentreY;
@@ -234,10 +223,6 @@ namespace Graphics {
 		void GeoSphereStarMaterial::SetGSUniforms()
 		{
 			OGL::Material::Apply();
-
-			GeoSphereProgram *p = static_cast<GeoSphereProgram *>(m_program);
-
-			p->emission.Set(this->emissive);
 		}
 
 	} // namespace OGL
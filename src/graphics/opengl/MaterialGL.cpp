@@ -4,16 +4,65 @@
 #include "MaterialGL.h"
 #include "Program.h"
 #include "RendererGL.h"
+#include <cstring>
 
 namespace Graphics {
 	namespace OGL {
 
+		GLuint Material::s_boundUniformBuffer = 0;
+
+		Material::~Material()
+		{
+			if (m_uniformBuffer) {
+				if (s_boundUniformBuffer == m_uniformBuffer)
+					s_boundUniformBuffer = 0;
+				glDeleteBuffers(1, &m_uniformBuffer);
+			}
+		}
+
 		void Material::Apply()
+		{
+			ApplyProgram();
+			ApplyMaterialUniforms(emissive, diffuse, specular, float(shininess));
+		}
+
+		void Material::ApplyProgram()
 		{
 			m_program->Use();
 			m_program->invLogZfarPlus1.Set(m_renderer->m_invLogZfarPlus1);
 		}
 
+		void Material::ApplyMaterialUniforms(const Color &emission, const Color &diffuse, const Color &specular, float shininess)
+		{
+			if (!m_program->UsesMaterialUniforms())
+				return;
+
+			MaterialUniformData data;
+			memset(&data, 0, sizeof(data));
+			data.emission = emission.ToColor4f();
+			data.diffuse = diffuse.ToColor4f();
+			data.specular = specular.ToColor4f();
+			data.shininess = shininess;
+
+			if (!m_uniformBuffer) {
+				glGenBuffers(1, &m_uniformBuffer);
+				glBindBuffer(GL_UNIFORM_BUFFER, m_uniformBuffer);
+				glBufferData(GL_UNIFORM_BUFFER, sizeof(data), &data, GL_DYNAMIC_DRAW);
+				glBindBuffer(GL_UNIFORM_BUFFER, 0);
+				m_uniformData = data;
+			} else if (memcmp(&data, &m_uniformData, sizeof(data))) {
+				glBindBuffer(GL_UNIFORM_BUFFER, m_uniformBuffer);
+				glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), &data);
+				glBindBuffer(GL_UNIFORM_BUFFER, 0);
+				m_uniformData = data;
+			}
+
+			if (s_boundUniformBuffer != m_uniformBuffer) {
+				glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_UNIFORMS_BINDING, m_uniformBuffer);
+				s_boundUniformBuffer = m_uniformBuffer;
+			}
+		}
+
 		void Material::Unapply()
 		{
 		}
@@ -29,7 +78,6 @@ namespace Graphics {
 			const matrix3x3f orient(mv.GetOrient());
 			const matrix3x3f NormalMatrix(orient.Inverse());
 
-			m_program->uProjectionMatrix.Set(proj);
 			m_program->uViewMatrix.Set(mv);
 			m_program->uViewMatrixInverse.Set(mv.Inverse());
 			m_program->uViewProjectionMatrix.Set(ViewProjection);
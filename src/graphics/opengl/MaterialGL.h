@@ -23,9 +23,21 @@ namespace Graphics {
 
 		class Program;
 
+		// The MaterialUniforms block in attributes.glsl, in std140 layout
+		struct MaterialUniformData {
+			Color4f emission;
+			Color4f ambient;
+			Color4f diffuse;
+			Color4f specular;
+			float shininess;
+			float padding[3];
+		};
+
 		class Material : public Graphics::Material {
 		public:
-			Material() {}
+			Material() :
+				m_uniformBuffer(0) {}
+			virtual ~Material();
 			// Create an appropriate program for this material.
 			virtual Program *CreateProgram(const MaterialDescriptor &) = 0;
 			// bind textures, set uniforms
@@ -34,11 +46,26 @@ namespace Graphics {
 			virtual bool IsProgramLoaded() const override final;
 			virtual void SetProgram(Program *p) { m_program = p; }
 			virtual void SetCommonUniforms(const matrix4x4f &mv, const matrix4x4f &proj) override;
+			virtual const void *GetProgramHandle() const override { return m_program; }
 
 		protected:
+			// The part of Apply() before the material uniforms, for materials that
+			// upload those with values of their own.
+			void ApplyProgram();
+			// Binds this material's uniform block with the given values, uploading
+			// them only if they differ from what the buffer already holds.
+			// Apply() does this with the material's own colours.
+			void ApplyMaterialUniforms(const Color &emission, const Color &diffuse, const Color &specular, float shininess);
+
 			friend class Graphics::RendererOGL;
 			Program *m_program;
 			RendererOGL *m_renderer;
+
+		private:
+			static GLuint s_boundUniformBuffer;
+
+			GLuint m_uniformBuffer;
+			MaterialUniformData m_uniformData;
 		};
 	} // namespace OGL
 } // namespace Graphics
@@ -82,8 +82,6 @@ namespace Graphics {
 
 			MultiProgram *p = static_cast<MultiProgram *>(m_program);
 
-			p->diffuse.Set(this->diffuse);
-
 			p->texture0.Set(this->texture0, 0);
 			p->texture1.Set(this->texture1, 1);
 			p->texture2.Set(this->texture2, 2);
@@ -118,21 +116,6 @@ namespace Graphics {
 			}
 
 			MultiMaterial::Apply();
-
-			MultiProgram *p = static_cast<MultiProgram *>(m_program);
-			p->emission.Set(this->emissive);
-			p->specular.Set(this->specular);
-			p->shininess.Set(float(this->shininess));
-			p->sceneAmbient.Set(m_renderer->GetAmbientColor());
-
-			//Light uniform parameters
-			for (Uint32 i = 0; i < m_renderer->GetNumLights(); i++) {
-				const Light &Light = m_renderer->GetLight(i);
-				p->lights[i].diffuse.Set(Light.GetDiffuse());
-				p->lights[i].specular.Set(Light.GetSpecular());
-				const vector3f pos = Light.GetPosition();
-				p->lights[i].position.Set(pos.x, pos.y, pos.z, (Light.GetType() == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f));
-			}
 			CHECKERRORS();
 		}
 
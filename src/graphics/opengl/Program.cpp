@@ -6,8 +6,11 @@
 #include "StringF.h"
 #include "StringRange.h"
 #include "graphics/Graphics.h"
+#include "jenkins/lookup3.h"
 #include "utils.h"
 
+#include <algorithm>
+#include <cstring>
 #include <set>
 
 namespace Graphics {
@@ -20,6 +23,35 @@ namespace Graphics {
 		static const char *s_glslVersion = "#version 140\n";
 		GLuint Program::s_curProgram = 0;
 
+		// The linked programs are kept in the user directory, in the driver's own
+		// format, one file for each program name and set of defines. A file holds
+		// a hash of the complete source of both shaders and the driver's vendor,
+		// renderer and version strings, and is written over when that changes, so
+		// the cache doesn't grow as shaders and drivers are updated.
+		static const char s_binaryCacheDir[] = "shadercache";
+		static const Uint32 s_binaryCacheVersion = 2;
+
+		struct BinaryCacheHeader {
+			char magic[4];
+			Uint32 version;
+			Uint32 sourceHash[2];
+			Uint32 format;
+			Uint32 length;
+			float compileMs; // how long it took to build from source, to report what loading it saved
+		};
+
+		static bool s_binaryCacheEnabled = false;
+		static std::string s_driverString;
+
+		static struct {
+			Uint32 hits;
+			Uint32 misses;
+			Uint32 rejected;
+			double compileMs;
+			double loadMs;
+			double savedMs;
+		} s_binaryCacheStats;
+
 		// Check and warn about compile & link errors
 		static bool check_glsl_errors(const char *filename, GLuint obj)
 		{
@@ -75,22 +107,27 @@ namespace Graphics {
 			return true;
 		}
 
+		// Reads a shader and its includes and builds the text to compile, which
+		// Hash() and Compile() then use.
 		struct Shader {
-			Shader(GLenum type, const std::string &filename, const std::string &defines)
+			Shader(GLenum type, const std::string &filename, const std::string &defines) :
+				shader(0),
+				m_type(type),
+				m_filename(filename)
 			{
 				RefCountedPtr<FileSystem::FileData> filecode = FileSystem::gameDataFiles.ReadFile(filename);
 
 				if (!filecode.Valid())
 					Error("Could not load %s", filename.c_str());
 
-				std::string strCode(filecode->AsStringRange().ToString());
-				size_t found = strCode.find("#include");
+				m_code = filecode->AsStringRange().ToString();
+				size_t found = m_code.find("#include");
 				while (found != std::string::npos) {
 					// find the name of the file to include
-					const size_t begFilename = strCode.find_first_of("\"", found + 8) + 1;
-					const size_t endFilename = strCode.find_first_of("\"", begFilename + 1);
+					const size_t begFilename = m_code.find_first_of("\"", found + 8) + 1;
+					const size_t endFilename = m_code.find_first_of("\"", begFilename + 1);
 
-					const std::string incFilename = strCode.substr(begFilename, endFilename - begFilename);
+					const std::string incFilename = m_code.substr(begFilename, endFilename - begFilename);
 
 					// check we haven't it already included it (avoids circular dependencies)
 					const std::set<std::string>::const_iterator foundIt = previousIncludes.find(incFilename);
@@ -109,14 +146,14 @@ namespace Graphics {
 
 					if (incCode.Valid()) {
 						// replace the #include and filename with the included files text
-						strCode.replace(found, (endFilename + 1) - found, incCode->GetData(), incCode->GetSize());
-						found = strCode.find("#include");
+						m_code.replace(found, (endFilename + 1) - found, incCode->GetData(), incCode->GetSize());
+						found = m_code.find("#include");
 					} else {
 						Error("Could not load shader #include %s for shader %s\n", incPathBuffer.c_str(), filename.c_str());
 					}
 				}
 				// Store the modified text with the included files (if any)
-				const StringRange code(strCode.c_str(), strCode.size());
+				const StringRange code(m_code.c_str(), m_code.size());
 
 				// Build the final shader text to be compiled
 				AppendSource(s_glslVersion);
@@ -151,19 +188,30 @@ namespace Graphics {
 			}
 		}
 #endif
-				shader = glCreateShader(type);
+			};
+
+			~Shader()
+			{
+				if (shader)
+					glDeleteShader(shader);
+			}
+
+			void Hash(Uint32 &pc, Uint32 &pb) const
+			{
+				for (size_t i = 0; i < blocks.size(); i++)
+					lookup3_hashlittle2(blocks[i], block_sizes[i], &pc, &pb);
+			}
+
+			void Compile()
+			{
+				shader = glCreateShader(m_type);
 				if (glIsShader(shader) != GL_TRUE)
 					throw ShaderException();
 
 				Compile(shader);
 
-				if (!check_glsl_errors(filename.c_str(), shader))
+				if (!check_glsl_errors(m_filename.c_str(), shader))
 					throw ShaderException();
-			};
-
-			~Shader()
-			{
-				glDeleteShader(shader);
 			}
 
 			GLuint shader;
@@ -188,16 +236,165 @@ namespace Graphics {
 				glCompileShader(shader_id);
 			}
 
+			GLenum m_type;
+			std::string m_filename;
+			std::string m_code; // the blocks point into this
 			std::vector<const char *> blocks;
 			std::vector<GLint> block_sizes;
 			std::set<std::string> previousIncludes;
 		};
 
+		static std::string BinaryCachePath(const std::string &name, const std::string &defines)
+		{
+			char hash[10];
+			snprintf(hash, sizeof(hash), "%08x", lookup3_hashlittle(defines.data(), defines.size(), 0));
+			return stringf("%0/%1-%2.bin", s_binaryCacheDir, name, hash);
+		}
+
+		static void BinarySourceHash(const Shader &vs, const Shader &fs, Uint32 hash[2])
+		{
+			hash[0] = hash[1] = 0;
+			lookup3_hashlittle2(s_driverString.data(), s_driverString.size(), &hash[0], &hash[1]);
+			vs.Hash(hash[0], hash[1]);
+			fs.Hash(hash[0], hash[1]);
+		}
+
+		// Links the program from a cached binary if there is one, it was built from
+		// the same source by the same driver, and the driver takes it.
+		static bool LoadBinary(GLuint program, const std::string &path, const Uint32 sourceHash[2])
+		{
+			PROFILE_SCOPED()
+			RefCountedPtr<FileSystem::FileData> data = FileSystem::userFiles.ReadFile(path);
+			if (!data.Valid())
+				return false;
+
+			BinaryCacheHeader header;
+			if (data->GetSize() < sizeof(header)) {
+				++s_binaryCacheStats.rejected;
+				return false;
+			}
+			memcpy(&header, data->GetData(), sizeof(header));
+			if (memcmp(header.magic, "PGSB", 4) || header.version != s_binaryCacheVersion ||
+				header.sourceHash[0] != sourceHash[0] || header.sourceHash[1] != sourceHash[1] ||
+				header.length != data->GetSize() - sizeof(header)) {
+				++s_binaryCacheStats.rejected;
+				return false;
+			}
+
+			Profiler::Clock timer;
+			timer.Start();
+			glProgramBinary(program, header.format, data->GetData() + sizeof(header), header.length);
+			GLint status = GL_FALSE;
+			glGetProgramiv(program, GL_LINK_STATUS, &status);
+			timer.Stop();
+
+			// drivers refuse binaries from other versions of themselves, whatever
+			// they say their version is; it just gets built from source again
+			if (status != GL_TRUE) {
+				++s_binaryCacheStats.rejected;
+				return false;
+			}
+
+			++s_binaryCacheStats.hits;
+			s_binaryCacheStats.loadMs += timer.milliseconds();
+			s_binaryCacheStats.savedMs += std::max(0.0, header.compileMs - timer.milliseconds());
+			return true;
+		}
+
+		static void SaveBinary(GLuint program, const std::string &path, const Uint32 sourceHash[2], double compileMs)
+		{
+			PROFILE_SCOPED()
+			GLint length = 0;
+			glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+			if (length <= 0)
+				return;
+
+			std::vector<char> binary(length);
+			GLenum format = 0;
+			glGetProgramBinary(program, length, &length, &format, binary.data());
+			if (length <= 0)
+				return;
+
+			BinaryCacheHeader header;
+			memcpy(header.magic, "PGSB", 4);
+			header.version = s_binaryCacheVersion;
+			header.sourceHash[0] = sourceHash[0];
+			header.sourceHash[1] = sourceHash[1];
+			header.format = format;
+			header.length = length;
+			header.compileMs = compileMs;
+
+			FILE *f = FileSystem::userFiles.OpenWriteStream(path);
+			if (!f) {
+				Output("Could not write shader cache file %s\n", path.c_str());
+				return;
+			}
+			bool written = fwrite(&header, sizeof(header), 1, f) == 1;
+			written = written && fwrite(binary.data(), length, 1, f) == 1;
+			written = (fclose(f) == 0) && written;
+			if (!written) {
+				Output("Could not write shader cache file %s\n", path.c_str());
+				FileSystem::userFiles.RemoveFile(path);
+			}
+		}
+
+		// Removes files left by older versions of the cache, which are never
+		// looked at again.
+		static void PruneBinaryCache()
+		{
+			for (FileSystem::FileEnumerator files(FileSystem::userFiles, s_binaryCacheDir); !files.Finished(); files.Next()) {
+				const std::string &path = files.Current().GetPath();
+				FILE *f = FileSystem::userFiles.OpenReadStream(path);
+				if (!f)
+					continue;
+				BinaryCacheHeader header;
+				const bool current = fread(&header, sizeof(header), 1, f) == 1 &&
+					!memcmp(header.magic, "PGSB", 4) && header.version == s_binaryCacheVersion;
+				fclose(f);
+				if (!current)
+					FileSystem::userFiles.RemoveFile(path);
+			}
+		}
+
+		void Program::InitBinaryCache()
+		{
+			GLint numFormats = 0;
+			if (glewIsSupported("GL_VERSION_4_1") || glewIsSupported("GL_ARB_get_program_binary"))
+				glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+
+			s_binaryCacheEnabled = numFormats > 0 && FileSystem::userFiles.MakeDirectory(s_binaryCacheDir);
+			if (!s_binaryCacheEnabled) {
+				Output("Shader binary cache not available, programs will be compiled from source\n");
+				return;
+			}
+
+			s_driverString = stringf("%0\n%1\n%2",
+				reinterpret_cast<const char *>(glGetString(GL_VENDOR)),
+				reinterpret_cast<const char *>(glGetString(GL_RENDERER)),
+				reinterpret_cast<const char *>(glGetString(GL_VERSION)));
+
+			PruneBinaryCache();
+		}
+
+		void Program::LogBinaryCacheStats()
+		{
+			if (s_binaryCacheEnabled) {
+				Output("Shader binary cache: %u hits, %u compiled from source (%u binaries rejected)\n",
+					s_binaryCacheStats.hits, s_binaryCacheStats.misses, s_binaryCacheStats.rejected);
+				Output("Shader binary cache: %.2fms loading binaries, %.2fms compiling, about %.2fms saved\n",
+					s_binaryCacheStats.loadMs, s_binaryCacheStats.compileMs, s_binaryCacheStats.savedMs);
+			} else {
+				Output("Shaders: %u programs compiled from source in %.2fms\n",
+					s_binaryCacheStats.misses, s_binaryCacheStats.compileMs);
+			}
+		}
+
 		Program::Program() :
 			m_name(""),
 			m_defines(""),
 			m_program(0),
-			success(false)
+			success(false),
+			m_usesMaterialUniforms(false)
 		{
 		}
 
@@ -205,7 +402,8 @@ namespace Graphics {
 			m_name(name),
 			m_defines(defines),
 			m_program(0),
-			success(false)
+			success(false),
+			m_usesMaterialUniforms(false)
 		{
 			LoadShaders(name, defines);
 			InitUniforms();
@@ -243,15 +441,38 @@ namespace Graphics {
 			PROFILE_SCOPED()
 			const std::string filename = std::string("shaders/opengl/") + name;
 
-			//load, create and compile shaders
+			//load shaders
 			Shader vs(GL_VERTEX_SHADER, filename + ".vert", defines);
 			Shader fs(GL_FRAGMENT_SHADER, filename + ".frag", defines);
 
-			//create program, attach shaders and link
 			m_program = glCreateProgram();
 			if (glIsProgram(m_program) != GL_TRUE)
 				throw ProgramException();
 
+			std::string cachePath;
+			Uint32 sourceHash[2];
+			if (s_binaryCacheEnabled) {
+				cachePath = BinaryCachePath(name, defines);
+				BinarySourceHash(vs, fs, sourceHash);
+				if (LoadBinary(m_program, cachePath, sourceHash)) {
+					success = true;
+					return;
+				}
+
+				// start again with a clean program rather than one a binary failed to link
+				glDeleteProgram(m_program);
+				m_program = glCreateProgram();
+				if (glIsProgram(m_program) != GL_TRUE)
+					throw ProgramException();
+			}
+
+			Profiler::Clock timer;
+			timer.Start();
+
+			//compile shaders, attach them and link
+			vs.Compile();
+			fs.Compile();
+
 			glAttachShader(m_program, vs.shader);
 
 			glAttachShader(m_program, fs.shader);
@@ -269,38 +490,42 @@ namespace Graphics {
 
 			glBindFragDataLocation(m_program, 0, "frag_color");
 
+			if (s_binaryCacheEnabled)
+				glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 			glLinkProgram(m_program);
 
 			success = check_glsl_errors(name.c_str(), m_program);
 
+			timer.Stop();
+			++s_binaryCacheStats.misses;
+			s_binaryCacheStats.compileMs += timer.milliseconds();
+
+			if (success && s_binaryCacheEnabled)
+				SaveBinary(m_program, cachePath, sourceHash, timer.milliseconds());
+
 			//shaders may now be deleted by Shader destructor
 		}
 
 		void Program::InitUniforms()
 		{
 			PROFILE_SCOPED()
+			// the uniform blocks aren't in programs that don't use them
+			const GLuint frameBlock = glGetUniformBlockIndex(m_program, "FrameUniforms");
+			if (frameBlock != GL_INVALID_INDEX)
+				glUniformBlockBinding(m_program, frameBlock, FRAME_UNIFORMS_BINDING);
+			const GLuint materialBlock = glGetUniformBlockIndex(m_program, "MaterialUniforms");
+			m_usesMaterialUniforms = (materialBlock != GL_INVALID_INDEX);
+			if (m_usesMaterialUniforms)
+				glUniformBlockBinding(m_program, materialBlock, MATERIAL_UNIFORMS_BINDING);
+
 			//Init generic uniforms, like matrices
-			uProjectionMatrix.Init("uProjectionMatrix", m_program);
 			uViewMatrix.Init("uViewMatrix", m_program);
 			uViewMatrixInverse.Init("uViewMatrixInverse", m_program);
 			uViewProjectionMatrix.Init("uViewProjectionMatrix", m_program);
 			uNormalMatrix.Init("uNormalMatrix", m_program);
 
-			//Light uniform parameters
-			char cLight[64];
-			for (int i = 0; i < 4; i++) {
-				snprintf(cLight, 64, "uLight[%d]", i);
-				const std::string strLight(cLight);
-				lights[i].diffuse.Init((strLight + ".diffuse").c_str(), m_program);
-				lights[i].specular.Init((strLight + ".specular").c_str(), m_program);
-				lights[i].position.Init((strLight + ".position").c_str(), m_program);
-			}
-
 			invLogZfarPlus1.Init("invLogZfarPlus1", m_program);
-			diffuse.Init("material.diffuse", m_program);
-			emission.Init("material.emission", m_program);
-			specular.Init("material.specular", m_program);
-			shininess.Init("material.shininess", m_program);
 			texture0.Init("texture0", m_program);
 			texture1.Init("texture1", m_program);
 			texture2.Init("texture2", m_program);
@@ -312,7 +537,6 @@ namespace Graphics {
 			heatingMatrix.Init("heatingMatrix", m_program);
 			heatingNormal.Init("heatingNormal", m_program);
 			heatingAmount.Init("heatingAmount", m_program);
-			sceneAmbient.Init("scene.ambient", m_program);
 		}
 
 	} // namespace OGL
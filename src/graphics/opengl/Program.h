@@ -20,6 +20,12 @@ namespace Graphics {
 
 		struct ProgramException {};
 
+		// The binding points of the uniform blocks declared in attributes.glsl
+		enum UniformBlockBinding {
+			FRAME_UNIFORMS_BINDING = 0,
+			MATERIAL_UNIFORMS_BINDING = 1
+		};
+
 		class Program {
 		public:
 			Program();
@@ -29,19 +35,22 @@ namespace Graphics {
 			virtual void Use();
 			virtual void Unuse();
 			bool Loaded() const { return success; }
+			bool UsesMaterialUniforms() const { return m_usesMaterialUniforms; }
+
+			// Turns on the on-disk cache of linked programs if the driver can
+			// give them back as binaries (GL 4.1 or ARB_get_program_binary).
+			static void InitBinaryCache();
+			// Writes how many programs came from the cache and the time it saved to the log
+			static void LogBinaryCacheStats();
 
-			// Uniforms.
-			Uniform uProjectionMatrix;
+			// Uniforms. The projection, lights and scene ambient colour are in
+			// the FrameUniforms block, and the material colours in MaterialUniforms.
 			Uniform uViewMatrix;
 			Uniform uViewMatrixInverse;
 			Uniform uViewProjectionMatrix;
 			Uniform uNormalMatrix;
 
 			Uniform invLogZfarPlus1;
-			Uniform diffuse;
-			Uniform emission;
-			Uniform specular;
-			Uniform shininess;
 			Uniform texture0;
 			Uniform texture1;
 			Uniform texture2;
@@ -54,16 +63,6 @@ namespace Graphics {
 			Uniform heatingNormal;
 			Uniform heatingAmount;
 
-			Uniform sceneAmbient;
-
-			//Light uniform parameters
-			struct UniformLight {
-				Uniform diffuse;
-				Uniform specular;
-				Uniform position;
-			};
-			UniformLight lights[4];
-
 		protected:
 			static GLuint s_curProgram;
 
@@ -73,6 +72,7 @@ namespace Graphics {
 			std::string m_defines;
 			GLuint m_program;
 			bool success;
+			bool m_usesMaterialUniforms;
 		};
 
 	} // namespace OGL
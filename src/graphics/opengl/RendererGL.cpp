@@ -7,6 +7,7 @@
 #include "RefCounted.h"
 #include "RenderStateGL.h"
 #include "RenderTargetGL.h"
+#include "StreamBufferGL.h"
 #include "StringF.h"
 #include "TextureGL.h"
 #include "VertexBufferGL.h"
@@ -127,11 +128,24 @@ namespace Graphics {
 
 	// static member instantiations
 	bool RendererOGL::initted = false;
-	RendererOGL::AttribBufferMap RendererOGL::s_AttribBufferMap;
 
 	// typedefs
 	typedef std::vector<std::pair<MaterialDescriptor, OGL::Program *>>::const_iterator ProgramIterator;
 
+	namespace {
+		// The FrameUniforms block in attributes.glsl, in std140 layout
+		struct FrameUniformData {
+			matrix4x4f projection;
+			struct {
+				Color4f diffuse;
+				Color4f specular;
+				float position[4];
+			} lights[TOTAL_NUM_LIGHTS];
+			Color4f ambient;
+		};
+		static_assert(sizeof(FrameUniformData) == 64 + 48 * 4 + 16, "FrameUniformData must match the std140 layout");
+	} // namespace
+
 	// ----------------------------------------------------------------------------
 	RendererOGL::RendererOGL(SDL_Window *window, const Graphics::Settings &vs, SDL_GLContext &glContext) :
 		Renderer(window, vs.width, vs.height),
@@ -198,6 +212,18 @@ namespace Graphics {
 		}
 
 		TextureBuilder::Init();
+		OGL::Program::InitBinaryCache();
+
+		// room for a few frames of trails, labels and point sprites; grows if a frame needs more
+		m_streamBuffer.reset(new OGL::StreamBuffer(4 * 1024 * 1024, m_stats));
+
+		// the data goes in when the first draw needs it
+		glGenBuffers(1, &m_frameUniformBuffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glBindBufferBase(GL_UNIFORM_BUFFER, OGL::FRAME_UNIFORMS_BINDING, m_frameUniformBuffer);
+		m_frameUniformsDirty = true;
 
 		const bool useDXTnTextures = vs.useTextureCompression;
 		m_useCompressedTextures = useDXTnTextures;
@@ -263,6 +289,9 @@ namespace Graphics {
 			m_windowRenderTarget->Unbind();
 		delete m_windowRenderTarget;
 
+		m_streamBuffer.reset();
+		glDeleteBuffers(1, &m_frameUniformBuffer);
+
 		SDL_GL_DeleteContext(m_glContext);
 	}
 
@@ -429,6 +458,8 @@ namespace Graphics {
 	bool RendererOGL::EndFrame()
 	{
 		PROFILE_SCOPED()
+		FlushQueue();
+
 		uint32_t used_tex2d = 0;
 		uint32_t used_texCube = 0;
 		uint32_t used_texArray2d = 0;
@@ -538,6 +569,8 @@ namespace Graphics {
 		glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_windowRenderTarget->m_fbo);
 
+		m_streamBuffer->EndFrame();
+
 		SDL_GL_SwapWindow(m_window);
 		m_stats.NextFrame();
 		return true;
@@ -556,6 +589,8 @@ namespace Graphics {
 	bool RendererOGL::SetRenderTarget(RenderTarget *rt)
 	{
 		PROFILE_SCOPED()
+		FlushQueue();
+
 		if (rt) {
 			if (m_activeRenderTarget)
 				m_activeRenderTarget->Unbind();
@@ -578,6 +613,8 @@ namespace Graphics {
 
 	bool RendererOGL::SetDepthRange(double znear, double zfar)
 	{
+		FlushQueue();
+
 		// XXX since we're using reverse-Z, flip the inputs to this function to avoid breaking old code.
 		glDepthRange(1.0 - zfar, 1.0 - znear);
 		return true;
@@ -585,6 +622,8 @@ namespace Graphics {
 
 	bool RendererOGL::ResetDepthRange()
 	{
+		FlushQueue();
+
 		if (m_useNVDepthRanged)
 			glDepthRangedNV(-1.0, 1.0);
 		else
@@ -595,6 +634,8 @@ namespace Graphics {
 
 	bool RendererOGL::ClearScreen()
 	{
+		FlushQueue();
+
 		m_activeRenderState = nullptr;
 		glEnable(GL_DEPTH_TEST);
 		glDepthMask(GL_TRUE);
@@ -606,6 +647,8 @@ namespace Graphics {
 
 	bool RendererOGL::ClearDepthBuffer()
 	{
+		FlushQueue();
+
 		m_activeRenderState = nullptr;
 		glEnable(GL_DEPTH_TEST);
 		glDepthMask(GL_TRUE);
@@ -623,6 +666,8 @@ namespace Graphics {
 
 	bool RendererOGL::SetViewport(Viewport v)
 	{
+		FlushQueue();
+
 		m_viewport = v;
 		glViewport(v.x, v.y, v.w, v.h);
 		return true;
@@ -648,6 +693,7 @@ namespace Graphics {
 	bool RendererOGL::SetPerspectiveProjection(float fov, float aspect, float near_, float far_)
 	{
 		PROFILE_SCOPED()
+		FlushQueue();
 
 		// update values for log-z hack
 		m_invLogZfarPlus1 = 1.0f / (log1p(far_) / log(2.0f));
@@ -668,7 +714,10 @@ namespace Graphics {
 	bool RendererOGL::SetProjection(const matrix4x4f &m)
 	{
 		PROFILE_SCOPED()
+		FlushQueue();
+
 		m_projectionMat = m;
+		m_frameUniformsDirty = true;
 		return true;
 	}
 
@@ -679,13 +728,18 @@ namespace Graphics {
 
 	bool RendererOGL::SetWireFrameMode(bool enabled)
 	{
+		FlushQueue();
+
 		glPolygonMode(GL_FRONT_AND_BACK, enabled ? GL_LINE : GL_FILL);
 		return true;
 	}
 
 	bool RendererOGL::SetLights(Uint32 numlights, const Light *lights)
 	{
+		FlushQueue();
+
 		numlights = std::min(numlights, TOTAL_NUM_LIGHTS);
+		m_frameUniformsDirty = true;
 		if (numlights < 1) {
 			m_numLights = 0;
 			m_numDirLights = 0;
@@ -712,12 +766,17 @@ namespace Graphics {
 
 	bool RendererOGL::SetAmbientColor(const Color &c)
 	{
+		FlushQueue();
+
 		m_ambient = c;
+		m_frameUniformsDirty = true;
 		return true;
 	}
 
 	bool RendererOGL::SetScissor(bool enabled, const vector2f &pos, const vector2f &size)
 	{
+		FlushQueue();
+
 		if (enabled) {
 			glScissor(pos.x, pos.y, size.x, size.y);
 			glEnable(GL_SCISSOR_TEST);
@@ -729,67 +788,50 @@ namespace Graphics {
 
 	void RendererOGL::SetMaterialShaderTransforms(Material *m)
 	{
+		UpdateFrameUniforms();
 		m->SetCommonUniforms(m_modelViewMat, m_projectionMat);
 		CheckRenderErrors(__FUNCTION__, __LINE__);
 	}
 
-	bool RendererOGL::DrawTriangles(const VertexArray *v, RenderState *rs, Material *m, PrimitiveType t)
+	void RendererOGL::UpdateFrameUniforms()
 	{
+		if (!m_frameUniformsDirty)
+			return;
+
 		PROFILE_SCOPED()
-		if (!v || v->position.size() < 3) return false;
+		FrameUniformData data;
+		memset(&data, 0, sizeof(data));
+		data.projection = m_projectionMat;
+		for (Uint32 i = 0; i < m_numLights; i++) {
+			const Light &l = m_lights[i];
+			data.lights[i].diffuse = l.GetDiffuse().ToColor4f();
+			data.lights[i].specular = l.GetSpecular().ToColor4f();
+			const vector3f &pos = l.GetPosition();
+			data.lights[i].position[0] = pos.x;
+			data.lights[i].position[1] = pos.y;
+			data.lights[i].position[2] = pos.z;
+			data.lights[i].position[3] = l.GetType() == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f;
+		}
+		data.ambient = m_ambient.ToColor4f();
 
-		const AttributeSet attribs = v->GetAttributeSet();
-		RefCountedPtr<VertexBuffer> drawVB;
-
-		// see if we have a buffer to re-use
-		AttribBufferIter iter = s_AttribBufferMap.find(std::make_pair(attribs, v->position.size()));
-		if (iter == s_AttribBufferMap.end()) {
-			// not found a buffer so create a new one
-			VertexBufferDesc vbd;
-			Uint32 attribIdx = 0;
-			assert(v->HasAttrib(ATTRIB_POSITION));
-			vbd.attrib[attribIdx].semantic = ATTRIB_POSITION;
-			vbd.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT3;
-			++attribIdx;
-
-			if (v->HasAttrib(ATTRIB_NORMAL)) {
-				vbd.attrib[attribIdx].semantic = ATTRIB_NORMAL;
-				vbd.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT3;
-				++attribIdx;
-			}
-			if (v->HasAttrib(ATTRIB_DIFFUSE)) {
-				vbd.attrib[attribIdx].semantic = ATTRIB_DIFFUSE;
-				vbd.attrib[attribIdx].format = ATTRIB_FORMAT_UBYTE4;
-				++attribIdx;
-			}
-			if (v->HasAttrib(ATTRIB_UV0)) {
-				vbd.attrib[attribIdx].semantic = ATTRIB_UV0;
-				vbd.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT2;
-				++attribIdx;
-			}
-			if (v->HasAttrib(ATTRIB_TANGENT)) {
-				vbd.attrib[attribIdx].semantic = ATTRIB_TANGENT;
-				vbd.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT3;
-				++attribIdx;
-			}
-			vbd.numVertices = static_cast<Uint32>(v->position.size());
-			vbd.usage = BUFFER_USAGE_DYNAMIC; // dynamic since we'll be reusing these buffers if possible
+		// respecify rather than update, so draws still using the old values don't hold this up
+		glBindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(data), &data, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		m_frameUniformsDirty = false;
+	}
 
-			// VertexBuffer
-			RefCountedPtr<VertexBuffer> vb;
-			vb.Reset(CreateVertexBuffer(vbd));
-			vb->Populate(*v);
+	bool RendererOGL::DrawTriangles(const VertexArray *v, RenderState *rs, Material *m, PrimitiveType t)
+	{
+		PROFILE_SCOPED()
+		FlushQueue();
 
-			// add to map
-			s_AttribBufferMap[std::make_pair(attribs, v->position.size())] = vb;
-			drawVB = vb;
-		} else {
-			// got a buffer so use it and fill it with newest data
-			drawVB = iter->second;
-			drawVB->Populate(*v);
-		}
+		if (!v || v->position.size() < 3) return false;
+
+		if (!m_streamBuffer->Populate(*v))
+			return false;
 
-		const bool res = DrawBuffer(drawVB.Get(), rs, m, t);
+		const bool res = DrawStream(rs, m, t);
 		CheckRenderErrors(__FUNCTION__, __LINE__);
 
 		m_stats.AddToStatCount(Stats::STAT_DRAWTRIS, 1);
@@ -800,6 +842,8 @@ namespace Graphics {
 	bool RendererOGL::DrawPointSprites(const Uint32 count, const vector3f *positions, RenderState *rs, Material *material, float size)
 	{
 		PROFILE_SCOPED()
+		FlushQueue();
+
 		if (count == 0 || !material || !material->texture0)
 			return false;
 
@@ -812,40 +856,21 @@ namespace Graphics {
 		};
 #pragma pack(pop)
 
-		RefCountedPtr<VertexBuffer> drawVB;
-		AttribBufferIter iter = s_AttribBufferMap.find(std::make_pair(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL, count));
-		if (iter == s_AttribBufferMap.end()) {
-			// NB - we're (ab)using the normal type to hold (uv coordinate offset value + point size)
-			Graphics::VertexBufferDesc vbd;
-			vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-			vbd.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-			vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
-			vbd.attrib[1].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-			vbd.numVertices = count;
-			vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC; // we could be updating this per-frame
-
-			// VertexBuffer
-			RefCountedPtr<VertexBuffer> vb;
-			vb.Reset(CreateVertexBuffer(vbd));
-
-			// add to map
-			s_AttribBufferMap[std::make_pair(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL, count)] = vb;
-			drawVB = vb;
-		} else {
-			drawVB = iter->second;
-		}
-
-		// got a buffer so use it and fill it with newest data
-		PosNormVert *vtxPtr = drawVB->Map<PosNormVert>(Graphics::BUFFER_MAP_WRITE);
-		assert(drawVB->GetDesc().stride == sizeof(PosNormVert));
-		for (Uint32 i = 0; i < count; i++) {
-			vtxPtr[i].pos = positions[i];
-			vtxPtr[i].norm = vector3f(0.0f, 0.0f, size);
+		// NB - we're (ab)using the normal type to hold (uv coordinate offset value + point size)
+		PosNormVert *vtxPtr = reinterpret_cast<PosNormVert *>(m_streamBuffer->Map(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL, count));
+		assert(m_streamBuffer->GetStride() == sizeof(PosNormVert));
+		if (vtxPtr) {
+			for (Uint32 i = 0; i < count; i++) {
+				vtxPtr[i].pos = positions[i];
+				vtxPtr[i].norm = vector3f(0.0f, 0.0f, size);
+			}
 		}
-		drawVB->Unmap();
+		m_streamBuffer->Unmap();
+		if (!vtxPtr)
+			return false;
 
 		SetTransform(matrix4x4f::Identity());
-		DrawBuffer(drawVB.Get(), rs, material, Graphics::POINTS);
+		DrawStream(rs, material, Graphics::POINTS);
 		GetStats().AddToStatCount(Graphics::Stats::STAT_DRAWPOINTSPRITES, 1);
 		CheckRenderErrors(__FUNCTION__, __LINE__);
 
@@ -855,6 +880,8 @@ namespace Graphics {
 	bool RendererOGL::DrawPointSprites(const Uint32 count, const vector3f *positions, const vector2f *offsets, const float *sizes, RenderState *rs, Material *material)
 	{
 		PROFILE_SCOPED()
+		FlushQueue();
+
 		if (count == 0 || !material || !material->texture0)
 			return false;
 
@@ -865,47 +892,28 @@ namespace Graphics {
 		};
 #pragma pack(pop)
 
-		RefCountedPtr<VertexBuffer> drawVB;
-		AttribBufferIter iter = s_AttribBufferMap.find(std::make_pair(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL, count));
-		if (iter == s_AttribBufferMap.end()) {
-			// NB - we're (ab)using the normal type to hold (uv coordinate offset value + point size)
-			Graphics::VertexBufferDesc vbd;
-			vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-			vbd.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-			vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
-			vbd.attrib[1].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-			vbd.numVertices = count;
-			vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC; // we could be updating this per-frame
-
-			// VertexBuffer
-			RefCountedPtr<VertexBuffer> vb;
-			vb.Reset(CreateVertexBuffer(vbd));
-
-			// add to map
-			s_AttribBufferMap[std::make_pair(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL, count)] = vb;
-			drawVB = vb;
-		} else {
-			drawVB = iter->second;
-		}
-
-		// got a buffer so use it and fill it with newest data
-		PosNormVert *vtxPtr = drawVB->Map<PosNormVert>(Graphics::BUFFER_MAP_WRITE);
-		assert(drawVB->GetDesc().stride == sizeof(PosNormVert));
-		for (Uint32 i = 0; i < count; i++) {
-			vtxPtr[i].pos = positions[i];
-			vtxPtr[i].norm = vector3f(offsets[i], Clamp(sizes[i], 0.1f, FLT_MAX));
+		// NB - we're (ab)using the normal type to hold (uv coordinate offset value + point size)
+		PosNormVert *vtxPtr = reinterpret_cast<PosNormVert *>(m_streamBuffer->Map(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL, count));
+		assert(m_streamBuffer->GetStride() == sizeof(PosNormVert));
+		if (vtxPtr) {
+			for (Uint32 i = 0; i < count; i++) {
+				vtxPtr[i].pos = positions[i];
+				vtxPtr[i].norm = vector3f(offsets[i], Clamp(sizes[i], 0.1f, FLT_MAX));
+			}
 		}
-		drawVB->Unmap();
+		m_streamBuffer->Unmap();
+		if (!vtxPtr)
+			return false;
 
 		SetTransform(matrix4x4f::Identity());
-		DrawBuffer(drawVB.Get(), rs, material, Graphics::POINTS);
+		DrawStream(rs, material, Graphics::POINTS);
 		GetStats().AddToStatCount(Graphics::Stats::STAT_DRAWPOINTSPRITES, 1);
 		CheckRenderErrors(__FUNCTION__, __LINE__);
 
 		return true;
 	}
 
-	bool RendererOGL::DrawBuffer(VertexBuffer *vb, RenderState *state, Material *mat, PrimitiveType pt)
+	bool RendererOGL::DrawStream(RenderState *state, Material *mat, PrimitiveType pt)
 	{
 		PROFILE_SCOPED()
 		SetRenderState(state);
@@ -913,9 +921,7 @@ namespace Graphics {
 
 		SetMaterialShaderTransforms(mat);
 
-		vb->Bind();
-		glDrawArrays(pt, 0, vb->GetSize());
-		vb->Release();
+		m_streamBuffer->Draw(pt);
 		CheckRenderErrors(__FUNCTION__, __LINE__);
 
 		m_stats.AddToStatCount(Stats::STAT_DRAWCALL, 1);
@@ -923,22 +929,34 @@ namespace Graphics {
 		return true;
 	}
 
-	bool RendererOGL::DrawBufferIndexed(VertexBuffer *vb, IndexBuffer *ib, RenderState *state, Material *mat, PrimitiveType pt)
+	bool RendererOGL::DrawBuffer(VertexBuffer *vb, RenderState *state, Material *mat, PrimitiveType pt)
 	{
 		PROFILE_SCOPED()
+		if (QueueDraw(vb, nullptr, nullptr, state, mat, pt))
+			return true;
+
 		SetRenderState(state);
 		mat->Apply();
 
 		SetMaterialShaderTransforms(mat);
 
-		vb->Bind();
-		ib->Bind();
-		glDrawElements(pt, ib->GetIndexCount(), GL_UNSIGNED_INT, 0);
-		ib->Release();
-		vb->Release();
-		CheckRenderErrors(__FUNCTION__, __LINE__);
+		DrawBuffers(vb, nullptr, nullptr, pt);
 
-		m_stats.AddToStatCount(Stats::STAT_DRAWCALL, 1);
+		return true;
+	}
+
+	bool RendererOGL::DrawBufferIndexed(VertexBuffer *vb, IndexBuffer *ib, RenderState *state, Material *mat, PrimitiveType pt)
+	{
+		PROFILE_SCOPED()
+		if (QueueDraw(vb, ib, nullptr, state, mat, pt))
+			return true;
+
+		SetRenderState(state);
+		mat->Apply();
+
+		SetMaterialShaderTransforms(mat);
+
+		DrawBuffers(vb, ib, nullptr, pt);
 
 		return true;
 	}
@@ -946,19 +964,15 @@ namespace Graphics {
 	bool RendererOGL::DrawBufferInstanced(VertexBuffer *vb, RenderState *state, Material *mat, InstanceBuffer *instb, PrimitiveType pt)
 	{
 		PROFILE_SCOPED()
+		if (QueueDraw(vb, nullptr, instb, state, mat, pt))
+			return true;
+
 		SetRenderState(state);
 		mat->Apply();
 
 		SetMaterialShaderTransforms(mat);
 
-		vb->Bind();
-		instb->Bind();
-		glDrawArraysInstanced(pt, 0, vb->GetSize(), instb->GetInstanceCount());
-		instb->Release();
-		vb->Release();
-		CheckRenderErrors(__FUNCTION__, __LINE__);
-
-		m_stats.AddToStatCount(Stats::STAT_DRAWCALL, 1);
+		DrawBuffers(vb, nullptr, instb, pt);
 
 		return true;
 	}
@@ -966,23 +980,57 @@ namespace Graphics {
 	bool RendererOGL::DrawBufferIndexedInstanced(VertexBuffer *vb, IndexBuffer *ib, RenderState *state, Material *mat, InstanceBuffer *instb, PrimitiveType pt)
 	{
 		PROFILE_SCOPED()
+		if (QueueDraw(vb, ib, instb, state, mat, pt))
+			return true;
+
 		SetRenderState(state);
 		mat->Apply();
 
 		SetMaterialShaderTransforms(mat);
 
+		DrawBuffers(vb, ib, instb, pt);
+
+		return true;
+	}
+
+	void RendererOGL::DrawQueued(const RenderQueue::Item &item, bool applyMaterial)
+	{
+		PROFILE_SCOPED()
+		SetTransform(item.transform);
+		SetRenderState(item.state);
+		// the previous draw used the same material, so its program, textures and
+		// uniforms are all still set, apart from the transforms
+		if (applyMaterial)
+			item.material->Apply();
+
+		SetMaterialShaderTransforms(item.material);
+
+		DrawBuffers(item.vertices, item.indices, item.instances, item.type);
+	}
+
+	void RendererOGL::DrawBuffers(VertexBuffer *vb, IndexBuffer *ib, InstanceBuffer *instb, PrimitiveType pt)
+	{
 		vb->Bind();
-		ib->Bind();
-		instb->Bind();
-		glDrawElementsInstanced(pt, ib->GetIndexCount(), GL_UNSIGNED_INT, 0, instb->GetInstanceCount());
-		instb->Release();
-		ib->Release();
+		if (ib)
+			ib->Bind();
+		if (instb) {
+			instb->Bind();
+			if (ib)
+				glDrawElementsInstanced(pt, ib->GetIndexCount(), GL_UNSIGNED_INT, 0, instb->GetInstanceCount());
+			else
+				glDrawArraysInstanced(pt, 0, vb->GetSize(), instb->GetInstanceCount());
+			instb->Release();
+		} else if (ib) {
+			glDrawElements(pt, ib->GetIndexCount(), GL_UNSIGNED_INT, 0);
+		} else {
+			glDrawArrays(pt, 0, vb->GetSize());
+		}
+		if (ib)
+			ib->Release();
 		vb->Release();
 		CheckRenderErrors(__FUNCTION__, __LINE__);
 
 		m_stats.AddToStatCount(Stats::STAT_DRAWCALL, 1);
-
-		return true;
 	}
 
 	Material *RendererOGL::CreateMaterial(const MaterialDescriptor &d)
@@ -1062,6 +1110,11 @@ namespace Graphics {
 		return mat;
 	}
 
+	void RendererOGL::LogShaderStats() const
+	{
+		OGL::Program::LogBinaryCacheStats();
+	}
+
 	bool RendererOGL::ReloadShaders()
 	{
 		Output("Reloading " SIZET_FMT " programs...\n", m_programs.size());
@@ -1217,6 +1270,8 @@ namespace Graphics {
 
 	bool RendererOGL::Screendump(ScreendumpState &sd)
 	{
+		FlushQueue();
+
 		int w, h;
 		SDL_GetWindowSize(m_window, &w, &h);
 		sd.width = w;
@@ -1239,6 +1294,8 @@ namespace Graphics {
 
 	bool RendererOGL::FrameGrab(ScreendumpState &sd)
 	{
+		FlushQueue();
+
 		int w, h;
 		SDL_GetWindowSize(m_window, &w, &h);
 		sd.width = w;
@@ -38,6 +38,7 @@ namespace Graphics {
 		class RingMaterial;
 		class FresnelColourMaterial;
 		class ShieldMaterial;
+		class StreamBuffer;
 		class UIMaterial;
 		class BillboardMaterial;
 	} // namespace OGL
@@ -53,6 +54,7 @@ namespace Graphics {
 		virtual RendererType GetRendererType() const override final { return RENDERER_OPENGL_3x; }
 
 		virtual void WriteRendererInfo(std::ostream &out) const override final;
+		virtual void LogShaderStats() const override final;
 
 		virtual void CheckRenderErrors(const char *func = nullptr, const int line = -1) const override final { CheckErrors(func, line); }
 		static void CheckErrors(const char *func = nullptr, const int line = -1);
@@ -119,6 +121,7 @@ namespace Graphics {
 	protected:
 		virtual void PushState() override final;
 		virtual void PopState() override final;
+		virtual void DrawQueued(const RenderQueue::Item &item, bool applyMaterial) override final;
 
 		Uint32 m_numLights;
 		Uint32 m_numDirLights;
@@ -129,6 +132,8 @@ namespace Graphics {
 		bool m_useAnisotropicFiltering;
 
 		void SetMaterialShaderTransforms(Material *);
+		// uploads the projection, lights and ambient colour if they've changed
+		void UpdateFrameUniforms();
 
 		matrix4x4f &GetCurrentTransform() { return m_currentTransform; }
 		matrix4x4f m_currentTransform;
@@ -161,9 +166,17 @@ namespace Graphics {
 	private:
 		static bool initted;
 
-		typedef std::map<std::pair<AttributeSet, size_t>, RefCountedPtr<VertexBuffer>> AttribBufferMap;
-		typedef AttribBufferMap::iterator AttribBufferIter;
-		static AttribBufferMap s_AttribBufferMap;
+		// sets up a draw of the vertices last written to the stream buffer
+		bool DrawStream(RenderState *state, Material *mat, PrimitiveType pt);
+		// binds the buffers and draws them; ib and instb may be null
+		void DrawBuffers(VertexBuffer *vb, IndexBuffer *ib, InstanceBuffer *instb, PrimitiveType pt);
+
+		// shared by the draws that write their vertices every time
+		std::unique_ptr<OGL::StreamBuffer> m_streamBuffer;
+
+		// the FrameUniforms block of every program
+		GLuint m_frameUniformBuffer;
+		bool m_frameUniformsDirty;
 
 		SDL_GLContext m_glContext;
 	};
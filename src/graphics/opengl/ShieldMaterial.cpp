@@ -55,8 +55,6 @@ namespace Graphics {
 
 			ShieldProgram *p = static_cast<ShieldProgram *>(m_program);
 
-			p->diffuse.Set(this->diffuse);
-
 			if (this->specialParameter0) {
 				const ShieldRenderParameters srp = *static_cast<ShieldRenderParameters *>(this->specialParameter0);
 				p->shieldStrength.Set(srp.strength);
@@ -28,12 +28,14 @@ namespace Graphics {
 
 			virtual void Apply() override
 			{
-				m_program->Use();
+				// not the base Apply(), which would upload the uniform block with
+				// the material's own shininess first
+				ApplyProgram();
 				if (texture0) {
 					m_program->texture0.Set(texture0, 0);
 				}
 				const float em = (float(emissive.r) * 0.003921568627451f);
-				m_program->shininess.Set(fSkyboxFactor * em);
+				ApplyMaterialUniforms(emissive, diffuse, specular, fSkyboxFactor * em);
 			}
 
 			// Skybox multiplier
@@ -28,7 +28,6 @@ namespace Graphics {
 				assert(this->texture0);
 				m_program->Use();
 				m_program->texture0.Set(this->texture0, 0);
-				m_program->emission.Set(this->emissive);
 			}
 
 			virtual void Unapply() override
@@ -0,0 +1,271 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "StreamBufferGL.h"
+#include "VertexBufferGL.h"
+#include "graphics/Stats.h"
+#include "graphics/VertexArray.h"
+#include "utils.h"
+#include <algorithm>
+
+namespace Graphics {
+	namespace OGL {
+
+		StreamBuffer::StreamBuffer(size_t capacity, Stats &stats) :
+			m_stats(stats),
+			m_capacity(0),
+			m_useFences(glewIsSupported("GL_VERSION_3_2") || glewIsSupported("GL_ARB_sync")),
+			m_position(0),
+			m_frameStart(0),
+			m_current(0),
+			m_first(0),
+			m_count(0),
+			m_mapped(false)
+		{
+			glGenBuffers(1, &m_buffer);
+			Reallocate(capacity);
+		}
+
+		StreamBuffer::~StreamBuffer()
+		{
+			DropFrames();
+			for (const Layout &layout : m_layouts)
+				glDeleteVertexArrays(1, &layout.vao);
+			glDeleteBuffers(1, &m_buffer);
+			m_stats.SetStatCount(Stats::STAT_MEM_STREAM_BUFFER, 0);
+		}
+
+		// New storage for the buffer. The vertex array objects refer to the buffer
+		// by name, so they carry on working; what was in flight keeps the old storage.
+		void StreamBuffer::Reallocate(size_t capacity)
+		{
+			PROFILE_SCOPED()
+			DropFrames();
+			if (m_capacity)
+				m_stats.AddToStatCount(Stats::STAT_STREAM_ORPHANS, 1);
+			m_capacity = capacity;
+			m_position = 0;
+			m_frameStart = 0;
+
+			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+			glBufferData(GL_ARRAY_BUFFER, m_capacity, nullptr, GL_STREAM_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			m_stats.SetStatCount(Stats::STAT_MEM_STREAM_BUFFER, m_capacity);
+		}
+
+		size_t StreamBuffer::GetLayout(AttributeSet attribs)
+		{
+			for (size_t i = 0; i < m_layouts.size(); i++)
+				if (m_layouts[i].attribs == attribs)
+					return i;
+
+			// the same layout DrawTriangles used to create vertex buffers with
+			Layout layout;
+			layout.attribs = attribs;
+			Uint32 attribIdx = 0;
+			assert(attribs & ATTRIB_POSITION);
+			layout.desc.attrib[attribIdx].semantic = ATTRIB_POSITION;
+			layout.desc.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT3;
+			++attribIdx;
+			if (attribs & ATTRIB_NORMAL) {
+				layout.desc.attrib[attribIdx].semantic = ATTRIB_NORMAL;
+				layout.desc.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT3;
+				++attribIdx;
+			}
+			if (attribs & ATTRIB_DIFFUSE) {
+				layout.desc.attrib[attribIdx].semantic = ATTRIB_DIFFUSE;
+				layout.desc.attrib[attribIdx].format = ATTRIB_FORMAT_UBYTE4;
+				++attribIdx;
+			}
+			if (attribs & ATTRIB_UV0) {
+				layout.desc.attrib[attribIdx].semantic = ATTRIB_UV0;
+				layout.desc.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT2;
+				++attribIdx;
+			}
+			if (attribs & ATTRIB_TANGENT) {
+				layout.desc.attrib[attribIdx].semantic = ATTRIB_TANGENT;
+				layout.desc.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT3;
+				++attribIdx;
+			}
+			layout.desc.usage = BUFFER_USAGE_DYNAMIC;
+			CompleteVertexBufferDesc(layout.desc);
+
+			glGenVertexArrays(1, &layout.vao);
+			glBindVertexArray(layout.vao);
+			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+			SetVertexAttribPointers(layout.desc);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glBindVertexArray(0);
+
+			m_layouts.push_back(layout);
+			return m_layouts.size() - 1;
+		}
+
+		Uint8 *StreamBuffer::Map(AttributeSet attribs, Uint32 count)
+		{
+			PROFILE_SCOPED()
+			assert(count > 0);
+			m_current = GetLayout(attribs);
+			const Uint32 stride = m_layouts[m_current].desc.stride;
+			const size_t size = size_t(count) * stride;
+
+			if (size > m_capacity)
+				Reallocate(std::max(m_capacity * 2, size_t(ceil_pow2(size))));
+
+			// start on a whole vertex, so the draw can give its first vertex instead of
+			// setting up the attribute pointers again; wrap if it doesn't fit before the end
+			Uint64 lap = m_position - m_position % m_capacity;
+			size_t offset = (m_position % m_capacity + stride - 1) / stride * stride;
+			// the last range may have ended right on the end of the buffer, and
+			// starting again at 0 is then a wrap just the same
+			bool wrap = offset == 0 && m_position > 0;
+			if (offset + size > m_capacity) {
+				wrap = true;
+				lap += m_capacity;
+				offset = 0;
+			}
+			Uint64 start = lap + offset;
+
+			if (start + size - m_frameStart > m_capacity) {
+				// this frame alone has filled the ring
+				Reallocate(m_capacity * 2);
+				start = 0;
+				offset = 0;
+			} else if (m_useFences) {
+				WaitForFrames(start + size);
+			} else if (wrap) {
+				glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+				glBufferData(GL_ARRAY_BUFFER, m_capacity, nullptr, GL_STREAM_DRAW);
+				m_stats.AddToStatCount(Stats::STAT_STREAM_ORPHANS, 1);
+			}
+
+			m_position = start + size;
+			m_first = offset / stride;
+			m_count = count;
+
+			m_stats.AddToStatCount(Stats::STAT_STREAM_ALLOCS, 1);
+			m_stats.AddToStatCount(Stats::STAT_STREAM_BYTES, size);
+
+			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+			Uint8 *data = static_cast<Uint8 *>(glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+			m_mapped = data != nullptr;
+			return data;
+		}
+
+		void StreamBuffer::Unmap()
+		{
+			if (m_mapped)
+				glUnmapBuffer(GL_ARRAY_BUFFER);
+			m_mapped = false;
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+		bool StreamBuffer::Populate(const VertexArray &va)
+		{
+			PROFILE_SCOPED()
+			const Uint32 count = va.GetNumVerts();
+			Uint8 *data = Map(va.GetAttributeSet(), count);
+			if (!data) {
+				Unmap();
+				return false;
+			}
+
+			static_assert(sizeof(Color) == 4, "VertexArray colours must be four bytes");
+			const VertexBufferDesc &desc = m_layouts[m_current].desc;
+			for (Uint32 i = 0; i < MAX_ATTRIBS && desc.attrib[i].semantic != ATTRIB_NONE; i++) {
+				const Uint8 *src = nullptr;
+				size_t size = 0;
+				switch (desc.attrib[i].semantic) {
+				case ATTRIB_POSITION:
+					src = reinterpret_cast<const Uint8 *>(va.position.data());
+					size = sizeof(vector3f);
+					break;
+				case ATTRIB_NORMAL:
+					src = reinterpret_cast<const Uint8 *>(va.normal.data());
+					size = sizeof(vector3f);
+					break;
+				case ATTRIB_DIFFUSE:
+					src = reinterpret_cast<const Uint8 *>(va.diffuse.data());
+					size = sizeof(Color);
+					break;
+				case ATTRIB_UV0:
+					src = reinterpret_cast<const Uint8 *>(va.uv0.data());
+					size = sizeof(vector2f);
+					break;
+				case ATTRIB_TANGENT:
+					src = reinterpret_cast<const Uint8 *>(va.tangent.data());
+					size = sizeof(vector3f);
+					break;
+				default:
+					continue;
+				}
+
+				Uint8 *dst = data + desc.attrib[i].offset;
+				for (Uint32 v = 0; v < count; v++, dst += desc.stride, src += size)
+					memcpy(dst, src, size);
+			}
+
+			Unmap();
+			return true;
+		}
+
+		void StreamBuffer::Draw(PrimitiveType type)
+		{
+			glBindVertexArray(m_layouts[m_current].vao);
+			glDrawArrays(type, m_first, m_count);
+			glBindVertexArray(0);
+		}
+
+		// Waits until the GPU is done with everything that was written before the
+		// range that is about to be reused, which ends at end - capacity.
+		void StreamBuffer::WaitForFrames(Uint64 end)
+		{
+			if (end <= m_capacity)
+				return;
+
+			while (!m_frames.empty() && m_frames.front().start < end - m_capacity) {
+				GLsync fence = m_frames.front().fence;
+				GLenum result = glClientWaitSync(fence, 0, 0);
+				if (result == GL_TIMEOUT_EXPIRED) {
+					PROFILE_SCOPED_DESC("StreamBuffer wait")
+					m_stats.AddToStatCount(Stats::STAT_STREAM_WAITS, 1);
+					do {
+						result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+					} while (result == GL_TIMEOUT_EXPIRED);
+				}
+				glDeleteSync(fence);
+				m_frames.pop_front();
+			}
+		}
+
+		void StreamBuffer::DropFrames()
+		{
+			for (const Frame &frame : m_frames)
+				glDeleteSync(frame.fence);
+			m_frames.clear();
+		}
+
+		void StreamBuffer::EndFrame()
+		{
+			if (m_useFences && m_position > m_frameStart) {
+				Frame frame;
+				frame.start = m_frameStart;
+				frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				m_frames.push_back(frame);
+			}
+			m_frameStart = m_position;
+
+			// let go of the frames the GPU has finished with, so the list stays short
+			while (!m_frames.empty()) {
+				const GLenum result = glClientWaitSync(m_frames.front().fence, 0, 0);
+				if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+					break;
+				glDeleteSync(m_frames.front().fence);
+				m_frames.pop_front();
+			}
+		}
+
+	} // namespace OGL
+} // namespace Graphics
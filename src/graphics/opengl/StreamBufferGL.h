@@ -0,0 +1,96 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef OGL_STREAMBUFFER_H
+#define OGL_STREAMBUFFER_H
+
+#include "OpenGLLibs.h"
+#include "graphics/Types.h"
+#include "graphics/VertexBuffer.h"
+#include <deque>
+#include <vector>
+
+namespace Graphics {
+
+	class Stats;
+	class VertexArray;
+
+	namespace OGL {
+
+		/* One vertex buffer shared by all the geometry that is written, drawn once
+		   and thrown away: DrawTriangles and DrawPointSprites.
+
+		   Each draw takes the next range of the buffer, maps just that range
+		   without synchronising and draws from it, so there's a single buffer
+		   however many different sizes of draw there are. A fence goes in at the
+		   end of every frame; when the ring comes round again to memory that a
+		   frame used, that frame's fence is waited on, which normally signalled
+		   long before since the ring holds several frames' worth.
+
+		   If a single frame writes more than the whole ring, the buffer is orphaned
+		   and the ring doubled in size. Without sync objects (GL 3.1 without
+		   ARB_sync) the buffer is orphaned every time it wraps instead.
+		*/
+		class StreamBuffer {
+		public:
+			StreamBuffer(size_t capacity, Stats &stats);
+			~StreamBuffer();
+
+			// Maps room for count vertices with the given attributes, interleaved in
+			// the order and formats a VertexBufferDesc built from a VertexArray would
+			// have. Must be followed by Unmap() and then Draw(); Unmap() even if this
+			// returns null, to unbind the buffer.
+			Uint8 *Map(AttributeSet attribs, Uint32 count);
+			void Unmap();
+
+			// Map(), copy and Unmap() in one
+			bool Populate(const VertexArray &va);
+
+			// draws what was written by the last Map()
+			void Draw(PrimitiveType type);
+
+			// fences off what this frame used
+			void EndFrame();
+
+			// the stride of the vertices written by the last Map()
+			Uint32 GetStride() const { return m_layouts[m_current].desc.stride; }
+
+		private:
+			struct Layout {
+				AttributeSet attribs;
+				VertexBufferDesc desc;
+				GLuint vao;
+			};
+
+			struct Frame {
+				Uint64 start; // where the frame's data starts
+				GLsync fence;
+			};
+
+			size_t GetLayout(AttributeSet attribs);
+			void Reallocate(size_t capacity);
+			void WaitForFrames(Uint64 end);
+			void DropFrames();
+
+			Stats &m_stats;
+			GLuint m_buffer;
+			size_t m_capacity;
+			bool m_useFences;
+
+			// positions count the bytes written since the buffer was last (re)allocated;
+			// the offset into the buffer is the position % capacity
+			Uint64 m_position;	 // where the next range starts
+			Uint64 m_frameStart; // where the current frame's data starts
+			std::deque<Frame> m_frames;
+
+			std::vector<Layout> m_layouts;
+			size_t m_current; // layout of the last Map()
+			Uint32 m_first;	  // first vertex of the last Map()
+			Uint32 m_count;
+			bool m_mapped; // the last Map() succeeded and hasn't been unmapped yet
+		};
+
+	} // namespace OGL
+} // namespace Graphics
+
+#endif // OGL_STREAMBUFFER_H
@@ -85,19 +85,40 @@ namespace Graphics {
 		TextureGL::TextureGL(const TextureDescriptor &descriptor, const bool useCompressed, const bool useAnisoFiltering, const Uint16 numSamples) :
 			Texture(descriptor),
 			m_allocSize(0),
+			m_numSamples(numSamples),
+			m_useCompressed(useCompressed),
 			m_useAnisoFiltering(useAnisoFiltering && descriptor.useAnisotropicFiltering)
 		{
 			PROFILE_SCOPED()
+			glGenTextures(1, &m_texture);
+			Allocate(descriptor);
+		}
+
+		void TextureGL::Reallocate(const TextureDescriptor &descriptor)
+		{
+			PROFILE_SCOPED()
+			// the new descriptor may have another type or format, so start again with
+			// a new name rather than respecifying the old one
+			glDeleteTextures(1, &m_texture);
+			glGenTextures(1, &m_texture);
+			SetDescriptor(descriptor);
+			Allocate(descriptor);
+		}
+
+		void TextureGL::Allocate(const TextureDescriptor &descriptor)
+		{
+			const Uint16 numSamples = m_numSamples;
+			m_allocSize = 0;
+
 			// this is kind of a hack, but it limits the amount of things that need to care about multisample textures.
 			m_target = numSamples ? GL_TEXTURE_2D_MULTISAMPLE : GLTextureType(descriptor.type);
 
-			glGenTextures(1, &m_texture);
 			glBindTexture(m_target, m_texture);
 			CHECKERRORS();
 
 			// useCompressed is the global scope flag whereas descriptor.allowCompression is the local texture mode flag
 			// either both or neither might be true however only compress the texture when both are true.
-			const bool compressTexture = useCompressed && descriptor.allowCompression;
+			const bool compressTexture = m_useCompressed && descriptor.allowCompression;
 
 			switch (m_target) {
 			// XXX(sturnclaw): multisample assumes an uncompressed, un-mipmapped 2d texture descriptor.
@@ -31,10 +31,17 @@ namespace Graphics {
 
 			uint32_t GetTextureMemSize() const final { return m_allocSize; }
 
+			virtual void Reallocate(const TextureDescriptor &descriptor) override final;
+
 		private:
+			// creates storage for the descriptor under m_texture
+			void Allocate(const TextureDescriptor &descriptor);
+
 			GLenum m_target;
 			GLuint m_texture;
 			uint32_t m_allocSize;
+			const Uint16 m_numSamples;
+			const bool m_useCompressed;
 			const bool m_useAnisoFiltering;
 		};
 	} // namespace OGL
@@ -37,47 +37,31 @@ namespace Graphics {
 			}
 		}
 
-		VertexBuffer::VertexBuffer(const VertexBufferDesc &desc) :
-			Graphics::VertexBuffer(desc)
+		void CompleteVertexBufferDesc(VertexBufferDesc &desc)
 		{
-			PROFILE_SCOPED()
 			//update offsets in desc
 			for (Uint32 i = 0; i < MAX_ATTRIBS; i++) {
-				if (m_desc.attrib[i].offset == 0)
-					m_desc.attrib[i].offset = VertexBufferDesc::CalculateOffset(m_desc, m_desc.attrib[i].semantic);
+				if (desc.attrib[i].offset == 0)
+					desc.attrib[i].offset = VertexBufferDesc::CalculateOffset(desc, desc.attrib[i].semantic);
 			}
 
 			//update stride in desc (respecting offsets)
-			if (m_desc.stride == 0) {
+			if (desc.stride == 0) {
 				Uint32 lastAttrib = 0;
 				while (lastAttrib < MAX_ATTRIBS) {
-					if (m_desc.attrib[lastAttrib].semantic == ATTRIB_NONE)
+					if (desc.attrib[lastAttrib].semantic == ATTRIB_NONE)
 						break;
 					lastAttrib++;
 				}
 
-				m_desc.stride = m_desc.attrib[lastAttrib].offset + VertexBufferDesc::GetAttribSize(m_desc.attrib[lastAttrib].format);
+				desc.stride = desc.attrib[lastAttrib].offset + VertexBufferDesc::GetAttribSize(desc.attrib[lastAttrib].format);
 			}
-			assert(m_desc.stride > 0);
-			assert(m_desc.numVertices > 0);
-
-			//SetVertexCount(m_desc.numVertices);
-
-			glGenVertexArrays(1, &m_vao);
-			glBindVertexArray(m_vao);
-
-			glGenBuffers(1, &m_buffer);
-
-			//Allocate GL buffer with undefined contents
-			//Critical optimisation for some architectures in cases where buffer is created and written in the same frame
-			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-			const Uint32 dataSize = m_desc.numVertices * m_desc.stride;
-			const GLenum usage = (m_desc.usage == BUFFER_USAGE_STATIC) ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
-			glBufferData(GL_ARRAY_BUFFER, dataSize, 0, usage);
+		}
 
-			//Setup the VAO pointers
+		void SetVertexAttribPointers(const VertexBufferDesc &desc)
+		{
 			for (Uint8 i = 0; i < MAX_ATTRIBS; i++) {
-				const auto &attr = m_desc.attrib[i];
+				const auto &attr = desc.attrib[i];
 				if (attr.semantic == ATTRIB_NONE)
 					break;
 
@@ -86,29 +70,55 @@ namespace Graphics {
 				switch (attr.semantic) {
 				case ATTRIB_POSITION:
 					glEnableVertexAttribArray(0); // Enable the attribute at that location
-					glVertexAttribPointer(0, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, m_desc.stride, offset);
+					glVertexAttribPointer(0, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, desc.stride, offset);
 					break;
 				case ATTRIB_NORMAL:
 					glEnableVertexAttribArray(1); // Enable the attribute at that location
-					glVertexAttribPointer(1, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, m_desc.stride, offset);
+					glVertexAttribPointer(1, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, desc.stride, offset);
 					break;
 				case ATTRIB_DIFFUSE:
 					glEnableVertexAttribArray(2); // Enable the attribute at that location
-					glVertexAttribPointer(2, get_num_components(attr.format), get_component_type(attr.format), GL_TRUE, m_desc.stride, offset); // only normalise the colours
+					glVertexAttribPointer(2, get_num_components(attr.format), get_component_type(attr.format), GL_TRUE, desc.stride, offset); // only normalise the colours
 					break;
 				case ATTRIB_UV0:
 					glEnableVertexAttribArray(3); // Enable the attribute at that location
-					glVertexAttribPointer(3, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, m_desc.stride, offset);
+					glVertexAttribPointer(3, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, desc.stride, offset);
 					break;
 				case ATTRIB_TANGENT:
 					glEnableVertexAttribArray(4); // Enable the attribute at that location
-					glVertexAttribPointer(4, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, m_desc.stride, offset);
+					glVertexAttribPointer(4, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, desc.stride, offset);
 					break;
 				case ATTRIB_NONE:
 				default:
 					break;
 				}
 			}
+		}
+
+		VertexBuffer::VertexBuffer(const VertexBufferDesc &desc) :
+			Graphics::VertexBuffer(desc)
+		{
+			PROFILE_SCOPED()
+			CompleteVertexBufferDesc(m_desc);
+			assert(m_desc.stride > 0);
+			assert(m_desc.numVertices > 0);
+
+			//SetVertexCount(m_desc.numVertices);
+
+			glGenVertexArrays(1, &m_vao);
+			glBindVertexArray(m_vao);
+
+			glGenBuffers(1, &m_buffer);
+
+			//Allocate GL buffer with undefined contents
+			//Critical optimisation for some architectures in cases where buffer is created and written in the same frame
+			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+			const Uint32 dataSize = m_desc.numVertices * m_desc.stride;
+			const GLenum usage = (m_desc.usage == BUFFER_USAGE_STATIC) ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
+			glBufferData(GL_ARRAY_BUFFER, dataSize, 0, usage);
+
+			//Setup the VAO pointers
+			SetVertexAttribPointers(m_desc);
 
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 			glBindVertexArray(0);
@@ -329,14 +339,20 @@ namespace Graphics {
 			return result;
 		}
 
-		void VertexBuffer::BufferData(const size_t size, void *data)
+		void VertexBuffer::BufferData(const size_t size, const void *data)
 		{
 			PROFILE_SCOPED()
 			assert(m_mapMode == BUFFER_MAP_NONE); //must not be currently mapped
 			if (GetDesc().usage == BUFFER_USAGE_DYNAMIC) {
 				glBindVertexArray(m_vao);
 				glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-				glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(size), static_cast<GLvoid *>(data), GL_DYNAMIC_DRAW);
+				glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(size), static_cast<const GLvoid *>(data), GL_DYNAMIC_DRAW);
+			} else if (GetDesc().usage == BUFFER_USAGE_STATIC) {
+				assert(size <= size_t(m_desc.numVertices) * m_desc.stride);
+				glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+				glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(size), static_cast<const GLvoid *>(data));
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+				m_written = true;
 			}
 		}
 
@@ -442,13 +458,19 @@ namespace Graphics {
 			m_written = true;
 		}
 
-		void IndexBuffer::BufferData(const size_t size, void *data)
+		void IndexBuffer::BufferData(const size_t size, const void *data)
 		{
 			PROFILE_SCOPED()
 			assert(m_mapMode == BUFFER_MAP_NONE); //must not be currently mapped
 			if (GetUsage() == BUFFER_USAGE_DYNAMIC) {
 				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
-				glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(size), static_cast<GLvoid *>(data), GL_DYNAMIC_DRAW);
+				glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(size), static_cast<const GLvoid *>(data), GL_DYNAMIC_DRAW);
+			} else if (GetUsage() == BUFFER_USAGE_STATIC) {
+				assert(size <= sizeof(Uint32) * m_size);
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
+				glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(size), static_cast<const GLvoid *>(data));
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+				m_written = true;
 			}
 		}
 
@@ -9,6 +9,12 @@
 namespace Graphics {
 	namespace OGL {
 
+		// fills in the offsets and stride of a desc that leaves them at zero
+		void CompleteVertexBufferDesc(VertexBufferDesc &desc);
+		// enables the attributes of a completed desc in the bound vertex array object,
+		// pointing them into the buffer bound to GL_ARRAY_BUFFER
+		void SetVertexAttribPointers(const VertexBufferDesc &desc);
+
 		class GLBufferBase {
 		public:
 			GLBufferBase() :
@@ -31,7 +37,7 @@ namespace Graphics {
 			virtual bool Populate(const VertexArray &) override final;
 
 			// change the buffer data without mapping
-			virtual void BufferData(const size_t, void *) override final;
+			virtual void BufferData(const size_t, const void *) override final;
 
 			virtual void Bind() override final;
 			virtual void Release() override final;
@@ -53,7 +59,7 @@ namespace Graphics {
 			virtual void Unmap() override final;
 
 			// change the buffer data without mapping
-			virtual void BufferData(const size_t, void *) override final;
+			virtual void BufferData(const size_t, const void *) override final;
 
 			virtual void Bind() override final;
 			virtual void Release() override final;
@@ -99,6 +99,7 @@ namespace Lua {
 		LuaConstants::Register(Lua::manager->GetLuaState());
 		LuaLang::Register();
 		LuaEngine::Register();
+		LuaEvent::Register();
 		LuaEconomy::Register();
 		LuaInput::Register();
 		LuaFileSystem::Register();
@@ -128,6 +129,9 @@ namespace Lua {
 
 		pi_lua_import_recursive(l, "modules");
 
+		// no frames have stepped the collector while the modules were loading
+		Lua::manager->CollectGarbage();
+
 		Pi::luaNameGen = new LuaNameGen(Lua::manager);
 	}
 
@@ -135,6 +139,8 @@ namespace Lua {
 	{
 		delete Pi::luaNameGen;
 
+		LuaEvent::Uninit();
+
 		delete Pi::luaSerializer;
 		delete Pi::luaTimer;
 	}
@@ -2,10 +2,31 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "LuaDev.h"
+#include "Body.h"
+#include "FileSystem.h"
 #include "Game.h"
+#include "GameSaveError.h"
+#include "GameSaveHeader.h"
+#include "JsonUtils.h"
+#include "LuaManager.h"
 #include "LuaObject.h"
+#include "LuaProfiler.h"
 #include "Pi.h"
+#include "ShipType.h"
+#include "Space.h"
 #include "WorldView.h"
+#include "core/GZipFormat.h"
+#include "core/LZ4Format.h"
+#include "galaxy/Factions.h"
+#include "galaxy/Galaxy.h"
+#include "galaxy/SystemQuery.h"
+#include "graphics/dummy/RendererDummy.h"
+#include "scenegraph/BinaryConverter.h"
+#include "scenegraph/Loader.h"
+#include "scenegraph/Model.h"
+#include <algorithm>
+#include <functional>
+#include <set>
 #include <sstream>
 
 /*
@@ -233,6 +254,645 @@ static int l_dev_galaxy_stats(lua_State *l)
 	return 1;
 }
 
+/*
+ * The Bench* methods time a part of the engine, usually against the way it
+ * was done before or the alternatives to it, and print a short report that
+ * they also return as a string. Like everything else here they are
+ * experimental, and only for development.
+ */
+
+static void require_game(lua_State *l, const char *method)
+{
+	if (!Pi::game)
+		luaL_error(l, "Dev.%s only works when there is a game running", method);
+}
+
+static int push_bench_report(lua_State *l, const std::ostringstream &result)
+{
+	Output("%s", result.str().c_str());
+	LuaPush<std::string>(l, result.str());
+	return 1;
+}
+
+/*
+ * Method: BenchFactionClaims
+ *
+ * Generate every sector in the given cube and time faction assignment for all
+ * of their systems, with and without the faction claim index. Any system that
+ * gets a different faction from the two lookups is reported as a mismatch.
+ *
+ * > require 'Dev'.BenchFactionClaims(0,0,0,10)
+ *
+ * Parameters:
+ *   centerX, centerY, centerZ - integer, coordinates of center of the cube, 0, 0, 0 = Sol
+ *   radius - integer - distance in sectors from center to edge of the cube
+ */
+static int l_dev_bench_faction_claims(lua_State *l)
+{
+	require_game(l, "BenchFactionClaims");
+
+	int centerX = LuaPull<int>(l, 1);
+	int centerY = LuaPull<int>(l, 2);
+	int centerZ = LuaPull<int>(l, 3);
+	int radius = LuaPull<int>(l, 4);
+
+	RefCountedPtr<Galaxy> galaxy = Pi::game->GetGalaxy();
+	const FactionsDatabase *factions = galaxy->GetFactions();
+
+	std::vector<RefCountedPtr<const Sector>> sectors;
+	Profiler::Clock sectorTimer;
+	sectorTimer.Start();
+	for (int sx = centerX - radius; sx <= centerX + radius; ++sx)
+		for (int sy = centerY - radius; sy <= centerY + radius; ++sy)
+			for (int sz = centerZ - radius; sz <= centerZ + radius; ++sz)
+				sectors.push_back(galaxy->GetSector(SystemPath(sx, sy, sz)));
+	sectorTimer.Stop();
+
+	size_t systems = 0, mismatches = 0;
+	for (auto &sec : sectors)
+		systems += sec->m_systems.size();
+
+	Profiler::Clock unindexedTimer;
+	unindexedTimer.Start();
+	std::vector<const Faction *> unindexed;
+	unindexed.reserve(systems);
+	for (auto &sec : sectors)
+		for (auto &system : sec->m_systems)
+			unindexed.push_back(factions->GetNearestClaimantUnindexed(&system));
+	unindexedTimer.Stop();
+
+	Profiler::Clock indexedTimer;
+	indexedTimer.Start();
+	std::vector<const Faction *> indexed;
+	indexed.reserve(systems);
+	for (auto &sec : sectors)
+		for (auto &system : sec->m_systems)
+			indexed.push_back(factions->GetNearestClaimant(&system));
+	indexedTimer.Stop();
+
+	for (size_t i = 0; i < systems; i++)
+		if (indexed[i] != unindexed[i])
+			mismatches++;
+
+	std::ostringstream result;
+	result.precision(3);
+	result << sectors.size() << " sectors, " << systems << " systems, fetched in " << std::fixed << sectorTimer.milliseconds() << "ms\n";
+	result << "unindexed claims: " << unindexedTimer.milliseconds() << "ms (" << systems / std::max(unindexedTimer.milliseconds(), 0.001) << " systems/ms)\n";
+	result << "indexed claims: " << indexedTimer.milliseconds() << "ms (" << systems / std::max(indexedTimer.milliseconds(), 0.001) << " systems/ms)\n";
+	result << mismatches << " mismatches\n";
+
+	return push_bench_report(l, result);
+}
+
+/*
+ * Method: BenchSystemQuery
+ *
+ * Compare the time taken by a SystemQuery (as used by StarSystem:FindNearbySystems)
+ * against generating every system in range and filtering them afterwards, which is
+ * what StarSystem:GetNearbySystems with a Lua filter function does. The query runs
+ * first, so the second pass may find some of its systems already cached.
+ *
+ * > require 'Dev'.BenchSystemQuery(30)
+ *
+ * Parameters:
+ *   range - search radius in light years around the current system
+ */
+static int l_dev_bench_system_query(lua_State *l)
+{
+	require_game(l, "BenchSystemQuery");
+
+	const double range = LuaPull<double>(l, 1);
+	RefCountedPtr<Galaxy> galaxy = Pi::game->GetGalaxy();
+	RefCountedPtr<StarSystem> here = Pi::game->GetSpace()->GetStarSystem();
+	const Faction *faction = here->GetFaction();
+
+	struct Scenario {
+		const char *name;
+		bool explored;
+		bool ownFaction;
+		bool stations;
+	} scenarios[] = {
+		{ "hasStations", false, false, true },
+		{ "explored, hasStations", true, false, true },
+		{ "same faction, hasStations", false, true, true },
+		{ "same faction", false, true, false },
+	};
+
+	std::ostringstream result;
+	result.precision(3);
+	for (const Scenario &sc : scenarios) {
+		SystemQuery query(here->GetPath(), range);
+		if (sc.explored) query.SetExplored(SystemQuery::EXPLORED_ONLY);
+		if (sc.ownFaction) query.AddFaction(faction);
+		if (sc.stations) query.SetStations(SystemQuery::STATIONS_ONLY);
+
+		Profiler::Clock queryTimer;
+		queryTimer.Start();
+		std::vector<RefCountedPtr<StarSystem>> found;
+		query.FindSystems(galaxy.Get(), found);
+		queryTimer.Stop();
+
+		// everything in range, generated one by one and then filtered
+		Profiler::Clock filterTimer;
+		filterTimer.Start();
+		SystemQuery all(here->GetPath(), range);
+		std::vector<SystemPath> paths;
+		all.FindPaths(galaxy.Get(), paths);
+		size_t filtered = 0;
+		for (const SystemPath &path : paths) {
+			RefCountedPtr<StarSystem> sys = galaxy->GetStarSystem(path);
+			if (sc.explored && sys->GetExplored() == StarSystem::eUNEXPLORED) continue;
+			if (sc.ownFaction && sys->GetFaction() != faction) continue;
+			if (sc.stations && !sys->HasSpaceStations()) continue;
+			++filtered;
+		}
+		filterTimer.Stop();
+
+		const SystemQuery::Stats &stats = query.GetStats();
+		result << sc.name << ": " << found.size() << " matches (filter: " << filtered << ") of " << stats.inRange << " in range\n";
+		result << "  query " << std::fixed << queryTimer.milliseconds() << "ms, generated " << stats.generated << " systems\n";
+		result << "  generate and filter " << filterTimer.milliseconds() << "ms, generated " << paths.size() << " systems\n";
+	}
+
+	return push_bench_report(l, result);
+}
+
+/*
+ * Method: BenchLuaObjects
+ *
+ * Time pushing engine objects to Lua and pulling them back off the stack, for
+ * the bodies in the current system and for <SystemPath>. Bodies are pulled as
+ * <Body>, so most of them have to be checked against their base class.
+ *
+ * > require 'Dev'.BenchLuaObjects(100000)
+ *
+ * Parameters:
+ *   iterations - optional integer, number of pushes and pulls of each kind (default 100000)
+ */
+static int l_dev_bench_lua_objects(lua_State *l)
+{
+	require_game(l, "BenchLuaObjects");
+
+	const int iterations = std::max(int(luaL_optinteger(l, 1, 100000)), 1);
+
+	std::vector<Body *> bodies;
+	for (Body *body : Pi::game->GetSpace()->GetBodies())
+		bodies.push_back(body);
+	const SystemPath path = Pi::game->GetSpace()->GetStarSystem()->GetPath();
+
+	std::ostringstream result;
+	result.precision(1);
+	auto report = [&](const char *name, Profiler::Clock &clock) {
+		result << name << ": " << std::fixed << clock.milliseconds() * 1e6 / iterations << "ns\n";
+	};
+
+	Profiler::Clock pushBody;
+	pushBody.Start();
+	for (int i = 0; i < iterations; i++) {
+		LuaObject<Body>::PushToLua(bodies[i % bodies.size()]);
+		lua_pop(l, 1);
+	}
+	pushBody.Stop();
+	report("push Body", pushBody);
+
+	lua_checkstack(l, bodies.size());
+	const int first = lua_gettop(l) + 1;
+	for (Body *body : bodies)
+		LuaObject<Body>::PushToLua(body);
+
+	size_t pulled = 0;
+	Profiler::Clock pullBody;
+	pullBody.Start();
+	for (int i = 0; i < iterations; i++)
+		pulled += LuaObject<Body>::CheckFromLua(first + i % bodies.size()) != nullptr;
+	pullBody.Stop();
+	report("pull Body", pullBody);
+	lua_settop(l, first - 1);
+
+	Profiler::Clock pushPath;
+	pushPath.Start();
+	for (int i = 0; i < iterations; i++) {
+		LuaObject<SystemPath>::PushToLua(path);
+		lua_pop(l, 1);
+	}
+	pushPath.Stop();
+	report("push SystemPath", pushPath);
+
+	LuaObject<SystemPath>::PushToLua(path);
+	Profiler::Clock pullPath;
+	pullPath.Start();
+	for (int i = 0; i < iterations; i++)
+		pulled += LuaObject<SystemPath>::CheckFromLua(-1) != nullptr;
+	pullPath.Stop();
+	report("pull SystemPath", pullPath);
+	lua_pop(l, 1);
+
+	result << "(" << bodies.size() << " bodies, " << pulled << " pulls)\n";
+
+	return push_bench_report(l, result);
+}
+
+/*
+ * Method: BenchSaveCompression
+ *
+ * Compress the saved games in the save folder with each of the choices for the
+ * SaveCompression config option, decompress them again, and report the average
+ * time per save for both along with the compressed size as a share of the
+ * uncompressed game state. The header of each save is left out.
+ *
+ * > require 'Dev'.BenchSaveCompression(3, 10)
+ *
+ * Parameters:
+ *   iterations - optional integer, times each save is compressed and decompressed
+ *                with each method (default 3)
+ *   maxFiles - optional integer, the most saves to use (default 10)
+ */
+static int l_dev_bench_save_compression(lua_State *l)
+{
+	const int iterations = std::max(int(luaL_optinteger(l, 1, 3)), 1);
+	const int maxFiles = std::max(int(luaL_optinteger(l, 2, 10)), 1);
+
+	typedef std::function<std::string(const std::string &)> CompressFunc;
+	struct Method {
+		Method(const char *name_, CompressFunc compress_) :
+			name(name_),
+			compress(compress_),
+			compressedSize(0),
+			mismatches(0) {}
+
+		const char *name;
+		CompressFunc compress;
+		size_t compressedSize;
+		Profiler::Clock compressTimer;
+		Profiler::Clock decompressTimer;
+		int mismatches;
+	};
+	// the same presets that Game uses for lz4 and lz4hc
+	Method methods[] = {
+		{ "gzip", [](const std::string &data) { return gzip::CompressGZip(data, "bench.json"); } },
+		{ "gzip-mt", [](const std::string &data) { return gzip::CompressGZipParallel(reinterpret_cast<const unsigned char *>(data.data()), data.size(), "bench.json", Pi::GetAsyncJobQueue()->GetNumRunners()); } },
+		{ "lz4", [](const std::string &data) { return lz4::CompressLZ4(data, 0); } },
+		{ "lz4hc", [](const std::string &data) { return lz4::CompressLZ4(data, 9); } },
+	};
+
+	std::vector<std::string> saves;
+	size_t plainSize = 0;
+	for (FileSystem::FileEnumerator files(FileSystem::userFiles, Pi::SAVE_DIR_NAME); !files.Finished() && int(saves.size()) < maxFiles; files.Next()) {
+		auto file = files.Current().Read();
+		if (!file) continue;
+
+		const unsigned char *data = reinterpret_cast<const unsigned char *>(file->GetData());
+		const size_t header = GameSaveHeader::GetSize(data, file->GetSize());
+		try {
+			saves.push_back(JsonUtils::DecompressSaveData(data + header, file->GetSize() - header));
+			plainSize += saves.back().size();
+		} catch (gzip::DecompressionFailedException) {
+		} catch (lz4::DecompressionFailedException &) {
+		}
+	}
+	if (saves.empty())
+		return luaL_error(l, "Dev.BenchSaveCompression found no saved games");
+
+	for (Method &method : methods) {
+		for (const std::string &plain : saves) {
+			std::string compressed;
+			for (int i = 0; i < iterations; i++) {
+				method.compressTimer.Start();
+				compressed = method.compress(plain);
+				method.compressTimer.Stop();
+			}
+			method.compressedSize += compressed.size();
+
+			std::string decompressed;
+			for (int i = 0; i < iterations; i++) {
+				method.decompressTimer.Start();
+				decompressed = JsonUtils::DecompressSaveData(reinterpret_cast<const unsigned char *>(compressed.data()), compressed.size());
+				method.decompressTimer.Stop();
+			}
+			if (decompressed != plain)
+				++method.mismatches;
+		}
+	}
+
+	std::ostringstream result;
+	result << saves.size() << " saves, " << plainSize / 1024 << "KB of game state\n";
+	const double runs = double(saves.size()) * iterations;
+	for (Method &method : methods) {
+		result << method.name << ": " << std::fixed;
+		result.precision(1);
+		result << "compress " << method.compressTimer.milliseconds() / runs << "ms, decompress " << method.decompressTimer.milliseconds() / runs << "ms, ";
+		result.precision(3);
+		result << "ratio " << double(method.compressedSize) / plainSize;
+		if (method.mismatches)
+			result << ", " << method.mismatches << " FAILED ROUND TRIPS";
+		result << "\n";
+	}
+
+	return push_bench_report(l, result);
+}
+
+/*
+ * Method: BenchModelLoading
+ *
+ * Save every ship model as both a compressed and a mapped .sgm in the user's
+ * binarymodels/bench folder, then load each of them again, and report the
+ * average time per model for both along with the size of the files. The
+ * compressed ones are read and decompressed, the mapped ones are mapped.
+ *
+ * > require 'Dev'.BenchModelLoading(3)
+ *
+ * Parameters:
+ *   iterations - optional integer, times each model is loaded from each file
+ *                (default 3)
+ */
+static int l_dev_bench_model_loading(lua_State *l)
+{
+	const int iterations = std::max(int(luaL_optinteger(l, 1, 3)), 1);
+
+	struct Format {
+		const char *name;
+		bool mapped;
+		size_t size;
+		Profiler::Clock timer;
+	};
+	Format formats[] = {
+		{ "compressed", false, 0, Profiler::Clock() },
+		{ "mapped", true, 0, Profiler::Clock() },
+	};
+
+	std::set<std::string> modelNames;
+	for (const auto &it : ShipType::types)
+		modelNames.insert(it.second.modelName);
+
+	int numModels = 0;
+	int failures = 0;
+	for (const std::string &modelName : modelNames) {
+		// from the .model, as the modelcompiler does
+		std::unique_ptr<SceneGraph::Model> model;
+		try {
+			SceneGraph::Loader loader(Pi::renderer, false, false);
+			model.reset(loader.LoadModel(modelName));
+		} catch (SceneGraph::LoadingError &) {
+			continue;
+		}
+
+		// the converter finds the textures in the directory Save() found the .model in
+		SceneGraph::BinaryConverter bc(Pi::renderer);
+		try {
+			for (Format &format : formats)
+				bc.Save(modelName, std::string("bench/") + format.name + "/" + modelName, model.get(), false, format.mapped);
+		} catch (const CouldNotOpenFileException &) {
+			return luaL_error(l, "Dev.BenchModelLoading couldn't write to binarymodels/bench");
+		} catch (const CouldNotWriteToFileException &) {
+			return luaL_error(l, "Dev.BenchModelLoading couldn't write to binarymodels/bench");
+		}
+		++numModels;
+
+		for (Format &format : formats) {
+			const std::string path = std::string("binarymodels/bench/") + format.name + "/" + modelName + ".sgm";
+			for (int i = 0; i < iterations; i++) {
+				format.timer.Start();
+				RefCountedPtr<FileSystem::FileData> file = format.mapped ? FileSystem::userFiles.MapFile(path) : FileSystem::userFiles.ReadFile(path);
+				std::unique_ptr<SceneGraph::Model> loaded(file ? bc.Load(modelName, file) : nullptr);
+				format.timer.Stop();
+				if (!loaded)
+					++failures;
+				if (file && i == 0)
+					format.size += file->GetSize();
+			}
+		}
+	}
+	if (!numModels)
+		return luaL_error(l, "Dev.BenchModelLoading found no ship models to load");
+
+	std::ostringstream result;
+	result << numModels << " ship models\n";
+	const double runs = double(numModels) * iterations;
+	for (Format &format : formats) {
+		result << format.name << ": " << std::fixed;
+		result.precision(2);
+		result << "load " << format.timer.milliseconds() / runs << "ms, ";
+		result << format.size / 1024 << "KB of files\n";
+	}
+	if (failures)
+		result << failures << " LOADS FAILED\n";
+
+	return push_bench_report(l, result);
+}
+
+/*
+ * Method: BenchModelRendering
+ *
+ * Load every ship model through a renderer that draws nothing, make a number
+ * of instances of each spread out in front of the camera, and report the CPU
+ * time per instance it takes to render them all by traversing the scene graph
+ * and by walking the compiled render list, in the two passes Model::Render()
+ * makes.
+ *
+ * > require 'Dev'.BenchModelRendering(100, 10)
+ *
+ * Parameters:
+ *   instances - optional integer, instances of each model (default 100)
+ *   frames - optional integer, times each instance is rendered (default 10)
+ */
+static int l_dev_bench_model_rendering(lua_State *l)
+{
+	const int numInstances = std::max(int(luaL_optinteger(l, 1, 100)), 1);
+	const int frames = std::max(int(luaL_optinteger(l, 2, 10)), 1);
+
+	std::set<std::string> modelNames;
+	for (const auto &it : ShipType::types)
+		modelNames.insert(it.second.modelName);
+
+	// the nodes keep the renderer they were made with, so the models are
+	// loaded again for this one
+	Graphics::RendererDummy renderer;
+	Profiler::Clock graphTimer;
+	Profiler::Clock listTimer;
+	size_t numItems = 0;
+	int numModels = 0;
+	for (const std::string &modelName : modelNames) {
+		std::unique_ptr<SceneGraph::Model> model;
+		try {
+			SceneGraph::Loader loader(&renderer);
+			model.reset(loader.LoadModel(modelName));
+		} catch (SceneGraph::LoadingError &) {
+			continue;
+		}
+		++numModels;
+
+		// from close up to far enough away for the lowest detail level
+		std::vector<std::unique_ptr<SceneGraph::Model>> instances;
+		std::vector<matrix4x4f> transforms;
+		for (int i = 0; i < numInstances; i++) {
+			instances.emplace_back(model->MakeInstance());
+			const float distance = model->GetDrawClipRadius() * (2.f + 200.f * i / numInstances);
+			transforms.push_back(matrix4x4f::Translation(0.f, 0.f, -distance) * matrix4x4f::RotateYMatrix(float(i)));
+		}
+		numItems += instances.front()->GetRenderList().GetNumItems();
+
+		SceneGraph::RenderData rd;
+		rd.boundingRadius = model->GetDrawClipRadius();
+		for (int f = 0; f < frames; f++) {
+			graphTimer.Start();
+			for (int i = 0; i < numInstances; i++) {
+				SceneGraph::Group *root = instances[i]->GetRoot().Get();
+				rd.nodemask = SceneGraph::NODE_SOLID;
+				root->Render(transforms[i], &rd);
+				rd.nodemask = SceneGraph::NODE_TRANSPARENT;
+				root->Render(transforms[i], &rd);
+			}
+			graphTimer.Stop();
+
+			listTimer.Start();
+			for (int i = 0; i < numInstances; i++) {
+				SceneGraph::RenderList &list = instances[i]->GetRenderList();
+				rd.nodemask = SceneGraph::NODE_SOLID;
+				list.Render(transforms[i], &rd);
+				rd.nodemask = SceneGraph::NODE_TRANSPARENT;
+				list.Render(transforms[i], &rd);
+			}
+			listTimer.Stop();
+		}
+	}
+	if (!numModels)
+		return luaL_error(l, "Dev.BenchModelRendering found no ship models to load");
+
+	std::ostringstream result;
+	const double runs = double(numModels) * numInstances * frames;
+	result << numModels << " ship models, " << numInstances << " instances each, " << std::fixed;
+	result.precision(1);
+	result << double(numItems) / numModels << " render list items per model on average\n";
+	result.precision(2);
+	result << "graph: " << graphTimer.milliseconds() * 1000.0 / runs << "us per instance\n";
+	result << "render list: " << listTimer.milliseconds() * 1000.0 / runs << "us per instance\n";
+
+	return push_bench_report(l, result);
+}
+
+/*
+ * Method: StartLuaProfiler
+ *
+ * Start profiling Lua code. Results add up until <DumpLuaProfile> is called.
+ *
+ * > require 'Dev'.StartLuaProfiler("sample", 1000)
+ *
+ * Parameters:
+ *   mode - optional string, "sample" (the default) takes a sample of the call
+ *          stack every so many VM instructions, "calls" counts every call and
+ *          times it exactly, at a much higher cost
+ *   interval - optional integer, VM instructions between samples (default 1000)
+ *
+ * Availability:
+ *
+ *   2020
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_dev_start_lua_profiler(lua_State *l)
+{
+	const std::string mode = luaL_optstring(l, 1, "sample");
+	const int interval = luaL_optinteger(l, 2, 1000);
+
+	LuaProfiler::Mode profilerMode;
+	if (mode == "sample")
+		profilerMode = LuaProfiler::MODE_SAMPLE;
+	else if (mode == "calls")
+		profilerMode = LuaProfiler::MODE_CALLS;
+	else
+		return luaL_error(l, "Unknown profiler mode '%s' (expected 'sample' or 'calls')", mode.c_str());
+
+	Lua::manager->GetProfiler()->Start(profilerMode, interval);
+	return 0;
+}
+
+/*
+ * Method: StopLuaProfiler
+ *
+ * Stop profiling Lua code, keeping the results so far.
+ *
+ * > require 'Dev'.StopLuaProfiler()
+ *
+ * Availability:
+ *
+ *   2020
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_dev_stop_lua_profiler(lua_State *l)
+{
+	Lua::manager->GetProfiler()->Stop();
+	return 0;
+}
+
+/*
+ * Method: DumpLuaProfile
+ *
+ * Print the functions with the most self time (or samples), write every call
+ * stack seen to a folded stack file in the profiler folder of the user
+ * directory, ready for flamegraph.pl or speedscope, and clear the results.
+ *
+ * > require 'Dev'.DumpLuaProfile("lua.folded")
+ *
+ * Parameters:
+ *   filename - optional string, defaults to "lua.folded"
+ *
+ * Returns:
+ *   the path of the file written, relative to the user directory
+ *
+ * Availability:
+ *
+ *   2020
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_dev_dump_lua_profile(lua_State *l)
+{
+	const std::string filename = luaL_optstring(l, 1, "lua.folded");
+	LuaProfiler *profiler = Lua::manager->GetProfiler();
+
+	// the results can't be walked while they're being added to
+	const bool running = profiler->IsRunning();
+	profiler->Stop();
+
+	std::vector<LuaProfiler::FunctionStats> stats;
+	profiler->GetFunctionStats(stats);
+	const bool sampled = profiler->GetMode() == LuaProfiler::MODE_SAMPLE;
+	std::sort(stats.begin(), stats.end(), [sampled](const LuaProfiler::FunctionStats &a, const LuaProfiler::FunctionStats &b) {
+		return sampled ? a.samples > b.samples : a.selfMs > b.selfMs;
+	});
+
+	std::ostringstream result;
+	result.precision(3);
+	result << std::fixed;
+	for (size_t i = 0; i < std::min<size_t>(stats.size(), 20); i++) {
+		const LuaProfiler::FunctionStats &fs = stats[i];
+		if (sampled)
+			result << fs.samples << " self, " << fs.totalSamples << " total samples: " << fs.name << "\n";
+		else
+			result << fs.selfMs << "ms self, " << fs.totalMs << "ms total, " << fs.calls << " calls: " << fs.name << "\n";
+	}
+	Output("%s", result.str().c_str());
+
+	FileSystem::userFiles.MakeDirectory("profiler");
+	const std::string path = FileSystem::JoinPathBelow("profiler", filename);
+	if (!profiler->DumpFolded(path))
+		return luaL_error(l, "Couldn't write the Lua profile to '%s'", path.c_str());
+
+	profiler->Reset();
+	if (running)
+		profiler->Start(profiler->GetMode(), profiler->GetSampleInterval());
+
+	LuaPush<std::string>(l, path);
+	return 1;
+}
+
 /*
  * Set current camera offset to vector,
  * (the offset will reset when switching cameras)
@@ -259,6 +919,15 @@ void LuaDev::Register()
 
 	static const luaL_Reg methods[] = {
 		{ "GalaxyStats", l_dev_galaxy_stats },
+		{ "BenchFactionClaims", l_dev_bench_faction_claims },
+		{ "BenchSystemQuery", l_dev_bench_system_query },
+		{ "BenchLuaObjects", l_dev_bench_lua_objects },
+		{ "BenchSaveCompression", l_dev_bench_save_compression },
+		{ "BenchModelLoading", l_dev_bench_model_loading },
+		{ "BenchModelRendering", l_dev_bench_model_rendering },
+		{ "StartLuaProfiler", l_dev_start_lua_profiler },
+		{ "StopLuaProfiler", l_dev_stop_lua_profiler },
+		{ "DumpLuaProfile", l_dev_dump_lua_profile },
 		{ "SetCameraOffset", l_dev_set_camera_offset },
 		{ 0, 0 }
 	};
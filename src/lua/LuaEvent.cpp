@@ -6,50 +6,273 @@
 #include "LuaObject.h"
 #include "LuaUtils.h"
 #include "libs.h"
+#include <algorithm>
+#include <unordered_map>
 
-namespace LuaEvent {
+/*
+ * The event queue and the handler lists live here rather than in Lua.
+ *
+ * Each event type gets a small index the first time its name is seen, and
+ * its handlers are kept as registry refs in registration order. A queued
+ * event is just its type and a run of slots in a single Lua table that holds
+ * the arguments, so queueing doesn't create any tables or call into Lua, and
+ * the arguments are still turned into Lua values straight away (a Body can
+ * be gone by the time the queue is processed, its Lua object can't).
+ *
+ * Events are processed in the order they were queued. Consecutive events of
+ * the same type are dispatched as a batch that shares one handler lookup.
+ */
+
+namespace {
+
+	struct EventType {
+		std::string name;
+		std::vector<int> handlers; // LUA_NOREF for ones removed while being dispatched
+		bool debugTimer = false;
+
+		Uint32 queued = 0;
+		Uint32 calls = 0;
+		Uint64 ticks = 0;
+	};
+
+	struct PendingEvent {
+		Uint32 type;
+		Uint32 firstArg;
+		Uint32 numArgs;
+	};
+
+	// a growable ring of pending events
+	class EventRing {
+	public:
+		EventRing() :
+			m_events(64),
+			m_head(0),
+			m_count(0) {}
+
+		bool Empty() const { return m_count == 0; }
+
+		const PendingEvent &Front() const { return m_events[m_head]; }
+		const PendingEvent &At(size_t i) const { return m_events[(m_head + i) & (m_events.size() - 1)]; }
+
+		void Push(const PendingEvent &ev)
+		{
+			if (m_count == m_events.size()) Grow();
+			m_events[(m_head + m_count) & (m_events.size() - 1)] = ev;
+			++m_count;
+		}
+
+		void Pop()
+		{
+			assert(m_count > 0);
+			m_head = (m_head + 1) & (m_events.size() - 1);
+			--m_count;
+		}
+
+		void Clear()
+		{
+			m_head = 0;
+			m_count = 0;
+		}
+
+	private:
+		void Grow()
+		{
+			std::vector<PendingEvent> events(m_events.size() * 2);
+			for (size_t i = 0; i < m_count; i++)
+				events[i] = At(i);
+			m_events.swap(events);
+			m_head = 0;
+		}
+
+		std::vector<PendingEvent> m_events; // size is always a power of two
+		size_t m_head;
+		size_t m_count;
+	};
+
+	std::vector<EventType> s_types;
+	std::unordered_map<std::string, Uint32> s_typeIndex;
+
+	EventRing s_queue;
+	int s_argsRef = LUA_NOREF; // registry ref of the table holding the arguments of queued events
+	Uint32 s_nextArg = 1;
+
+	int s_dispatching = 0;
+	std::vector<int> s_deadRefs; // handlers removed during dispatch, unref'd once it's done
 
-	static bool _get_method_onto_stack(lua_State *l, const char *method)
+	Uint32 GetType(const std::string &name)
+	{
+		auto it = s_typeIndex.find(name);
+		if (it != s_typeIndex.end())
+			return it->second;
+
+		const Uint32 type = s_types.size();
+		s_types.emplace_back();
+		s_types.back().name = name;
+		s_typeIndex.emplace(name, type);
+		return type;
+	}
+
+	void PushArgsTable(lua_State *l)
+	{
+		if (s_argsRef == LUA_NOREF) {
+			lua_newtable(l);
+			lua_pushvalue(l, -1);
+			s_argsRef = luaL_ref(l, LUA_REGISTRYINDEX);
+		} else {
+			lua_rawgeti(l, LUA_REGISTRYINDEX, s_argsRef);
+		}
+	}
+
+	// queue an event of the given type with the numArgs values on the top of the stack as its arguments, and pop them
+	void QueueFromStack(lua_State *l, Uint32 type, int numArgs)
 	{
 		LUA_DEBUG_START(l);
 
-		int top = lua_gettop(l);
+		const int first = lua_gettop(l) - numArgs + 1;
 
-		if (!pi_lua_import(l, "Event"))
-			return false;
+		PendingEvent ev;
+		ev.type = type;
+		ev.firstArg = s_nextArg;
+		ev.numArgs = numArgs;
+		s_nextArg += numArgs;
 
-		lua_getfield(l, -1, method);
-		if (!lua_isfunction(l, -1)) {
-			lua_pop(l, 2);
-			LUA_DEBUG_END(l, 0);
-			return false;
+		if (numArgs) {
+			PushArgsTable(l);
+			for (int i = 0; i < numArgs; i++) {
+				lua_pushvalue(l, first + i);
+				lua_rawseti(l, -2, ev.firstArg + i);
+			}
+			lua_pop(l, 1);
 		}
+		lua_pop(l, numArgs);
 
-		lua_insert(l, top + 1);
-		lua_settop(l, top + 1);
+		s_queue.Push(ev);
+		++s_types[type].queued;
 
-		LUA_DEBUG_END(l, 1);
+		LUA_DEBUG_END(l, -numArgs);
+	}
 
-		return true;
+	// push the arguments of the event at the front of the queue, and drop it from the queue
+	void PopArgs(lua_State *l, const PendingEvent &ev)
+	{
+		if (ev.numArgs) {
+			PushArgsTable(l);
+			for (Uint32 i = 0; i < ev.numArgs; i++) {
+				lua_rawgeti(l, -1 - i, ev.firstArg + i);
+				// don't let the table keep anything alive
+				lua_pushnil(l);
+				lua_rawseti(l, -3 - i, ev.firstArg + i);
+			}
+			lua_remove(l, -1 - ev.numArgs);
+		}
+
+		s_queue.Pop();
+		if (s_queue.Empty())
+			s_nextArg = 1;
+	}
+
+	void CallHandler(lua_State *l, Uint32 typeIndex, int handler, int args, int numArgs)
+	{
+		lua_rawgeti(l, LUA_REGISTRYINDEX, handler);
+		for (int i = 0; i < numArgs; i++)
+			lua_pushvalue(l, args + i);
+
+		Profiler::Clock clock;
+		clock.Start();
+		pi_lua_protected_call(l, numArgs, 0);
+		clock.Stop();
+
+		// the handler may have added event types and moved this one
+		EventType &type = s_types[typeIndex];
+		++type.calls;
+		type.ticks += clock.ticks;
+
+		if (type.debugTimer) {
+			lua_rawgeti(l, LUA_REGISTRYINDEX, handler);
+			lua_Debug ar;
+			lua_getinfo(l, ">S", &ar);
+			Output("DEBUG: %s %.3fms %s:%d\n", type.name.c_str(), Profiler::Clock::ms(clock.ticks), ar.source, ar.linedefined);
+		}
 	}
 
+	int FindHandler(lua_State *l, const EventType &type, int fn)
+	{
+		for (size_t i = 0; i < type.handlers.size(); i++) {
+			if (type.handlers[i] == LUA_NOREF) continue;
+			lua_rawgeti(l, LUA_REGISTRYINDEX, type.handlers[i]);
+			const bool found = lua_rawequal(l, -1, fn);
+			lua_pop(l, 1);
+			if (found) return int(i);
+		}
+		return -1;
+	}
+
+	void CompactHandlers()
+	{
+		if (s_deadRefs.empty()) return;
+
+		lua_State *l = Lua::manager->GetLuaState();
+		for (int ref : s_deadRefs)
+			luaL_unref(l, LUA_REGISTRYINDEX, ref);
+		s_deadRefs.clear();
+
+		for (EventType &type : s_types)
+			type.handlers.erase(std::remove(type.handlers.begin(), type.handlers.end(), LUA_NOREF), type.handlers.end());
+	}
+
+} // namespace
+
+namespace LuaEvent {
+
 	void Clear()
 	{
 		lua_State *l = Lua::manager->GetLuaState();
 
-		LUA_DEBUG_START(l);
-		if (!_get_method_onto_stack(l, "_Clear")) return;
-		pi_lua_protected_call(l, 0, 0);
-		LUA_DEBUG_END(l, 0);
+		if (s_argsRef != LUA_NOREF) {
+			lua_newtable(l);
+			lua_rawseti(l, LUA_REGISTRYINDEX, s_argsRef);
+		}
+		s_queue.Clear();
+		s_nextArg = 1;
 	}
 
 	void Emit()
 	{
+		if (s_queue.Empty())
+			return;
+
+		PROFILE_SCOPED()
 		lua_State *l = Lua::manager->GetLuaState();
 
 		LUA_DEBUG_START(l);
-		if (!_get_method_onto_stack(l, "_Emit")) return;
-		pi_lua_protected_call(l, 0, 0);
+
+		++s_dispatching;
+		while (!s_queue.Empty()) {
+			const Uint32 typeIndex = s_queue.Front().type;
+
+			// a batch runs until the next event of another type
+			while (!s_queue.Empty() && s_queue.Front().type == typeIndex) {
+				const PendingEvent ev = s_queue.Front();
+				const int args = lua_gettop(l) + 1;
+				PopArgs(l, ev);
+
+				// registering a handler can move the list, so index it afresh each time;
+				// handlers added while this event is being dispatched don't see it
+				const size_t numHandlers = s_types[typeIndex].handlers.size();
+				for (size_t i = 0; i < numHandlers; i++) {
+					const int handler = s_types[typeIndex].handlers[i];
+					if (handler != LUA_NOREF)
+						CallHandler(l, typeIndex, handler, args, ev.numArgs);
+				}
+
+				lua_pop(l, int(ev.numArgs));
+			}
+		}
+		--s_dispatching;
+
+		if (!s_dispatching)
+			CompactHandlers();
+
 		LUA_DEBUG_END(l, 0);
 	}
 
@@ -58,14 +281,138 @@ namespace LuaEvent {
 		lua_State *l = Lua::manager->GetLuaState();
 
 		LUA_DEBUG_START(l);
-		if (!_get_method_onto_stack(l, "Queue")) return;
 
-		int top = lua_gettop(l);
-		lua_pushstring(l, event);
+		const Uint32 type = GetType(event);
+		const int top = lua_gettop(l);
 		args.PrepareStack(l);
-		pi_lua_protected_call(l, lua_gettop(l) - top, 0);
+		QueueFromStack(l, type, lua_gettop(l) - top);
 
 		LUA_DEBUG_END(l, 0);
 	}
 
+	void GetStats(std::vector<EventStats> &stats)
+	{
+		stats.clear();
+		stats.reserve(s_types.size());
+		for (const EventType &type : s_types) {
+			EventStats es;
+			es.name = type.name;
+			es.queued = type.queued;
+			es.handlers = type.handlers.size() - std::count(type.handlers.begin(), type.handlers.end(), LUA_NOREF);
+			es.calls = type.calls;
+			es.ms = Profiler::Clock::ms(type.ticks);
+			stats.push_back(es);
+		}
+	}
+
+	void ResetStats()
+	{
+		for (EventType &type : s_types) {
+			type.queued = 0;
+			type.calls = 0;
+			type.ticks = 0;
+		}
+	}
+
+} // namespace LuaEvent
+
+/*
+ * These are the functions behind the Event library (data/libs/Event.lua),
+ * which is where they are documented.
+ */
+
+static int l_event_register(lua_State *l)
+{
+	const std::string name = luaL_checkstring(l, 1);
+	luaL_checktype(l, 2, LUA_TFUNCTION);
+
+	EventType &type = s_types[GetType(name)];
+	if (FindHandler(l, type, 2) >= 0)
+		return 0;
+
+	lua_pushvalue(l, 2);
+	type.handlers.push_back(luaL_ref(l, LUA_REGISTRYINDEX));
+	return 0;
+}
+
+static int l_event_deregister(lua_State *l)
+{
+	const std::string name = luaL_checkstring(l, 1);
+
+	auto it = s_typeIndex.find(name);
+	if (it == s_typeIndex.end())
+		return 0;
+
+	EventType &type = s_types[it->second];
+	const int index = FindHandler(l, type, 2);
+	if (index < 0)
+		return 0;
+
+	if (s_dispatching) {
+		// the handler list may be being walked right now
+		s_deadRefs.push_back(type.handlers[index]);
+		type.handlers[index] = LUA_NOREF;
+	} else {
+		luaL_unref(l, LUA_REGISTRYINDEX, type.handlers[index]);
+		type.handlers.erase(type.handlers.begin() + index);
+	}
+	return 0;
+}
+
+static int l_event_queue(lua_State *l)
+{
+	const std::string name = luaL_checkstring(l, 1);
+	QueueFromStack(l, GetType(name), lua_gettop(l) - 1);
+	return 0;
+}
+
+static int l_event_debug_timer(lua_State *l)
+{
+	const std::string name = luaL_checkstring(l, 1);
+	s_types[GetType(name)].debugTimer = lua_toboolean(l, 2);
+	return 0;
+}
+
+namespace LuaEvent {
+
+	void Register()
+	{
+		lua_State *l = Lua::manager->GetLuaState();
+
+		LUA_DEBUG_START(l);
+
+		static const luaL_Reg l_methods[] = {
+			{ "Register", l_event_register },
+			{ "Deregister", l_event_deregister },
+			{ "Queue", l_event_queue },
+			{ "DebugTimer", l_event_debug_timer },
+			{ 0, 0 }
+		};
+
+		lua_getfield(l, LUA_REGISTRYINDEX, "CoreImports");
+		LuaObjectBase::CreateObject(l_methods, 0, 0);
+		lua_setfield(l, -2, "EventQueue");
+		lua_pop(l, 1);
+
+		LUA_DEBUG_END(l, 0);
+	}
+
+	void Uninit()
+	{
+		lua_State *l = Lua::manager->GetLuaState();
+
+		Clear();
+		for (EventType &type : s_types)
+			for (int ref : type.handlers)
+				luaL_unref(l, LUA_REGISTRYINDEX, ref);
+		for (int ref : s_deadRefs)
+			luaL_unref(l, LUA_REGISTRYINDEX, ref);
+		luaL_unref(l, LUA_REGISTRYINDEX, s_argsRef);
+
+		s_types.clear();
+		s_typeIndex.clear();
+		s_deadRefs.clear();
+		s_argsRef = LUA_NOREF;
+	}
+
 } // namespace LuaEvent
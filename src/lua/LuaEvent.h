@@ -80,9 +80,26 @@ namespace LuaEvent {
 		}
 	};
 
+	// the native side of the Event library; called from Lua::InitModules
+	void Register();
+	// drops the queue and all handlers
+	void Uninit();
+
 	void Clear();
 	void Emit();
 
+	// Per event type totals since the last ResetStats(), for the debug window.
+	struct EventStats {
+		std::string name;
+		Uint32 queued;
+		Uint32 handlers; // registered handlers
+		Uint32 calls;	 // handler calls
+		double ms;		 // time spent in handlers
+	};
+
+	void GetStats(std::vector<EventStats> &stats);
+	void ResetStats();
+
 	void QueueInternal(const char *event, const ArgsBase &args);
 
 	template <typename... TArgs>
@@ -77,6 +77,16 @@ static int l_game_start_game(lua_State *l)
 	return 0;
 }
 
+static void set_game_info(LuaTable &t, const Json &gameInfo)
+{
+	t.Set("system", gameInfo["system"].get<std::string>());
+	t.Set("ship", gameInfo["ship"].get<std::string>());
+	t.Set("credits", gameInfo["credits"].get<float>());
+	t.Set("flight_state", gameInfo["flight_state"].get<std::string>());
+	if (gameInfo["docked_at"].is_string())
+		t.Set("docked_at", gameInfo["docked_at"].get<std::string>());
+}
+
 /*
 * Function: SaveGameStats
 *
@@ -102,6 +112,15 @@ static int l_game_savegame_stats(lua_State *l)
 	std::string filename = LuaPull<std::string>(l, 1);
 
 	try {
+		// saves with a header don't need decompressing
+		Json header;
+		if (Game::LoadGameHeader(filename, header)) {
+			LuaTable t(l, 0, 6);
+			t.Set("time", header["time"].get<double>());
+			set_game_info(t, header["game_info"]);
+			return 1;
+		}
+
 		Json rootNode = Game::LoadGameToJson(filename);
 
 		LuaTable t(l, 0, 3);
@@ -110,13 +129,7 @@ static int l_game_savegame_stats(lua_State *l)
 
 		// if this is a newer saved game, show the embedded info
 		if (rootNode["game_info"].is_object()) {
-			Json gameInfo = rootNode["game_info"];
-			t.Set("system", gameInfo["system"].get<std::string>());
-			t.Set("ship", gameInfo["ship"].get<std::string>());
-			t.Set("credits", gameInfo["credits"].get<float>());
-			t.Set("flight_state", gameInfo["flight_state"].get<std::string>());
-			if (gameInfo["docked_at"].is_string())
-				t.Set("docked_at", gameInfo["docked_at"].get<std::string>());
+			set_game_info(t, rootNode["game_info"]);
 		} else {
 			// this is an older saved game...try to show something useful
 			Json shipNode = rootNode["space"]["bodies"][rootNode["player"].get<int>() - 1];
@@ -267,6 +280,88 @@ static int l_game_save_game(lua_State *l)
 	}
 }
 
+/*
+ * Function: SaveGameAsync
+ *
+ * Save the current game in the background.
+ *
+ * > path = Game.SaveGameAsync(filename)
+ *
+ * Only capturing the game state happens during the call; the file is
+ * compressed and written on a worker thread afterwards. When it is done
+ * either the <onGameSaved> or the <onGameSaveFailed> event is triggered.
+ *
+ * Errors that can be detected straight away (in hyperspace, player dead,
+ * save directory unusable) are raised by the call itself, as for <SaveGame>.
+ *
+ * Parameters:
+ *
+ *   filename - Filename to save to. The file will be placed the 'savefiles'
+ *              directory in the user's game directory.
+ *
+ * Return:
+ *
+ *   path - the full path the file will be saved to (so it can be displayed)
+ *
+ * Availability:
+ *
+ *   2020
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_game_save_game_async(lua_State *l)
+{
+	if (!Pi::game) {
+		return luaL_error(l, "can't save when no game is running");
+	}
+
+	const std::string filename(luaL_checkstring(l, 1));
+	const std::string path = FileSystem::JoinPathBelow(Pi::GetSaveDir(), filename);
+
+	try {
+		Game::SaveGameAsync(filename, Pi::game);
+		lua_pushlstring(l, path.c_str(), path.size());
+		return 1;
+	} catch (CannotSaveInHyperspace) {
+		return luaL_error(l, "%s", Lang::CANT_SAVE_IN_HYPERSPACE);
+	} catch (CannotSaveDeadPlayer) {
+		return luaL_error(l, "%s", Lang::CANT_SAVE_DEAD_PLAYER);
+	} catch (CouldNotOpenFileException) {
+		const std::string message = stringf(Lang::COULD_NOT_OPEN_FILENAME, formatarg("path", path));
+		lua_pushlstring(l, message.c_str(), message.size());
+		return lua_error(l);
+	} catch (CouldNotWriteToFileException) {
+		return luaL_error(l, "%s", Lang::GAME_SAVE_CANNOT_WRITE);
+	}
+}
+
+/*
+ * Function: IsSaving
+ *
+ * Check whether a background save is still being written.
+ *
+ * > saving = Game.IsSaving()
+ *
+ * Return:
+ *
+ *   saving - true if a <SaveGameAsync> hasn't finished yet
+ *
+ * Availability:
+ *
+ *   2020
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_game_is_saving(lua_State *l)
+{
+	lua_pushboolean(l, Game::IsSaving());
+	return 1;
+}
+
 /*
  * Function: EndGame
  *
@@ -682,6 +777,8 @@ void LuaGame::Register()
 		{ "LoadGame", l_game_load_game },
 		{ "CanLoadGame", l_game_can_load_game },
 		{ "SaveGame", l_game_save_game },
+		{ "SaveGameAsync", l_game_save_game_async },
+		{ "IsSaving", l_game_is_saving },
 		{ "EndGame", l_game_end_game },
 		{ "InHyperspace", l_game_in_hyperspace },
 		{ "SetRadarVisible", l_game_set_radar_visible },
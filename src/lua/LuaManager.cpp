@@ -3,12 +3,38 @@
 
 #include "LuaManager.h"
 #include "FileSystem.h"
+#include "LuaProfiler.h"
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 
+namespace {
+	// Lua's own defaults, which the automatic collector goes back to
+	const int DEFAULT_GC_PAUSE = 200;
+	const int DEFAULT_GC_STEPMUL = 200;
+
+	const int MAX_GC_PAUSE = 400;
+	const int MAX_GC_STEPMUL = 1000;
+
+	// once memory has grown this much (in percent) since a cycle started, the
+	// cycle is falling behind and the steps stop keeping to the budget
+	const size_t CATCH_UP_GROWTH = 150;
+} // namespace
+
 bool instantiated = false;
 
 LuaManager::LuaManager() :
-	m_lua(0)
+	m_lua(0),
+	m_gcFramePaced(false),
+	m_gcBudgetMs(1.0),
+	m_gcInCycle(false),
+	m_gcThreshold(0),
+	m_gcLastMemory(0),
+	m_gcStartMemory(0),
+	m_gcPeakMemory(0),
+	m_gcCycleFrames(0),
+	m_gcOverBudgetFrames(0),
+	m_gcStats()
 {
 	if (instantiated) {
 		Output("Can't instantiate more than one LuaManager");
@@ -23,11 +49,14 @@ LuaManager::LuaManager() :
 	// in the codebase and thus available via the "immediate" window in the MSVC debugger for us in any C++ lua function
 	pi_lua_stacktrace(m_lua);
 
+	m_profiler.reset(new LuaProfiler(m_lua));
+
 	instantiated = true;
 }
 
 LuaManager::~LuaManager()
 {
+	m_profiler.reset();
 	lua_close(m_lua);
 
 	instantiated = false;
@@ -43,4 +72,124 @@ size_t LuaManager::GetMemoryUsage() const
 void LuaManager::CollectGarbage()
 {
 	lua_gc(m_lua, LUA_GCCOLLECT, 0);
+
+	if (m_gcFramePaced) {
+		m_gcInCycle = false;
+		const size_t memory = GetMemoryUsage();
+		m_gcThreshold = memory / 100 * m_gcStats.pause;
+		m_gcLastMemory = memory;
+	}
+}
+
+void LuaManager::SetFramePacedGC(bool enabled, double budgetMs)
+{
+	m_gcBudgetMs = budgetMs;
+	if (enabled == m_gcFramePaced)
+		return;
+
+	m_gcFramePaced = enabled;
+	m_gcStats = GCStats();
+	m_gcStats.pause = DEFAULT_GC_PAUSE;
+	m_gcStats.stepMul = DEFAULT_GC_STEPMUL;
+	lua_gc(m_lua, LUA_GCSETPAUSE, DEFAULT_GC_PAUSE);
+	lua_gc(m_lua, LUA_GCSETSTEPMUL, DEFAULT_GC_STEPMUL);
+
+	if (enabled) {
+		lua_gc(m_lua, LUA_GCSTOP, 0);
+		// finish whatever cycle the automatic collector was part way through
+		m_gcInCycle = true;
+		m_gcLastMemory = GetMemoryUsage();
+		m_gcStartMemory = m_gcLastMemory;
+		m_gcPeakMemory = m_gcLastMemory;
+		m_gcThreshold = m_gcLastMemory;
+		m_gcCycleFrames = 0;
+		m_gcOverBudgetFrames = 0;
+	} else {
+		lua_gc(m_lua, LUA_GCRESTART, 0);
+	}
+}
+
+void LuaManager::StepGarbageCollector()
+{
+	if (!m_gcFramePaced)
+		return;
+
+	PROFILE_SCOPED()
+	typedef std::chrono::steady_clock Clock;
+
+	const size_t before = GetMemoryUsage();
+	m_gcStats.allocatedBytes = before > m_gcLastMemory ? before - m_gcLastMemory : 0;
+	m_gcStats.stepMs = 0.0;
+	m_gcStats.freedBytes = 0;
+
+	if (!m_gcInCycle) {
+		if (before < m_gcThreshold) {
+			m_gcLastMemory = before;
+			return;
+		}
+		m_gcInCycle = true;
+		m_gcStartMemory = before;
+		m_gcPeakMemory = before;
+		m_gcCycleFrames = 0;
+		m_gcOverBudgetFrames = 0;
+	}
+
+	const Clock::time_point start = Clock::now();
+	const Clock::duration budget = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(m_gcBudgetMs));
+
+	// If the cycle has fallen well behind, do the work the automatic collector
+	// would have done for this frame's allocations, budget or not. The collector
+	// is stopped, so the step is only for what's passed in.
+	bool finished = false;
+	const bool overBudget = before / 100 > m_gcStartMemory / 100 * CATCH_UP_GROWTH;
+	if (overBudget)
+		finished = lua_gc(m_lua, LUA_GCSTEP, int(m_gcStats.allocatedBytes / 1024)) != 0;
+
+	// then single steps for as long as the budget lasts, and always at least one
+	if (!finished) {
+		do {
+			finished = lua_gc(m_lua, LUA_GCSTEP, 0) != 0;
+		} while (!finished && Clock::now() - start < budget);
+	}
+
+	const size_t after = GetMemoryUsage();
+	m_gcStats.stepMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	m_gcStats.freedBytes = before > after ? before - after : 0;
+	m_gcLastMemory = after;
+	m_gcPeakMemory = std::max(m_gcPeakMemory, before);
+	++m_gcCycleFrames;
+	if (overBudget)
+		++m_gcOverBudgetFrames;
+
+	if (finished)
+		EndGCCycle(after);
+}
+
+void LuaManager::EndGCCycle(size_t memory)
+{
+	m_gcInCycle = false;
+	++m_gcStats.cycles;
+
+	// Memory going well past the point the cycle started at means the cycle took
+	// too long for the allocation rate: do more work per byte allocated when
+	// catching up. If it
+	// barely grew, ease back towards the default.
+	if (m_gcStartMemory > 0) {
+		const double overshoot = double(m_gcPeakMemory) / double(m_gcStartMemory);
+		if (overshoot > 1.25)
+			m_gcStats.stepMul = std::min(m_gcStats.stepMul * 5 / 4, MAX_GC_STEPMUL);
+		else if (overshoot < 1.05)
+			m_gcStats.stepMul = std::max(m_gcStats.stepMul * 9 / 10, DEFAULT_GC_STEPMUL);
+	}
+
+	// If the cycle kept having to catch up, allocation is fast compared to the
+	// heap size, so let the heap grow further between cycles to spread the work
+	// out; once the budget is enough again, go back towards the default.
+	if (m_gcOverBudgetFrames * 2 > m_gcCycleFrames)
+		m_gcStats.pause = std::min(m_gcStats.pause + 25, MAX_GC_PAUSE);
+	else if (m_gcOverBudgetFrames == 0)
+		m_gcStats.pause = std::max(m_gcStats.pause - 25, DEFAULT_GC_PAUSE);
+
+	lua_gc(m_lua, LUA_GCSETSTEPMUL, m_gcStats.stepMul);
+	m_gcThreshold = memory / 100 * m_gcStats.pause;
 }
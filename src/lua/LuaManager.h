@@ -5,6 +5,9 @@
 #define _LUAMANAGER_H
 
 #include "LuaUtils.h"
+#include <memory>
+
+class LuaProfiler;
 
 class LuaManager {
 public:
@@ -15,11 +18,48 @@ public:
 	size_t GetMemoryUsage() const;
 	void CollectGarbage();
 
+	// In frame paced mode Lua's collector never runs by itself. Instead
+	// StepGarbageCollector(), called once a frame, collects until the time
+	// budget is spent, and only goes over it to catch up when memory has grown
+	// well past where the cycle started. Long stretches without frames, such as
+	// module init and loading a game, end with a CollectGarbage(). The pause and
+	// step multiplier are tuned after each cycle from how far memory overshot
+	// and how often the cycle had to catch up.
+	void SetFramePacedGC(bool enabled, double budgetMs = 1.0);
+	bool IsFramePacedGC() const { return m_gcFramePaced; }
+	void StepGarbageCollector();
+
+	struct GCStats {
+		double stepMs;		   // time spent in the last step
+		size_t freedBytes;	   // freed by the last step
+		size_t allocatedBytes; // allocated since the step before
+		int pause;
+		int stepMul;
+		Uint32 cycles; // completed since paced mode was enabled
+	};
+	const GCStats &GetGCStats() const { return m_gcStats; }
+
+	LuaProfiler *GetProfiler() { return m_profiler.get(); }
+
 private:
 	LuaManager(const LuaManager &);
 	LuaManager &operator=(const LuaManager &) = delete;
 
+	void EndGCCycle(size_t memory);
+
 	lua_State *m_lua;
+	std::unique_ptr<LuaProfiler> m_profiler;
+
+	bool m_gcFramePaced;
+	double m_gcBudgetMs;
+	bool m_gcInCycle;
+	size_t m_gcThreshold;		 // start the next cycle once memory is above this
+	size_t m_gcLastMemory;		 // after the previous step
+	size_t m_gcStartMemory;		 // when the current cycle started
+	size_t m_gcPeakMemory;		 // during the current cycle
+	Uint32 m_gcCycleFrames;		 // steps taken in the current cycle
+	Uint32 m_gcOverBudgetFrames; // of those, the ones that went over the budget
+	GCStats m_gcStats;
 };
 
 #endif
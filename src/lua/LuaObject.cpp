@@ -10,6 +10,8 @@
 #include "libs.h"
 
 #include <map>
+#include <typeindex>
+#include <unordered_map>
 #include <utility>
 
 /*
@@ -91,6 +93,16 @@
  */
 
 static std::map<std::string, std::map<std::string, PromotionTest>> promotions;
+
+// the type objects of each initial type and class end up as after promotion
+static std::map<std::pair<const char *, std::type_index>, const char *> promotedTypes;
+
+// results of IsaCached, by object type and base type
+static std::map<std::pair<const char *, const char *>, bool> isaResults;
+
+// registry refs of the wrappers of core objects. these are pushed far more
+// often than anything else, so they skip the lookup in LuaObjectRegistry
+static std::unordered_map<const LuaWrappable *, int> coreWrappers;
 static std::map<std::string, SerializerPair> serializers;
 
 class LuaObjectHelpers {
@@ -484,31 +496,69 @@ bool LuaObjectBase::PushRegistered(LuaWrappable *o)
 	return false;
 }
 
+bool LuaObjectBase::PushCached(LuaWrappable *o)
+{
+	lua_State *l = Lua::manager->GetLuaState();
+
+	if (!o) {
+		lua_pushnil(l);
+		return true;
+	}
+
+	auto cached = coreWrappers.find(o);
+	if (cached == coreWrappers.end())
+		return false;
+
+	lua_rawgeti(l, LUA_REGISTRYINDEX, cached->second);
+	return true;
+}
+
+void LuaObjectBase::Cache(LuaWrappable *o)
+{
+	lua_State *l = Lua::manager->GetLuaState();
+
+	assert(lua_isuserdata(l, -1));
+	assert(!coreWrappers.count(o));
+
+	lua_pushvalue(l, -1);
+	coreWrappers[o] = luaL_ref(l, LUA_REGISTRYINDEX);
+}
+
 void LuaObjectBase::Register(LuaObjectBase *lo)
 {
 	assert(lo->GetObject());
 
-	bool have_promotions = true;
-	bool tried_promote = false;
-
-	while (have_promotions && !tried_promote) {
-		std::map<std::string, std::map<std::string, PromotionTest>>::const_iterator base_iter = promotions.find(lo->m_type);
-		if (base_iter != promotions.end()) {
-			tried_promote = true;
-
-			for (
-				std::map<std::string, PromotionTest>::const_iterator target_iter = (*base_iter).second.begin();
-				target_iter != (*base_iter).second.end();
-				++target_iter) {
-				if ((*target_iter).second(lo->GetObject())) {
-					lo->m_type = (*target_iter).first.c_str();
-					tried_promote = false;
+	// promotion only depends on the class of the object, so it only needs
+	// working out for the first object of each class
+	const auto promotionKey = std::make_pair(lo->m_type, std::type_index(typeid(*lo->GetObject())));
+	auto promoted = promotedTypes.find(promotionKey);
+	if (promoted != promotedTypes.end()) {
+		lo->m_type = promoted->second;
+	} else {
+		bool have_promotions = true;
+		bool tried_promote = false;
+
+		while (have_promotions && !tried_promote) {
+			std::map<std::string, std::map<std::string, PromotionTest>>::const_iterator base_iter = promotions.find(lo->m_type);
+			if (base_iter != promotions.end()) {
+				tried_promote = true;
+
+				for (
+					std::map<std::string, PromotionTest>::const_iterator target_iter = (*base_iter).second.begin();
+					target_iter != (*base_iter).second.end();
+					++target_iter) {
+					if ((*target_iter).second(lo->GetObject())) {
+						lo->m_type = (*target_iter).first.c_str();
+						tried_promote = false;
+					}
 				}
-			}
 
-			assert(lo->Isa((*base_iter).first.c_str()));
-		} else
-			have_promotions = false;
+				assert(lo->Isa((*base_iter).first.c_str()));
+			} else
+				have_promotions = false;
+		}
+
+		promotedTypes.emplace(promotionKey, lo->m_type);
 	}
 
 	lua_State *l = Lua::manager->GetLuaState();
@@ -572,6 +622,12 @@ void LuaObjectBase::Deregister(LuaObjectBase *lo)
 
 	LUA_DEBUG_START(l);
 
+	auto cached = coreWrappers.find(o);
+	if (cached != coreWrappers.end()) {
+		luaL_unref(l, LUA_REGISTRYINDEX, cached->second);
+		coreWrappers.erase(cached);
+	}
+
 	lua_getfield(l, LUA_REGISTRYINDEX, "LuaObjectRegistry");
 	assert(lua_istable(l, -1));
 
@@ -599,7 +655,7 @@ LuaWrappable *LuaObjectBase::CheckFromLua(int index, const char *type)
 		return 0;
 	}
 
-	if (!lo->Isa(type))
+	if (!lo->IsaCached(type))
 		luaL_error(l, "Object on stack has type %s which can not be used as type %s\n", lo->m_type, type);
 
 	// found it
@@ -619,7 +675,7 @@ LuaWrappable *LuaObjectBase::GetFromLua(int index, const char *type)
 	if (!o)
 		return 0;
 
-	if (!lo->Isa(type))
+	if (!lo->IsaCached(type))
 		return 0;
 
 	// found it
@@ -662,9 +718,25 @@ bool LuaObjectBase::Isa(const char *base) const
 	return true;
 }
 
+bool LuaObjectBase::IsaCached(const char *base) const
+{
+	if (m_type == base)
+		return true;
+
+	const auto key = std::make_pair(m_type, base);
+	auto it = isaResults.find(key);
+	if (it != isaResults.end())
+		return it->second;
+
+	const bool result = Isa(base);
+	isaResults.emplace(key, result);
+	return result;
+}
+
 void LuaObjectBase::RegisterPromotion(const char *base_type, const char *target_type, PromotionTest test_fn)
 {
 	promotions[base_type][target_type] = test_fn;
+	promotedTypes.clear();
 }
 
 void LuaObjectBase::RegisterSerializer(const char *type, SerializerPair pair)
@@ -143,13 +143,23 @@ protected:
 	// pushed, false otherwise
 	static bool PushRegistered(LuaWrappable *o);
 
+	// the same for core (DeleteEmitter) objects, but looked up in a C++-side
+	// cache of their wrappers instead of the lua registry
+	static bool PushCached(LuaWrappable *o);
+
+	// adds a core object's wrapper to the cache. its userdata should be on
+	// the top of the stack. the cache keeps the wrapper alive until the
+	// object is deleted
+	static void Cache(LuaWrappable *o);
+
 	// adds an object->wrapper mapping to the registry for the given wrapper
 	// object. the wrapper's corresponding userdata should be on the top of
 	// the stack
 	static void Register(LuaObjectBase *lo);
 
-	// remove the object->wrapper from the registry. checks to make sure the
-	// the mapping matches first, to protect against memory being reused
+	// remove the object->wrapper from the registry and the cache. checks to
+	// make sure the the mapping matches first, to protect against memory being
+	// reused
 	static void Deregister(LuaObjectBase *lo);
 
 	// pulls an object off the lua stack and returns its associated c++
@@ -162,7 +172,8 @@ protected:
 
 	// register a promotion test. when an object with lua type base_type is
 	// pushed, test_fn will be called. if it returns true then the created lua
-	// object will be of target_type
+	// object will be of target_type. the result is remembered for each class
+	// of object, so test_fn must only depend on the object's class
 	static void RegisterPromotion(const char *base_type, const char *target_type, PromotionTest test_fn);
 
 	static void RegisterSerializer(const char *type, SerializerPair pair);
@@ -192,6 +203,10 @@ private:
 	// determine if the object has a class in its ancestry
 	bool Isa(const char *base) const;
 
+	// same, but the answer is remembered. base must never be freed, as
+	// LuaObject<T>::s_type never is
+	bool IsaCached(const char *base) const;
+
 	// lua type (ie method/metatable name)
 	const char *m_type;
 };
@@ -359,8 +374,10 @@ private:
 template <typename T>
 inline void LuaObject<T>::PushToLua(DeleteEmitter *o)
 {
-	if (!PushRegistered(o))
+	if (!PushCached(o)) {
 		Register(new (LuaObjectBase::Allocate(sizeof(LuaCoreObject<T>))) LuaCoreObject<T>(static_cast<T *>(o)));
+		Cache(o);
+	}
 }
 
 template <typename T>
@@ -4,6 +4,7 @@
 #include "Input.h"
 #include "LuaPiGuiInternal.h"
 
+#include "Camera.h"
 #include "EnumStrings.h"
 #include "Game.h"
 #include "LuaColor.h"
@@ -1730,11 +1731,9 @@ static int l_pigui_get_mouse_clicked_pos(lua_State *l)
 	return 1;
 }
 
-PiGui::TScreenSpace PiGui::lua_rel_space_to_screen_space(const vector3d &pos)
+// p is a point projected by one of WorldView's *ToScreenSpace functions
+static PiGui::TScreenSpace screen_space_from_projection(const vector3d &p)
 {
-	PROFILE_SCOPED()
-	const WorldView *wv = Pi::game->GetWorldView();
-	const vector3d p = wv->RelSpaceToScreenSpace(pos);
 	const int width = Graphics::GetScreenWidth();
 	const int height = Graphics::GetScreenHeight();
 	const vector3d direction = (p - vector3d(width / 2, height / 2, 0)).Normalized();
@@ -1745,19 +1744,20 @@ PiGui::TScreenSpace PiGui::lua_rel_space_to_screen_space(const vector3d &pos)
 	}
 }
 
+PiGui::TScreenSpace PiGui::lua_rel_space_to_screen_space(const vector3d &pos)
+{
+	PROFILE_SCOPED()
+	const WorldView *wv = Pi::game->GetWorldView();
+	const vector3d p = wv->RelSpaceToScreenSpace(pos);
+	return screen_space_from_projection(p);
+}
+
 PiGui::TScreenSpace PiGui::lua_world_space_to_screen_space(const vector3d &pos)
 {
 	PROFILE_SCOPED()
 	const WorldView *wv = Pi::game->GetWorldView();
 	const vector3d p = wv->WorldSpaceToScreenSpace(pos);
-	const int width = Graphics::GetScreenWidth();
-	const int height = Graphics::GetScreenHeight();
-	const vector3d direction = (p - vector3d(width / 2, height / 2, 0)).Normalized();
-	if (vector3d(0, 0, 0) == p || p.x < 0 || p.y < 0 || p.x > width || p.y > height || p.z > 0) {
-		return PiGui::TScreenSpace(false, vector2d(0, 0), direction * (p.z > 0 ? -1 : 1));
-	} else {
-		return PiGui::TScreenSpace(true, vector2d(p.x, p.y), direction);
-	}
+	return screen_space_from_projection(p);
 }
 
 PiGui::TScreenSpace lua_world_space_to_screen_space(const Body *body)
@@ -1765,14 +1765,7 @@ PiGui::TScreenSpace lua_world_space_to_screen_space(const Body *body)
 	PROFILE_SCOPED()
 	const WorldView *wv = Pi::game->GetWorldView();
 	const vector3d p = wv->WorldSpaceToScreenSpace(body);
-	const int width = Graphics::GetScreenWidth();
-	const int height = Graphics::GetScreenHeight();
-	const vector3d direction = (p - vector3d(width / 2, height / 2, 0)).Normalized();
-	if (vector3d(0, 0, 0) == p || p.x < 0 || p.y < 0 || p.x > width || p.y > height || p.z > 0) {
-		return PiGui::TScreenSpace(false, vector2d(0, 0), direction * (p.z > 0 ? -1 : 1));
-	} else {
-		return PiGui::TScreenSpace(true, vector2d(p.x, p.y), direction);
-	}
+	return screen_space_from_projection(p);
 }
 
 bool PiGui::first_body_is_more_important_than(Body *body, Body *other)
@@ -1858,6 +1851,98 @@ bool PiGui::first_body_is_more_important_than(Body *body, Body *other)
 	return result;
 }
 
+namespace {
+	struct ProjectedGroup {
+		Body *mainBody;
+		vector2d screenCoords; // screen coords of group
+		std::vector<Body *> bodies;
+		bool hasNavTarget;
+		bool hasSetSpeedTarget;
+
+		bool SameMembers(const ProjectedGroup &other) const
+		{
+			return mainBody == other.mainBody && bodies == other.bodies &&
+				hasNavTarget == other.hasNavTarget && hasSetSpeedTarget == other.hasSetSpeedTarget;
+		}
+	};
+
+	// Buckets groups by the screen-space cell their coordinates are in. The
+	// cells are at least cluster_size across, so any group within cluster_size
+	// of a point is in the point's cell or one of the eight around it.
+	class ClusterGrid {
+	public:
+		void Reset(double width, double height, double clusterSize)
+		{
+			for (Uint32 cell : m_usedCells)
+				m_cells[cell].clear();
+			m_usedCells.clear();
+
+			m_cellSize = std::max(clusterSize, std::max(width, height) / MAX_CELLS);
+			m_cols = Clamp(int(ceil(width / m_cellSize)), 1, MAX_CELLS);
+			m_rows = Clamp(int(ceil(height / m_cellSize)), 1, MAX_CELLS);
+			if (m_cells.size() < size_t(m_cols * m_rows))
+				m_cells.resize(m_cols * m_rows);
+		}
+
+		void Insert(Uint32 group, const vector2d &pos)
+		{
+			const Uint32 cell = CellIndex(Column(pos.x), Row(pos.y));
+			if (m_cells[cell].empty())
+				m_usedCells.push_back(cell);
+			m_cells[cell].push_back(group);
+		}
+
+		void Move(Uint32 group, const vector2d &from, const vector2d &to)
+		{
+			const Uint32 oldCell = CellIndex(Column(from.x), Row(from.y));
+			if (oldCell == CellIndex(Column(to.x), Row(to.y)))
+				return;
+			std::vector<Uint32> &groups = m_cells[oldCell];
+			groups.erase(std::find(groups.begin(), groups.end(), group));
+			Insert(group, to);
+		}
+
+		// the first group within radius of pos, or -1 if there isn't one
+		int Find(const vector2d &pos, double radius, const std::vector<ProjectedGroup> &groups) const
+		{
+			const int col = Column(pos.x), row = Row(pos.y);
+			int found = -1;
+			for (int y = std::max(row - 1, 0); y <= std::min(row + 1, m_rows - 1); y++) {
+				for (int x = std::max(col - 1, 0); x <= std::min(col + 1, m_cols - 1); x++) {
+					for (Uint32 group : m_cells[CellIndex(x, y)]) {
+						if ((found < 0 || group < Uint32(found)) && (groups[group].screenCoords - pos).Length() <= radius)
+							found = int(group);
+					}
+				}
+			}
+			return found;
+		}
+
+	private:
+		static const int MAX_CELLS = 256; // per side
+
+		int Column(double x) const { return Clamp(int(x / m_cellSize), 0, m_cols - 1); }
+		int Row(double y) const { return Clamp(int(y / m_cellSize), 0, m_rows - 1); }
+		Uint32 CellIndex(int col, int row) const { return row * m_cols + col; }
+
+		double m_cellSize = 1.0;
+		int m_cols = 0;
+		int m_rows = 0;
+		std::vector<std::vector<Uint32>> m_cells;
+		std::vector<Uint32> m_usedCells;
+	};
+
+	ClusterGrid s_clusterGrid;
+
+	// the groups returned last time, and the table they were returned in
+	struct {
+		std::vector<ProjectedGroup> groups;
+		lua_State *lua = nullptr;
+		int tableRef = LUA_NOREF;
+		Uint32 bodyRemovals = 0;
+	} s_lastGroups;
+} // namespace
+
 /*
  * Function: GetProjectedBodiesGrouped
  *
@@ -1875,7 +1960,9 @@ bool PiGui::first_body_is_more_important_than(Body *body, Body *other)
  *
  * Returns:
  *
- *   groups - array of info records describing each group
+ *   groups - array of info records describing each group. If the groups are
+ *            the same as last time, this is the same table as last time with
+ *            the screenCoordinates updated, so it shouldn't be modified.
  *
  * Fields in info record:
  *
@@ -1904,103 +1991,122 @@ static int l_pigui_get_projected_bodies_grouped(lua_State *l)
 	PiGui::TSS_vector filtered;
 	filtered.reserve(Pi::game->GetSpace()->GetNumBodies());
 
-	for (Body *body : Pi::game->GetSpace()->GetBodies()) {
-		if (body == Pi::game->GetPlayer()) continue;
-		if (body->GetType() == ObjectType::PROJECTILE) continue;
+	auto include_body = [ship_max_distance](Body *body) {
+		if (body == Pi::game->GetPlayer()) return false;
+		if (body->GetType() == ObjectType::PROJECTILE) return false;
 		if (body->GetType() == ObjectType::SHIP &&
-			body->GetPositionRelTo(Pi::player).Length() > ship_max_distance) continue;
-		const PiGui::TScreenSpace res = lua_world_space_to_screen_space(body); // defined in LuaPiGui.cpp
-		if (!res._onScreen) continue;
-		filtered.emplace_back(res);
-		filtered.back()._body = body;
-	}
+			body->GetPositionRelTo(Pi::player).Length() > ship_max_distance) return false;
+		return true;
+	};
 
-	struct GroupInfo {
-		Body *m_mainBody;
-		vector2d m_screenCoords; // screen coords of group
-		std::vector<Body *> m_bodies;
-		bool m_hasNavTarget;
-		bool m_hasSetSpeedTarget;
-
-		GroupInfo(Body *b, const vector2d &coords, bool isNavTarget,
-			bool isSetSpeedTarget) :
-			m_mainBody(b),
-			m_screenCoords(coords),
-			m_hasNavTarget(isNavTarget),
-			m_hasSetSpeedTarget(isSetSpeedTarget)
-		{
-			m_bodies.push_back(b);
+	const WorldView *wv = Pi::game->GetWorldView();
+	if (Pi::GetView() == wv) {
+		// the camera has already found the bodies in the frustum, and where they are relative to it
+		for (const Camera::BodyInView &view : wv->GetCamera()->GetBodiesInView()) {
+			if (!include_body(view.body)) continue;
+			const PiGui::TScreenSpace res = screen_space_from_projection(wv->CameraSpaceToScreenSpace(view.viewCoords));
+			if (!res._onScreen) continue;
+			filtered.emplace_back(res);
+			filtered.back()._body = view.body;
 		}
-	};
-	std::vector<GroupInfo> groups;
+	} else {
+		for (Body *body : Pi::game->GetSpace()->GetBodies()) {
+			if (!include_body(body)) continue;
+			const PiGui::TScreenSpace res = lua_world_space_to_screen_space(body); // defined in LuaPiGui.cpp
+			if (!res._onScreen) continue;
+			filtered.emplace_back(res);
+			filtered.back()._body = body;
+		}
+	}
+
+	std::vector<ProjectedGroup> groups;
 	groups.reserve(filtered.size());
 	const Body *nav_target = Pi::game->GetPlayer()->GetNavTarget();
 	const Body *combat_target = Pi::game->GetPlayer()->GetCombatTarget();
 	const Body *setspeed_target = Pi::game->GetPlayer()->GetSetSpeedTarget();
 
-	for (PiGui::TScreenSpace &obj : filtered) {
-		bool inserted = false;
+	s_clusterGrid.Reset(Graphics::GetScreenWidth(), Graphics::GetScreenHeight(), cluster_size);
 
+	for (PiGui::TScreenSpace &obj : filtered) {
 		// never collapse combat target
-		if (obj._body != combat_target) {
-			for (GroupInfo &group : groups) {
-				if ((group.m_screenCoords - obj._screenPosition).Length() <= cluster_size) {
-					// body inside group boundaries: insert into group
-					group.m_bodies.push_back(obj._body);
-
-					// make the more important body the new main body;
-					// but nav target is always most important
-					if (obj._body == nav_target) {
-						group.m_hasNavTarget = true;
-						group.m_mainBody = obj._body;
-						group.m_screenCoords = obj._screenPosition;
-					} else if (!group.m_hasNavTarget && PiGui::first_body_is_more_important_than(obj._body, group.m_mainBody)) {
-						group.m_mainBody = obj._body;
-						group.m_screenCoords = obj._screenPosition;
-					}
-					if (obj._body == setspeed_target)
-						group.m_hasSetSpeedTarget = true;
-					inserted = true;
-					break;
-				}
+		const int found = obj._body != combat_target ? s_clusterGrid.Find(obj._screenPosition, cluster_size, groups) : -1;
+
+		if (found >= 0) {
+			// body inside group boundaries: insert into group
+			ProjectedGroup &group = groups[found];
+			group.bodies.push_back(obj._body);
+
+			// make the more important body the new main body;
+			// but nav target is always most important
+			if (obj._body == nav_target || (!group.hasNavTarget && PiGui::first_body_is_more_important_than(obj._body, group.mainBody))) {
+				if (obj._body == nav_target)
+					group.hasNavTarget = true;
+				group.mainBody = obj._body;
+				s_clusterGrid.Move(found, group.screenCoords, obj._screenPosition);
+				group.screenCoords = obj._screenPosition;
 			}
-		}
-		if (!inserted) {
+			if (obj._body == setspeed_target)
+				group.hasSetSpeedTarget = true;
+		} else {
 			// create new group
-			GroupInfo newgroup(obj._body, obj._screenPosition,
-				obj._body == nav_target ? true : false,
-				obj._body == setspeed_target ? true : false);
-			groups.push_back(std::move(newgroup));
+			s_clusterGrid.Insert(groups.size(), obj._screenPosition);
+			groups.push_back({ obj._body, obj._screenPosition, { obj._body }, obj._body == nav_target, obj._body == setspeed_target });
 		}
 	}
 
 	// Sort each groups bodies according to importance
-	for (GroupInfo &group : groups) {
-		std::sort(begin(group.m_bodies), end(group.m_bodies),
+	for (ProjectedGroup &group : groups) {
+		std::sort(begin(group.bodies), end(group.bodies),
 			[](Body *a, Body *b) {
 				return PiGui::first_body_is_more_important_than(a, b);
 			});
 	}
 
+	// if nothing has changed but where the groups are, update last time's table
+	bool unchanged = s_lastGroups.lua == l && s_lastGroups.tableRef != LUA_NOREF &&
+		s_lastGroups.bodyRemovals == Space::GetBodyRemovalCount() &&
+		s_lastGroups.groups.size() == groups.size();
+	for (size_t i = 0; unchanged && i < groups.size(); i++)
+		unchanged = groups[i].SameMembers(s_lastGroups.groups[i]);
+
+	if (unchanged) {
+		lua_rawgeti(l, LUA_REGISTRYINDEX, s_lastGroups.tableRef);
+		for (size_t i = 0; i < groups.size(); i++) {
+			lua_rawgeti(l, -1, i + 1);
+			LuaTable(l, -1).Set("screenCoordinates", groups[i].screenCoords);
+			lua_pop(l, 1);
+		}
+		s_lastGroups.groups.swap(groups);
+		return 1;
+	}
+
 	LuaTable result(l, groups.size(), 0);
 	int index = 1;
 
-	for (GroupInfo &group : groups) {
+	for (ProjectedGroup &group : groups) {
 		LuaTable info_table(l, 0, 5);
-		LuaTable bodies_table(l, group.m_bodies.size(), 0);
+		LuaTable bodies_table(l, group.bodies.size(), 0);
 
-		info_table.Set("screenCoordinates", group.m_screenCoords);
-		info_table.Set("mainBody", group.m_mainBody);
-		bodies_table.LoadVector(group.m_bodies.begin(), group.m_bodies.end());
+		info_table.Set("screenCoordinates", group.screenCoords);
+		info_table.Set("mainBody", group.mainBody);
+		bodies_table.LoadVector(group.bodies.begin(), group.bodies.end());
 		info_table.Set("bodies", bodies_table);
 		lua_pop(l, 1);
-		info_table.Set("multiple", group.m_bodies.size() > 1 ? true : false);
-		info_table.Set("hasNavTarget", group.m_hasNavTarget);
-		info_table.Set("hasSetSpeedTarget", group.m_hasSetSpeedTarget);
+		info_table.Set("multiple", group.bodies.size() > 1 ? true : false);
+		info_table.Set("hasNavTarget", group.hasNavTarget);
+		info_table.Set("hasSetSpeedTarget", group.hasSetSpeedTarget);
 		result.Set(index++, info_table);
 		lua_pop(l, 1);
 	}
 	LuaPush(l, result);
+
+	if (s_lastGroups.lua == l)
+		luaL_unref(l, LUA_REGISTRYINDEX, s_lastGroups.tableRef);
+	lua_pushvalue(l, -1);
+	s_lastGroups.tableRef = luaL_ref(l, LUA_REGISTRYINDEX);
+	s_lastGroups.lua = l;
+	s_lastGroups.bodyRemovals = Space::GetBodyRemovalCount();
+	s_lastGroups.groups.swap(groups);
 	return 1;
 }
 
@@ -0,0 +1,306 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "LuaProfiler.h"
+#include "FileSystem.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+	// lua hooks are plain functions, and there's only ever one LuaManager
+	LuaProfiler *s_profiler = nullptr;
+
+	const Uint32 ROOT_FUNCTION = ~Uint32(0);
+
+	// the number of levels on the stack, found the way luaL_traceback does it
+	int StackDepth(lua_State *l)
+	{
+		lua_Debug ar;
+		int lo = 1, hi = 1;
+		while (lua_getstack(l, hi, &ar)) {
+			lo = hi;
+			hi *= 2;
+		}
+		while (lo < hi) {
+			const int mid = (lo + hi) / 2;
+			if (lua_getstack(l, mid, &ar))
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	double ToMs(std::chrono::steady_clock::duration d)
+	{
+		return std::chrono::duration<double, std::milli>(d).count();
+	}
+} // namespace
+
+LuaProfiler::LuaProfiler(lua_State *l) :
+	m_lua(l),
+	m_running(false),
+	m_mode(MODE_SAMPLE),
+	m_sampleInterval(1000)
+{
+	assert(!s_profiler);
+	s_profiler = this;
+	Reset();
+}
+
+LuaProfiler::~LuaProfiler()
+{
+	Stop();
+	s_profiler = nullptr;
+}
+
+void LuaProfiler::Start(Mode mode, int sampleInterval)
+{
+	if (m_running)
+		Stop();
+
+	m_mode = mode;
+	m_sampleInterval = std::max(sampleInterval, 1);
+	m_running = true;
+	m_stacks.clear();
+
+	if (mode == MODE_SAMPLE)
+		lua_sethook(m_lua, &LuaProfiler::Hook, LUA_MASKCOUNT, m_sampleInterval);
+	else
+		lua_sethook(m_lua, &LuaProfiler::Hook, LUA_MASKCALL | LUA_MASKRET, 0);
+}
+
+void LuaProfiler::Stop()
+{
+	if (!m_running)
+		return;
+
+	lua_sethook(m_lua, nullptr, 0, 0);
+	m_running = false;
+
+	// close whatever is still on the stack, so its time isn't lost
+	const Clock::time_point now = Clock::now();
+	for (auto &stack : m_stacks)
+		while (!stack.second.empty())
+			PopFrame(stack.second, now);
+	m_stacks.clear();
+}
+
+void LuaProfiler::Reset()
+{
+	m_functions.clear();
+	m_functionIndex.clear();
+	m_nodes.clear();
+	m_stacks.clear();
+	m_sampleCount = 0;
+
+	Node root;
+	root.function = ROOT_FUNCTION;
+	root.parent = 0;
+	m_nodes.push_back(root);
+}
+
+void LuaProfiler::Hook(lua_State *l, lua_Debug *ar)
+{
+	LuaProfiler *p = s_profiler;
+	if (!p || !p->m_running)
+		return;
+
+	switch (ar->event) {
+	case LUA_HOOKCOUNT:
+		p->Sample(l);
+		break;
+	case LUA_HOOKCALL:
+	case LUA_HOOKTAILCALL:
+		p->OnCall(l, ar, Clock::now());
+		break;
+	case LUA_HOOKRET:
+		p->OnReturn(l, Clock::now());
+		break;
+	default:
+		break;
+	}
+}
+
+Uint32 LuaProfiler::GetFunction(lua_State *l, lua_Debug *ar)
+{
+	lua_getinfo(l, "Sn", ar);
+
+	std::string name = ar->short_src;
+	name += ':';
+	name += std::to_string(ar->linedefined);
+	name += ':';
+	if (ar->name)
+		name += ar->name;
+	else if (ar->what && !strcmp(ar->what, "main"))
+		name += "main";
+	else
+		name += '?';
+
+	auto it = m_functionIndex.find(name);
+	if (it != m_functionIndex.end())
+		return it->second;
+
+	const Uint32 index = m_functions.size();
+	m_functions.emplace_back();
+	m_functions.back().name = name;
+	m_functionIndex.emplace(std::move(name), index);
+	return index;
+}
+
+Uint32 LuaProfiler::GetChild(Uint32 node, Uint32 function)
+{
+	auto it = m_nodes[node].children.find(function);
+	if (it != m_nodes[node].children.end())
+		return it->second;
+
+	const Uint32 child = m_nodes.size();
+	m_nodes[node].children.emplace(function, child);
+
+	Node n;
+	n.function = function;
+	n.parent = node;
+	m_nodes.push_back(std::move(n));
+	return child;
+}
+
+void LuaProfiler::Sample(lua_State *l)
+{
+	++m_sampleCount;
+
+	// innermost first
+	m_sampleStack.clear();
+	lua_Debug ar;
+	for (int level = 0; lua_getstack(l, level, &ar); level++)
+		m_sampleStack.push_back(GetFunction(l, &ar));
+	if (m_sampleStack.empty())
+		return;
+
+	Uint32 node = 0;
+	for (auto it = m_sampleStack.rbegin(); it != m_sampleStack.rend(); ++it) {
+		node = GetChild(node, *it);
+
+		Function &f = m_functions[*it];
+		if (f.lastSample != m_sampleCount) {
+			f.lastSample = m_sampleCount;
+			++f.totalSamples;
+		}
+	}
+
+	++m_nodes[node].samples;
+	++m_functions[m_sampleStack.front()].samples;
+}
+
+void LuaProfiler::OnCall(lua_State *l, lua_Debug *ar, Clock::time_point now)
+{
+	std::vector<Frame> &stack = m_stacks[l];
+
+	// a tail call's hook runs before it takes its caller's place on the stack
+	const int depth = StackDepth(l) - (ar->event == LUA_HOOKTAILCALL ? 1 : 0);
+
+	// anything at this depth or deeper has gone without returning: either it was
+	// replaced by a tail call, or an error unwound it
+	while (!stack.empty() && stack.back().depth >= depth)
+		PopFrame(stack, now);
+
+	const Uint32 function = GetFunction(l, ar);
+	const Uint32 parent = stack.empty() ? 0 : stack.back().node;
+
+	Function &f = m_functions[function];
+	++f.calls;
+	++f.active;
+
+	Frame frame;
+	frame.node = GetChild(parent, function);
+	frame.depth = depth;
+	frame.start = now;
+	frame.children = Clock::duration::zero();
+	stack.push_back(frame);
+}
+
+void LuaProfiler::OnReturn(lua_State *l, Clock::time_point now)
+{
+	std::vector<Frame> &stack = m_stacks[l];
+	if (stack.empty())
+		return; // called before the profiler started
+
+	const int depth = StackDepth(l);
+	while (!stack.empty() && stack.back().depth > depth)
+		PopFrame(stack, now);
+	if (!stack.empty() && stack.back().depth == depth)
+		PopFrame(stack, now);
+}
+
+void LuaProfiler::PopFrame(std::vector<Frame> &stack, Clock::time_point now)
+{
+	const Frame frame = stack.back();
+	stack.pop_back();
+
+	const Clock::duration elapsed = now - frame.start;
+	const Clock::duration self = elapsed - frame.children;
+
+	Node &node = m_nodes[frame.node];
+	node.self += self;
+
+	Function &f = m_functions[node.function];
+	f.self += self;
+	if (--f.active == 0)
+		f.total += elapsed;
+
+	if (!stack.empty())
+		stack.back().children += elapsed;
+}
+
+void LuaProfiler::GetFunctionStats(std::vector<FunctionStats> &stats) const
+{
+	stats.clear();
+	stats.reserve(m_functions.size());
+	for (const Function &f : m_functions) {
+		FunctionStats fs;
+		fs.name = f.name;
+		fs.samples = f.samples;
+		fs.totalSamples = f.totalSamples;
+		fs.calls = f.calls;
+		fs.selfMs = ToMs(f.self);
+		fs.totalMs = ToMs(f.total);
+		stats.push_back(fs);
+	}
+}
+
+void LuaProfiler::AppendStack(std::string &out, Uint32 node) const
+{
+	if (node == 0)
+		return;
+
+	const Node &n = m_nodes[node];
+	if (n.parent != 0) {
+		AppendStack(out, n.parent);
+		out += ';';
+	}
+	out += m_functions[n.function].name;
+}
+
+bool LuaProfiler::DumpFolded(const std::string &path) const
+{
+	FILE *f = FileSystem::userFiles.OpenWriteStream(path, FileSystem::FileSourceFS::WRITE_TEXT);
+	if (!f)
+		return false;
+
+	std::string line;
+	for (Uint32 i = 1; i < m_nodes.size(); i++) {
+		const Node &node = m_nodes[i];
+		const Uint64 weight = m_mode == MODE_SAMPLE ? node.samples :
+			std::chrono::duration_cast<std::chrono::microseconds>(node.self).count();
+		if (!weight)
+			continue;
+
+		line.clear();
+		AppendStack(line, i);
+		fprintf(f, "%s %llu\n", line.c_str(), static_cast<unsigned long long>(weight));
+	}
+
+	const bool ok = !ferror(f);
+	fclose(f);
+	return ok;
+}
@@ -0,0 +1,123 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _LUAPROFILER_H
+#define _LUAPROFILER_H
+
+#include "LuaUtils.h"
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Profiles the Lua code running in the LuaManager's state, using debug hooks.
+
+   There are two modes:
+
+   MODE_SAMPLE takes a sample of the Lua call stack every so many VM instructions.
+   It's cheap enough to leave running while playing, but it only counts samples,
+   so C functions (which execute no VM instructions) show up only through their
+   Lua callers.
+
+   MODE_CALLS hooks every call and return, and measures the exact number of calls
+   and the self and total time of each function. It slows Lua down considerably,
+   but the proportions are right.
+
+   Functions are identified as "source:line:name", where line is the line the
+   function is defined on. Coroutines created while the profiler is running are
+   profiled too; ones that already existed are not.
+*/
+class LuaProfiler {
+public:
+	enum Mode {
+		MODE_SAMPLE,
+		MODE_CALLS
+	};
+
+	struct FunctionStats {
+		std::string name;
+		Uint64 samples;		 // samples with this function at the top of the stack
+		Uint64 totalSamples; // samples with this function anywhere on the stack
+		Uint64 calls;
+		double selfMs;
+		double totalMs;
+	};
+
+	explicit LuaProfiler(lua_State *l);
+	~LuaProfiler();
+
+	// starting again keeps the results so far; sampleInterval is in VM instructions
+	void Start(Mode mode, int sampleInterval = 1000);
+	void Stop();
+	void Reset();
+
+	bool IsRunning() const { return m_running; }
+	Mode GetMode() const { return m_mode; }
+	int GetSampleInterval() const { return m_sampleInterval; }
+
+	void GetFunctionStats(std::vector<FunctionStats> &stats) const;
+
+	// Writes one line per distinct call stack, outermost function first, with
+	// the frames separated by ';' and followed by the number of samples (or, if
+	// the last mode was MODE_CALLS, the self time in microseconds). That's the
+	// "folded" format that flamegraph.pl and speedscope read. The path is in the
+	// user folder.
+	bool DumpFolded(const std::string &path) const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Function {
+		std::string name;
+		Uint64 samples = 0;
+		Uint64 totalSamples = 0;
+		Uint64 calls = 0;
+		Clock::duration self = Clock::duration::zero();
+		Clock::duration total = Clock::duration::zero();
+		int active = 0; // activations on the stack, so recursion isn't counted twice in total
+		Uint32 lastSample = 0;
+	};
+
+	// a node in the call tree, one per distinct stack
+	struct Node {
+		Uint32 function;
+		Uint32 parent;
+		Uint64 samples = 0;
+		Clock::duration self = Clock::duration::zero();
+		std::unordered_map<Uint32, Uint32> children;
+	};
+
+	// the shadow stack of a thread, for MODE_CALLS
+	struct Frame {
+		Uint32 node;
+		int depth;
+		Clock::time_point start;
+		Clock::duration children;
+	};
+
+	static void Hook(lua_State *l, lua_Debug *ar);
+
+	void Sample(lua_State *l);
+	void OnCall(lua_State *l, lua_Debug *ar, Clock::time_point now);
+	void OnReturn(lua_State *l, Clock::time_point now);
+	void PopFrame(std::vector<Frame> &stack, Clock::time_point now);
+
+	Uint32 GetFunction(lua_State *l, lua_Debug *ar);
+	Uint32 GetChild(Uint32 node, Uint32 function);
+	void AppendStack(std::string &out, Uint32 node) const;
+
+	lua_State *m_lua;
+	bool m_running;
+	Mode m_mode;
+	int m_sampleInterval;
+
+	std::vector<Function> m_functions;
+	std::unordered_map<std::string, Uint32> m_functionIndex;
+	std::vector<Node> m_nodes; // m_nodes[0] is the root, above the outermost function
+	std::unordered_map<lua_State *, std::vector<Frame>> m_stacks;
+
+	Uint32 m_sampleCount;
+	std::vector<Uint32> m_sampleStack;
+};
+
+#endif
@@ -63,6 +63,10 @@ public:
  *
  * > connection = object:Connect(property, function)
  *
+ * The function isn't called straight away, but after the end of the time step
+ * (or the frame, for changes made outside of it), and only once however many
+ * times the property was set in between. It gets the value at that point.
+ *
  * Note that some properties can be changed often, sometimes every frame or
  * more. Do not use this mechanism for those properties; it will cause things
  * to slow down significantly. Consider another facility (eg a UI bind) to do
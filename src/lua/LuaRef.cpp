@@ -6,6 +6,7 @@
 #include "Json.h"
 #include "Lua.h"
 #include "LuaSerializer.h"
+#include "base64/base64.hpp"
 #include <cassert>
 
 LuaRef::LuaRef(const LuaRef &ref) :
@@ -116,11 +117,13 @@ void LuaRef::SaveToJson(Json &jsonObj)
 		return;
 	}
 
-	Json out;
+	std::string pickled;
 	PushCopyToStack();
-	LuaSerializer::pickle_json(m_lua, -1, out);
+	LuaSerializer::pickle_bin(m_lua, -1, pickled);
 	lua_pop(m_lua, 1);
-	jsonObj["lua_ref_json"] = out;
+	std::string encoded;
+	Base64::Encode(pickled, &encoded);
+	jsonObj["lua_ref_bin"] = encoded;
 
 	LUA_DEBUG_END(m_lua, 0);
 }
@@ -142,7 +145,13 @@ void LuaRef::LoadFromJson(const Json &jsonObj)
 		return;
 	}
 
-	if (jsonObj.count("lua_ref_json")) {
+	if (jsonObj.count("lua_ref_bin")) {
+		const Json &value = jsonObj["lua_ref_bin"];
+		std::string pickled;
+		if (!value.is_string() || !Base64::Decode(value.get_ref<const std::string &>(), &pickled))
+			throw SavedGameCorruptException();
+		LuaSerializer::unpickle_bin(m_lua, pickled);
+	} else if (jsonObj.count("lua_ref_json")) {
 		LuaSerializer::unpickle_json(m_lua, jsonObj["lua_ref_json"]);
 	} else if (jsonObj.count("lua_ref")) {
 		std::string pickled = jsonObj["lua_ref"];
@@ -2,9 +2,13 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "LuaSerializer.h"
+#include "CborWriter.h"
 #include "GameSaveError.h"
 #include "JsonUtils.h"
 #include "LuaObject.h"
+#include "base64/base64.hpp"
+#include <cmath>
+#include <cstring>
 
 // every module can save one object. that will usually be a table.  we call
 // each serializer in turn and capture its return value we build a table like
@@ -28,8 +32,25 @@
 // down into tables. it can do userdata assuming the appropriate Lua wrapper
 // class has registered a serializer and deseriaizer
 //
-// pickle format is newline-seperated. each line begins with a type value,
-// followed by data for that type as follows
+// pickle format is binary. it starts with the format version byte, then one
+// pickled value. each value begins with a one byte tag, followed by data for
+// that tag as follows ("varint" is an unsigned LEB128 number):
+//   NIL, FALSE, TRUE - nothing more
+//   INTEGER    - number with an integral value, as a zigzag-encoded varint
+//   NUMBER     - any other number, as the 8 bytes of the double, little endian
+//   STRING     - varint length, then the bytes. strings are numbered from 0 in
+//                the order they first appear
+//   STRING_REF - varint number of a string that has already appeared
+//   TABLE      - varint table id, then key and value pairs, then END. table
+//                ids are shared by everything pickled in one save, so tables
+//                can be referred to across LuaRefs and the module data
+//   TABLE_REF  - varint id of a table that has already appeared
+//   OBJECT     - class name as a STRING or STRING_REF, then one pickled item
+//                (typically a TABLE)
+//   USERDATA   - varint length, then the output of LuaObjectBase::Serialize
+//
+// older saves used a newline-seperated text format and later a JSON tree.
+// those can still be read by unpickle and unpickle_json. the text format is:
 //   fNNN.nnn - number (float)
 //   bN       - boolean. N is 0 or 1 for true/false
 //   sNNN     - string. number is length, followed by newline, then string of bytes
@@ -51,145 +72,470 @@
 // "Deserialize" function under that namespace. that data returned will be
 // given back to the module
 
-void LuaSerializer::pickle(lua_State *l, int to_serialize, std::string &out, std::string key)
-{
-	PROFILE_SCOPED()
-	static char buf[256];
+namespace {
+	enum PickleTag {
+		PICKLE_NIL,
+		PICKLE_FALSE,
+		PICKLE_TRUE,
+		PICKLE_INTEGER,
+		PICKLE_NUMBER,
+		PICKLE_STRING,
+		PICKLE_STRING_REF,
+		PICKLE_TABLE,
+		PICKLE_TABLE_REF,
+		PICKLE_OBJECT,
+		PICKLE_USERDATA,
+		PICKLE_END
+	};
 
-	LUA_DEBUG_START(l);
+	static const Uint8 PICKLE_VERSION = 1;
+
+	// ids for tables pickled since the last InitTableRefs
+	static lua_Integer s_nextTableRef = 0;
+} // namespace
+
+class LuaSerializer::BinaryPickler {
+public:
+	BinaryPickler(lua_State *l, std::string &out) :
+		m_lua(l),
+		m_out(out),
+		m_nextString(0)
+	{
+		lua_newtable(m_lua);
+		m_strings = lua_gettop(m_lua);
+		lua_getfield(m_lua, LUA_REGISTRYINDEX, "PiSerializerTableRefs");
+		m_tableRefs = lua_gettop(m_lua);
+		if (!lua_istable(m_lua, m_tableRefs))
+			luaL_error(m_lua, "The Lua serializer hasn't been initialised");
+
+		m_out.push_back(char(PICKLE_VERSION));
+	}
 
-	// tables are pickled recursively, so we can run out of Lua stack space if we're not careful
-	// start by ensuring we have enough (this grows the stack if necessary)
-	// (20 is somewhat arbitrary)
-	if (!lua_checkstack(l, 20))
-		luaL_error(l, "The Lua stack couldn't be extended (out of memory?)");
+	~BinaryPickler()
+	{
+		lua_pop(m_lua, 2);
+	}
 
-	to_serialize = lua_absindex(l, to_serialize);
-	int idx = to_serialize;
+	void Pickle(int idx)
+	{
+		LUA_DEBUG_START(m_lua);
 
-	if (lua_getmetatable(l, idx)) {
-		lua_getfield(l, -1, "class");
-		if (lua_isnil(l, -1))
-			lua_pop(l, 2);
+		// tables are pickled recursively, so we can run out of Lua stack space if we're not careful
+		// start by ensuring we have enough (this grows the stack if necessary)
+		// (20 is somewhat arbitrary)
+		if (!lua_checkstack(m_lua, 20))
+			luaL_error(m_lua, "The Lua stack couldn't be extended (out of memory?)");
 
-		else {
-			const char *cl = lua_tostring(l, -1);
-			snprintf(buf, sizeof(buf), "o%s\n", cl);
+		idx = lua_absindex(m_lua, idx);
+		const int top = lua_gettop(m_lua);
+		int value = idx;
 
-			lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerClasses");
+		if (lua_getmetatable(m_lua, idx)) {
+			lua_getfield(m_lua, -1, "class");
+			if (lua_isnil(m_lua, -1))
+				lua_pop(m_lua, 2);
 
-			lua_getfield(l, -1, cl);
-			if (lua_isnil(l, -1))
-				luaL_error(l, "No Serialize method found for class '%s'\n", cl);
+			else {
+				const int cl = lua_gettop(m_lua);
 
-			lua_getfield(l, -1, "Serialize");
-			if (lua_isnil(l, -1))
-				luaL_error(l, "No Serialize method found for class '%s'\n", cl);
+				lua_getfield(m_lua, LUA_REGISTRYINDEX, "PiSerializerClasses");
 
-			lua_pushvalue(l, idx);
-			pi_lua_protected_call(l, 1, 1);
+				lua_pushvalue(m_lua, cl);
+				lua_gettable(m_lua, -2);
+				if (lua_isnil(m_lua, -1))
+					luaL_error(m_lua, "No Serialize method found for class '%s'\n", lua_tostring(m_lua, cl));
+
+				lua_getfield(m_lua, -1, "Serialize");
+				if (lua_isnil(m_lua, -1))
+					luaL_error(m_lua, "No Serialize method found for class '%s'\n", lua_tostring(m_lua, cl));
+
+				lua_pushvalue(m_lua, idx);
+				pi_lua_protected_call(m_lua, 1, 1);
 
-			idx = lua_gettop(l);
+				value = lua_gettop(m_lua);
 
-			if (lua_isnil(l, idx)) {
-				lua_pop(l, 5);
-				LUA_DEBUG_END(l, 0);
-				return;
+				if (lua_isnil(m_lua, value)) {
+					WriteTag(PICKLE_NIL);
+					lua_settop(m_lua, top);
+					LUA_DEBUG_END(m_lua, 0);
+					return;
+				}
+
+				WriteTag(PICKLE_OBJECT);
+				WriteString(cl);
 			}
+		}
 
-			out += buf;
+		switch (lua_type(m_lua, value)) {
+		case LUA_TNIL:
+			WriteTag(PICKLE_NIL);
+			break;
+
+		case LUA_TBOOLEAN:
+			WriteTag(lua_toboolean(m_lua, value) ? PICKLE_TRUE : PICKLE_FALSE);
+			break;
+
+		case LUA_TNUMBER:
+			WriteNumber(lua_tonumber(m_lua, value));
+			break;
+
+		case LUA_TSTRING:
+			WriteString(value);
+			break;
+
+		case LUA_TTABLE: {
+			// tables are identified by the original object, even if its class turned it into something else
+			lua_pushvalue(m_lua, idx);
+			lua_rawget(m_lua, m_tableRefs);
+			if (!lua_isnil(m_lua, -1)) {
+				WriteTag(PICKLE_TABLE_REF);
+				WriteVarint(lua_tointeger(m_lua, -1));
+				lua_pop(m_lua, 1);
+				break;
+			}
+			lua_pop(m_lua, 1);
+
+			const lua_Integer ref = s_nextTableRef++;
+			lua_pushvalue(m_lua, idx);
+			lua_pushinteger(m_lua, ref);
+			lua_rawset(m_lua, m_tableRefs);
+
+			WriteTag(PICKLE_TABLE);
+			WriteVarint(ref);
+
+			lua_pushnil(m_lua);
+			while (lua_next(m_lua, value)) {
+				m_keys.push_back(lua_absindex(m_lua, -2));
+				Pickle(-2);
+				Pickle(-1);
+				m_keys.pop_back();
+				lua_pop(m_lua, 1);
+			}
+
+			WriteTag(PICKLE_END);
+			break;
+		}
+
+		case LUA_TUSERDATA: {
+			LuaObjectBase *lo = static_cast<LuaObjectBase *>(lua_touserdata(m_lua, value));
+
+			// Check that there is still an object attached.
+			// There might not be; e.g., this could be a core object which has been deleted where Lua holds a weak reference.
+			void *o = lo->GetObject();
+			if (!o)
+				Error("Lua serializer '%s' tried to serialize an invalid '%s' object", KeyPath().c_str(), lo->GetType());
+
+			const std::string data = lo->Serialize();
+			WriteTag(PICKLE_USERDATA);
+			WriteVarint(data.size());
+			m_out += data;
+			break;
+		}
+
+		default:
+			Error("Lua serializer '%s' tried to serialize %s value", KeyPath().c_str(), lua_typename(m_lua, lua_type(m_lua, value)));
+			break;
 		}
+
+		lua_settop(m_lua, top);
+
+		LUA_DEBUG_END(m_lua, 0);
 	}
 
-	switch (lua_type(l, idx)) {
-	case LUA_TNIL:
-		break;
+private:
+	void WriteTag(PickleTag tag) { m_out.push_back(char(tag)); }
 
-	case LUA_TNUMBER: {
-		snprintf(buf, sizeof(buf), "f%g\n", lua_tonumber(l, idx));
-		out += buf;
-		break;
+	void WriteVarint(Uint64 v)
+	{
+		while (v >= 0x80) {
+			m_out.push_back(char((v & 0x7f) | 0x80));
+			v >>= 7;
+		}
+		m_out.push_back(char(v));
 	}
 
-	case LUA_TBOOLEAN: {
-		snprintf(buf, sizeof(buf), "b%d", lua_toboolean(l, idx) ? 1 : 0);
-		out += buf;
-		break;
+	void WriteNumber(double n)
+	{
+		// integral values (the common case: counts, money, ids) as zigzag varints,
+		// everything else as the exact bits of the double
+		if (n == floor(n) && fabs(n) < 9007199254740992.0 && !(n == 0.0 && std::signbit(n))) {
+			const Sint64 i = Sint64(n);
+			WriteTag(PICKLE_INTEGER);
+			WriteVarint((Uint64(i) << 1) ^ Uint64(i >> 63));
+		} else {
+			Uint64 bits;
+			memcpy(&bits, &n, sizeof(bits));
+			WriteTag(PICKLE_NUMBER);
+			for (int i = 0; i < 8; i++)
+				m_out.push_back(char((bits >> (i * 8)) & 0xff));
+		}
 	}
 
-	case LUA_TSTRING: {
+	void WriteString(int idx)
+	{
+		lua_pushvalue(m_lua, idx);
+		lua_rawget(m_lua, m_strings);
+		if (!lua_isnil(m_lua, -1)) {
+			WriteTag(PICKLE_STRING_REF);
+			WriteVarint(lua_tointeger(m_lua, -1));
+			lua_pop(m_lua, 1);
+			return;
+		}
+		lua_pop(m_lua, 1);
+
+		lua_pushvalue(m_lua, idx);
+		lua_pushinteger(m_lua, m_nextString++);
+		lua_rawset(m_lua, m_strings);
+
 		size_t len;
-		const char *str = lua_tolstring(l, idx, &len);
-		snprintf(buf, sizeof(buf), "s" SIZET_FMT "\n", len);
-		out += buf;
-		out.append(str, len);
-		break;
+		const char *str = lua_tolstring(m_lua, idx, &len);
+		WriteTag(PICKLE_STRING);
+		WriteVarint(len);
+		m_out.append(str, len);
 	}
 
-	case LUA_TTABLE: {
-		lua_pushinteger(l, lua_Integer(lua_topointer(l, to_serialize))); // ptr
+	// the path to the value being pickled, for error messages
+	std::string KeyPath() const
+	{
+		std::string path;
+		for (int key : m_keys) {
+			// tostring would change a number key in place, so work on a copy
+			lua_pushvalue(m_lua, key);
+			const char *k = lua_tostring(m_lua, -1);
+			path += "." + (k ? std::string(k) : "<" + std::string(lua_typename(m_lua, lua_type(m_lua, key))) + ">");
+			lua_pop(m_lua, 1);
+		}
+		return path;
+	}
 
-		lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs"); // ptr reftable
-		lua_pushvalue(l, -2); // ptr reftable ptr
-		lua_rawget(l, -2); // ptr reftable ???
+	lua_State *m_lua;
+	std::string &m_out;
+	int m_strings;
+	int m_tableRefs;
+	lua_Integer m_nextString;
+	std::vector<int> m_keys; // stack indices of the table keys leading to the current value
+};
+
+class LuaSerializer::BinaryUnpickler {
+public:
+	BinaryUnpickler(lua_State *l, const std::string &in) :
+		m_lua(l),
+		m_pos(in.data()),
+		m_end(in.data() + in.size()),
+		m_nextString(0)
+	{
+		if (ReadByte() != PICKLE_VERSION)
+			throw SavedGameCorruptException();
 
-		if (!lua_isnil(l, -1)) {
-			out += "r";
-			pickle(l, -3, out, key);
-			lua_pop(l, 3); // [empty]
-		}
+		lua_newtable(m_lua);
+		m_strings = lua_gettop(m_lua);
+		lua_getfield(m_lua, LUA_REGISTRYINDEX, "PiSerializerTableRefs");
+		m_tableRefs = lua_gettop(m_lua);
+		if (!lua_istable(m_lua, m_tableRefs))
+			luaL_error(m_lua, "The Lua serializer hasn't been initialised");
+	}
 
-		else {
-			out += "t";
+	// leaves the unpickled value on the stack
+	void Finish()
+	{
+		if (m_pos != m_end)
+			throw SavedGameCorruptException();
+		lua_remove(m_lua, m_tableRefs);
+		lua_remove(m_lua, m_strings);
+	}
 
-			lua_pushvalue(l, -3); // ptr reftable nil ptr
-			lua_pushvalue(l, to_serialize); // ptr reftable nil ptr table
-			lua_rawset(l, -4); // ptr reftable nil
-			pickle(l, -3, out, key);
-			lua_pop(l, 3); // [empty]
+	void Unpickle()
+	{
+		LUA_DEBUG_START(m_lua);
+
+		// tables are also unpickled recursively, so we can run out of Lua stack space if we're not careful
+		// start by ensuring we have enough (this grows the stack if necessary)
+		// (20 is somewhat arbitrary)
+		if (!lua_checkstack(m_lua, 20))
+			luaL_error(m_lua, "The Lua stack couldn't be extended (not enough memory?)");
+
+		switch (ReadByte()) {
+		case PICKLE_NIL:
+			lua_pushnil(m_lua);
+			break;
+
+		case PICKLE_FALSE:
+			lua_pushboolean(m_lua, 0);
+			break;
+
+		case PICKLE_TRUE:
+			lua_pushboolean(m_lua, 1);
+			break;
+
+		case PICKLE_INTEGER: {
+			const Uint64 v = ReadVarint();
+			lua_pushnumber(m_lua, double(Sint64(v >> 1) ^ -Sint64(v & 1)));
+			break;
+		}
 
-			lua_pushvalue(l, idx);
-			lua_pushnil(l);
-			while (lua_next(l, -2)) {
+		case PICKLE_NUMBER: {
+			if (m_end - m_pos < 8) throw SavedGameCorruptException();
+			Uint64 bits = 0;
+			for (int i = 0; i < 8; i++)
+				bits |= Uint64(Uint8(*m_pos++)) << (i * 8);
+			double n;
+			memcpy(&n, &bits, sizeof(n));
+			lua_pushnumber(m_lua, n);
+			break;
+		}
 
-				lua_pushvalue(l, -2);
-				const char *k = lua_tostring(l, -1);
-				std::string new_key = key + "." + (k ? std::string(k) : "<" + std::string(lua_typename(l, lua_type(l, -1))) + ">");
-				lua_pop(l, 1);
+		case PICKLE_STRING:
+		case PICKLE_STRING_REF:
+			--m_pos;
+			ReadString();
+			break;
+
+		case PICKLE_TABLE: {
+			const lua_Integer ref = ReadVarint();
+			lua_newtable(m_lua);
+
+			lua_pushinteger(m_lua, ref);
+			lua_pushvalue(m_lua, -2);
+			lua_rawset(m_lua, m_tableRefs);
+
+			while (PeekByte() != PICKLE_END) {
+				Unpickle();
+				Unpickle();
+				if (lua_isnil(m_lua, -2)) throw SavedGameCorruptException();
+				lua_rawset(m_lua, -3);
+			}
+			++m_pos;
+			break;
+		}
 
-				// Copy the values to pickle, as they might be mutated by the pickling process.
-				pickle(l, -2, out, new_key);
-				pickle(l, -1, out, new_key);
-				lua_pop(l, 1);
+		case PICKLE_TABLE_REF:
+			lua_pushinteger(m_lua, ReadVarint());
+			lua_rawget(m_lua, m_tableRefs);
+			if (lua_isnil(m_lua, -1))
+				throw SavedGameCorruptException();
+			break;
+
+		case PICKLE_OBJECT: {
+			ReadString(); // class name
+
+			// If it is a reference, don't run the unserializer. It has either
+			// already been run, or the data is still building (cyclic
+			// references will do that to you.)
+			const bool isRef = PeekByte() == PICKLE_TABLE_REF;
+			Unpickle(); // [cl] [value]
+
+			if (!isRef) {
+				// get PiSerializerClasses[typename]
+				lua_getfield(m_lua, LUA_REGISTRYINDEX, "PiSerializerClasses"); // [cl] [value] [classes]
+				lua_pushvalue(m_lua, -3);
+				lua_gettable(m_lua, -2);
+				lua_remove(m_lua, -2); // [cl] [value] [klass]
+
+				if (lua_isnil(m_lua, -1)) {
+					lua_pop(m_lua, 1);
+				} else {
+					lua_getfield(m_lua, -1, "Unserialize"); // [cl] [value] [klass] [klass.Unserialize]
+					if (lua_isnil(m_lua, -1))
+						luaL_error(m_lua, "No Unserialize method found for class '%s'\n", lua_tostring(m_lua, -4));
+
+					lua_insert(m_lua, -3); // [cl] [klass.Unserialize] [value] [klass]
+					lua_pop(m_lua, 1);
+
+					pi_lua_protected_call(m_lua, 1, 1); // [cl] [object]
+				}
 			}
-			lua_pop(l, 1);
-			out += "n";
+			lua_remove(m_lua, -2);
+			break;
 		}
 
-		break;
+		case PICKLE_USERDATA: {
+			const size_t len = ReadVarint();
+			if (size_t(m_end - m_pos) < len) throw SavedGameCorruptException();
+			// the deserializers expect a null terminated stream
+			const std::string data(m_pos, len);
+			m_pos += len;
+			const char *end;
+			if (!LuaObjectBase::Deserialize(data.c_str(), &end) || end > data.c_str() + data.size())
+				throw SavedGameCorruptException();
+			break;
+		}
+
+		default:
+			throw SavedGameCorruptException();
+		}
+
+		LUA_DEBUG_END(m_lua, 1);
 	}
 
-	case LUA_TUSERDATA: {
-		out += "u";
+private:
+	Uint8 PeekByte() const
+	{
+		if (m_pos >= m_end) throw SavedGameCorruptException();
+		return Uint8(*m_pos);
+	}
 
-		LuaObjectBase *lo = static_cast<LuaObjectBase *>(lua_touserdata(l, idx));
-		void *o = lo->GetObject();
-		if (!o)
-			Error("Lua serializer '%s' tried to serialize an invalid '%s' object", key.c_str(), lo->GetType());
+	Uint8 ReadByte()
+	{
+		const Uint8 b = PeekByte();
+		++m_pos;
+		return b;
+	}
 
-		out += lo->Serialize();
-		break;
+	Uint64 ReadVarint()
+	{
+		Uint64 v = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			const Uint8 b = ReadByte();
+			v |= Uint64(b & 0x7f) << shift;
+			if (!(b & 0x80))
+				return v;
+		}
+		throw SavedGameCorruptException();
 	}
 
-	default:
-		Error("Lua serializer '%s' tried to serialize %s value", key.c_str(), lua_typename(l, lua_type(l, idx)));
-		break;
+	// pushes a STRING or STRING_REF
+	void ReadString()
+	{
+		const Uint8 tag = ReadByte();
+		if (tag == PICKLE_STRING) {
+			const size_t len = ReadVarint();
+			if (size_t(m_end - m_pos) < len) throw SavedGameCorruptException();
+			lua_pushlstring(m_lua, m_pos, len);
+			m_pos += len;
+
+			lua_pushvalue(m_lua, -1);
+			lua_rawseti(m_lua, m_strings, m_nextString++);
+		} else if (tag == PICKLE_STRING_REF) {
+			const lua_Integer id = ReadVarint();
+			if (id >= m_nextString) throw SavedGameCorruptException();
+			lua_rawgeti(m_lua, m_strings, id);
+		} else {
+			throw SavedGameCorruptException();
+		}
 	}
 
-	if (idx != lua_absindex(l, to_serialize)) // It means we called a transformation function on the data, so we clean it up.
-		lua_pop(l, 5);
+	lua_State *m_lua;
+	const char *m_pos;
+	const char *m_end;
+	int m_strings;
+	int m_tableRefs;
+	lua_Integer m_nextString;
+};
 
-	LUA_DEBUG_END(l, 0);
+void LuaSerializer::pickle_bin(lua_State *l, int idx, std::string &out)
+{
+	PROFILE_SCOPED()
+	idx = lua_absindex(l, idx);
+	BinaryPickler pickler(l, out);
+	pickler.Pickle(idx);
+}
+
+void LuaSerializer::unpickle_bin(lua_State *l, const std::string &in)
+{
+	PROFILE_SCOPED()
+	BinaryUnpickler unpickler(l, in);
+	unpickler.Unpickle();
+	unpickler.Finish();
 }
 
 const char *LuaSerializer::unpickle(lua_State *l, const char *pos)
@@ -326,150 +672,6 @@ const char *LuaSerializer::unpickle(lua_State *l, const char *pos)
 	return pos;
 }
 
-void LuaSerializer::pickle_json(lua_State *l, int to_serialize, Json &out, const std::string &key)
-{
-	PROFILE_SCOPED()
-	LUA_DEBUG_START(l);
-
-	// tables are pickled recursively, so we can run out of Lua stack space if we're not careful
-	// start by ensuring we have enough (this grows the stack if necessary)
-	// (20 is somewhat arbitrary)
-	if (!lua_checkstack(l, 20))
-		luaL_error(l, "The Lua stack couldn't be extended (out of memory?)");
-
-	to_serialize = lua_absindex(l, to_serialize);
-	int idx = to_serialize;
-
-	if (lua_getmetatable(l, idx)) {
-		lua_getfield(l, -1, "class");
-		if (lua_isnil(l, -1))
-			lua_pop(l, 2);
-
-		else {
-			const char *cl = lua_tostring(l, -1);
-
-			out["lua_class"] = cl;
-
-			lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerClasses");
-
-			lua_getfield(l, -1, cl);
-			if (lua_isnil(l, -1))
-				luaL_error(l, "No Serialize method found for class '%s'\n", cl);
-
-			lua_getfield(l, -1, "Serialize");
-			if (lua_isnil(l, -1))
-				luaL_error(l, "No Serialize method found for class '%s'\n", cl);
-
-			lua_pushvalue(l, idx);
-			pi_lua_protected_call(l, 1, 1);
-
-			idx = lua_gettop(l);
-
-			if (lua_isnil(l, idx)) {
-				lua_pop(l, 5);
-				LUA_DEBUG_END(l, 0);
-				return;
-			}
-		}
-	}
-
-	switch (lua_type(l, idx)) {
-	case LUA_TNIL:
-		out = Json();
-		break;
-
-	case LUA_TBOOLEAN: {
-		out = Json(static_cast<bool>(lua_toboolean(l, idx)));
-		break;
-	}
-
-	case LUA_TSTRING: {
-		lua_pushvalue(l, idx);
-		size_t len;
-		const char *str = lua_tolstring(l, -1, &len);
-		out = Json(std::string(str, str + len));
-		lua_pop(l, 1);
-		break;
-	}
-
-	case LUA_TNUMBER: {
-		out = lua_tonumber(l, idx);
-		break;
-	}
-
-	case LUA_TTABLE: {
-		lua_Integer ptr = lua_Integer(lua_topointer(l, to_serialize));
-		lua_pushinteger(l, ptr); // ptr
-
-		lua_getfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs"); // ptr reftable
-		lua_pushvalue(l, -2); // ptr reftable ptr
-		lua_rawget(l, -2); // ptr reftable ???
-
-		out["ref"] = ptr;
-
-		if (!lua_isnil(l, -1)) {
-			lua_pop(l, 3); // [empty]
-		} else {
-			lua_pushvalue(l, -3); // ptr reftable nil ptr
-			lua_pushvalue(l, to_serialize); // ptr reftable nil ptr table
-			lua_rawset(l, -4); // ptr reftable nil
-			lua_pop(l, 3); // [empty]
-
-			Json inner = Json::array();
-
-			lua_pushvalue(l, idx);
-			lua_pushnil(l);
-			while (lua_next(l, -2)) {
-				lua_pushvalue(l, -2);
-				const char *k = lua_tostring(l, -1);
-				std::string new_key = key + "." + (k ? std::string(k) : "<" + std::string(lua_typename(l, lua_type(l, -1))) + ">");
-				lua_pop(l, 1);
-
-				// Copy the values to pickle, as they might be mutated by the pickling process.
-				Json out_k, out_v;
-
-				pickle_json(l, -2, out_k, new_key);
-				pickle_json(l, -1, out_v, new_key);
-
-				inner.push_back(out_k);
-				inner.push_back(out_v);
-
-				lua_pop(l, 1);
-			}
-			lua_pop(l, 1);
-
-			out["table"] = Json(inner);
-		}
-
-		break;
-	}
-
-	case LUA_TUSERDATA: {
-		LuaObjectBase *lo = static_cast<LuaObjectBase *>(lua_touserdata(l, idx));
-
-		// Check that there is still an object attached.
-		// There might not be; e.g., this could be a core object which has been deleted where Lua holds a weak reference.
-		void *o = lo->GetObject();
-		if (!o)
-			Error("Lua serializer '%s' tried to serialize an invalid '%s' object", key.c_str(), lo->GetType());
-
-		Json obj = Json::object();
-		lo->ToJson(obj);
-		out["userdata"] = obj;
-		break;
-	}
-
-	default:
-		Error("Lua serializer '%s' tried to serialize %s value", key.c_str(), lua_typename(l, lua_type(l, idx)));
-		break;
-	}
-
-	if (idx != lua_absindex(l, to_serialize)) // It means we called a transformation function on the data, so we clean it up.
-		lua_pop(l, 5);
-
-	LUA_DEBUG_END(l, 0);
-}
-
 void LuaSerializer::unpickle_json(lua_State *l, const Json &value)
 {
 	PROFILE_SCOPED()
@@ -600,6 +802,7 @@ void LuaSerializer::InitTableRefs()
 
 	lua_newtable(l);
 	lua_setfield(l, LUA_REGISTRYINDEX, "PiSerializerTableRefs");
+	s_nextTableRef = 0;
 
 	lua_newtable(l);
 	lua_setfield(l, LUA_REGISTRYINDEX, "PiLuaRefLoadTable");
@@ -619,7 +822,7 @@ void LuaSerializer::UninitTableRefs()
 	lua_setfield(l, LUA_REGISTRYINDEX, "PiLuaRefLoadTable");
 }
 
-void LuaSerializer::ToJson(Json &jsonObj)
+void LuaSerializer::ToCbor(CborWriter &writer)
 {
 	PROFILE_SCOPED()
 	lua_State *l = Lua::manager->GetLuaState();
@@ -650,9 +853,13 @@ void LuaSerializer::ToJson(Json &jsonObj)
 
 	lua_pop(l, 1);
 
-	Json pickled;
-	pickle_json(l, savetable, pickled);
-	jsonObj["lua_modules_json"] = pickled;
+	// base64, as savegamedump and the JSON save format need valid UTF-8
+	std::string pickled;
+	pickle_bin(l, savetable, pickled);
+	std::string encoded;
+	Base64::Encode(pickled, &encoded);
+	writer.Key("lua_modules_bin");
+	writer.String(encoded);
 
 	lua_pop(l, 1);
 
@@ -666,7 +873,14 @@ void LuaSerializer::FromJson(const Json &jsonObj)
 
 	LUA_DEBUG_START(l);
 
-	if (jsonObj.count("lua_modules_json")) {
+	if (jsonObj.count("lua_modules_bin")) {
+		const Json &value = jsonObj["lua_modules_bin"];
+		std::string pickled;
+		if (!value.is_string() || !Base64::Decode(value.get_ref<const std::string &>(), &pickled)) {
+			throw SavedGameCorruptException();
+		}
+		unpickle_bin(l, pickled);
+	} else if (jsonObj.count("lua_modules_json")) {
 		const Json &value = jsonObj["lua_modules_json"];
 		if (!value.is_object()) {
 			throw SavedGameCorruptException();
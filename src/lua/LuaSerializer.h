@@ -9,13 +9,16 @@
 #include "LuaObject.h"
 #include "LuaRef.h"
 
+class CborWriter;
+
 class LuaSerializer : public DeleteEmitter {
 	friend class LuaObject<LuaSerializer>;
 	friend void LuaRef::SaveToJson(Json &jsonObj);
 	friend void LuaRef::LoadFromJson(const Json &jsonObj);
 
 public:
-	void ToJson(Json &jsonObj);
+	// writes the pickled module data as the "lua_modules_bin" member of the saved game object
+	void ToCbor(CborWriter &writer);
 	void FromJson(const Json &jsonObj);
 
 	void InitTableRefs();
@@ -25,10 +28,14 @@ private:
 	static int l_register(lua_State *l);
 	static int l_register_class(lua_State *l);
 
-	static void pickle(lua_State *l, int idx, std::string &out, std::string key = "");
-	static const char *unpickle(lua_State *l, const char *pos);
+	class BinaryPickler;
+	class BinaryUnpickler;
 
-	static void pickle_json(lua_State *l, int idx, Json &out, const std::string &key = "");
+	static void pickle_bin(lua_State *l, int idx, std::string &out);
+	static void unpickle_bin(lua_State *l, const std::string &in);
+
+	// decoders for the formats used by older saves
+	static const char *unpickle(lua_State *l, const char *pos);
 	static void unpickle_json(lua_State *l, const Json &value);
 };
 
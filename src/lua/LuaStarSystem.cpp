@@ -20,6 +20,7 @@
 #include "galaxy/GalaxyCache.h"
 #include "galaxy/Sector.h"
 #include "galaxy/StarSystem.h"
+#include "galaxy/SystemQuery.h"
 #include "src/lua.h"
 
 /*
@@ -200,6 +201,49 @@ static int l_starsystem_is_commodity_legal(lua_State *l)
 	return 1;
 }
 
+// fill a SystemQuery from an optional table of criteria at the given stack index
+static void pull_system_query_criteria(lua_State *l, int index, SystemQuery &query, Galaxy *galaxy)
+{
+	if (lua_isnoneornil(l, index))
+		return;
+
+	LuaTable criteria(l, index);
+
+	criteria.PushValueToStack("explored");
+	if (!lua_isnil(l, -1))
+		query.SetExplored(lua_toboolean(l, -1) ? SystemQuery::EXPLORED_ONLY : SystemQuery::UNEXPLORED_ONLY);
+	lua_pop(l, 1);
+
+	criteria.PushValueToStack("faction");
+	if (lua_isstring(l, -1)) {
+		const Faction *faction = galaxy->GetFactions()->GetFaction(lua_tostring(l, -1));
+		if (!faction->IsValid())
+			luaL_error(l, "Unknown faction '%s'", lua_tostring(l, -1));
+		query.AddFaction(faction);
+	} else if (!lua_isnil(l, -1)) {
+		query.AddFaction(LuaObject<Faction>::CheckFromLua(-1));
+	}
+	lua_pop(l, 1);
+
+	const double minPop = criteria.Get<double>("minPopulation", -1.0);
+	const double maxPop = criteria.Get<double>("maxPopulation", -1.0);
+	if (minPop >= 0.0 || maxPop >= 0.0)
+		query.SetPopulation(fixed::FromDouble(std::max(minPop, 0.0)), maxPop >= 0.0 ? fixed::FromDouble(maxPop) : fixed(std::numeric_limits<Sint64>::max()));
+
+	const std::string economy = criteria.Get<std::string>("economy", "");
+	if (!economy.empty()) {
+		const GalacticEconomy::EconomyId econId = GalacticEconomy::GetEconomyByName(economy);
+		if (econId == GalacticEconomy::InvalidEconomyId)
+			luaL_error(l, "Unknown economy type '%s'", economy.c_str());
+		query.SetEconomy(econId);
+	}
+
+	criteria.PushValueToStack("hasStations");
+	if (!lua_isnil(l, -1))
+		query.SetStations(lua_toboolean(l, -1) ? SystemQuery::STATIONS_ONLY : SystemQuery::NO_STATIONS);
+	lua_pop(l, 1);
+}
+
 /*
  * Method: GetNearbySystems
  *
@@ -244,48 +288,155 @@ static int l_starsystem_get_nearby_systems(lua_State *l)
 		filter = true;
 	}
 
+	SystemQuery query(s->GetPath(), dist_ly);
+	std::vector<RefCountedPtr<StarSystem>> systems;
+	query.FindSystems(s->m_galaxy.Get(), systems);
+
 	lua_newtable(l);
 
-	const SystemPath &here = s->GetPath();
-
-	const int here_x = here.sectorX;
-	const int here_y = here.sectorY;
-	const int here_z = here.sectorZ;
-	const Uint32 here_idx = here.systemIndex;
-	RefCountedPtr<const Sector> here_sec = s->m_galaxy->GetSector(here);
-
-	const int diff_sec = int(ceil(dist_ly / Sector::SIZE));
-
-	for (int x = here_x - diff_sec; x <= here_x + diff_sec; x++) {
-		for (int y = here_y - diff_sec; y <= here_y + diff_sec; y++) {
-			for (int z = here_z - diff_sec; z <= here_z + diff_sec; z++) {
-				RefCountedPtr<const Sector> sec = s->m_galaxy->GetSector(SystemPath(x, y, z));
-
-				for (unsigned int idx = 0; idx < sec->m_systems.size(); idx++) {
-					if (x == here_x && y == here_y && z == here_z && idx == here_idx)
-						continue;
-
-					if (Sector::DistanceBetween(here_sec, here_idx, sec, idx) > dist_ly)
-						continue;
-
-					RefCountedPtr<StarSystem> sys = s->m_galaxy->GetStarSystem(SystemPath(x, y, z, idx));
-					if (filter) {
-						lua_pushvalue(l, 3);
-						LuaObject<StarSystem>::PushToLua(sys.Get());
-						lua_call(l, 1, 1);
-						if (!lua_toboolean(l, -1)) {
-							lua_pop(l, 1);
-							continue;
-						}
-						lua_pop(l, 1);
-					}
-
-					lua_pushinteger(l, lua_rawlen(l, -1) + 1);
-					LuaObject<StarSystem>::PushToLua(sys.Get());
-					lua_rawset(l, -3);
-				}
+	for (RefCountedPtr<StarSystem> &sys : systems) {
+		if (filter) {
+			lua_pushvalue(l, 3);
+			LuaObject<StarSystem>::PushToLua(sys.Get());
+			lua_call(l, 1, 1);
+			if (!lua_toboolean(l, -1)) {
+				lua_pop(l, 1);
+				continue;
 			}
+			lua_pop(l, 1);
 		}
+
+		lua_pushinteger(l, lua_rawlen(l, -1) + 1);
+		LuaObject<StarSystem>::PushToLua(sys.Get());
+		lua_rawset(l, -3);
+	}
+
+	LUA_DEBUG_END(l, 1);
+
+	return 1;
+}
+
+/*
+ * Method: FindNearbySystems
+ *
+ * Get a list of nearby <StarSystems> that match a set of criteria
+ *
+ * > systems = system:FindNearbySystems(range, criteria)
+ *
+ * Unlike the filter function of <GetNearbySystems>, the criteria are checked
+ * in C++, as far as possible from sector data alone, and only the systems
+ * that pass them are generated.
+ *
+ * Parameters:
+ *
+ *   range - distance from this system to search, in light years
+ *
+ *   criteria - an optional table with any of the following fields:
+ *
+ *     explored - true for explored systems only, false for unexplored only
+ *
+ *     faction - a <Faction> or faction name the system must belong to
+ *
+ *     minPopulation, maxPopulation - population bounds, in billions
+ *
+ *     economy - economy type name the system must have, as returned by
+ *               Economy.GetEconomies()
+ *
+ *     hasStations - true for systems with stations only, false for systems
+ *                   without any
+ *
+ * Return:
+ *
+ *  systems - an array of systems in range that matched the criteria, in the
+ *            same order as <GetNearbySystems> would return them
+ *
+ * Example:
+ *
+ * > local systems = Game.system:FindNearbySystems(20, { hasStations = true })
+ *
+ * Availability:
+ *
+ *   2020
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_starsystem_find_nearby_systems(lua_State *l)
+{
+	PROFILE_SCOPED()
+	LUA_DEBUG_START(l);
+
+	const StarSystem *s = LuaObject<StarSystem>::CheckFromLua(1);
+	const double dist_ly = luaL_checknumber(l, 2);
+
+	SystemQuery query(s->GetPath(), dist_ly);
+	pull_system_query_criteria(l, 3, query, s->m_galaxy.Get());
+
+	std::vector<RefCountedPtr<StarSystem>> systems;
+	query.FindSystems(s->m_galaxy.Get(), systems);
+
+	lua_createtable(l, systems.size(), 0);
+	for (size_t i = 0; i < systems.size(); i++) {
+		lua_pushinteger(l, i + 1);
+		LuaObject<StarSystem>::PushToLua(systems[i].Get());
+		lua_rawset(l, -3);
+	}
+
+	LUA_DEBUG_END(l, 1);
+
+	return 1;
+}
+
+/*
+ * Method: GetNearbySystemPaths
+ *
+ * Get a list of the <SystemPaths> of nearby systems that match a set of
+ * criteria
+ *
+ * > paths = system:GetNearbySystemPaths(range, criteria)
+ *
+ * Works like <FindNearbySystems>, but returns paths, so that systems only
+ * have to be generated if one of the criteria needs them. Without criteria
+ * (or with only explored and faction) no system is generated at all.
+ *
+ * Parameters:
+ *
+ *   range - distance from this system to search, in light years
+ *
+ *   criteria - an optional table, see <FindNearbySystems>
+ *
+ * Return:
+ *
+ *  paths - an array of <SystemPath> objects, one for each system that matched
+ *
+ * Availability:
+ *
+ *   2020
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_starsystem_get_nearby_system_paths(lua_State *l)
+{
+	PROFILE_SCOPED()
+	LUA_DEBUG_START(l);
+
+	const StarSystem *s = LuaObject<StarSystem>::CheckFromLua(1);
+	const double dist_ly = luaL_checknumber(l, 2);
+
+	SystemQuery query(s->GetPath(), dist_ly);
+	pull_system_query_criteria(l, 3, query, s->m_galaxy.Get());
+
+	std::vector<SystemPath> paths;
+	query.FindPaths(s->m_galaxy.Get(), paths);
+
+	lua_createtable(l, paths.size(), 0);
+	for (size_t i = 0; i < paths.size(); i++) {
+		lua_pushinteger(l, i + 1);
+		LuaObject<SystemPath>::PushToLua(paths[i]);
+		lua_rawset(l, -3);
 	}
 
 	LUA_DEBUG_END(l, 1);
@@ -697,6 +848,8 @@ void LuaObject<StarSystem>::RegisterClass()
 		{ "IsCommodityLegal", l_starsystem_is_commodity_legal },
 
 		{ "GetNearbySystems", l_starsystem_get_nearby_systems },
+		{ "GetNearbySystemPaths", l_starsystem_get_nearby_system_paths },
+		{ "FindNearbySystems", l_starsystem_find_nearby_systems },
 
 		{ "DistanceTo", l_starsystem_distance_to },
 
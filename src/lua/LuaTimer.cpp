@@ -7,64 +7,80 @@
 #include "LuaObject.h"
 #include "LuaUtils.h"
 #include "Pi.h"
+#include <algorithm>
+
+LuaTimer::LuaTimer() :
+	m_nextSeq(0)
+{
+}
+
+LuaTimer::~LuaTimer()
+{
+	RemoveAll();
+}
 
 void LuaTimer::RemoveAll()
 {
+	if (m_timers.empty())
+		return;
+
 	lua_State *l = Lua::manager->GetLuaState();
+	for (const Timer &timer : m_timers)
+		luaL_unref(l, LUA_REGISTRYINDEX, timer.callback);
+	m_timers.clear();
+}
 
-	lua_pushnil(l);
-	lua_setfield(l, LUA_REGISTRYINDEX, "PiTimerCallbacks");
+void LuaTimer::Schedule(double at, double every, int callback)
+{
+	Timer timer;
+	timer.at = at;
+	timer.every = every;
+	timer.callback = callback;
+	Push(timer);
+}
+
+void LuaTimer::Push(Timer timer)
+{
+	timer.seq = m_nextSeq++;
+	m_timers.push_back(timer);
+	std::push_heap(m_timers.begin(), m_timers.end(), DueLater());
 }
 
 void LuaTimer::Tick()
 {
 	assert(Pi::game);
-	lua_State *l = Lua::manager->GetLuaState();
 
-	LUA_DEBUG_START(l);
-
-	lua_getfield(l, LUA_REGISTRYINDEX, "PiTimerCallbacks");
-	if (lua_isnil(l, -1)) {
-		lua_pop(l, 1);
-		LUA_DEBUG_END(l, 0);
+	const double now = Pi::game->GetTime();
+	if (m_timers.empty() || m_timers.front().at > now)
 		return;
-	}
-	assert(lua_istable(l, -1));
 
-	double now = Pi::game->GetTime();
+	PROFILE_SCOPED()
+	lua_State *l = Lua::manager->GetLuaState();
 
-	lua_pushnil(l);
-	while (lua_next(l, -2)) {
-		assert(lua_istable(l, -1));
+	LUA_DEBUG_START(l);
 
-		lua_getfield(l, -1, "at");
-		double at = lua_tonumber(l, -1);
+	// A repeating timer due well in the past, or a new one set for the past, can
+	// be pushed already due. Those wait for the next tick, so this ends. They
+	// stop the loop rather than being skipped, which keeps the timers in due
+	// order.
+	const Uint64 firstNewSeq = m_nextSeq;
+	while (!m_timers.empty() && m_timers.front().at <= now && m_timers.front().seq < firstNewSeq) {
+		std::pop_heap(m_timers.begin(), m_timers.end(), DueLater());
+		Timer timer = m_timers.back();
+		m_timers.pop_back();
+
+		lua_rawgeti(l, LUA_REGISTRYINDEX, timer.callback);
+		pi_lua_protected_call(l, 0, 1);
+		bool cancel = lua_toboolean(l, -1);
 		lua_pop(l, 1);
 
-		if (at <= now) {
-			lua_getfield(l, -1, "callback");
-			pi_lua_protected_call(l, 0, 1);
-			bool cancel = lua_toboolean(l, -1);
-			lua_pop(l, 1);
-
-			lua_getfield(l, -1, "every");
-			if (lua_isnil(l, -1) || cancel) {
-				lua_pop(l, 1);
-
-				lua_pushvalue(l, -2);
-				lua_pushnil(l);
-				lua_settable(l, -5);
-			} else {
-				double every = lua_tonumber(l, -1);
-				lua_pop(l, 1);
-
-				pi_lua_settable(l, "at", Pi::game->GetTime() + every);
-			}
+		if (timer.every <= 0 || cancel) {
+			luaL_unref(l, LUA_REGISTRYINDEX, timer.callback);
+		} else {
+			timer.at = Pi::game->GetTime() + timer.every;
+			Push(timer);
 		}
-
-		lua_pop(l, 1);
 	}
-	lua_pop(l, 1);
 
 	LUA_DEBUG_END(l, 0);
 }
@@ -105,28 +121,6 @@ void LuaTimer::Tick()
  * underlying object exists before trying to use it.
  */
 
-static void _finish_timer_create(lua_State *l)
-{
-	lua_pushstring(l, "callback");
-	lua_pushvalue(l, 3);
-	lua_settable(l, -3);
-
-	lua_getfield(l, LUA_REGISTRYINDEX, "PiTimerCallbacks");
-	if (lua_isnil(l, -1)) {
-		lua_pop(l, 1);
-		lua_newtable(l);
-		lua_pushvalue(l, -1);
-		lua_setfield(l, LUA_REGISTRYINDEX, "PiTimerCallbacks");
-	}
-
-	lua_insert(l, -2);
-	lua_pushinteger(l, lua_rawlen(l, -2) + 1);
-	lua_insert(l, -2);
-	lua_settable(l, -3);
-
-	lua_pop(l, 1);
-}
-
 /*
  * Method: CallAt
  *
@@ -173,10 +167,8 @@ static int l_timer_call_at(lua_State *l)
 
 	LUA_DEBUG_START(l);
 
-	lua_newtable(l);
-	pi_lua_settable(l, "at", at);
-
-	_finish_timer_create(l);
+	lua_pushvalue(l, 3);
+	Pi::luaTimer->Schedule(at, 0.0, luaL_ref(l, LUA_REGISTRYINDEX));
 
 	LUA_DEBUG_END(l, 0);
 
@@ -238,11 +230,8 @@ static int l_timer_call_every(lua_State *l)
 
 	LUA_DEBUG_START(l);
 
-	lua_newtable(l);
-	pi_lua_settable(l, "every", every);
-	pi_lua_settable(l, "at", Pi::game->GetTime() + every);
-
-	_finish_timer_create(l);
+	lua_pushvalue(l, 3);
+	Pi::luaTimer->Schedule(Pi::game->GetTime() + every, every, luaL_ref(l, LUA_REGISTRYINDEX));
 
 	LUA_DEBUG_END(l, 0);
 
@@ -6,11 +6,43 @@
 
 #include "DeleteEmitter.h"
 #include "LuaManager.h"
+#include <vector>
 
+// Pending timers are kept in a min-heap on their due time, so a Tick() with
+// nothing due doesn't touch Lua at all. Callbacks are held as registry refs.
 class LuaTimer : public DeleteEmitter {
 public:
+	LuaTimer();
+	~LuaTimer();
+
 	void Tick();
 	void RemoveAll();
+
+	// takes ownership of the registry ref; every <= 0 means call only once
+	void Schedule(double at, double every, int callback);
+
+	size_t GetNumTimers() const { return m_timers.size(); }
+
+private:
+	struct Timer {
+		double at;
+		double every;
+		int callback;
+		Uint64 seq; // so that timers due at the same time fire in the order they were set
+	};
+
+	// heap order: the timer due first at the front
+	struct DueLater {
+		bool operator()(const Timer &a, const Timer &b) const
+		{
+			return a.at > b.at || (a.at == b.at && a.seq > b.seq);
+		}
+	};
+
+	void Push(Timer timer);
+
+	std::vector<Timer> m_timers;
+	Uint64 m_nextSeq;
 };
 
 #endif
@@ -4,8 +4,47 @@
 #include "PropertyMap.h"
 #include "LuaSerializer.h"
 #include "LuaUtils.h"
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
 
-PropertyMap::PropertyMap(LuaManager *lua)
+namespace {
+	// every name a key has been made for; a deque, so the names never move
+	struct KeyNames {
+		std::deque<std::string> names;
+		std::unordered_map<std::string, Uint32> ids;
+	};
+
+	// keys are made by static constructors, so this has to be made on first use
+	KeyNames &GetKeyNames()
+	{
+		static KeyNames keyNames;
+		return keyNames;
+	}
+
+	// maps with signals waiting to be sent. a map that's deleted first leaves a null behind
+	std::vector<PropertyMap *> s_queuedMaps;
+} // namespace
+
+PropertyMap::Key::Key(const char *name) :
+	Key(std::string(name))
+{
+}
+
+PropertyMap::Key::Key(const std::string &name)
+{
+	KeyNames &keyNames = GetKeyNames();
+	auto it = keyNames.ids.find(name);
+	if (it == keyNames.ids.end()) {
+		it = keyNames.ids.emplace(name, Uint32(keyNames.names.size())).first;
+		keyNames.names.push_back(name);
+	}
+	m_id = it->second;
+	m_name = &keyNames.names[m_id];
+}
+
+PropertyMap::PropertyMap(LuaManager *lua) :
+	m_queued(false)
 {
 	lua_State *l = lua->GetLuaState();
 	LUA_DEBUG_START(l);
@@ -15,13 +54,75 @@ PropertyMap::PropertyMap(LuaManager *lua)
 	LUA_DEBUG_END(l, 0);
 }
 
-void PropertyMap::SendSignal(const std::string &k)
+PropertyMap::~PropertyMap()
+{
+	if (m_queued)
+		std::replace(s_queuedMaps.begin(), s_queuedMaps.end(), this, static_cast<PropertyMap *>(nullptr));
+}
+
+sigc::connection PropertyMap::Connect(const Key &k, const Signal::slot_type &fn)
+{
+	for (KeySignal &ks : m_signals)
+		if (ks.key == k.GetId())
+			return ks.signal.connect(fn);
+
+	m_signals.push_back({ k.GetId(), false, Signal() });
+	return m_signals.back().signal.connect(fn);
+}
+
+void PropertyMap::QueueSignal(Uint32 key)
 {
-	std::map<std::string, sigc::signal<void, PropertyMap &, const std::string &>>::iterator i = m_signals.find(k);
-	if (i == m_signals.end())
+	for (KeySignal &ks : m_signals) {
+		if (ks.key != key) continue;
+		if (ks.pending || ks.signal.empty()) return;
+
+		ks.pending = true;
+		if (!m_queued) {
+			m_queued = true;
+			s_queuedMaps.push_back(this);
+		}
 		return;
+	}
+}
+
+void PropertyMap::QueueSignal(const std::string &k)
+{
+	// a name that was never interned can't have been connected to
+	const KeyNames &keyNames = GetKeyNames();
+	auto it = keyNames.ids.find(k);
+	if (it != keyNames.ids.end())
+		QueueSignal(it->second);
+}
+
+void PropertyMap::EmitPending()
+{
+	m_queued = false;
+
+	for (size_t i = 0; i < m_signals.size(); i++) {
+		if (!m_signals[i].pending) continue;
+		m_signals[i].pending = false;
+
+		// a handler can connect to another property and move m_signals; the
+		// copy shares its slots with the original
+		Signal signal = m_signals[i].signal;
+		signal.emit(*this, GetKeyNames().names[m_signals[i].key]);
+	}
+}
+
+void PropertyMap::EmitPendingSignals()
+{
+	if (s_queuedMaps.empty())
+		return;
+
+	PROFILE_SCOPED()
 
-	(*i).second.emit(*this, k);
+	// maps queued by the handlers are added after these, and left for next time
+	const size_t count = s_queuedMaps.size();
+	for (size_t i = 0; i < count; i++) {
+		if (s_queuedMaps[i])
+			s_queuedMaps[i]->EmitPending();
+	}
+	s_queuedMaps.erase(s_queuedMaps.begin(), s_queuedMaps.begin() + count);
 }
 
 void PropertyMap::PushLuaTable()
@@ -8,15 +8,52 @@
 #include "LuaRef.h"
 #include "LuaTable.h"
 
+// The values live in a Lua table, which is what scripts see. Signals for
+// changed properties are held back and sent by EmitPendingSignals(), once per
+// property however many times it was set in between.
 class PropertyMap {
 public:
+	typedef sigc::signal<void, PropertyMap &, const std::string &> Signal;
+
+	// A property name, interned when it's constructed so that the signals
+	// for it can be found without comparing strings. Keys are meant to be
+	// made once, as statics, for properties that are set or read often.
+	class Key {
+	public:
+		explicit Key(const char *name);
+		explicit Key(const std::string &name);
+
+		const std::string &GetName() const { return *m_name; }
+		Uint32 GetId() const { return m_id; }
+
+	private:
+		const std::string *m_name;
+		Uint32 m_id;
+	};
+
 	PropertyMap(LuaManager *lua);
+	~PropertyMap();
+
+	template <class Value>
+	void Set(const Key &k, const Value &v)
+	{
+		ScopedTable(m_table).Set(k.GetName(), v);
+		if (!m_signals.empty())
+			QueueSignal(k.GetId());
+	}
 
 	template <class Value>
 	void Set(const std::string &k, const Value &v)
 	{
 		ScopedTable(m_table).Set(k, v);
-		SendSignal(k);
+		if (!m_signals.empty())
+			QueueSignal(k);
+	}
+
+	template <class Value>
+	void Get(const Key &k, Value &v) const
+	{
+		v = ScopedTable(m_table).Get<Value>(k.GetName(), v);
 	}
 
 	template <class Value>
@@ -27,19 +64,34 @@ public:
 
 	void PushLuaTable();
 
-	sigc::connection Connect(const std::string &k, const sigc::slot<void, PropertyMap &, const std::string &> &fn)
-	{
-		return m_signals[k].connect(fn);
-	}
+	sigc::connection Connect(const Key &k, const Signal::slot_type &fn);
+	sigc::connection Connect(const std::string &k, const Signal::slot_type &fn) { return Connect(Key(k), fn); }
 
 	void SaveToJson(Json &jsonObj);
 	void LoadFromJson(const Json &jsonObj);
 
+	// sends the signals for everything that changed since the last call.
+	// properties changed by the signal handlers wait for the next one
+	static void EmitPendingSignals();
+
 private:
+	PropertyMap(const PropertyMap &) = delete;
+	PropertyMap &operator=(const PropertyMap &) = delete;
+
+	struct KeySignal {
+		Uint32 key;
+		bool pending;
+		Signal signal;
+	};
+
+	void QueueSignal(Uint32 key);
+	void QueueSignal(const std::string &k);
+	void EmitPending();
+
 	LuaRef m_table;
 
-	void SendSignal(const std::string &k);
-	std::map<std::string, sigc::signal<void, PropertyMap &, const std::string &>> m_signals;
+	std::vector<KeySignal> m_signals; // few enough to search linearly
+	bool m_queued;
 };
 
 #endif
@@ -41,7 +41,7 @@ std::unique_ptr<AsyncJobQueue> asyncJobQueue;
 static const std::string s_dummyPath("");
 
 // fwd decl'
-void RunCompiler(const std::string &modelName, const std::string &filepath, const bool bInPlace);
+void RunCompiler(const std::string &modelName, const std::string &filepath, const bool bInPlace, const bool bMapped);
 
 // ********************************************************************************
 // Overloaded PureJob class to handle compiling each model
@@ -49,12 +49,13 @@ void RunCompiler(const std::string &modelName, const std::string &filepath, cons
 class CompileJob : public Job {
 public:
 	CompileJob(){};
-	CompileJob(const std::string &name, const std::string &path, const bool inPlace) :
+	CompileJob(const std::string &name, const std::string &path, const bool inPlace, const bool mapped) :
 		m_name(name),
 		m_path(path),
-		m_inPlace(inPlace) {}
+		m_inPlace(inPlace),
+		m_mapped(mapped) {}
 
-	virtual void OnRun() override final { RunCompiler(m_name, m_path, m_inPlace); } // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+	virtual void OnRun() override final { RunCompiler(m_name, m_path, m_inPlace, m_mapped); } // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 	virtual void OnFinish() override final {}
 	virtual void OnCancel() override final {}
 
@@ -62,6 +63,7 @@ protected:
 	std::string m_name;
 	std::string m_path;
 	bool m_inPlace;
+	bool m_mapped;
 };
 
 // ********************************************************************************
@@ -111,7 +113,7 @@ void SetupRenderer()
 #endif
 }
 
-void RunCompiler(const std::string &modelName, const std::string &filepath, const bool bInPlace)
+void RunCompiler(const std::string &modelName, const std::string &filepath, const bool bInPlace, const bool bMapped)
 {
 	PROFILE_SCOPED()
 	Profiler::Timer timer;
@@ -137,7 +139,7 @@ void RunCompiler(const std::string &modelName, const std::string &filepath, cons
 	try {
 		const std::string DataPath = FileSystem::NormalisePath(filepath.substr(0, filepath.size() - 6));
 		SceneGraph::BinaryConverter bc(s_renderer.get());
-		bc.Save(modelName, DataPath, model.get(), bInPlace);
+		bc.Save(modelName, DataPath, model.get(), bInPlace, bMapped);
 	} catch (const CouldNotOpenFileException &) {
 	} catch (const CouldNotWriteToFileException &) {
 	}
@@ -166,6 +168,8 @@ extern "C" int main(int argc, char **argv)
 #endif
 
 	RunMode mode = MODE_MODELCOMPILER;
+	// write the uncompressed .sgm that the game maps instead of reading
+	bool isMapped = false;
 
 	if (argc > 1) {
 		const char switchchar = argv[1][0];
@@ -186,6 +190,18 @@ extern "C" int main(int argc, char **argv)
 			goto start;
 		}
 
+		if (modeopt == "compilemapped" || modeopt == "cm") {
+			mode = MODE_MODELCOMPILER;
+			isMapped = true;
+			goto start;
+		}
+
+		if (modeopt == "batchmapped" || modeopt == "bm") {
+			mode = MODE_MODELBATCHEXPORT;
+			isMapped = true;
+			goto start;
+		}
+
 		if (modeopt == "version" || modeopt == "v") {
 			mode = MODE_VERSION;
 			goto start;
@@ -240,7 +256,7 @@ start:
 				}
 			}
 			SetupRenderer();
-			RunCompiler(modelName, filePath, isInPlace);
+			RunCompiler(modelName, filePath, isInPlace, isMapped);
 		}
 		break;
 	}
@@ -278,12 +294,12 @@ start:
 
 #ifndef USES_THREADS
 		for (auto &modelName : list_model) {
-			RunCompiler(modelName.first, modelName.second, isInPlace);
+			RunCompiler(modelName.first, modelName.second, isInPlace, isMapped);
 		}
 #else
 		std::deque<Job::Handle> handles;
 		for (auto &modelName : list_model) {
-			handles.push_back(asyncJobQueue->Queue(new CompileJob(modelName.first, modelName.second, isInPlace)));
+			handles.push_back(asyncJobQueue->Queue(new CompileJob(modelName.first, modelName.second, isInPlace, isMapped)));
 		}
 
 		while (true) {
@@ -318,6 +334,8 @@ start:
 			"    -compile inplace  [-c ... inplace]  model compiler\n"
 			"    -batch            [-b]              batch mode output into users home/Pioneer directory\n"
 			"    -batch inplace    [-b inplace]      batch mode output into the source folder\n"
+			"    -compilemapped    [-cm ...]         model compiler, uncompressed .sgm for memory-mapping\n"
+			"    -batchmapped      [-bm ...]         batch mode, uncompressed .sgm for memory-mapping\n"
 			"    -version          [-v]              show version\n"
 			"    -help             [-h,-?]           this help\n");
 		break;
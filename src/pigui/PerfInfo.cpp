@@ -2,9 +2,11 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "PerfInfo.h"
+#include "FileSystem.h"
 #include "Frame.h"
 #include "Game.h"
 #include "LuaPiGui.h"
+#include "ModelCache.h"
 #include "Pi.h"
 #include "Player.h"
 #include "Space.h"
@@ -12,7 +14,9 @@
 #include "graphics/Stats.h"
 #include "graphics/Texture.h"
 #include "lua/Lua.h"
+#include "lua/LuaEvent.h"
 #include "lua/LuaManager.h"
+#include "lua/LuaProfiler.h"
 #include "scenegraph/Model.h"
 #include "text/TextureFont.h"
 
@@ -50,6 +54,8 @@ PerfInfo::PerfInfo() :
 {
 	m_fpsGraph.fill(0.0);
 	m_physFpsGraph.fill(0.0);
+	m_luaGCTimeGraph.fill(0.0);
+	m_luaGCFreedGraph.fill(0.0);
 }
 
 PerfInfo::~PerfInfo()
@@ -116,6 +122,12 @@ void PerfInfo::Update(float deltaTime, float physTime)
 	m_fpsGraph[NUM_FRAMES - 1] = deltaTime;
 	m_physFpsGraph[NUM_FRAMES - 1] = physTime;
 
+	const LuaManager::GCStats &gcStats = ::Lua::manager->GetGCStats();
+	std::move(m_luaGCTimeGraph.begin() + 1, m_luaGCTimeGraph.end(), m_luaGCTimeGraph.begin());
+	std::move(m_luaGCFreedGraph.begin() + 1, m_luaGCFreedGraph.end(), m_luaGCFreedGraph.begin());
+	m_luaGCTimeGraph[NUM_FRAMES - 1] = gcStats.stepMs;
+	m_luaGCFreedGraph[NUM_FRAMES - 1] = gcStats.freedBytes / 1024.0f;
+
 	float fpsAccum = 0;
 	frameTimeMax = 0.f;
 	frameTimeMin = 0.f;
@@ -203,6 +215,12 @@ void PerfInfo::DrawPerfWindow()
 		if (process_mem.currentMemSize)
 			ImGui::Text("%.1f MB process memory usage (%.1f MB peak)", (process_mem.currentMemSize * 1e-3), (process_mem.peakMemSize * 1e-3));
 		ImGui::Text("%.3f MB Lua memory usage", double(lua_mem) / scale_MB);
+		if (::Lua::manager->IsFramePacedGC()) {
+			const LuaManager::GCStats &gcStats = ::Lua::manager->GetGCStats();
+			ImGui::PlotLines("Lua GC Time (ms)", m_luaGCTimeGraph.data(), m_luaGCTimeGraph.size(), 0, nullptr, 0.0, 4.0, { 0, 25 });
+			ImGui::PlotLines("Lua GC Freed (KB)", m_luaGCFreedGraph.data(), m_luaGCFreedGraph.size(), 0, nullptr, 0.0, FLT_MAX, { 0, 25 });
+			ImGui::Text("Lua GC: %u cycles, pause %d%%, step multiplier %d%%", gcStats.cycles, gcStats.pause, gcStats.stepMul);
+		}
 		ImGui::Spacing();
 
 		if (ImGui::BeginTabBar("PerfInfoTabs")) {
@@ -212,6 +230,16 @@ void PerfInfo::DrawPerfWindow()
 				ImGui::EndTabItem();
 			}
 
+			if (ImGui::BeginTabItem("Lua Events")) {
+				DrawLuaEventStats();
+				ImGui::EndTabItem();
+			}
+
+			if (ImGui::BeginTabItem("Lua Profiler")) {
+				DrawLuaProfiler();
+				ImGui::EndTabItem();
+			}
+
 			if (false && ImGui::BeginTabItem("Input")) {
 				DrawInputDebug();
 				ImGui::EndTabItem();
@@ -242,6 +270,18 @@ void PerfInfo::DrawRendererStats()
 	const Uint32 numBuffersCreated = stats.m_stats[Graphics::Stats::STAT_CREATE_BUFFER];
 	const Uint32 numBuffersInUse = stats.m_stats[Graphics::Stats::STAT_BUFFER_INUSE];
 	const Uint32 numDrawTris = stats.m_stats[Graphics::Stats::STAT_DRAWTRIS];
+	const Uint32 numStreamAllocs = stats.m_stats[Graphics::Stats::STAT_STREAM_ALLOCS];
+	const Uint32 streamBytes = stats.m_stats[Graphics::Stats::STAT_STREAM_BYTES];
+	const Uint32 numStreamWaits = stats.m_stats[Graphics::Stats::STAT_STREAM_WAITS];
+	const Uint32 numStreamOrphans = stats.m_stats[Graphics::Stats::STAT_STREAM_ORPHANS];
+	const Uint32 streamMemUsage = stats.m_stats[Graphics::Stats::STAT_MEM_STREAM_BUFFER];
+	const Uint32 numQueuedDraws = stats.m_stats[Graphics::Stats::STAT_QUEUED_DRAWS];
+	const Uint32 numProgramChangesUnsorted = stats.m_stats[Graphics::Stats::STAT_PROGRAM_CHANGES_UNSORTED];
+	const Uint32 numProgramChanges = stats.m_stats[Graphics::Stats::STAT_PROGRAM_CHANGES];
+	const Uint32 numMaterialChangesUnsorted = stats.m_stats[Graphics::Stats::STAT_MATERIAL_CHANGES_UNSORTED];
+	const Uint32 numMaterialChanges = stats.m_stats[Graphics::Stats::STAT_MATERIAL_CHANGES];
+	const Uint32 numTextureChangesUnsorted = stats.m_stats[Graphics::Stats::STAT_TEXTURE_CHANGES_UNSORTED];
+	const Uint32 numTextureChanges = stats.m_stats[Graphics::Stats::STAT_TEXTURE_CHANGES];
 	const Uint32 numDrawPointSprites = stats.m_stats[Graphics::Stats::STAT_DRAWPOINTSPRITES];
 	const Uint32 numDrawBuildings = stats.m_stats[Graphics::Stats::STAT_BUILDINGS];
 	const Uint32 numDrawCities = stats.m_stats[Graphics::Stats::STAT_CITIES];
@@ -252,6 +292,8 @@ void PerfInfo::DrawRendererStats()
 	const Uint32 numDrawGasGiants = stats.m_stats[Graphics::Stats::STAT_GASGIANTS];
 	const Uint32 numDrawStars = stats.m_stats[Graphics::Stats::STAT_STARS];
 	const Uint32 numDrawShips = stats.m_stats[Graphics::Stats::STAT_SHIPS];
+	const Uint32 numInstancedModels = stats.m_stats[Graphics::Stats::STAT_INSTANCED_MODELS];
+	const Uint32 numModelGroups = stats.m_stats[Graphics::Stats::STAT_MODEL_GROUPS];
 	const Uint32 numDrawBillBoards = stats.m_stats[Graphics::Stats::STAT_BILLBOARD];
 
 	const Uint32 numTex2ds = stats.m_stats[Graphics::Stats::STAT_NUM_TEXTURE2D];
@@ -260,6 +302,9 @@ void PerfInfo::DrawRendererStats()
 	const Uint32 texCubeMemUsage = stats.m_stats[Graphics::Stats::STAT_MEM_TEXTURECUBE];
 	const Uint32 numTexArray2ds = stats.m_stats[Graphics::Stats::STAT_NUM_TEXTUREARRAY2D];
 	const Uint32 texArray2dMemUsage = stats.m_stats[Graphics::Stats::STAT_MEM_TEXTUREARRAY2D];
+	const Uint32 numTexturesPending = stats.m_stats[Graphics::Stats::STAT_TEXTURES_PENDING];
+	const Uint32 numTextureUploads = stats.m_stats[Graphics::Stats::STAT_TEXTURE_UPLOADS];
+	const Uint32 textureUploadBytes = stats.m_stats[Graphics::Stats::STAT_TEXTURE_UPLOAD_BYTES];
 	const Uint32 numCachedTextures = numTex2ds + numTexCubemaps + numTexArray2ds;
 	const Uint32 cachedTextureMemUsage = tex2dMemUsage + texCubeMemUsage + texArray2dMemUsage;
 
@@ -272,10 +317,24 @@ void PerfInfo::DrawRendererStats()
 		numDrawBuildings, numDrawCities, numDrawGroundStations, numDrawSpaceStations);
 	ImGui::Text("%u Atmospheres, %u Planets, %u Gas Giants, %u Stars, %u Ships",
 		numDrawAtmospheres, numDrawPlanets, numDrawGasGiants, numDrawStars, numDrawShips);
+	ImGui::Text("%u Models drawn instanced, in %u groups", numInstancedModels, numModelGroups);
 	ImGui::Text("%u Buffers Created (%u in use)", numBuffersCreated, numBuffersInUse);
+	ImGui::Text("Stream buffer: %u allocations, %.1f KB written, %u waits, %u orphaned (%.3f MB)",
+		numStreamAllocs, double(streamBytes) / 1024.0, numStreamWaits, numStreamOrphans, double(streamMemUsage) / scale_MB);
+	ImGui::Text("Render queue: %u draws, changes unsorted -> sorted: %u -> %u programs, %u -> %u materials, %u -> %u textures",
+		numQueuedDraws, numProgramChangesUnsorted, numProgramChanges, numMaterialChangesUnsorted, numMaterialChanges,
+		numTextureChangesUnsorted, numTextureChanges);
 	ImGui::Spacing();
 
 	ImGui::Text("%u cached textures, using %.3f MB VRAM", numCachedTextures, double(cachedTextureMemUsage) / scale_MB);
+	ImGui::Text("Texture loading: %u pending, %u uploaded this frame (%.1f KB)",
+		numTexturesPending, numTextureUploads, double(textureUploadBytes) / 1024.0);
+	if (Pi::modelCache) {
+		const ModelCache::Stats modelStats = Pi::modelCache->GetStats();
+		ImGui::Text("Model cache: %u models (%u unused), %u loading, %u evicted, %.3f MB of %.3f MB",
+			modelStats.models, modelStats.unused, modelStats.loading, modelStats.evicted,
+			double(modelStats.memoryUsed) / scale_MB, double(modelStats.memoryBudget) / scale_MB);
+	}
 
 	if (ImGui::Button("Open Texture Cache Visualizer"))
 		m_state->textureCacheViewerOpen = true;
@@ -407,6 +466,114 @@ void PerfInfo::DrawInputDebug()
 	}
 }
 
+void PerfInfo::DrawLuaEventStats()
+{
+	std::vector<LuaEvent::EventStats> stats;
+	LuaEvent::GetStats(stats);
+	std::sort(stats.begin(), stats.end(), [](const LuaEvent::EventStats &a, const LuaEvent::EventStats &b) {
+		return a.ms > b.ms;
+	});
+
+	if (ImGui::Button("Reset"))
+		LuaEvent::ResetStats();
+
+	ImGui::Columns(5);
+	ImGui::TextUnformatted("Event");
+	ImGui::NextColumn();
+	ImGui::TextUnformatted("Queued");
+	ImGui::NextColumn();
+	ImGui::TextUnformatted("Handlers");
+	ImGui::NextColumn();
+	ImGui::TextUnformatted("Calls");
+	ImGui::NextColumn();
+	ImGui::TextUnformatted("Time (ms)");
+	ImGui::NextColumn();
+	ImGui::Separator();
+
+	for (const auto &es : stats) {
+		ImGui::TextUnformatted(es.name.c_str());
+		ImGui::NextColumn();
+		ImGui::Text("%u", es.queued);
+		ImGui::NextColumn();
+		ImGui::Text("%u", es.handlers);
+		ImGui::NextColumn();
+		ImGui::Text("%u", es.calls);
+		ImGui::NextColumn();
+		ImGui::Text("%.3f", es.ms);
+		ImGui::NextColumn();
+	}
+	ImGui::Columns();
+}
+
+void PerfInfo::DrawLuaProfiler()
+{
+	LuaProfiler *profiler = ::Lua::manager->GetProfiler();
+
+	if (profiler->IsRunning()) {
+		if (ImGui::Button("Stop"))
+			profiler->Stop();
+	} else {
+		if (ImGui::Button("Sample"))
+			profiler->Start(LuaProfiler::MODE_SAMPLE);
+		ImGui::SameLine();
+		if (ImGui::Button("Count Calls"))
+			profiler->Start(LuaProfiler::MODE_CALLS);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Reset"))
+		profiler->Reset();
+	ImGui::SameLine();
+	if (!profiler->IsRunning() && ImGui::Button("Write Folded Stacks")) {
+		FileSystem::userFiles.MakeDirectory("profiler");
+		const std::string path = FileSystem::JoinPathBelow("profiler", "lua.folded");
+		if (profiler->DumpFolded(path))
+			Output("Lua profile written to %s\n", path.c_str());
+	}
+
+	// the results are being added to while it runs
+	if (profiler->IsRunning())
+		return;
+
+	std::vector<LuaProfiler::FunctionStats> stats;
+	profiler->GetFunctionStats(stats);
+	const bool sampled = profiler->GetMode() == LuaProfiler::MODE_SAMPLE;
+	std::sort(stats.begin(), stats.end(), [sampled](const LuaProfiler::FunctionStats &a, const LuaProfiler::FunctionStats &b) {
+		return sampled ? a.samples > b.samples : a.selfMs > b.selfMs;
+	});
+
+	ImGui::Columns(4);
+	ImGui::TextUnformatted("Function");
+	ImGui::NextColumn();
+	ImGui::TextUnformatted(sampled ? "Self Samples" : "Self (ms)");
+	ImGui::NextColumn();
+	ImGui::TextUnformatted(sampled ? "Total Samples" : "Total (ms)");
+	ImGui::NextColumn();
+	ImGui::TextUnformatted(sampled ? "" : "Calls");
+	ImGui::NextColumn();
+	ImGui::Separator();
+
+	for (size_t i = 0; i < std::min<size_t>(stats.size(), 50); i++) {
+		const auto &fs = stats[i];
+		ImGui::TextUnformatted(fs.name.c_str());
+		ImGui::NextColumn();
+		if (sampled) {
+			ImGui::Text("%llu", static_cast<unsigned long long>(fs.samples));
+			ImGui::NextColumn();
+			ImGui::Text("%llu", static_cast<unsigned long long>(fs.totalSamples));
+			ImGui::NextColumn();
+			ImGui::NextColumn();
+		} else {
+			ImGui::Text("%.3f", fs.selfMs);
+			ImGui::NextColumn();
+			ImGui::Text("%.3f", fs.totalMs);
+			ImGui::NextColumn();
+			ImGui::Text("%llu", static_cast<unsigned long long>(fs.calls));
+			ImGui::NextColumn();
+		}
+	}
+	ImGui::Columns();
+}
+
 void PerfInfo::DrawImGuiStats()
 {
 	ImGui::NewLine();
@@ -40,11 +40,15 @@ namespace PiGui {
 		void DrawWorldViewStats();
 		void DrawImGuiStats();
 		void DrawInputDebug();
+		void DrawLuaEventStats();
+		void DrawLuaProfiler();
 		void DrawStatList(const Perf::Stats::FrameInfo &fi);
 
 		static const int NUM_FRAMES = 60;
 		std::array<float, NUM_FRAMES> m_fpsGraph;
 		std::array<float, NUM_FRAMES> m_physFpsGraph;
+		std::array<float, NUM_FRAMES> m_luaGCTimeGraph;
+		std::array<float, NUM_FRAMES> m_luaGCFreedGraph;
 		float frameTimeAverage = 0;
 		float frameTimeMax = 0;
 		float frameTimeMin = 0;
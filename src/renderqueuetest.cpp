@@ -0,0 +1,156 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "graphics/Stats.h"
+#include "graphics/dummy/RendererDummy.h"
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Queues draws through the dummy renderer and checks the order they come out
+// in and how many program and material changes were saved by sorting them.
+
+namespace {
+	int s_failures = 0;
+
+	void Check(bool ok, const char *what)
+	{
+		if (!ok) {
+			printf("FAILED: %s\n", what);
+			++s_failures;
+		}
+	}
+
+	void CheckCount(Uint32 value, Uint32 expected, const char *what)
+	{
+		if (value != expected) {
+			printf("FAILED: %s is %u, expected %u\n", what, value, expected);
+			++s_failures;
+		}
+	}
+
+	// a material that draws with the program it's given
+	class TestMaterial : public Graphics::Dummy::Material {
+	public:
+		TestMaterial(const void *program, Graphics::Texture *texture) :
+			m_program(program)
+		{
+			texture0 = texture;
+		}
+		virtual const void *GetProgramHandle() const override { return m_program; }
+
+	private:
+		const void *m_program;
+	};
+
+	// remembers what it was asked to draw, in order
+	class RecordingRenderer : public Graphics::RendererDummy {
+	public:
+		struct Draw {
+			const Graphics::Material *material;
+			float depth;
+			bool applyMaterial;
+		};
+		std::vector<Draw> draws;
+
+	protected:
+		virtual void DrawQueued(const Graphics::RenderQueue::Item &item, bool applyMaterial) override
+		{
+			draws.push_back({ item.material, item.transform.GetTranslate().z, applyMaterial });
+		}
+	};
+} // namespace
+
+extern "C" int main(int argc, char **argv)
+{
+	using namespace Graphics;
+
+	RecordingRenderer r;
+
+	// anything will do for a program handle
+	const char program1 = 1, program2 = 2;
+	std::unique_ptr<Texture> tex1(r.CreateTexture(TextureDescriptor()));
+	std::unique_ptr<Texture> tex2(r.CreateTexture(TextureDescriptor()));
+
+	RenderStateDesc solidDesc;
+	RenderStateDesc blendDesc;
+	blendDesc.blendMode = BLEND_ALPHA;
+	std::unique_ptr<RenderState> solid(r.CreateRenderState(solidDesc));
+	std::unique_ptr<RenderState> blend(r.CreateRenderState(blendDesc));
+
+	VertexBufferDesc vbd;
+	std::unique_ptr<VertexBuffer> vb(r.CreateVertexBuffer(vbd));
+
+	TestMaterial a(&program1, tex1.get());
+	TestMaterial b(&program2, tex1.get());
+	TestMaterial c(&program1, tex2.get());
+	TestMaterial t(&program1, nullptr);
+
+	struct Submit {
+		TestMaterial *material;
+		RenderState *state;
+		float depth;
+	};
+	const Submit submits[] = {
+		{ &a, solid.get(), 10.0f },
+		{ &b, solid.get(), 5.0f },
+		{ &c, solid.get(), 1.0f },
+		{ &a, solid.get(), 2.0f },
+		{ &t, blend.get(), 3.0f },
+		{ &b, solid.get(), 8.0f },
+		{ &t, blend.get(), 20.0f },
+		{ &c, solid.get(), 4.0f },
+	};
+
+	r.BeginQueue();
+	for (const Submit &s : submits) {
+		r.SetTransform(matrix4x4f::Translation(0.0f, 0.0f, s.depth));
+		r.DrawBuffer(vb.get(), s.state, s.material, TRIANGLES);
+	}
+	Check(r.draws.empty(), "nothing is drawn before EndQueue()");
+	r.EndQueue();
+
+	// opaque first, by program in the order first seen, then material, front
+	// to back; then blended, back to front
+	const RecordingRenderer::Draw expected[] = {
+		{ &a, 2.0f, true },
+		{ &a, 10.0f, false },
+		{ &c, 1.0f, true },
+		{ &c, 4.0f, false },
+		{ &b, 5.0f, true },
+		{ &b, 8.0f, false },
+		{ &t, 20.0f, true },
+		{ &t, 3.0f, false },
+	};
+	const size_t numExpected = sizeof(expected) / sizeof(expected[0]);
+
+	CheckCount(r.draws.size(), numExpected, "number of draws");
+	for (size_t i = 0; i < numExpected && i < r.draws.size(); i++) {
+		const RecordingRenderer::Draw &got = r.draws[i];
+		if (got.material != expected[i].material || got.depth != expected[i].depth) {
+			printf("FAILED: draw %u is at depth %.0f, expected %.0f\n", unsigned(i), got.depth, expected[i].depth);
+			++s_failures;
+		}
+		Check(got.applyMaterial == expected[i].applyMaterial, "a material is applied only when it changes");
+	}
+
+	Check(r.GetTransform().GetTranslate().z == 4.0f, "the transform is put back after drawing the queue");
+
+	Stats &stats = r.GetStats();
+	stats.NextFrame();
+	const Stats::TFrameData &frame = stats.FrameStatsPrevious();
+	CheckCount(frame.m_stats[Stats::STAT_QUEUED_DRAWS], numExpected, "queued draws");
+	CheckCount(frame.m_stats[Stats::STAT_PROGRAM_CHANGES_UNSORTED], 5, "program changes as submitted");
+	CheckCount(frame.m_stats[Stats::STAT_PROGRAM_CHANGES], 3, "program changes");
+	CheckCount(frame.m_stats[Stats::STAT_MATERIAL_CHANGES_UNSORTED], 8, "material changes as submitted");
+	CheckCount(frame.m_stats[Stats::STAT_MATERIAL_CHANGES], 4, "material changes");
+	CheckCount(frame.m_stats[Stats::STAT_TEXTURE_CHANGES_UNSORTED], 7, "texture changes as submitted");
+	CheckCount(frame.m_stats[Stats::STAT_TEXTURE_CHANGES], 4, "texture changes");
+
+	if (s_failures) {
+		printf("%d checks failed\n", s_failures);
+		return 1;
+	}
+	printf("all render queue checks passed\n");
+	return 0;
+}
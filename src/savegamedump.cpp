@@ -2,8 +2,11 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "FileSystem.h"
+#include "GameSaveHeader.h"
 #include "Json.h"
+#include "JsonUtils.h"
 #include "core/GZipFormat.h"
+#include "core/LZ4Format.h"
 #include <SDL.h>
 
 extern "C" int main(int argc, char **argv)
@@ -32,13 +35,12 @@ extern "C" int main(int argc, char **argv)
 	}
 
 	const auto compressed_data = file->AsByteRange();
+	const uint8_t *data = reinterpret_cast<const uint8_t *>(compressed_data.begin);
+	// skip the uncompressed header of newer saves; the game state after it has everything
+	const size_t header_size = GameSaveHeader::GetSize(data, compressed_data.Size());
 	Json rootNode;
 	try {
-		std::string plain_data;
-		if (gzip::IsGZipFormat(reinterpret_cast<const uint8_t *>(compressed_data.begin), compressed_data.Size()))
-			plain_data = gzip::DecompressDeflateOrGZip(reinterpret_cast<const uint8_t *>(compressed_data.begin), compressed_data.Size());
-		else
-			plain_data = std::string(compressed_data.begin, compressed_data.Size());
+		const std::string plain_data = JsonUtils::DecompressSaveData(data + header_size, compressed_data.Size() - header_size);
 
 		try {
 			// Allow loading files in JSON format as well as CBOR
@@ -58,6 +60,9 @@ extern "C" int main(int argc, char **argv)
 	} catch (gzip::DecompressionFailedException) {
 		printf("Decompressing saved data failed - saved game is corrupt.\n");
 		return 3;
+	} catch (lz4::DecompressionFailedException &e) {
+		printf("Decompressing saved data failed - saved game is corrupt: %s.\n", e.what());
+		return 3;
 	}
 
 	auto outFile = FileSystem::userFiles.OpenWriteStream(outname);
@@ -3,8 +3,33 @@
 
 #include "Animation.h"
 #include "scenegraph/Model.h"
+#include <algorithm>
 #include <iostream>
 
+namespace {
+	// The key at or before the time. The time mostly moves a little at a time,
+	// so the search starts from the key found last and only falls back to a
+	// binary search if it's moved more than one key.
+	template <typename Key>
+	unsigned int FindKey(const std::vector<Key> &keys, double time, unsigned int &cursor)
+	{
+		const unsigned int last = keys.size() - 1;
+		const auto between = [&keys, last, time](unsigned int frame) {
+			return (frame == 0 || keys[frame].time <= time) && (frame == last || time < keys[frame + 1].time);
+		};
+
+		unsigned int frame = std::min(cursor, last);
+		if (!between(frame)) {
+			if (frame < last && between(frame + 1))
+				++frame;
+			else
+				frame = std::upper_bound(keys.begin() + 1, keys.end(), time, [](double t, const Key &key) { return t < key.time; }) - keys.begin() - 1;
+		}
+		cursor = frame;
+		return frame;
+	}
+} // namespace
+
 namespace SceneGraph {
 
 	typedef std::vector<AnimationChannel> ChannelList;
@@ -13,6 +38,7 @@ namespace SceneGraph {
 	Animation::Animation(const std::string &name, double duration) :
 		m_duration(duration),
 		m_time(0.0),
+		m_interpolatedTime(-1.0),
 		m_name(name)
 	{
 	}
@@ -20,6 +46,7 @@ namespace SceneGraph {
 	Animation::Animation(const Animation &anim) :
 		m_duration(anim.m_duration),
 		m_time(0.0),
+		m_interpolatedTime(-1.0),
 		m_name(anim.m_name)
 	{
 		for (ChannelList::const_iterator chan = anim.m_channels.begin(); chan != anim.m_channels.end(); ++chan) {
@@ -41,19 +68,25 @@ namespace SceneGraph {
 	{
 		PROFILE_SCOPED()
 		const double mtime = m_time;
+		if (mtime == m_interpolatedTime)
+			return;
+		m_interpolatedTime = mtime;
+
+		if (m_cursors.size() != m_channels.size()) {
+			const KeyCursor start = { 0, 0, 0 };
+			m_cursors.assign(m_channels.size(), start);
+			m_transforms.resize(m_channels.size());
+		}
 
 		//go through channels and calculate transforms
-		for (ChannelIterator chan = m_channels.begin(); chan != m_channels.end(); ++chan) {
-			matrix4x4f trans = chan->node->GetTransform();
+		for (unsigned int i = 0; i < m_channels.size(); i++) {
+			const AnimationChannel *chan = &m_channels[i];
+			KeyCursor &cursor = m_cursors[i];
+			matrix4x4f &trans = m_transforms[i];
+			trans = chan->node->GetTransform();
 
 			if (!chan->rotationKeys.empty()) {
-				//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-				unsigned int frame = 0;
-				while (frame + 1 < chan->rotationKeys.size()) {
-					if (mtime < chan->rotationKeys[frame + 1].time)
-						break;
-					frame++;
-				}
+				const unsigned int frame = FindKey(chan->rotationKeys, mtime, cursor.rotation);
 
 				const RotationKey &a = chan->rotationKeys[frame];
 				vector3f saved_position = trans.GetTranslate();
@@ -73,13 +106,7 @@ namespace SceneGraph {
 			//continously scale the transform (would have to add originalTransform or
 			//something to MT)
 			if (!chan->scaleKeys.empty() && !chan->rotationKeys.empty()) {
-				//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-				unsigned int frame = 0;
-				while (frame + 1 < chan->scaleKeys.size()) {
-					if (mtime < chan->scaleKeys[frame + 1].time)
-						break;
-					frame++;
-				}
+				const unsigned int frame = FindKey(chan->scaleKeys, mtime, cursor.scale);
 
 				const ScaleKey &a = chan->scaleKeys[frame];
 				vector3f out;
@@ -96,13 +123,7 @@ namespace SceneGraph {
 			}
 
 			if (!chan->positionKeys.empty()) {
-				//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-				unsigned int frame = 0;
-				while (frame + 1 < chan->positionKeys.size()) {
-					if (mtime < chan->positionKeys[frame + 1].time)
-						break;
-					frame++;
-				}
+				const unsigned int frame = FindKey(chan->positionKeys, mtime, cursor.position);
 
 				const PositionKey &a = chan->positionKeys[frame];
 				vector3f out;
@@ -117,9 +138,15 @@ namespace SceneGraph {
 				}
 				trans.SetTranslate(out);
 			}
-
-			chan->node->SetTransform(trans);
 		}
+
+		for (unsigned int i = 0; i < m_channels.size(); i++)
+			m_channels[i].node->SetTransform(m_transforms[i]);
+	}
+
+	void Animation::Invalidate()
+	{
+		m_interpolatedTime = -1.0;
 	}
 
 	double Animation::GetProgress()
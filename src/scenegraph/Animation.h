@@ -7,6 +7,9 @@
  * A named animation, such as "GearDown".
  * An animation has a number of channels, each of which
  * animate the position/rotation of a single MatrixTransform node
+ *
+ * Interpolate() does nothing if the progress hasn't changed since the last
+ * time, and otherwise looks for the keys from where it found them last.
  */
 #include "AnimationChannel.h"
 
@@ -26,15 +29,27 @@ namespace SceneGraph {
 		double GetProgress();
 		void SetProgress(double); //0.0 -- 1.0, overrides m_time
 		void Interpolate(); //update transforms according to m_time;
+		void Invalidate();	//the next Interpolate() sets the transforms even if m_time is the same
 		const std::vector<AnimationChannel> &GetChannels() const { return m_channels; }
 
 	private:
 		friend class Loader;
 		friend class BinaryConverter;
+
+		// the keys each channel was between last time
+		struct KeyCursor {
+			unsigned int position;
+			unsigned int rotation;
+			unsigned int scale;
+		};
+
 		double m_duration;
 		double m_time;
+		double m_interpolatedTime; // negative if the transforms haven't been set
 		std::string m_name;
 		std::vector<AnimationChannel> m_channels;
+		std::vector<KeyCursor> m_cursors;
+		std::vector<matrix4x4f> m_transforms; // the channels' output, in order
 	};
 
 } // namespace SceneGraph
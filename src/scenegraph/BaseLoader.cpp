@@ -54,20 +54,22 @@ void BaseLoader::ConvertMaterialDefinition(const MaterialDefinition &mdef)
 	if (mdef.opacity < 100)
 		mat->diffuse.a = (float(mdef.opacity) / 100.f) * 255;
 
+	//textures load in the background, with placeholders that look like the
+	//material without that map until they're ready
 	if (!diffTex.empty())
-		mat->texture0 = Graphics::TextureBuilder::Model(diffTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture0 = Graphics::TextureBuilder::Model(diffTex).GetOrCreateTextureAsync(m_renderer, "model");
 	else
 		mat->texture0 = Graphics::TextureBuilder::GetWhiteTexture(m_renderer);
 	if (!specTex.empty())
-		mat->texture1 = Graphics::TextureBuilder::Model(specTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture1 = Graphics::TextureBuilder::Model(specTex).GetOrCreateTextureAsync(m_renderer, "model", Color::WHITE);
 	if (!glowTex.empty())
-		mat->texture2 = Graphics::TextureBuilder::Model(glowTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture2 = Graphics::TextureBuilder::Model(glowTex).GetOrCreateTextureAsync(m_renderer, "model", Color::BLACK);
 	if (!ambiTex.empty())
-		mat->texture3 = Graphics::TextureBuilder::Model(ambiTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture3 = Graphics::TextureBuilder::Model(ambiTex).GetOrCreateTextureAsync(m_renderer, "model");
 	//texture4 is reserved for pattern
 	//texture5 is reserved for color gradient
 	if (!normTex.empty())
-		mat->texture6 = Graphics::TextureBuilder::Normal(normTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture6 = Graphics::TextureBuilder::Normal(normTex).GetOrCreateTextureAsync(m_renderer, "model", Color(128, 128, 255));
 
 	m_model->m_materials.push_back(std::make_pair(mdef.name, mat));
 }
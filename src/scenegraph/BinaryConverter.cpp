@@ -27,6 +27,7 @@ using namespace SceneGraph;
 // 5:	normal mapping
 // 6:	32-bit indicies
 // 6.1:	rewrote serialization, use lz4 compression instead of INFLATE/DEFLATE. Still compatible.
+// 6.2:	uncompressed variant that can be loaded where it's memory-mapped. Still compatible.
 const Uint32 SGM_VERSION = 6;
 union SGM_STRING_VALUE {
 	char name[4];
@@ -36,13 +37,29 @@ const SGM_STRING_VALUE SGM_STRING_ID = { { 's', 'g', 'm', SGM_VERSION } };
 const std::string SGM_EXTENSION = ".sgm";
 const std::string SAVE_TARGET_DIR = "binarymodels";
 
+// The mapped .sgm isn't compressed, and starts with SGM_MAPPED_ID, the number
+// of blobs and an offset and size for each, all Uint32. Blob 0 is the model as
+// it's serialized in a compressed .sgm, except that StaticGeometry gives the
+// index of a blob holding its vertices or indices instead of the data itself.
+// Those are laid out as the buffers have them, and every blob starts on a
+// multiple of SGM_MAPPED_ALIGN, so they can be uploaded straight from the file.
+const SGM_STRING_VALUE SGM_MAPPED_ID = { { 's', 'g', 'm', 'M' } };
+const Uint32 SGM_MAPPED_ALIGN = 16;
+
+static Uint32 AlignBlob(size_t offset)
+{
+	return Uint32((offset + SGM_MAPPED_ALIGN - 1) / SGM_MAPPED_ALIGN * SGM_MAPPED_ALIGN);
+}
+
 class SaveHelperVisitor : public NodeVisitor {
 public:
-	SaveHelperVisitor(Serializer::Writer *wr, Model *m)
+	SaveHelperVisitor(Serializer::Writer *wr, std::vector<std::string> *blobs, Model *m)
 	{
 		db.wr = wr;
 		db.rd = nullptr;
 		db.model = m;
+		db.wrBlobs = blobs;
+		db.rdBlobs = nullptr;
 	}
 
 	virtual void ApplyNode(Node &n) override
@@ -86,7 +103,7 @@ void BinaryConverter::Save(const std::string &filename, Model *m)
 	Save(filename, s_EmptyString, m, false);
 }
 
-void BinaryConverter::Save(const std::string &filename, const std::string &savepath, Model *m, const bool bInPlace)
+void BinaryConverter::Save(const std::string &filename, const std::string &savepath, Model *m, const bool bInPlace, const bool bMapped)
 {
 	PROFILE_SCOPED()
 	printf("Saving file (%s)\n", filename.c_str());
@@ -125,7 +142,9 @@ void BinaryConverter::Save(const std::string &filename, const std::string &savep
 
 	SaveMaterials(wr, m);
 
-	SaveHelperVisitor sv(&wr, m);
+	// blob 0 is the stream itself, filled in once it's written
+	std::vector<std::string> blobs(1);
+	SaveHelperVisitor sv(&wr, bMapped ? &blobs : nullptr, m);
 	m->GetRoot()->Accept(sv);
 
 	m->GetCollisionMesh()->Save(wr);
@@ -138,6 +157,30 @@ void BinaryConverter::Save(const std::string &filename, const std::string &savep
 	for (unsigned int i = 0; i < m->GetNumTags(); i++)
 		wr.String(m->GetTagByIndex(i)->GetName().c_str());
 
+	if (bMapped) {
+		blobs[0] = wr.GetData();
+		std::vector<Uint32> header = { SGM_MAPPED_ID.value, Uint32(blobs.size()) };
+		Uint32 offset = AlignBlob(sizeof(Uint32) * (2 + 2 * blobs.size()));
+		for (const std::string &blob : blobs) {
+			header.push_back(offset);
+			header.push_back(blob.size());
+			offset = AlignBlob(offset + blob.size());
+		}
+
+		std::string out(reinterpret_cast<const char *>(header.data()), header.size() * sizeof(Uint32));
+		for (const std::string &blob : blobs) {
+			out.resize(AlignBlob(out.size()), '\0');
+			out += blob;
+		}
+
+		const bool written = fwrite(out.data(), out.size(), 1, f) == 1;
+		fclose(f);
+		if (!written)
+			throw CouldNotWriteToFileException();
+		Output("Saved mapped model (%s): %.2f KB in %u blobs\n", filename.c_str(), out.size() / 1024.f, Uint32(blobs.size()));
+		return;
+	}
+
 	// compress in memory, write to open file
 	size_t outSize = 0;
 	const std::string &data = wr.GetData();
@@ -163,40 +206,61 @@ Model *BinaryConverter::Load(const std::string &filename)
 Model *BinaryConverter::Load(const std::string &name, RefCountedPtr<FileSystem::FileData> binfile)
 {
 	PROFILE_SCOPED()
-	Model *model(nullptr);
-	// decompress the loaded ByteRange in memory
-	const ByteRange bin = binfile->AsByteRange();
-	if (lz4::IsLZ4Format(bin.begin, bin.Size())) {
-		try {
-			std::string decompressedData = lz4::DecompressLZ4({ bin.begin, bin.Size() });
-			// Output("decompressed model file %s (%.2f KB) -> %.2f KB\n", name.c_str(), binfile->GetSize() / 1024.f, decompressedData.size() / 1024.f);
-			Serializer::Reader rd(ByteRange(decompressedData.data(), decompressedData.size()));
-			model = CreateModel(name, rd);
-		} catch (std::runtime_error &e) {
-			Warning("Error loading SGM model: %s\n", e.what());
-		}
-	} else {
-		void *pDecompressedData;
-		size_t outSize(0);
-		{
-			PROFILE_SCOPED_DESC("tinfl_decompress_mem_to_heap")
-			pDecompressedData = tinfl_decompress_mem_to_heap(&bin[0], bin.Size(), &outSize, 0);
-		}
-		// Output("decompressed model file %s (%.2f KB) -> %.2f KB\n", name.c_str(), binfile->GetSize() / 1024.f, outSize / 1024.f);
-		if (pDecompressedData) {
-			// now parse in-memory representation as new ByteRange.
-			Serializer::Reader rd(ByteRange(static_cast<char *>(pDecompressedData), outSize));
-			model = CreateModel(name, rd);
-			mz_free(pDecompressedData);
-		} else {
-			Error("BinaryConverter failed to load old-style SGM called: %s", name.c_str());
-		}
-	}
+	std::string data;
+	const bool mapped = IsMapped(binfile->AsByteRange());
+	if (!mapped && !Decompress(name, binfile->AsByteRange(), data))
+		return nullptr;
 
-	return model;
+	try {
+		return CreateModel(name, mapped ? binfile->AsByteRange() : ByteRange(data.data(), data.size()));
+	} catch (std::runtime_error &e) {
+		Warning("Error loading SGM model: %s\n", e.what());
+	}
+	return nullptr;
 }
 
 Model *BinaryConverter::Load(const std::string &shortname, const std::string &basepath)
+{
+	PROFILE_SCOPED()
+	RefCountedPtr<FileSystem::FileData> binfile = FindModelFile(shortname, basepath, m_curPath);
+	if (binfile.Valid()) return Load(binfile->GetInfo().GetName(), binfile);
+
+	throw(LoadingError("File not found"));
+	return nullptr;
+}
+
+Model *BinaryConverter::Load(const std::string &shortname, const std::string &dir, const ByteRange &data)
+{
+	PROFILE_SCOPED()
+	m_curPath = dir;
+	try {
+		return CreateModel(shortname + SGM_EXTENSION, data);
+	} catch (std::runtime_error &e) {
+		Warning("Error loading SGM model: %s\n", e.what());
+	}
+	return nullptr;
+}
+
+//static
+bool BinaryConverter::ReadModel(const std::string &shortname, const std::string &basepath, std::string &dir, RefCountedPtr<FileSystem::FileData> &file, std::string &data)
+{
+	PROFILE_SCOPED()
+	file = FindModelFile(shortname, basepath, dir);
+	if (!file.Valid())
+		return false;
+	if (IsMapped(file->AsByteRange()))
+		return true;
+	return Decompress(file->GetInfo().GetName(), file->AsByteRange(), data);
+}
+
+//static
+bool BinaryConverter::IsMapped(const ByteRange &bin)
+{
+	return bin.Size() >= sizeof(Uint32) && *reinterpret_cast<const Uint32 *>(bin.begin) == SGM_MAPPED_ID.value;
+}
+
+//static
+RefCountedPtr<FileSystem::FileData> BinaryConverter::FindModelFile(const std::string &shortname, const std::string &basepath, std::string &dir)
 {
 	PROFILE_SCOPED()
 	FileSystem::FileSource &fileSource = FileSystem::gameDataFiles;
@@ -210,26 +274,68 @@ Model *BinaryConverter::Load(const std::string &shortname, const std::string &ba
 			const std::string name = info.GetName();
 
 			if (shortname == name.substr(0, name.length() - SGM_EXTENSION.length())) {
-				//curPath is used to find textures, patterns,
+				//dir is used to find textures, patterns,
 				//possibly other data files for this model.
 				//Strip trailing slash
-				m_curPath = info.GetDir();
-				if (m_curPath[m_curPath.length() - 1] == '/')
-					m_curPath = m_curPath.substr(0, m_curPath.length() - 1);
+				dir = info.GetDir();
+				if (dir[dir.length() - 1] == '/')
+					dir = dir.substr(0, dir.length() - 1);
 
-				RefCountedPtr<FileSystem::FileData> binfile = info.Read();
-				if (binfile.Valid()) return Load(name, binfile);
+				// mapped, as a mapped .sgm is used where it is
+				RefCountedPtr<FileSystem::FileData> binfile = info.Map();
+				if (binfile.Valid()) return binfile;
 			}
 		}
 	}
+	return RefCountedPtr<FileSystem::FileData>();
+}
 
-	throw(LoadingError("File not found"));
-	return nullptr;
+//static
+bool BinaryConverter::Decompress(const std::string &name, const ByteRange &bin, std::string &data)
+{
+	PROFILE_SCOPED()
+	// decompress the loaded ByteRange in memory
+	if (lz4::IsLZ4Format(bin.begin, bin.Size())) {
+		try {
+			data = lz4::DecompressLZ4({ bin.begin, bin.Size() });
+			// Output("decompressed model file %s (%.2f KB) -> %.2f KB\n", name.c_str(), bin.Size() / 1024.f, data.size() / 1024.f);
+			return true;
+		} catch (std::runtime_error &e) {
+			Warning("Error loading SGM model: %s\n", e.what());
+		}
+	} else {
+		void *pDecompressedData;
+		size_t outSize(0);
+		{
+			PROFILE_SCOPED_DESC("tinfl_decompress_mem_to_heap")
+			pDecompressedData = tinfl_decompress_mem_to_heap(&bin[0], bin.Size(), &outSize, 0);
+		}
+		// Output("decompressed model file %s (%.2f KB) -> %.2f KB\n", name.c_str(), bin.Size() / 1024.f, outSize / 1024.f);
+		if (pDecompressedData) {
+			data.assign(static_cast<char *>(pDecompressedData), outSize);
+			mz_free(pDecompressedData);
+			return true;
+		} else {
+			Error("BinaryConverter failed to load old-style SGM called: %s", name.c_str());
+		}
+	}
+	return false;
 }
 
-Model *BinaryConverter::CreateModel(const std::string &filename, Serializer::Reader &rd)
+Model *BinaryConverter::CreateModel(const std::string &filename, const ByteRange &data)
 {
 	PROFILE_SCOPED()
+	m_blobs.clear();
+	ByteRange stream = data;
+	if (IsMapped(data)) {
+		if (!ReadBlobs(data)) {
+			Warning("Error whilst loading %s\nSGM blob table is damaged\nSGM file will be ignored\n", filename.c_str());
+			return nullptr;
+		}
+		stream = m_blobs[0];
+	}
+	Serializer::Reader rd(stream);
+
 	//verify signature
 	const Uint32 sig = rd.Int32();
 	if (sig != SGM_STRING_ID.value) { //'SGM#'
@@ -265,9 +371,32 @@ Model *BinaryConverter::CreateModel(const std::string &filename, Serializer::Rea
 	//m_model->CreateCollisionMesh();
 	if (m_patternsUsed) SetUpPatterns();
 
+	// it's all been uploaded, and the file may not be around for much longer
+	m_blobs.clear();
+
 	return m_model;
 }
 
+// finds the blobs in a mapped .sgm, checking that they're all within it
+bool BinaryConverter::ReadBlobs(const ByteRange &data)
+{
+	const Uint32 *header = reinterpret_cast<const Uint32 *>(data.begin);
+	if (data.Size() < 2 * sizeof(Uint32))
+		return false;
+	const Uint32 numBlobs = header[1];
+	if (numBlobs == 0 || (2 + 2 * Uint64(numBlobs)) * sizeof(Uint32) > data.Size())
+		return false;
+
+	for (Uint32 i = 0; i < numBlobs; i++) {
+		const Uint32 offset = header[2 + 2 * i];
+		const Uint32 size = header[3 + 2 * i];
+		if (offset % SGM_MAPPED_ALIGN || Uint64(offset) + size > data.Size())
+			return false;
+		m_blobs.push_back(ByteRange(data.begin + offset, data.begin + offset + size));
+	}
+	return true;
+}
+
 void BinaryConverter::SaveMaterials(Serializer::Writer &wr, Model *model)
 {
 	PROFILE_SCOPED()
@@ -442,6 +571,8 @@ Node *BinaryConverter::LoadNode(Serializer::Reader &rd)
 	db.loader = this;
 	db.model = m_model;
 	db.rd = &rd;
+	db.wrBlobs = nullptr;
+	db.rdBlobs = m_blobs.empty() ? nullptr : &m_blobs;
 
 	auto loadFuncIt = m_loaders.find(ntype);
 	if (loadFuncIt == m_loaders.end()) {
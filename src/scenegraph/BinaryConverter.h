@@ -33,17 +33,31 @@ namespace SceneGraph {
 	public:
 		BinaryConverter(Graphics::Renderer *);
 		void Save(const std::string &filename, Model *m);
-		void Save(const std::string &filename, const std::string &savepath, Model *m, const bool bInPlace);
+		// bMapped saves the uncompressed .sgm that is loaded where it's mapped
+		void Save(const std::string &filename, const std::string &savepath, Model *m, const bool bInPlace, const bool bMapped = false);
 		Model *Load(const std::string &filename);
 		Model *Load(const std::string &filename, const std::string &path);
 		Model *Load(const std::string &filename, RefCountedPtr<FileSystem::FileData> binfile);
+		// builds a model from an uncompressed .sgm, such as ReadModel() gives
+		Model *Load(const std::string &shortname, const std::string &dir, const ByteRange &data);
+
+		// Finds the model's .sgm under basepath and maps it into file, with dir
+		// set to the directory it's in. A compressed .sgm is decompressed into
+		// data; a mapped one is left as it is, with data empty. Doesn't touch the
+		// renderer, so it can run on a worker thread. Returns false if there's
+		// no .sgm for the model or it couldn't be decompressed.
+		static bool ReadModel(const std::string &shortname, const std::string &basepath, std::string &dir, RefCountedPtr<FileSystem::FileData> &file, std::string &data);
 
 		//if you implement any new node types, you must also register a loader function
 		//before calling Load.
 		void RegisterLoader(const std::string &typeName, std::function<Node *(NodeDatabase &)>);
 
 	private:
-		Model *CreateModel(const std::string &filename, Serializer::Reader &);
+		static RefCountedPtr<FileSystem::FileData> FindModelFile(const std::string &shortname, const std::string &basepath, std::string &dir);
+		static bool Decompress(const std::string &name, const ByteRange &bin, std::string &data);
+		static bool IsMapped(const ByteRange &bin);
+		Model *CreateModel(const std::string &filename, const ByteRange &data);
+		bool ReadBlobs(const ByteRange &data);
 		void SaveMaterials(Serializer::Writer &, Model *m);
 		void LoadMaterials(Serializer::Reader &);
 		void SaveAnimations(Serializer::Writer &, Model *m);
@@ -56,6 +70,7 @@ namespace SceneGraph {
 		static Label3D *LoadLabel3D(NodeDatabase &);
 
 		bool m_patternsUsed;
+		std::vector<ByteRange> m_blobs; // of the mapped .sgm being loaded
 		std::map<std::string, std::function<Node *(NodeDatabase &)>> m_loaders;
 	};
 } // namespace SceneGraph
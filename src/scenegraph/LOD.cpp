@@ -42,19 +42,26 @@ namespace SceneGraph {
 		AddChild(nod);
 	}
 
-	void LOD::Render(const matrix4x4f &trans, const RenderData *rd)
+	int LOD::PickLevel(const matrix4x4f &trans, float boundingRadius) const
 	{
-		PROFILE_SCOPED()
+		if (m_pixelSizes.empty()) return -1;
 		//figure out approximate pixel size of object's bounding radius
 		//on screen and pick a child to render
 		const vector3f cameraPos(-trans[12], -trans[13], -trans[14]);
 		//fov is vertical, so using screen height
-		const float pixrad = Graphics::GetScreenHeight() * rd->boundingRadius / (cameraPos.Length() * Graphics::GetFovFactor());
-		if (m_pixelSizes.empty()) return;
+		const float pixrad = Graphics::GetScreenHeight() * boundingRadius / (cameraPos.Length() * Graphics::GetFovFactor());
 		unsigned int lod = m_children.size() - 1;
 		for (unsigned int i = m_pixelSizes.size(); i > 0; i--) {
 			if (pixrad < m_pixelSizes[i - 1]) lod = i - 1;
 		}
+		return lod;
+	}
+
+	void LOD::Render(const matrix4x4f &trans, const RenderData *rd)
+	{
+		PROFILE_SCOPED()
+		const int lod = PickLevel(trans, rd->boundingRadius);
+		if (lod < 0) return;
 		m_children[lod]->Render(trans, rd);
 	}
 
@@ -79,19 +86,7 @@ namespace SceneGraph {
 
 			// seperate out the transformations
 			for (auto mt : trans) {
-				//figure out approximate pixel size of object's bounding radius
-				//on screen and pick a child to render
-				const vector3f cameraPos(-mt[12], -mt[13], -mt[14]);
-				//fov is vertical, so using screen height
-				const float pixrad = Graphics::GetScreenHeight() * rd->boundingRadius / (cameraPos.Length() * Graphics::GetFovFactor());
-				unsigned int lod = m_children.size() - 1;
-				for (unsigned int i = m_pixelSizes.size(); i > 0; i--) {
-					if (pixrad < m_pixelSizes[i - 1]) {
-						lod = i - 1;
-					}
-				}
-
-				transform[lod].push_back(mt);
+				transform[PickLevel(mt, rd->boundingRadius)].push_back(mt);
 			}
 
 			// now render each of the buffers for each of the lods
@@ -20,6 +20,8 @@ namespace SceneGraph {
 		virtual void Render(const matrix4x4f &trans, const RenderData *rd) override;
 		virtual void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd) override;
 		void AddLevel(float pixelRadius, Node *child);
+		// the child to draw an object of that radius with, or -1 if there are none
+		int PickLevel(const matrix4x4f &trans, float boundingRadius) const;
 		virtual void Save(NodeDatabase &) override;
 		static LOD *Load(NodeDatabase &);
 
@@ -135,13 +135,18 @@ namespace SceneGraph {
 		if (m_debugFlags & DEBUG_WIREFRAME)
 			m_renderer->SetWireFrameMode(true);
 
+		RenderList &list = GetRenderList();
 		if (params.nodemask & MASK_IGNORE) {
-			m_root->Render(trans, &params);
+			list.Render(trans, &params);
 		} else {
+			// solid geometry is queued, to be drawn sorted by program and material;
+			// blended geometry is drawn in order
+			m_renderer->BeginQueue();
 			params.nodemask = NODE_SOLID;
-			m_root->Render(trans, &params);
+			list.Render(trans, &params);
+			m_renderer->EndQueue();
 			params.nodemask = NODE_TRANSPARENT;
-			m_root->Render(trans, &params);
+			list.Render(trans, &params);
 		}
 
 		if (!m_debugFlags)
@@ -201,16 +206,70 @@ namespace SceneGraph {
 		if (m_debugFlags & DEBUG_WIREFRAME)
 			m_renderer->SetWireFrameMode(true);
 
+		RenderList &list = GetRenderList();
 		if (params.nodemask & MASK_IGNORE) {
-			m_root->Render(trans, &params);
+			list.Render(trans, &params);
 		} else {
+			// solid geometry is queued, to be drawn sorted by program and material;
+			// blended geometry is drawn in order
+			m_renderer->BeginQueue();
 			params.nodemask = NODE_SOLID;
-			m_root->Render(trans, &params);
+			list.Render(trans, &params);
+			m_renderer->EndQueue();
 			params.nodemask = NODE_TRANSPARENT;
-			m_root->Render(trans, &params);
+			list.Render(trans, &params);
 		}
 	}
 
+	bool Model::CanInstanceWith(const Model &other) const
+	{
+		// instances of one model share their materials
+		if (m_name != other.m_name || m_materials.size() != other.m_materials.size())
+			return false;
+		for (size_t i = 0; i < m_materials.size(); i++)
+			if (m_materials[i].second.Get() != other.m_materials[i].second.Get())
+				return false;
+
+		// the debug drawing is per instance
+		if (m_debugFlags || other.m_debugFlags)
+			return false;
+
+		if (m_curPattern != other.m_curPattern || m_colors != other.m_colors)
+			return false;
+		for (unsigned int i = 0; i < MAX_DECAL_MATERIALS; i++)
+			if (m_curDecals[i] != other.m_curDecals[i])
+				return false;
+
+		// each instance has its own animated transforms, and the geometry of all
+		// of them is drawn through one set
+		assert(m_animations.size() == other.m_animations.size());
+		for (size_t i = 0; i < m_animations.size(); i++)
+			if (m_animations[i]->GetProgress() != other.m_animations[i]->GetProgress())
+				return false;
+
+		return true;
+	}
+
+	void Model::RenderInstanced(const std::vector<matrix4x4f> &trans)
+	{
+		PROFILE_SCOPED()
+		// only the solid pass; blended geometry has to be drawn in depth order,
+		// so each instance draws its own in RenderUninstanced()
+		RenderData params = m_renderData;
+		params.nodemask = NODE_SOLID | MASK_IGNORE;
+		m_renderer->BeginQueue();
+		Render(trans, &params);
+		m_renderer->EndQueue();
+	}
+
+	void Model::RenderUninstanced(const matrix4x4f &trans)
+	{
+		PROFILE_SCOPED()
+		RenderData params = m_renderData;
+		params.skipStaticGeometry = true;
+		Render(trans, &params);
+	}
+
 	void Model::CreateAabbVB()
 	{
 		PROFILE_SCOPED()
@@ -386,6 +445,14 @@ namespace SceneGraph {
 		node->SetNodeFlags(node->GetNodeFlags() | NODE_TAG);
 		m_root->AddChild(node);
 		m_tags.push_back(node);
+		m_renderList.Invalidate();
+	}
+
+	RenderList &Model::GetRenderList()
+	{
+		if (!m_renderList.IsCompiled(m_root.Get()))
+			m_renderList.Compile(m_root.Get(), m_animations);
+		return m_renderList;
 	}
 
 	void Model::SetPattern(unsigned int index)
@@ -401,6 +468,7 @@ namespace SceneGraph {
 	{
 		assert(colors.size() == 3); //primary, seconday, trim
 		m_colorMap.Generate(GetRenderer(), colors.at(0), colors.at(1), colors.at(2));
+		m_colors = colors;
 	}
 
 	void Model::SetDecalTexture(Graphics::Texture *t, unsigned int index)
@@ -463,6 +531,7 @@ namespace SceneGraph {
 	void Model::UpdateAnimations()
 	{
 		// XXX WIP. Assuming animations are controlled manually by SetProgress.
+		// Only the ones whose progress has changed do anything.
 		for (AnimationContainer::iterator anim = m_animations.begin(); anim != m_animations.end(); ++anim)
 			(*anim)->Interpolate();
 	}
@@ -480,19 +549,9 @@ namespace SceneGraph {
 
 	void Model::SetThrusterColor(const vector3f &dir, const Color &color)
 	{
-		assert(m_root != nullptr);
-
-		FindNodeVisitor thrusterFinder(FindNodeVisitor::MATCH_NAME_FULL, "thrusters");
-		m_root->Accept(thrusterFinder);
-		const std::vector<Node *> &results = thrusterFinder.GetResults();
-		Group *thrusters = static_cast<Group *>(results.at(0));
-
-		for (unsigned int i = 0; i < thrusters->GetNumChildren(); i++) {
-			MatrixTransform *mt = static_cast<MatrixTransform *>(thrusters->GetChildAt(i));
-			Thruster *my_thruster = static_cast<Thruster *>(mt->GetChildAt(0));
-			if (my_thruster == nullptr) continue;
-			float dot = my_thruster->GetDirection().Dot(dir);
-			if (dot > 0.99) my_thruster->SetColor(color);
+		for (Thruster *thruster : GetRenderList().GetThrusters()) {
+			float dot = thruster->GetDirection().Dot(dir);
+			if (dot > 0.99) thruster->SetColor(color);
 		}
 	}
 
@@ -511,19 +570,8 @@ namespace SceneGraph {
 
 	void Model::SetThrusterColor(const Color &color)
 	{
-		assert(m_root != nullptr);
-
-		FindNodeVisitor thrusterFinder(FindNodeVisitor::MATCH_NAME_FULL, "thrusters");
-		m_root->Accept(thrusterFinder);
-		const std::vector<Node *> &results = thrusterFinder.GetResults();
-		Group *thrusters = static_cast<Group *>(results.at(0));
-
-		for (unsigned int i = 0; i < thrusters->GetNumChildren(); i++) {
-			MatrixTransform *mt = static_cast<MatrixTransform *>(thrusters->GetChildAt(i));
-			Thruster *my_thruster = static_cast<Thruster *>(mt->GetChildAt(0));
-			assert(my_thruster != nullptr);
-			my_thruster->SetColor(color);
-		}
+		for (Thruster *thruster : GetRenderList().GetThrusters())
+			thruster->SetColor(color);
 	}
 
 	class SaveVisitorJson : public NodeVisitor {
@@ -596,6 +644,7 @@ namespace SceneGraph {
 			Json visitorArray = modelObj["visitor"].get<Json::array_t>();
 			LoadVisitorJson lv(visitorArray);
 			m_root->Accept(lv);
+			m_renderList.Invalidate(); // the unanimated transforms are baked into it
 			if (!lv.success()) {
 				Log::Info("Error(s) occurred while loading saved data for model '{}'. The model file may have changed on disk.\n", m_name);
 			}
@@ -608,6 +657,9 @@ namespace SceneGraph {
 			} else {
 				Log::Info("Saved model '{}' has invalid animation data. The model file may have changed on disk.\n", m_name);
 			}
+			// the transforms were just overwritten, whatever the progress
+			for (auto i : m_animations)
+				i->Invalidate();
 			UpdateAnimations();
 
 			SetPattern(modelObj["cur_pattern_index"]);
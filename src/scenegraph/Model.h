@@ -55,9 +55,11 @@
  *  - 3D labels (well, 2D) on models
  *  - spaceship thrusters
  *
+ * Rendering walks a RenderList compiled from the graph rather than the graph
+ * itself, so the transforms of unanimated nodes are only multiplied once.
+ *
  * Things to optimize:
  *  - model cache
- *  - removing unnecessary nodes from the scene graph: pre-translate unanimated meshes etc.
  */
 #include "CollMesh.h"
 #include "ColorMap.h"
@@ -65,6 +67,7 @@
 #include "Group.h"
 #include "JsonFwd.h"
 #include "Pattern.h"
+#include "RenderList.h"
 #include "graphics/Drawables.h"
 #include "graphics/Material.h"
 #include <stdexcept>
@@ -110,6 +113,15 @@ namespace SceneGraph {
 		void Render(const matrix4x4f &trans, const RenderData *rd = 0); //ModelNode can override RD
 		void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd = 0); //ModelNode can override RD
 
+		// Instancing: two instances that CanInstanceWith() each other look the same
+		// drawn with the same transform, so one of them can draw the solid
+		// geometry of both with RenderInstanced(). Each then draws its own
+		// blended geometry, thrusters, labels and billboards with
+		// RenderUninstanced().
+		bool CanInstanceWith(const Model &other) const;
+		void RenderInstanced(const std::vector<matrix4x4f> &trans);
+		void RenderUninstanced(const matrix4x4f &trans);
+
 		RefCountedPtr<CollMesh> CreateCollisionMesh();
 		RefCountedPtr<CollMesh> GetCollisionMesh() const { return m_collMesh; }
 		void SetCollisionMesh(RefCountedPtr<CollMesh> collMesh) { m_collMesh.Reset(collMesh.Get()); }
@@ -171,6 +183,12 @@ namespace SceneGraph {
 		};
 		void SetDebugFlags(Uint32 flags);
 
+		// compiled from the graph when it's first needed, and again after
+		// InvalidateRenderList(), which anything that adds or removes nodes in
+		// the graph once the model is set up has to call
+		RenderList &GetRenderList();
+		void InvalidateRenderList() { m_renderList.Invalidate(); }
+
 	private:
 		Model(const Model &);
 
@@ -187,10 +205,12 @@ namespace SceneGraph {
 		std::vector<Animation *> m_animations;
 		TagContainer m_tags; //named attachment points
 		RenderData m_renderData;
+		RenderList m_renderList;
 
 		//per-instance flavour data
 		unsigned int m_curPatternIndex;
 		Graphics::Texture *m_curPattern;
+		std::vector<Color> m_colors;
 		Graphics::Texture *m_curDecals[MAX_DECAL_MATERIALS];
 
 		// debug support
@@ -14,6 +14,8 @@ namespace Graphics {
 	class Renderer;
 }
 
+struct ByteRange;
+
 namespace Serializer {
 	class Reader;
 	class Writer;
@@ -48,12 +50,14 @@ namespace SceneGraph {
 
 		float boundingRadius; //updated by model and passed to submodels
 		unsigned int nodemask;
+		bool skipStaticGeometry; //solid pass already drawn instanced, see Model::RenderUninstanced
 
 		RenderData() :
 			linthrust(),
 			angthrust(),
 			boundingRadius(0.f),
-			nodemask(NODE_SOLID) //draw solids
+			nodemask(NODE_SOLID), //draw solids
+			skipStaticGeometry(false)
 		{
 		}
 	};
@@ -67,6 +71,10 @@ namespace SceneGraph {
 		Model *model;
 		std::vector<std::pair<std::string, RefCountedPtr<Graphics::Material>>> *materials;
 		BaseLoader *loader;
+		// for the mapped .sgm, data kept out of the stream and written or read
+		// as a whole, referred to by its index; null for the compressed .sgm
+		std::vector<std::string> *wrBlobs;
+		const std::vector<ByteRange> *rdBlobs;
 	};
 
 	class Node : public RefCounted {
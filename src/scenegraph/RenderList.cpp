@@ -0,0 +1,228 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "RenderList.h"
+#include "Animation.h"
+#include "LOD.h"
+#include "MatrixTransform.h"
+#include "Thruster.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	const matrix4x4f s_ident(matrix4x4f::Identity());
+
+	bool IsIdentity(const matrix4x4f &m)
+	{
+		return 0 == memcmp(&m, &s_ident, sizeof(matrix4x4f));
+	}
+} // namespace
+
+namespace SceneGraph {
+
+	RenderList::RenderList() :
+		m_root(nullptr)
+	{
+	}
+
+	bool RenderList::IsCompiled(const Group *root) const
+	{
+		return m_root == root;
+	}
+
+	void RenderList::Invalidate()
+	{
+		m_root = nullptr;
+	}
+
+	void RenderList::Compile(Group *root, const std::vector<Animation *> &animations)
+	{
+		PROFILE_SCOPED()
+		m_frames.clear();
+		m_items.clear();
+		m_switches.clear();
+		m_gates.clear();
+		m_thrusters.clear();
+
+		m_animated.clear();
+		for (const Animation *anim : animations)
+			for (const AnimationChannel &chan : anim->GetChannels())
+				m_animated.push_back(chan.node);
+		std::sort(m_animated.begin(), m_animated.end());
+
+		Frame model;
+		model.parent = 0;
+		model.offset = s_ident;
+		model.node = nullptr;
+		m_frames.push_back(model);
+
+		Placement at;
+		at.frame = 0;
+		at.local = s_ident;
+		at.identity = true;
+		at.lod = -1;
+		at.level = 0;
+		at.firstGate = 0;
+		at.numGates = 0;
+
+		// the model renders its root without looking at the root's mask
+		AddNode(root, at, false);
+
+		m_root = root;
+	}
+
+	void RenderList::AddNode(Node *node, Placement at, bool gated)
+	{
+		// a group checks each child's mask before rendering it; an LOD switch
+		// renders the child it picks whatever its mask
+		if (gated) {
+			const Uint32 first = m_gates.size();
+			for (Uint32 i = 0; i < at.numGates; i++) {
+				Node *gate = m_gates[at.firstGate + i];
+				m_gates.push_back(gate);
+			}
+			m_gates.push_back(node);
+			at.firstGate = first;
+			++at.numGates;
+		}
+
+		Group *group = dynamic_cast<Group *>(node);
+		if (!group) {
+			Item item;
+			item.node = node;
+			item.at = at;
+			m_items.push_back(item);
+
+			Thruster *thruster = dynamic_cast<Thruster *>(node);
+			if (thruster)
+				m_thrusters.push_back(thruster);
+			return;
+		}
+
+		MatrixTransform *mt = dynamic_cast<MatrixTransform *>(group);
+		if (mt) {
+			if (std::binary_search(m_animated.begin(), m_animated.end(), mt)) {
+				Frame frame;
+				frame.parent = at.frame;
+				frame.offset = at.local;
+				frame.node = mt;
+				m_frames.push_back(frame);
+				at.frame = m_frames.size() - 1;
+				at.local = s_ident;
+				at.identity = true;
+			} else if (!IsIdentity(mt->GetTransform())) {
+				at.local = at.local * mt->GetTransform();
+				at.identity = false;
+			}
+		}
+
+		const unsigned int numChildren = group->GetNumChildren();
+		if (dynamic_cast<LOD *>(group)) {
+			Item item;
+			item.node = group;
+			item.at = at;
+			m_switches.push_back(item);
+
+			Placement level = at;
+			level.lod = m_switches.size() - 1;
+			for (unsigned int i = 0; i < numChildren; i++) {
+				level.level = i;
+				AddNode(group->GetChildAt(i), level, false);
+			}
+		} else {
+			for (unsigned int i = 0; i < numChildren; i++)
+				AddNode(group->GetChildAt(i), at, true);
+		}
+	}
+
+	bool RenderList::PassesGates(const Placement &at, unsigned int nodemask) const
+	{
+		for (Uint32 i = at.firstGate, end = at.firstGate + at.numGates; i < end; i++)
+			if (!(m_gates[i]->GetNodeMask() & nodemask))
+				return false;
+		return true;
+	}
+
+	void RenderList::Render(const matrix4x4f &trans, const RenderData *rd)
+	{
+		PROFILE_SCOPED()
+		// the frames relative to the camera; parents come before their children
+		m_frameTransforms.resize(m_frames.size());
+		m_frameTransforms[0] = trans;
+		for (size_t i = 1; i < m_frames.size(); i++) {
+			const Frame &frame = m_frames[i];
+			m_frameTransforms[i] = m_frameTransforms[frame.parent] * frame.offset * frame.node->GetTransform();
+		}
+
+		// a switch under a level of another that wasn't picked picks nothing
+		m_levels.resize(m_switches.size());
+		for (size_t i = 0; i < m_switches.size(); i++) {
+			const Placement &at = m_switches[i].at;
+			m_levels[i] = -1;
+			if ((at.lod >= 0 && m_levels[at.lod] != Sint32(at.level)) || !PassesGates(at, rd->nodemask))
+				continue;
+			const matrix4x4f &frame = m_frameTransforms[at.frame];
+			const LOD *lod = static_cast<const LOD *>(m_switches[i].node);
+			m_levels[i] = lod->PickLevel(at.identity ? frame : frame * at.local, rd->boundingRadius);
+		}
+
+		for (const Item &item : m_items) {
+			const Placement &at = item.at;
+			if ((at.lod >= 0 && m_levels[at.lod] != Sint32(at.level)) || !PassesGates(at, rd->nodemask))
+				continue;
+			const matrix4x4f &frame = m_frameTransforms[at.frame];
+			if (at.identity)
+				item.node->Render(frame, rd);
+			else
+				item.node->Render(frame * at.local, rd);
+		}
+	}
+
+	// Instances are laid out one after another for each frame and switch, and
+	// each item draws all the instances that reach it in one go.
+	void RenderList::Render(const std::vector<matrix4x4f> &trans, const RenderData *rd)
+	{
+		PROFILE_SCOPED()
+		const size_t count = trans.size();
+		if (!count) return;
+
+		m_frameTransforms.resize(m_frames.size() * count);
+		std::copy(trans.begin(), trans.end(), m_frameTransforms.begin());
+		for (size_t i = 1; i < m_frames.size(); i++) {
+			const Frame &frame = m_frames[i];
+			const matrix4x4f m = frame.offset * frame.node->GetTransform();
+			for (size_t j = 0; j < count; j++)
+				m_frameTransforms[i * count + j] = m_frameTransforms[frame.parent * count + j] * m;
+		}
+
+		m_levels.assign(m_switches.size() * count, -1);
+		for (size_t i = 0; i < m_switches.size(); i++) {
+			const Placement &at = m_switches[i].at;
+			if (!PassesGates(at, rd->nodemask))
+				continue;
+			const LOD *lod = static_cast<const LOD *>(m_switches[i].node);
+			for (size_t j = 0; j < count; j++) {
+				if (at.lod >= 0 && m_levels[at.lod * count + j] != Sint32(at.level))
+					continue;
+				const matrix4x4f &frame = m_frameTransforms[at.frame * count + j];
+				m_levels[i * count + j] = lod->PickLevel(at.identity ? frame : frame * at.local, rd->boundingRadius);
+			}
+		}
+
+		for (const Item &item : m_items) {
+			const Placement &at = item.at;
+			if (!PassesGates(at, rd->nodemask))
+				continue;
+			m_placed.clear();
+			for (size_t j = 0; j < count; j++) {
+				if (at.lod >= 0 && m_levels[at.lod * count + j] != Sint32(at.level))
+					continue;
+				const matrix4x4f &frame = m_frameTransforms[at.frame * count + j];
+				m_placed.push_back(at.identity ? frame : frame * at.local);
+			}
+			if (!m_placed.empty())
+				item.node->Render(m_placed, rd);
+		}
+	}
+
+} // namespace SceneGraph
@@ -0,0 +1,91 @@
+// Copyright © 2008-2020 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SCENEGRAPH_RENDERLIST_H
+#define _SCENEGRAPH_RENDERLIST_H
+/*
+ * A model's graph flattened into the things it draws, in the order a
+ * traversal would draw them, so rendering is a walk along an array rather
+ * than a chain of virtual calls and matrix multiplications down the tree.
+ *
+ * The transforms of MatrixTransforms that aren't animated are multiplied
+ * together when the list is compiled. Each animated one starts a "frame",
+ * and only the frames are worked out again every render; everything below
+ * a frame is placed relative to it. LOD switches are picked once a render,
+ * and the node masks on the way down to each item are still checked every
+ * render, as navlights and shields turn nodes on and off as they go.
+ *
+ * The list has to be compiled again, after Invalidate(), when the graph
+ * changes shape or a transform that isn't animated is changed.
+ */
+#include "Group.h"
+
+namespace SceneGraph {
+
+	class Animation;
+	class MatrixTransform;
+	class Thruster;
+
+	class RenderList {
+	public:
+		RenderList();
+
+		bool IsCompiled(const Group *root) const;
+		void Compile(Group *root, const std::vector<Animation *> &animations);
+		void Invalidate();
+
+		void Render(const matrix4x4f &trans, const RenderData *rd);
+		void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd);
+
+		const std::vector<Thruster *> &GetThrusters() const { return m_thrusters; }
+
+		size_t GetNumItems() const { return m_items.size(); }
+		size_t GetNumFrames() const { return m_frames.size(); }
+
+	private:
+		// an animated MatrixTransform, or the model itself for frame 0
+		struct Frame {
+			Uint32 parent;
+			matrix4x4f offset; // from the parent frame to the node
+			const MatrixTransform *node;
+		};
+
+		// where something is drawn and what has to let it through
+		struct Placement {
+			Uint32 frame;
+			matrix4x4f local; // relative to the frame
+			bool identity;	  // local is the identity, so it's skipped
+			Sint32 lod;		  // the switch it's under, or -1
+			Uint32 level;	  // which of the switch's children it's under
+			Uint32 firstGate; // the nodes in m_gates whose masks it has to pass
+			Uint32 numGates;
+		};
+
+		struct Item {
+			Node *node;
+			Placement at;
+		};
+
+		void AddNode(Node *node, Placement at, bool gated);
+		bool PassesGates(const Placement &at, unsigned int nodemask) const;
+
+		const Group *m_root;
+
+		std::vector<Frame> m_frames;
+		std::vector<Item> m_items;
+		std::vector<Item> m_switches; // LOD nodes, parents before children
+		std::vector<Node *> m_gates;
+		std::vector<Thruster *> m_thrusters;
+
+		// compiled from, and only looked at while compiling
+		std::vector<const MatrixTransform *> m_animated;
+
+		// reused every render
+		std::vector<matrix4x4f> m_frameTransforms; // per frame, per instance
+		std::vector<Sint32> m_levels;			   // per switch, per instance
+		std::vector<matrix4x4f> m_placed;
+	};
+
+} // namespace SceneGraph
+
+#endif
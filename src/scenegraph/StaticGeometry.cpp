@@ -49,6 +49,9 @@ namespace SceneGraph {
 	{
 		PROFILE_SCOPED()
 		SDL_assert(m_renderState);
+		if (rd->skipStaticGeometry && (rd->nodemask & NODE_SOLID))
+			return;
+
 		Graphics::Renderer *r = GetRenderer();
 		r->SetTransform(trans);
 		for (auto &it : m_meshes)
@@ -92,35 +95,77 @@ namespace SceneGraph {
 				Graphics::MaterialDescriptor mdesc = it.material->GetDescriptor();
 				mdesc.instanced = true;
 				// create the "new" material with the instanced description
-				RefCountedPtr<Graphics::Material> mat(r->CreateMaterial(mdesc));
-				// copy over all of the other details
-				mat->texture0 = it.material->texture0;
-				mat->texture1 = it.material->texture1;
-				mat->texture2 = it.material->texture2;
-				mat->texture3 = it.material->texture3;
-				mat->texture4 = it.material->texture4;
-				mat->texture5 = it.material->texture5;
-				mat->texture6 = it.material->texture5;
-				mat->heatGradient = it.material->heatGradient;
-				mat->diffuse = it.material->diffuse;
-				mat->specular = it.material->specular;
-				mat->emissive = it.material->emissive;
-				mat->shininess = it.material->shininess;
-				mat->specialParameter0 = it.material->specialParameter0;
-				m_instanceMaterials.push_back(mat);
+				m_instanceMaterials.push_back(RefCountedPtr<Graphics::Material>(r->CreateMaterial(mdesc)));
 			}
 		}
 
 		// process each mesh
 		int i = 0;
 		for (auto &it : m_meshes) {
+			// copy over all of the other details, every time, as the model sets the
+			// pattern, colours and decals on the shared materials just before drawing
+			Graphics::Material *mat = m_instanceMaterials[i].Get();
+			mat->texture0 = it.material->texture0;
+			mat->texture1 = it.material->texture1;
+			mat->texture2 = it.material->texture2;
+			mat->texture3 = it.material->texture3;
+			mat->texture4 = it.material->texture4;
+			mat->texture5 = it.material->texture5;
+			mat->texture6 = it.material->texture6;
+			mat->heatGradient = it.material->heatGradient;
+			mat->diffuse = it.material->diffuse;
+			mat->specular = it.material->specular;
+			mat->emissive = it.material->emissive;
+			mat->shininess = it.material->shininess;
+			mat->specialParameter0 = it.material->specialParameter0;
+
 			// finally render using the instance material
-			r->DrawBufferIndexedInstanced(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, m_instanceMaterials[i].Get(), m_instBuffer.Get());
+			r->DrawBufferIndexedInstanced(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, mat, m_instBuffer.Get());
 			++i;
 		}
 	}
 
 	typedef std::vector<std::pair<std::string, RefCountedPtr<Graphics::Material>>> MaterialContainer;
+	namespace {
+		// The vertex layout of the meshes in an .sgm, packed in attribute order.
+		// The mapped .sgm keeps its vertices like this so they can be uploaded
+		// as they are.
+		Graphics::VertexBufferDesc ModelVertexDesc(bool hasTangents, Uint32 numVertices)
+		{
+			Graphics::VertexBufferDesc desc;
+			desc.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+			desc.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
+			desc.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
+			desc.attrib[1].format = Graphics::ATTRIB_FORMAT_FLOAT3;
+			desc.attrib[2].semantic = Graphics::ATTRIB_UV0;
+			desc.attrib[2].format = Graphics::ATTRIB_FORMAT_FLOAT2;
+			if (hasTangents) {
+				desc.attrib[3].semantic = Graphics::ATTRIB_TANGENT;
+				desc.attrib[3].format = Graphics::ATTRIB_FORMAT_FLOAT3;
+			}
+			for (Uint32 i = 0; i < Graphics::MAX_ATTRIBS && desc.attrib[i].semantic != Graphics::ATTRIB_NONE; i++) {
+				desc.attrib[i].offset = Graphics::VertexBufferDesc::CalculateOffset(desc, desc.attrib[i].semantic);
+				desc.stride += Graphics::VertexBufferDesc::GetAttribSize(desc.attrib[i].format);
+			}
+			desc.usage = Graphics::BUFFER_USAGE_STATIC;
+			desc.numVertices = numVertices;
+			return desc;
+		}
+
+		Uint32 AddBlob(NodeDatabase &db, std::string &&blob)
+		{
+			db.wrBlobs->push_back(std::move(blob));
+			return db.wrBlobs->size() - 1;
+		}
+
+		const ByteRange &GetBlob(NodeDatabase &db, Uint32 index)
+		{
+			if (index >= db.rdBlobs->size())
+				throw LoadingError("Mesh data missing");
+			return (*db.rdBlobs)[index];
+		}
+	} // namespace
+
 	void StaticGeometry::Save(NodeDatabase &db)
 	{
 		PROFILE_SCOPED()
@@ -154,7 +199,18 @@ namespace SceneGraph {
 			const Uint32 stride = vbDesc.stride;
 			db.wr->Int32(vbDesc.numVertices);
 			Uint8 *vtxPtr = mesh.vertexBuffer->Map<Uint8>(Graphics::BUFFER_MAP_READ);
-			if (hasTangents) {
+			if (db.wrBlobs) {
+				const Graphics::VertexBufferDesc layout = ModelVertexDesc(hasTangents, vbDesc.numVertices);
+				std::string vertices(size_t(layout.numVertices) * layout.stride, '\0');
+				Uint8 *outPtr = reinterpret_cast<Uint8 *>(&vertices[0]);
+				for (Uint32 a = 0; a < Graphics::MAX_ATTRIBS && layout.attrib[a].semantic != Graphics::ATTRIB_NONE; a++) {
+					const Uint32 inOffset = vbDesc.GetOffset(layout.attrib[a].semantic);
+					const Uint32 size = Graphics::VertexBufferDesc::GetAttribSize(layout.attrib[a].format);
+					for (Uint32 i = 0; i < vbDesc.numVertices; i++)
+						memcpy(outPtr + i * layout.stride + layout.attrib[a].offset, vtxPtr + i * stride + inOffset, size);
+				}
+				db.wr->Int32(AddBlob(db, std::move(vertices)));
+			} else if (hasTangents) {
 				for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
 					db.wr->Vector3f(*reinterpret_cast<vector3f *>(vtxPtr + i * stride + posOffset));
 					db.wr->Vector3f(*reinterpret_cast<vector3f *>(vtxPtr + i * stride + nrmOffset));
@@ -176,8 +232,12 @@ namespace SceneGraph {
 			const Uint32 *indexPtr = mesh.indexBuffer->Map(Graphics::BUFFER_MAP_READ);
 			const Uint32 numIndices = mesh.indexBuffer->GetSize();
 			db.wr->Int32(numIndices);
-			for (Uint32 i = 0; i < numIndices; i++)
-				db.wr->Int32(indexPtr[i]);
+			if (db.wrBlobs) {
+				db.wr->Int32(AddBlob(db, std::string(reinterpret_cast<const char *>(indexPtr), numIndices * sizeof(Uint32))));
+			} else {
+				for (Uint32 i = 0; i < numIndices; i++)
+					db.wr->Int32(indexPtr[i]);
+			}
 			mesh.indexBuffer->Unmap();
 		}
 	}
@@ -219,54 +279,57 @@ namespace SceneGraph {
 			const bool hasTangents = (vtxFormat & Graphics::ATTRIB_TANGENT);
 
 			//vertex buffer
-			Graphics::VertexBufferDesc vbDesc;
-			vbDesc.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-			vbDesc.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-			vbDesc.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
-			vbDesc.attrib[1].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-			vbDesc.attrib[2].semantic = Graphics::ATTRIB_UV0;
-			vbDesc.attrib[2].format = Graphics::ATTRIB_FORMAT_FLOAT2;
-			if (hasTangents) {
-				vbDesc.attrib[3].semantic = Graphics::ATTRIB_TANGENT;
-				vbDesc.attrib[3].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-			}
-			vbDesc.usage = Graphics::BUFFER_USAGE_STATIC;
-			vbDesc.numVertices = db.rd->Int32();
+			const Graphics::VertexBufferDesc vbDesc = ModelVertexDesc(hasTangents, db.rd->Int32());
 
 			RefCountedPtr<Graphics::VertexBuffer> vtxBuffer(db.loader->GetRenderer()->CreateVertexBuffer(vbDesc));
-			const Uint32 posOffset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_POSITION);
-			const Uint32 nrmOffset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_NORMAL);
-			const Uint32 uv0Offset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_UV0);
-			const Uint32 tanOffset = hasTangents ? vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_TANGENT) : 0;
-			const Uint32 stride = vtxBuffer->GetDesc().stride;
-			Uint8 *vtxPtr = vtxBuffer->Map<Uint8>(BUFFER_MAP_WRITE);
-			if (hasTangents) {
-				for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-					*reinterpret_cast<vector3f *>(vtxPtr + i * stride + posOffset) = db.rd->Vector3f();
-					*reinterpret_cast<vector3f *>(vtxPtr + i * stride + nrmOffset) = db.rd->Vector3f();
-					const float uvx = db.rd->Float();
-					const float uvy = db.rd->Float();
-					*reinterpret_cast<vector2f *>(vtxPtr + i * stride + uv0Offset) = vector2f(uvx, uvy);
-					*reinterpret_cast<vector3f *>(vtxPtr + i * stride + tanOffset) = db.rd->Vector3f();
-				}
+			if (db.rdBlobs) {
+				// already laid out as the buffer has it
+				const ByteRange &vertices = GetBlob(db, db.rd->Int32());
+				if (vertices.Size() != size_t(vtxBuffer->GetDesc().stride) * vbDesc.numVertices)
+					throw LoadingError("Vertex data doesn't match the vertex format");
+				vtxBuffer->BufferData(vertices.Size(), vertices.begin);
 			} else {
-				for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-					*reinterpret_cast<vector3f *>(vtxPtr + i * stride + posOffset) = db.rd->Vector3f();
-					*reinterpret_cast<vector3f *>(vtxPtr + i * stride + nrmOffset) = db.rd->Vector3f();
-					const float uvx = db.rd->Float();
-					const float uvy = db.rd->Float();
-					*reinterpret_cast<vector2f *>(vtxPtr + i * stride + uv0Offset) = vector2f(uvx, uvy);
+				const Uint32 posOffset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_POSITION);
+				const Uint32 nrmOffset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_NORMAL);
+				const Uint32 uv0Offset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_UV0);
+				const Uint32 tanOffset = hasTangents ? vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_TANGENT) : 0;
+				const Uint32 stride = vtxBuffer->GetDesc().stride;
+				Uint8 *vtxPtr = vtxBuffer->Map<Uint8>(BUFFER_MAP_WRITE);
+				if (hasTangents) {
+					for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
+						*reinterpret_cast<vector3f *>(vtxPtr + i * stride + posOffset) = db.rd->Vector3f();
+						*reinterpret_cast<vector3f *>(vtxPtr + i * stride + nrmOffset) = db.rd->Vector3f();
+						const float uvx = db.rd->Float();
+						const float uvy = db.rd->Float();
+						*reinterpret_cast<vector2f *>(vtxPtr + i * stride + uv0Offset) = vector2f(uvx, uvy);
+						*reinterpret_cast<vector3f *>(vtxPtr + i * stride + tanOffset) = db.rd->Vector3f();
+					}
+				} else {
+					for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
+						*reinterpret_cast<vector3f *>(vtxPtr + i * stride + posOffset) = db.rd->Vector3f();
+						*reinterpret_cast<vector3f *>(vtxPtr + i * stride + nrmOffset) = db.rd->Vector3f();
+						const float uvx = db.rd->Float();
+						const float uvy = db.rd->Float();
+						*reinterpret_cast<vector2f *>(vtxPtr + i * stride + uv0Offset) = vector2f(uvx, uvy);
+					}
 				}
+				vtxBuffer->Unmap();
 			}
-			vtxBuffer->Unmap();
 
 			//index buffer
 			const Uint32 numIndices = db.rd->Int32();
 			RefCountedPtr<Graphics::IndexBuffer> idxBuffer(db.loader->GetRenderer()->CreateIndexBuffer(numIndices, Graphics::BUFFER_USAGE_STATIC));
-			Uint32 *idxPtr = idxBuffer->Map(BUFFER_MAP_WRITE);
-			for (Uint32 i = 0; i < numIndices; i++)
-				idxPtr[i] = db.rd->Int32();
-			idxBuffer->Unmap();
+			if (db.rdBlobs) {
+				const ByteRange &indices = GetBlob(db, db.rd->Int32());
+				if (indices.Size() != numIndices * sizeof(Uint32))
+					throw LoadingError("Index data doesn't match the index count");
+				idxBuffer->BufferData(indices.Size(), indices.begin);
+			} else {
+				Uint32 *idxPtr = idxBuffer->Map(BUFFER_MAP_WRITE);
+				for (Uint32 i = 0; i < numIndices; i++)
+					idxPtr[i] = db.rd->Int32();
+				idxBuffer->Unmap();
+			}
 
 			sg->AddMesh(vtxBuffer, idxBuffer, material);
 		}